@@ -15,6 +15,10 @@ namespace ChatterBox.Background.AppService.Dto
     {
         public uint ForegroundProcessId { get; set; }
 
+        // Generation of the swap chain handle, echoed back when the
+        // foreground acknowledges it.
+        public ulong Generation { get; set; }
+
         public uint Height { get; set; }
         public bool IsLocal { get; set; }
 
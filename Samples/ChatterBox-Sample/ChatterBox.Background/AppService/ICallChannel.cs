@@ -18,6 +18,7 @@ namespace ChatterBox.Background.AppService
 {
     public interface ICallChannel
     {
+        IAsyncAction AcknowledgeFrameFormatAsync(FrameFormat frameFormat);
         IAsyncAction AnswerAsync();
         // Locally initiated calls
         IAsyncAction CallAsync(OutgoingCallRequest request);
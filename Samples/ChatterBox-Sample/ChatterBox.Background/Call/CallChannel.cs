@@ -71,6 +71,15 @@ namespace ChatterBox.Background.Call
             return Task.FromResult(Context.GetFrameFormat(local)).AsAsyncOperation();
         }
 
+        public IAsyncAction AcknowledgeFrameFormatAsync(FrameFormat frameFormat)
+        {
+            return Context.WithContextAction(cx =>
+            {
+                var videoRenderer = frameFormat.IsLocal ? cx.LocalVideoRenderer : cx.RemoteVideoRenderer;
+                videoRenderer?.AcknowledgeSwapChainHandle(frameFormat.Generation);
+            }).AsAsyncAction();
+        }
+
         // Hangup can happen on both sides
         public IAsyncAction HangupAsync()
         {
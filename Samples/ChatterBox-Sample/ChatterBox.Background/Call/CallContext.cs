@@ -302,12 +302,15 @@ namespace ChatterBox.Background.Call
         {
             if (LocalVideoRenderer != null)
             {
+                // The mailbox name is shared; the new renderer must be its only writer.
+                LocalVideoRenderer.CloseFrameFormatMailbox();
                 LocalVideoRenderer.Teardown();
                 LocalVideoRenderer = null;
             }
             LocalVideoRenderer = null;
             GC.Collect();
             LocalVideoRenderer = new Renderer();
+            LocalVideoRenderer.OpenFrameFormatMailbox(FrameFormatMailboxNames.Local);
             LocalVideoRenderer.RenderFormatUpdate += LocalVideoRenderer_RenderFormatUpdate;
         }
 
@@ -315,12 +318,14 @@ namespace ChatterBox.Background.Call
         {
             if (RemoteVideoRenderer != null)
             {
+                RemoteVideoRenderer.CloseFrameFormatMailbox();
                 RemoteVideoRenderer.Teardown();
                 RemoteVideoRenderer = null;
             }
             RemoteVideoRenderer = null;
             GC.Collect();
             RemoteVideoRenderer = new Renderer();
+            RemoteVideoRenderer.OpenFrameFormatMailbox(FrameFormatMailboxNames.Remote);
             RemoteVideoRenderer.RenderFormatUpdate += RemoteVideoRenderer_RenderFormatUpdate;
         }
 
@@ -536,7 +541,9 @@ namespace ChatterBox.Background.Call
                 Int64 swapChainHandle = 0;
                 UInt32 width = 0, height = 0;
                 UInt32 foregroundProcessId = 0;
-                if(videoRenderer.GetRenderFormat(out swapChainHandle, out width, out height, out foregroundProcessId))
+                UInt64 generation = 0;
+                if(videoRenderer.GetRenderFormat(out swapChainHandle, out width, out height, out foregroundProcessId,
+                    out generation))
                 {
                     return new FrameFormat
                     {
@@ -544,7 +551,8 @@ namespace ChatterBox.Background.Call
                         SwapChainHandle = swapChainHandle,
                         Width = width,
                         Height = height,
-                        ForegroundProcessId = foregroundProcessId
+                        ForegroundProcessId = foregroundProcessId,
+                        Generation = generation
                     };
                 }
             }
@@ -602,7 +610,7 @@ namespace ChatterBox.Background.Call
         }
 
         private void LocalVideoRenderer_RenderFormatUpdate(long swapChainHandle, uint width, uint height,
-            uint foregroundProcessId)
+            uint foregroundProcessId, ulong generation)
         {
             _hub.OnUpdateFrameFormat(
                 new FrameFormat
@@ -611,12 +619,13 @@ namespace ChatterBox.Background.Call
                     SwapChainHandle = swapChainHandle,
                     Width = width,
                     Height = height,
-                    ForegroundProcessId = foregroundProcessId
+                    ForegroundProcessId = foregroundProcessId,
+                    Generation = generation
                 });
         }
 
         private void RemoteVideoRenderer_RenderFormatUpdate(long swapChainHandle, uint width, uint height,
-            uint foregroundProcessId)
+            uint foregroundProcessId, ulong generation)
         {
             _hub.OnUpdateFrameFormat(
                 new FrameFormat
@@ -625,7 +634,8 @@ namespace ChatterBox.Background.Call
                     SwapChainHandle = swapChainHandle,
                     Width = width,
                     Height = height,
-                    ForegroundProcessId = foregroundProcessId
+                    ForegroundProcessId = foregroundProcessId,
+                    Generation = generation
                 });
         }
 
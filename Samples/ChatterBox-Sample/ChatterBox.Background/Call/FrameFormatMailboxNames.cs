@@ -0,0 +1,24 @@
+﻿//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+namespace ChatterBox.Background.Call
+{
+    /// <summary>
+    /// Shared memory names the renderers publish their render formats to,
+    /// for the matching WebRTCSwapChainPanel in the foreground.
+    /// </summary>
+    public sealed class FrameFormatMailboxNames
+    {
+        public static string Local => "ChatterBox.LocalFrameFormat";
+
+        public static string Remote => "ChatterBox.RemoteFrameFormat";
+    }
+}
@@ -27,6 +27,7 @@ namespace ChatterBox.Background.Call
         void SetDisplaySize(Size size);
 
         void UpdateForegroundProcessId(uint foregroundProcessId);
-        bool GetRenderFormat(out Int64 swapChainHandle, out UInt32 width, out UInt32 height, out UInt32 foregroundProcessId);
+        bool GetRenderFormat(out Int64 swapChainHandle, out UInt32 width, out UInt32 height, out UInt32 foregroundProcessId,
+            out UInt64 generation);
     }
 }
\ No newline at end of file
@@ -12,5 +12,5 @@
 namespace ChatterBox.Background.Call
 {
     public delegate void RenderFormatUpdateHandler(
-        long swapChainHandle, uint width, uint height, uint foregroundProcessId);
+        long swapChainHandle, uint width, uint height, uint foregroundProcessId, ulong generation);
 }
\ No newline at end of file
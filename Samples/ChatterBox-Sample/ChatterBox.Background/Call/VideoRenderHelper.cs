@@ -52,14 +52,17 @@ namespace ChatterBox.Background.Call
 
         public event RenderFormatUpdateHandler RenderFormatUpdate;
 
-        private void OnRenderFormatUpdate(long swapChainHandle, uint width, uint height, uint foregroundProcessId)
+        private void OnRenderFormatUpdate(long swapChainHandle, uint width, uint height, uint foregroundProcessId,
+            ulong generation)
         {
-            RenderFormatUpdate(swapChainHandle, width, height, foregroundProcessId);
+            RenderFormatUpdate(swapChainHandle, width, height, foregroundProcessId, generation);
         }
 
-        public bool GetRenderFormat(out Int64 swapChainHandle, out UInt32 width, out UInt32 height, out UInt32 foregroundProcessId)
+        public bool GetRenderFormat(out Int64 swapChainHandle, out UInt32 width, out UInt32 height, out UInt32 foregroundProcessId,
+            out UInt64 generation)
         {
-            return _renderer.GetRenderFormat(out swapChainHandle, out width, out height, out foregroundProcessId);
+            return _renderer.GetRenderFormat(out swapChainHandle, out width, out height, out foregroundProcessId,
+                out generation);
         }
 
         public void SetDisplaySize(Size size)
@@ -17,12 +17,24 @@
 #include <algorithm>
 
 using ChatterBox::Client::WebRTCSwapChainPanel::WebRTCSwapChainPanel;
+using ChatterBoxClient::Universal::BackgroundRenderer::FrameFormatMailbox;
+using ChatterBoxClient::Universal::BackgroundRenderer::FrameFormatRecord;
 using Microsoft::WRL::ComPtr;
 using Platform::COMException;
 using Platform::String;
 using Windows::Foundation::Size;
 
-WebRTCSwapChainPanel::WebRTCSwapChainPanel() : _handle(nullptr)
+// Frames in a row the mailbox may be stuck in a post before the panel gives
+// up on it, about half a second.
+static const uint32_t c_maxBusyFrames = 30;
+
+WebRTCSwapChainPanel::WebRTCSwapChainPanel() :
+    _handle(nullptr),
+    _mailboxMapping(nullptr),
+    _mailboxView(nullptr),
+    _handleFromMailbox(false),
+    _loaded(false),
+    _rendering(false)
 {
     _controlSize.Width = 0.0f;
     _controlSize.Height = 0.0;
@@ -30,10 +42,15 @@ WebRTCSwapChainPanel::WebRTCSwapChainPanel() : _handle(nullptr)
     _nativeVideoSize.Height = 0.0f;
     SizeChanged += ref new Windows::UI::Xaml::SizeChangedEventHandler(this,
         &ChatterBox::Client::WebRTCSwapChainPanel::WebRTCSwapChainPanel::OnSizeChanged);
+    Loaded += ref new Windows::UI::Xaml::RoutedEventHandler(this,
+        &ChatterBox::Client::WebRTCSwapChainPanel::WebRTCSwapChainPanel::OnLoaded);
+    Unloaded += ref new Windows::UI::Xaml::RoutedEventHandler(this,
+        &ChatterBox::Client::WebRTCSwapChainPanel::WebRTCSwapChainPanel::OnUnloaded);
 }
 
 WebRTCSwapChainPanel::~WebRTCSwapChainPanel()
 {
+    CloseFrameFormatMailbox();
     if (_handle != nullptr)
     {
         CloseHandle(_handle);
@@ -110,6 +127,124 @@ uint32 WebRTCSwapChainPanel::CurrentProcessId::get()
     return ::GetCurrentProcessId();
 }
 
+void WebRTCSwapChainPanel::FrameFormatMailboxName::set(String^ name)
+{
+    CloseFrameFormatMailbox();
+    _mailboxName = name;
+    if ((name != nullptr) && !name->IsEmpty())
+    {
+        // Made here if the renderer has not made it yet; the renderer lays
+        // it out when it gets to it.
+        _mailboxMapping = CreateFileMappingFromApp(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            FrameFormatMailbox::c_size, name->Data());
+        if (_mailboxMapping != nullptr)
+        {
+            _mailboxView = MapViewOfFileFromApp(_mailboxMapping, FILE_MAP_READ | FILE_MAP_WRITE, 0,
+                FrameFormatMailbox::c_size);
+        }
+        if (_mailboxView == nullptr)
+        {
+            OutputDebugString(L"Failed to open the frame format mailbox\n");
+            CloseFrameFormatMailbox();
+        }
+    }
+    UpdateRenderingHandler();
+}
+
+String^ WebRTCSwapChainPanel::FrameFormatMailboxName::get()
+{
+    return _mailboxName;
+}
+
+void WebRTCSwapChainPanel::CloseFrameFormatMailbox()
+{
+    _mailbox.Detach();
+    _handleFromMailbox = false;
+    if (_mailboxView != nullptr)
+    {
+        UnmapViewOfFile(_mailboxView);
+        _mailboxView = nullptr;
+    }
+    if (_mailboxMapping != nullptr)
+    {
+        CloseHandle(_mailboxMapping);
+        _mailboxMapping = nullptr;
+    }
+}
+
+// Checks the mailbox on every frame while the panel is in the tree.
+void WebRTCSwapChainPanel::UpdateRenderingHandler()
+{
+    bool rendering = _loaded && (_mailboxView != nullptr);
+    if (rendering == _rendering)
+    {
+        return;
+    }
+    if (rendering)
+    {
+        _renderingToken = Windows::UI::Xaml::Media::CompositionTarget::Rendering +=
+            ref new Windows::Foundation::EventHandler<Platform::Object^>(this,
+                &ChatterBox::Client::WebRTCSwapChainPanel::WebRTCSwapChainPanel::OnRendering);
+    }
+    else
+    {
+        Windows::UI::Xaml::Media::CompositionTarget::Rendering -= _renderingToken;
+    }
+    _rendering = rendering;
+}
+
+void WebRTCSwapChainPanel::OnRendering(Platform::Object^ sender, Platform::Object^ e)
+{
+    // A single load until the renderer has laid the mailbox out.
+    if (!_mailbox.IsAttached() && !_mailbox.AttachReader(_mailboxView, FrameFormatMailbox::c_size))
+    {
+        return;
+    }
+
+    FrameFormatRecord record;
+    if (!_mailbox.ReadIfChanged(&record))
+    {
+        if (_mailbox.BusyReads() >= c_maxBusyFrames)
+        {
+            // The background process stopped half way through a post and
+            // is not coming back to finish it. The app service still
+            // delivers the handle, so go back to that.
+            OutputDebugString(L"Frame format mailbox stuck, using the app service handle\n");
+            CloseFrameFormatMailbox();
+            UpdateRenderingHandler();
+            int64 handle = SwapChainPanelHandle;
+            if (handle != 0)
+            {
+                UpdateHandle(handle);
+            }
+        }
+        return;
+    }
+    if ((record.foregroundProcessId != ::GetCurrentProcessId()) || (record.swapChainHandle == 0))
+    {
+        // For an earlier foreground process.
+        return;
+    }
+
+    UpdateHandle((int64)record.swapChainHandle);
+    _handleFromMailbox = true;
+    NativeVideoSize = Size((float)record.width, (float)record.height);
+    // The background can close the handles this one replaced.
+    _mailbox.Acknowledge(record);
+}
+
+void WebRTCSwapChainPanel::OnLoaded(Platform::Object^ sender, Windows::UI::Xaml::RoutedEventArgs^ e)
+{
+    _loaded = true;
+    UpdateRenderingHandler();
+}
+
+void WebRTCSwapChainPanel::OnUnloaded(Platform::Object^ sender, Windows::UI::Xaml::RoutedEventArgs^ e)
+{
+    _loaded = false;
+    UpdateRenderingHandler();
+}
+
 void WebRTCSwapChainPanel::NativeVideoSize::set(Size s)
 {
     _nativeVideoSize = s;
@@ -126,6 +261,15 @@ void WebRTCSwapChainPanel::OnSwapChainPanelHandleChanged(Windows::UI::Xaml::Depe
 {
     WebRTCSwapChainPanel^ control = (WebRTCSwapChainPanel^)d;
     int64 val = (int64)(e->NewValue);
+    if (val == 0LL)
+    {
+        control->_handleFromMailbox = false;
+    }
+    else if (control->_handleFromMailbox)
+    {
+        // The app service only catches up with what the mailbox delivered.
+        return;
+    }
     control->UpdateHandle(val);
 }
 
@@ -11,6 +11,8 @@
 
 #pragma once
 
+#include "../ChatterBoxClient.Universal.BackgroundRenderer/FrameFormatMailbox.h"
+
 namespace ChatterBox {
 namespace Client {
 namespace WebRTCSwapChainPanel {
@@ -35,6 +37,16 @@ namespace WebRTCSwapChainPanel {
         {
             uint32 get();
         }
+
+        /// Name of the shared memory a background Renderer publishes its
+        /// render formats to. The panel checks it on every frame and takes
+        /// new swap chain handles from there; SwapChainPanelHandle is only
+        /// used until a handle came that way, apart from 0 to clear it.
+        property Platform::String^ FrameFormatMailboxName
+        {
+            void set(Platform::String^);
+            Platform::String^ get();
+        }
 		
 		static property Windows::UI::Xaml::DependencyProperty^ SwapChainPanelHandleProperty
 		{
@@ -53,6 +65,11 @@ namespace WebRTCSwapChainPanel {
 
     private:
         void UpdateHandle(int64 handle);
+        void CloseFrameFormatMailbox();
+        void UpdateRenderingHandler();
+        void OnRendering(Platform::Object^ sender, Platform::Object^ e);
+        void OnLoaded(Platform::Object^ sender, Windows::UI::Xaml::RoutedEventArgs^ e);
+        void OnUnloaded(Platform::Object^ sender, Windows::UI::Xaml::RoutedEventArgs^ e);
 
         static void OnSwapChainPanelHandleChanged(Windows::UI::Xaml::DependencyObject^ d,
             Windows::UI::Xaml::DependencyPropertyChangedEventArgs^ e);
@@ -60,6 +77,14 @@ namespace WebRTCSwapChainPanel {
             Windows::UI::Xaml::DependencyPropertyChangedEventArgs^ e);
 
         HANDLE _handle;
+        Platform::String^ _mailboxName;
+        HANDLE _mailboxMapping;
+        void* _mailboxView;
+        ChatterBoxClient::Universal::BackgroundRenderer::FrameFormatMailbox _mailbox;
+        bool _handleFromMailbox;
+        bool _loaded;
+        bool _rendering;
+        Windows::Foundation::EventRegistrationToken _renderingToken;
         Windows::Foundation::Size _nativeVideoSize;
         Windows::Foundation::Size _controlSize;        
 
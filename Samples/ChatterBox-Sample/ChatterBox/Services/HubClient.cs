@@ -85,6 +85,11 @@ namespace ChatterBox.Services
             return InvokeHubChannelAsync<ICallChannel, FrameFormat>(local);
         }
 
+        public IAsyncAction AcknowledgeFrameFormatAsync(FrameFormat frameFormat)
+        {
+            return InvokeHubChannelAsync<ICallChannel>(frameFormat).AsTask().AsAsyncAction();
+        }
+
         public IAsyncAction HangupAsync()
         {
             return InvokeHubChannelAsync<ICallChannel>().AsTask().AsAsyncAction();
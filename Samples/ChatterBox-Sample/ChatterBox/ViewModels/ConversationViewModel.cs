@@ -12,6 +12,7 @@
 using System;
 using System.Collections.Generic;
 using System.Collections.ObjectModel;
+using System.Diagnostics;
 using System.Linq;
 using System.Threading.Tasks;
 using System.Windows.Input;
@@ -27,6 +28,7 @@ using ChatterBox.Background;
 using ChatterBox.Background.AppService;
 using ChatterBox.Background.AppService.Dto;
 using ChatterBox.Background.Avatars;
+using ChatterBox.Background.Call;
 using ChatterBox.Background.Settings;
 using ChatterBox.Background.Signaling.PersistedData;
 using ChatterBox.Client.WebRTCSwapChainPanel;
@@ -686,7 +688,7 @@ namespace ChatterBox.ViewModels
             OnCloseConversation?.Invoke(this);
         }
 
-        private void OnFrameFormatUpdate(FrameFormat obj)
+        private async void OnFrameFormatUpdate(FrameFormat obj)
         {
             if (CallState == CallState.Idle)
             {
@@ -709,6 +711,20 @@ namespace ChatterBox.ViewModels
                 RemoteSwapChainPanelHandle = obj.SwapChainHandle;
                 RemoteNativeVideoSize = new Size(obj.Width, obj.Height);
             }
+
+            // The panel has duplicated the new handle, the background can
+            // close the ones it replaced. The app service can go away during
+            // a hangup, and this handler has no caller to throw to; the
+            // background releases unacknowledged handles after a grace
+            // period anyway.
+            try
+            {
+                await _callChannel.AcknowledgeFrameFormatAsync(obj);
+            }
+            catch (Exception e)
+            {
+                Debug.WriteLine($"Failed to acknowledge the frame format. Error: {e.Message}");
+            }
         }
 
         private void OnFrameRateUpdate(FrameRate obj)
@@ -822,6 +838,7 @@ namespace ChatterBox.ViewModels
         private void SetVideoPresenters()
         {
             var remoteVideoRenderer = new WebRTCSwapChainPanel();
+            remoteVideoRenderer.FrameFormatMailboxName = FrameFormatMailboxNames.Remote;
             remoteVideoRenderer.SizeChanged += (s, e) => { RemoteVideoControlSize = e.NewSize; };
 
             remoteVideoRenderer.SetBinding(
@@ -835,6 +852,7 @@ namespace ChatterBox.ViewModels
             RemoteVideoRenderer = remoteVideoRenderer;
 
             var localVideoRenderer = new WebRTCSwapChainPanel();
+            localVideoRenderer.FrameFormatMailboxName = FrameFormatMailboxNames.Local;
             localVideoRenderer.SizeChanged += (s, e) => { LocalVideoControlSize = e.NewSize; };
 
             localVideoRenderer.SetBinding(
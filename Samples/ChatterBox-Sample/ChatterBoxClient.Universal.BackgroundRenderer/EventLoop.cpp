@@ -0,0 +1,182 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "EventLoop.h"
+
+#include <new>
+
+using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+
+static uint64_t MicrosecondsBetween(std::chrono::steady_clock::time_point from,
+    std::chrono::steady_clock::time_point to)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+EventLoop::EventLoop(IEventHandler* handler) :
+    _handler(handler),
+    _running(false),
+    _stopping(false),
+    _posted(0),
+    _handled(0),
+    _coalesced(0),
+    _dropped(0),
+    _maxDepth(0)
+{
+}
+
+EventLoop::~EventLoop()
+{
+    Stop();
+}
+
+void EventLoop::Start()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    if (_running)
+    {
+        return;
+    }
+
+    _stopping = false;
+    _thread = std::thread(&EventLoop::Run, this);
+    _running = true;
+}
+
+void EventLoop::Stop()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    if (!_running)
+    {
+        return;
+    }
+
+    _stopping = true;
+    _wake.notify_all();
+    lock.unlock();
+
+    _thread.join();
+
+    lock.lock();
+    _running = false;
+    _dropped += _queue.size();
+    _queue.clear();
+}
+
+void EventLoop::Post(uint32_t id, uint64_t param1, uint32_t param2, bool coalesce)
+{
+    QueuedEvent event = { id, param1, param2, std::chrono::steady_clock::now() };
+
+    std::lock_guard<std::mutex> lock(_lock);
+    _posted++;
+    if (!_running || _stopping)
+    {
+        _dropped++;
+        return;
+    }
+
+    if (coalesce)
+    {
+        // The queue only grows past a handful during a storm, which is
+        // exactly what this keeps from happening.
+        for (const QueuedEvent& queued : _queue)
+        {
+            if (queued.id == id)
+            {
+                _coalesced++;
+                return;
+            }
+        }
+    }
+
+    try
+    {
+        _queue.push_back(event);
+    }
+    catch (const std::bad_alloc&)
+    {
+        _dropped++;
+        return;
+    }
+
+    if (_queue.size() > _maxDepth)
+    {
+        _maxDepth = (uint32_t)_queue.size();
+    }
+
+    // only an empty queue can have the thread waiting
+    if (_queue.size() == 1)
+    {
+        _wake.notify_one();
+    }
+}
+
+void EventLoop::GetStats(EventLoopStats* stats) const
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        stats->posted = _posted;
+        stats->handled = _handled;
+        stats->coalesced = _coalesced;
+        stats->dropped = _dropped;
+        stats->depth = (uint32_t)_queue.size();
+        stats->maxDepth = _maxDepth;
+    }
+
+    _wait.Summarize(&stats->wait);
+    _handling.Summarize(&stats->handling);
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Function:   EventLoop::Run
+//
+//  Synopsis:   Loop thread. Takes one event at a time and handles it outside
+//              the lock, so Post is never held up by a slow handler.
+//
+//-----------------------------------------------------------------------------
+void EventLoop::Run()
+{
+    _handler->OnThreadStart();
+
+    std::unique_lock<std::mutex> lock(_lock);
+    while (!_stopping)
+    {
+        if (_queue.empty())
+        {
+            _wake.wait(lock);
+            continue;
+        }
+
+        // Off the queue before it is handled, so a coalescing post that
+        // comes in meanwhile queues a new event instead of being lost.
+        QueuedEvent event = _queue.front();
+        _queue.pop_front();
+        lock.unlock();
+
+        auto started = std::chrono::steady_clock::now();
+        _handler->OnEvent(event);
+        auto finished = std::chrono::steady_clock::now();
+        _wait.Record(MicrosecondsBetween(event.posted, started));
+        _handling.Record(MicrosecondsBetween(started, finished));
+
+        lock.lock();
+        _handled++;
+    }
+    lock.unlock();
+
+    _handler->OnThreadStop();
+}
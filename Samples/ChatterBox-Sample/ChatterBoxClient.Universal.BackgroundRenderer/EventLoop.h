@@ -0,0 +1,117 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Events are plain numbers with two parameters; what they mean is up to
+// the IEventHandler, like pooled items behind IWarmPoolFactory.
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "LatencyHistogram.h"
+
+namespace ChatterBoxClient { namespace Universal { namespace BackgroundRenderer {
+
+using MEDIA::LatencyHistogram;
+using MEDIA::LatencySummary;
+
+struct QueuedEvent
+{
+    uint32_t id;
+    uint64_t param1;
+    uint32_t param2;
+    std::chrono::steady_clock::time_point posted;
+};
+
+//-----------------------------------------------------------------------------
+// IEventHandler
+//
+// Handles one event at a time on the loop thread, bracketed by
+// OnThreadStart/OnThreadStop for per-thread setup such as COM. Must not
+// throw, and must not stop the loop it runs on.
+//-----------------------------------------------------------------------------
+struct IEventHandler
+{
+    virtual ~IEventHandler() {}
+    virtual void OnEvent(const QueuedEvent& event) = 0;
+    virtual void OnThreadStart() {}
+    virtual void OnThreadStop() {}
+};
+
+struct EventLoopStats
+{
+    uint64_t posted;
+    uint64_t handled;
+    uint64_t coalesced;     // posts absorbed by an event still waiting
+    uint64_t dropped;       // posts while the loop was stopped
+    uint32_t depth;
+    uint32_t maxDepth;
+    LatencySummary wait;        // microseconds from Post to the handler
+    LatencySummary handling;    // microseconds in the handler
+};
+
+//-----------------------------------------------------------------------------
+// EventLoop
+//
+// One thread that handles events in the order they were posted, so the
+// thread posting them only pays for a short lock. A coalescing post is
+// absorbed by an event with the same id that has not been handled yet,
+// which turns a storm of them into a single one; its parameters are
+// the earlier event's, so the handler should look up the current state
+// rather than trust them.
+//-----------------------------------------------------------------------------
+class EventLoop
+{
+public:
+    explicit EventLoop(IEventHandler* handler);
+    ~EventLoop();
+
+    // Starts the thread; no-op while it runs.
+    void Start();
+
+    // Joins the thread. Events still waiting are dropped.
+    void Stop();
+
+    // Never waits for the handler. Dropped while the loop is stopped.
+    void Post(uint32_t id, uint64_t param1, uint32_t param2, bool coalesce);
+
+    void GetStats(EventLoopStats* stats) const;
+
+private:
+    EventLoop(const EventLoop&);
+    EventLoop& operator=(const EventLoop&);
+
+    void Run();
+
+    IEventHandler* _handler;
+
+    mutable std::mutex _lock;
+    std::condition_variable _wake;
+    std::thread _thread;
+    std::deque<QueuedEvent> _queue;
+    bool _running;
+    bool _stopping;
+
+    uint64_t _posted;
+    uint64_t _handled;
+    uint64_t _coalesced;
+    uint64_t _dropped;
+    uint32_t _maxDepth;
+
+    LatencyHistogram _wait;
+    LatencyHistogram _handling;
+};
+
+}}}
@@ -0,0 +1,231 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Only the layout and the protocol live here; the caller maps the memory.
+// Both the renderer and the swap chain panel include this file, so it
+// stays header only.
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "SeqLock.h"
+
+namespace ChatterBoxClient { namespace Universal { namespace BackgroundRenderer {
+
+// What RenderFormatUpdate carries. The handle is the duplicate made for
+// foregroundProcessId and means nothing to any other process. epoch tells
+// the writers that used the same mailbox apart, as each numbers its
+// generations from 1.
+struct FrameFormatRecord
+{
+    uint64_t epoch;
+    uint64_t swapChainHandle;
+    uint64_t generation;
+    uint32_t width;
+    uint32_t height;
+    uint32_t foregroundProcessId;
+    uint32_t reserved;
+};
+
+struct FrameFormatAck
+{
+    uint64_t epoch;
+    uint64_t generation;
+};
+
+//-----------------------------------------------------------------------------
+// FrameFormatMailbox
+//
+// The latest render format, in memory shared by the background renderer
+// and the foreground panel, so a new swap chain handle is picked up on
+// the panel's next frame instead of after an app service round trip.
+// The renderer writes the record and the panel the acknowledgement, each
+// through a SeqLock, so neither side ever waits for the other. One writer
+// and one reader at a time; a writer that attaches later takes over.
+//
+// The memory starts out zeroed, as a new file mapping does. The first
+// writer lays it out; a reader attaches once that has happened.
+//
+// Reads give up rather than wait for a write to finish, as the other
+// process can die or be suspended half way through one. A read that gave
+// up counts as no change and is tried again on the next call.
+//-----------------------------------------------------------------------------
+class FrameFormatMailbox
+{
+    struct Layout
+    {
+        std::atomic<uint32_t> magic;
+        uint32_t layoutVersion;
+        std::atomic<uint64_t> lastEpoch;
+        SeqLock<FrameFormatRecord> record;
+        SeqLock<FrameFormatAck> ack;
+    };
+
+public:
+    static const size_t c_size = sizeof(Layout);
+    static const uint32_t c_magic = 0x4D464643;    // 'CFFM'
+    static const uint32_t c_layoutVersion = 2;
+
+    // Copies tried per read before it gives up; a write takes a few dozen
+    // nanoseconds, so this only runs out on a writer that stopped.
+    static const uint32_t c_readAttempts = 1000;
+
+    FrameFormatMailbox() :
+        _layout(nullptr),
+        _epoch(0),
+        _recordVersion(0),
+        _ackVersion(0),
+        _busyReads(0)
+    {
+    }
+
+    // Background side. False if the memory is too small or laid out by an
+    // incompatible version.
+    bool AttachWriter(void* memory, size_t size)
+    {
+        Detach();
+        if ((memory == nullptr) || (size < c_size))
+        {
+            return false;
+        }
+
+        Layout* layout = static_cast<Layout*>(memory);
+        if (layout->magic.load(std::memory_order_acquire) != c_magic)
+        {
+            layout = new (memory) Layout();
+            layout->layoutVersion = c_layoutVersion;
+            layout->magic.store(c_magic, std::memory_order_release);
+        }
+        else if (layout->layoutVersion != c_layoutVersion)
+        {
+            return false;
+        }
+
+        // The record keeps its version, so a reader that is still attached
+        // sees the next post as a change. Nothing is read here: the writer
+        // this one replaces may have died half way through a post.
+        _epoch = layout->lastEpoch.fetch_add(1, std::memory_order_relaxed) + 1;
+        _ackVersion = layout->ack.Version();
+        _layout = layout;
+        return true;
+    }
+
+    // Foreground side. False until a writer has laid the memory out; try
+    // again later.
+    bool AttachReader(void* memory, size_t size)
+    {
+        Detach();
+        if ((memory == nullptr) || (size < c_size))
+        {
+            return false;
+        }
+
+        Layout* layout = static_cast<Layout*>(memory);
+        if ((layout->magic.load(std::memory_order_acquire) != c_magic) ||
+            (layout->layoutVersion != c_layoutVersion))
+        {
+            return false;
+        }
+
+        _layout = layout;
+        return true;
+    }
+
+    void Detach()
+    {
+        _layout = nullptr;
+        _epoch = 0;
+        _recordVersion = 0;
+        _ackVersion = 0;
+        _busyReads = 0;
+    }
+
+    bool IsAttached() const
+    {
+        return _layout != nullptr;
+    }
+
+    // Writer.
+    void Post(uint64_t swapChainHandle, uint32_t width, uint32_t height, uint32_t foregroundProcessId,
+        uint64_t generation)
+    {
+        FrameFormatRecord record = { _epoch, swapChainHandle, generation, width, height, foregroundProcessId, 0 };
+        _layout->record.Write(record);
+    }
+
+    // Writer. The newest generation of this writer that the reader
+    // acknowledged since the last call.
+    bool TakeAcknowledged(uint64_t* generation)
+    {
+        FrameFormatAck ack;
+        if (!ReadIfChanged(_layout->ack, &_ackVersion, &ack) || (ack.epoch != _epoch))
+        {
+            return false;
+        }
+
+        *generation = ack.generation;
+        return true;
+    }
+
+    // Reader. The record, if it changed since the last call.
+    bool ReadIfChanged(FrameFormatRecord* record)
+    {
+        return ReadIfChanged(_layout->record, &_recordVersion, record);
+    }
+
+    // Reads in a row, on either side, that gave up on a write in progress.
+    // A few mean the other process is slow; many mean it is gone.
+    uint32_t BusyReads() const
+    {
+        return _busyReads;
+    }
+
+    // Reader. The handle in record is in use, those before it can go.
+    void Acknowledge(const FrameFormatRecord& record)
+    {
+        FrameFormatAck ack = { record.epoch, record.generation };
+        _layout->ack.Write(ack);
+    }
+
+private:
+    FrameFormatMailbox(const FrameFormatMailbox&);
+    FrameFormatMailbox& operator=(const FrameFormatMailbox&);
+
+    template <typename T>
+    bool ReadIfChanged(const SeqLock<T>& lock, uint64_t* version, T* value)
+    {
+        if (lock.Version() == *version)
+        {
+            _busyReads = 0;
+            return false;
+        }
+
+        if (!lock.TryRead(value, version, c_readAttempts))
+        {
+            _busyReads++;
+            return false;
+        }
+
+        _busyReads = 0;
+        return true;
+    }
+
+    Layout* _layout;
+    uint64_t _epoch;
+    uint64_t _recordVersion;
+    uint64_t _ackVersion;
+    uint32_t _busyReads;
+};
+
+}}}
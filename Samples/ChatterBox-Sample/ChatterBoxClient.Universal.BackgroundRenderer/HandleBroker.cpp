@@ -0,0 +1,287 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "HandleBroker.h"
+
+using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+
+HandleBroker::HandleBroker(IHandleTransport* transport, uint32_t maxProcesses) :
+    _transport(transport),
+    _maxProcesses(maxProcesses),
+    _useCount(0),
+    _processOpens(0),
+    _processHits(0),
+    _sent(0),
+    _failed(0),
+    _sendBatches(0),
+    _released(0),
+    _releaseBatches(0)
+{
+}
+
+HandleBroker::~HandleBroker()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    std::vector<std::pair<uint32_t, uint64_t>> copies;
+    for (auto& copy : _copies)
+    {
+        copies.push_back(std::make_pair(copy.second.processId, copy.second.remote));
+    }
+    _copies.clear();
+    CloseCopies(copies);
+
+    for (auto& process : _processes)
+    {
+        _transport->CloseProcess(process.handle);
+    }
+    _processes.clear();
+}
+
+void HandleBroker::Share(const HandleShare* shares, size_t count, uint64_t* remote)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    // Copies being replaced go first, they may be in a process that is
+    // about to be trimmed.
+    std::vector<std::pair<uint32_t, uint64_t>> replaced;
+    for (size_t i = 0; i < count; i++)
+    {
+        remote[i] = c_invalidRemoteHandle;
+        auto found = _copies.find(CopyKey(shares[i].owner, shares[i].generation));
+        if (found != _copies.end())
+        {
+            replaced.push_back(std::make_pair(found->second.processId, found->second.remote));
+            _copies.erase(found);
+        }
+    }
+    CloseCopies(replaced);
+
+    std::vector<bool> done(count, false);
+    std::vector<size_t> batch;
+    std::vector<uint64_t> local;
+    std::vector<uint64_t> copied;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (done[i])
+        {
+            continue;
+        }
+
+        uint32_t processId = shares[i].processId;
+        batch.clear();
+        local.clear();
+        for (size_t j = i; j < count; j++)
+        {
+            if (!done[j] && (shares[j].processId == processId))
+            {
+                done[j] = true;
+                batch.push_back(j);
+                local.push_back(shares[j].local);
+            }
+        }
+
+        Process* process = FindProcess(processId);
+        if (process != nullptr)
+        {
+            _processHits += batch.size();
+        }
+        else
+        {
+            void* handle = _transport->OpenProcess(processId);
+            if (handle == nullptr)
+            {
+                _failed += batch.size();
+                continue;
+            }
+            Process opened = { processId, handle, 0, 0 };
+            _processes.push_back(opened);
+            process = &_processes.back();
+            _processOpens++;
+        }
+        process->lastUsed = ++_useCount;
+
+        copied.assign(batch.size(), c_invalidRemoteHandle);
+        _transport->Send(process->handle, local.data(), local.size(), copied.data());
+        _sendBatches++;
+
+        size_t succeeded = 0;
+        for (size_t k = 0; k < batch.size(); k++)
+        {
+            const HandleShare& share = shares[batch[k]];
+            remote[batch[k]] = copied[k];
+            if (copied[k] == c_invalidRemoteHandle)
+            {
+                _failed++;
+                continue;
+            }
+            Copy copy = { processId, copied[k] };
+            _copies[CopyKey(share.owner, share.generation)] = copy;
+            process->outstanding++;
+            _sent++;
+            succeeded++;
+        }
+
+        if ((succeeded == 0) && (process->outstanding == 0))
+        {
+            _transport->CloseProcess(process->handle);
+            _processes.erase(_processes.begin() + (process - _processes.data()));
+        }
+    }
+
+    TrimProcesses();
+}
+
+uint64_t HandleBroker::Share(uint64_t owner, uint64_t generation, uint64_t local, uint32_t processId)
+{
+    HandleShare share = { owner, generation, local, processId };
+    uint64_t remote;
+    Share(&share, 1, &remote);
+    return remote;
+}
+
+void HandleBroker::Release(uint64_t owner, const uint64_t* generations, size_t count)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    std::vector<std::pair<uint32_t, uint64_t>> copies;
+    for (size_t i = 0; i < count; i++)
+    {
+        auto found = _copies.find(CopyKey(owner, generations[i]));
+        if (found != _copies.end())
+        {
+            copies.push_back(std::make_pair(found->second.processId, found->second.remote));
+            _copies.erase(found);
+        }
+    }
+    CloseCopies(copies);
+    TrimProcesses();
+}
+
+void HandleBroker::ReleaseOwner(uint64_t owner)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    std::vector<std::pair<uint32_t, uint64_t>> copies;
+    auto copy = _copies.lower_bound(CopyKey(owner, 0));
+    while ((copy != _copies.end()) && (copy->first.first == owner))
+    {
+        copies.push_back(std::make_pair(copy->second.processId, copy->second.remote));
+        copy = _copies.erase(copy);
+    }
+    CloseCopies(copies);
+    TrimProcesses();
+}
+
+uint32_t HandleBroker::Outstanding(uint64_t owner) const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    uint32_t outstanding = 0;
+    auto copy = _copies.lower_bound(CopyKey(owner, 0));
+    while ((copy != _copies.end()) && (copy->first.first == owner))
+    {
+        outstanding++;
+        ++copy;
+    }
+    return outstanding;
+}
+
+void HandleBroker::GetStats(HandleBrokerStats* stats) const
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    stats->processOpens = _processOpens;
+    stats->processHits = _processHits;
+    stats->sent = _sent;
+    stats->failed = _failed;
+    stats->sendBatches = _sendBatches;
+    stats->released = _released;
+    stats->releaseBatches = _releaseBatches;
+    stats->openProcesses = (uint32_t)_processes.size();
+    stats->outstanding = (uint32_t)_copies.size();
+}
+
+// Called with _lock held.
+HandleBroker::Process* HandleBroker::FindProcess(uint32_t processId)
+{
+    for (auto& process : _processes)
+    {
+        if (process.processId == processId)
+        {
+            return &process;
+        }
+    }
+    return nullptr;
+}
+
+// Called with _lock held, with copies already gone from _copies. One
+// CloseRemote per process.
+void HandleBroker::CloseCopies(std::vector<std::pair<uint32_t, uint64_t>>& copies)
+{
+    std::vector<uint64_t> remote;
+    for (size_t i = 0; i < copies.size(); i++)
+    {
+        if (copies[i].second == c_invalidRemoteHandle)
+        {
+            continue;
+        }
+
+        uint32_t processId = copies[i].first;
+        remote.clear();
+        for (size_t j = i; j < copies.size(); j++)
+        {
+            if ((copies[j].first == processId) && (copies[j].second != c_invalidRemoteHandle))
+            {
+                remote.push_back(copies[j].second);
+                copies[j].second = c_invalidRemoteHandle;
+            }
+        }
+
+        // A copy always has its process open.
+        Process* process = FindProcess(processId);
+        _transport->CloseRemote(process->handle, remote.data(), remote.size());
+        process->outstanding -= (uint32_t)remote.size();
+        _released += remote.size();
+        _releaseBatches++;
+    }
+}
+
+// Called with _lock held. Closes the least recently used processes nothing
+// is shared with until at most _maxProcesses of those are left.
+void HandleBroker::TrimProcesses()
+{
+    for (;;)
+    {
+        uint32_t idle = 0;
+        size_t oldest = _processes.size();
+        for (size_t i = 0; i < _processes.size(); i++)
+        {
+            if (_processes[i].outstanding != 0)
+            {
+                continue;
+            }
+            idle++;
+            if ((oldest == _processes.size()) || (_processes[i].lastUsed < _processes[oldest].lastUsed))
+            {
+                oldest = i;
+            }
+        }
+
+        if (idle <= _maxProcesses)
+        {
+            return;
+        }
+
+        _transport->CloseProcess(_processes[oldest].handle);
+        _processes.erase(_processes.begin() + oldest);
+    }
+}
@@ -0,0 +1,148 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Only the bookkeeping lives here; how a handle gets into another process
+// is behind IHandleTransport, HANDLE duplication on Windows and file
+// descriptor passing elsewhere. Handles are plain numbers to this code.
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace ChatterBoxClient { namespace Universal { namespace BackgroundRenderer {
+
+// What Send reports for a handle it could not copy.
+static const uint64_t c_invalidRemoteHandle = ~0ull;
+
+//-----------------------------------------------------------------------------
+// IHandleTransport
+//
+// OpenProcess returns whatever Send needs to reach the process, nullptr on
+// failure; CloseProcess gets it back once nothing shared there is left.
+// Send copies count local handles into the process in one go and reports
+// what the process knows each copy as. CloseRemote closes such copies.
+//-----------------------------------------------------------------------------
+struct IHandleTransport
+{
+    virtual ~IHandleTransport() {}
+    virtual void* OpenProcess(uint32_t processId) = 0;
+    virtual void CloseProcess(void* process) = 0;
+    virtual void Send(void* process, const uint64_t* local, size_t count, uint64_t* remote) = 0;
+    virtual void CloseRemote(void* process, const uint64_t* remote, size_t count) = 0;
+};
+
+// One handle to share. An owner is any id unique to its user, e.g. one
+// per renderer; generation tells its handles apart.
+struct HandleShare
+{
+    uint64_t owner;
+    uint64_t generation;
+    uint64_t local;
+    uint32_t processId;
+};
+
+struct HandleBrokerStats
+{
+    uint64_t processOpens;
+    uint64_t processHits;   // shares that found the process open already
+    uint64_t sent;
+    uint64_t failed;
+    uint64_t sendBatches;
+    uint64_t released;
+    uint64_t releaseBatches;
+    uint32_t openProcesses;
+    uint32_t outstanding;
+};
+
+//-----------------------------------------------------------------------------
+// HandleBroker
+//
+// Shares handles with other processes and keeps track of every copy it
+// made there, by owner and generation, until the owner releases it. The
+// local handles stay with the caller.
+//
+// Processes stay open while any copy lives in them, and up to
+// maxProcesses more stay open after that, least recently used going
+// first, so a renderer switching handles does not reopen its foreground
+// process each time. A process where a whole Send failed is dropped from
+// the cache, as it may have gone away.
+//
+// Calls group their handles by process and make one transport call per
+// process. Thread safe; transport calls are made under the broker lock.
+//-----------------------------------------------------------------------------
+class HandleBroker
+{
+public:
+    HandleBroker(IHandleTransport* transport, uint32_t maxProcesses);
+
+    // Closes every copy still outstanding.
+    ~HandleBroker();
+
+    // remote[i] is the copy of shares[i], c_invalidRemoteHandle where it
+    // failed. Sharing an owner and generation again replaces its copy.
+    void Share(const HandleShare* shares, size_t count, uint64_t* remote);
+    uint64_t Share(uint64_t owner, uint64_t generation, uint64_t local, uint32_t processId);
+
+    // Closes the copies of these generations; unknown ones are ignored.
+    void Release(uint64_t owner, const uint64_t* generations, size_t count);
+    void ReleaseOwner(uint64_t owner);
+
+    // Copies an owner still has outstanding.
+    uint32_t Outstanding(uint64_t owner) const;
+
+    void GetStats(HandleBrokerStats* stats) const;
+
+private:
+    HandleBroker(const HandleBroker&);
+    HandleBroker& operator=(const HandleBroker&);
+
+    struct Process
+    {
+        uint32_t processId;
+        void* handle;
+        uint32_t outstanding;
+        uint64_t lastUsed;
+    };
+
+    struct Copy
+    {
+        uint32_t processId;
+        uint64_t remote;
+    };
+
+    typedef std::pair<uint64_t, uint64_t> CopyKey;     // owner, generation
+
+    Process* FindProcess(uint32_t processId);
+    void CloseCopies(std::vector<std::pair<uint32_t, uint64_t>>& copies);
+    void TrimProcesses();
+
+    IHandleTransport* _transport;
+    uint32_t _maxProcesses;
+
+    mutable std::mutex _lock;
+    std::vector<Process> _processes;
+    std::map<CopyKey, Copy> _copies;
+    uint64_t _useCount;
+
+    uint64_t _processOpens;
+    uint64_t _processHits;
+    uint64_t _sent;
+    uint64_t _failed;
+    uint64_t _sendBatches;
+    uint64_t _released;
+    uint64_t _releaseBatches;
+};
+
+}}}
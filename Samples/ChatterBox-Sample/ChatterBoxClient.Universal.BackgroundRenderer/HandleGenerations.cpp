@@ -0,0 +1,169 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "HandleGenerations.h"
+
+#include <algorithm>
+
+using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+
+TimerWheel::TimerWheel(uint64_t tickMs, uint32_t slotCount, uint64_t nowMs) :
+    _slots(slotCount > 0 ? slotCount : 1),
+    _tickMs(tickMs > 0 ? tickMs : 1),
+    _currentTick(0),
+    _count(0)
+{
+    _currentTick = nowMs / _tickMs;
+}
+
+void TimerWheel::Schedule(uint64_t id, uint64_t dueMs)
+{
+    // Round up so nothing fires early; anything already due goes to the
+    // next tick, which the next Advance always visits.
+    uint64_t dueTick = (dueMs + _tickMs - 1) / _tickMs;
+    if (dueTick <= _currentTick)
+    {
+        dueTick = _currentTick + 1;
+    }
+
+    Entry entry = { id, dueMs };
+    _slots[dueTick % _slots.size()].push_back(entry);
+    _count++;
+}
+
+void TimerWheel::Advance(uint64_t nowMs, std::vector<uint64_t>* expired)
+{
+    uint64_t nowTick = nowMs / _tickMs;
+    if (nowTick <= _currentTick)
+    {
+        return;
+    }
+
+    // Past a full turn every slot is visited once.
+    uint64_t ticks = (nowTick - _currentTick < _slots.size()) ? nowTick - _currentTick : _slots.size();
+    for (uint64_t tick = nowTick - ticks + 1; tick <= nowTick; tick++)
+    {
+        std::vector<Entry>& slot = _slots[tick % _slots.size()];
+        size_t kept = 0;
+        for (size_t i = 0; i < slot.size(); i++)
+        {
+            if (slot[i].dueMs <= nowMs)
+            {
+                expired->push_back(slot[i].id);
+                _count--;
+            }
+            else
+            {
+                // a later turn of the wheel
+                slot[kept++] = slot[i];
+            }
+        }
+        slot.resize(kept);
+    }
+
+    _currentTick = nowTick;
+}
+
+// A grace period fits in one turn, so expiry rarely waits for a second one.
+static const uint32_t c_expirySlots = 64;
+
+HandleGenerations::HandleGenerations(uint64_t graceMs, uint32_t maxRetiring, uint64_t nowMs) :
+    _expiry((graceMs / c_expirySlots) + 1, c_expirySlots, nowMs),
+    _graceMs(graceMs),
+    _maxRetiring(maxRetiring > 0 ? maxRetiring : 1),
+    _current(0),
+    _lastGeneration(0),
+    _published(0),
+    _acknowledged(0),
+    _expired(0),
+    _evicted(0)
+{
+}
+
+uint64_t HandleGenerations::Publish(uint64_t nowMs, std::vector<uint64_t>* release)
+{
+    if (_current != 0)
+    {
+        _retiring.push_back(_current);
+        _expiry.Schedule(_current, nowMs + _graceMs);
+
+        while (_retiring.size() > _maxRetiring)
+        {
+            release->push_back(_retiring.front());
+            _retiring.pop_front();
+            _evicted++;
+        }
+    }
+
+    _current = ++_lastGeneration;
+    _published++;
+    return _current;
+}
+
+void HandleGenerations::Acknowledge(uint64_t generation, std::vector<uint64_t>* release)
+{
+    if ((generation == 0) || (generation > _lastGeneration))
+    {
+        return;
+    }
+
+    // Retiring generations are in order, only a prefix can be older.
+    while (!_retiring.empty() && (_retiring.front() < generation))
+    {
+        release->push_back(_retiring.front());
+        _retiring.pop_front();
+        _acknowledged++;
+    }
+}
+
+void HandleGenerations::Advance(uint64_t nowMs, std::vector<uint64_t>* release)
+{
+    std::vector<uint64_t> due;
+    _expiry.Advance(nowMs, &due);
+
+    // Entries for generations already released stay in the wheel until
+    // they come due; they are simply not found here.
+    for (uint64_t generation : due)
+    {
+        auto found = std::find(_retiring.begin(), _retiring.end(), generation);
+        if (found != _retiring.end())
+        {
+            _retiring.erase(found);
+            release->push_back(generation);
+            _expired++;
+        }
+    }
+}
+
+void HandleGenerations::Clear(std::vector<uint64_t>* release)
+{
+    release->insert(release->end(), _retiring.begin(), _retiring.end());
+    _retiring.clear();
+    if (_current != 0)
+    {
+        release->push_back(_current);
+        _current = 0;
+    }
+}
+
+void HandleGenerations::GetStats(HandleGenerationStats* stats) const
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+
+    stats->published = _published;
+    stats->acknowledged = _acknowledged;
+    stats->expired = _expired;
+    stats->evicted = _evicted;
+    stats->retiring = (uint32_t)_retiring.size();
+}
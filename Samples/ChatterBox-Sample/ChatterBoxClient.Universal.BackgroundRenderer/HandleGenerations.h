@@ -0,0 +1,126 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Only generation numbers and times live here; the caller keeps the handles
+// and closes whatever it is told to release. Time is passed in, in
+// milliseconds, so nothing here reads a clock.
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace ChatterBoxClient { namespace Universal { namespace BackgroundRenderer {
+
+//-----------------------------------------------------------------------------
+// TimerWheel
+//
+// Hashed timer wheel: an entry sits in the slot of the first tick at or
+// after its due time and fires on the first Advance that reaches that
+// tick, so never early and at most one tick late. Entries more than one
+// turn of the wheel away share slots and wait for their turn.
+// Not thread safe.
+//-----------------------------------------------------------------------------
+class TimerWheel
+{
+public:
+    TimerWheel(uint64_t tickMs, uint32_t slotCount, uint64_t nowMs);
+
+    void Schedule(uint64_t id, uint64_t dueMs);
+
+    // Appends the ids due by nowMs, earliest tick first.
+    void Advance(uint64_t nowMs, std::vector<uint64_t>* expired);
+
+    bool IsEmpty() const { return _count == 0; }
+
+private:
+    TimerWheel(const TimerWheel&);
+    TimerWheel& operator=(const TimerWheel&);
+
+    struct Entry
+    {
+        uint64_t id;
+        uint64_t dueMs;
+    };
+
+    std::vector<std::vector<Entry>> _slots;
+    uint64_t _tickMs;
+    uint64_t _currentTick;
+    size_t _count;
+};
+
+struct HandleGenerationStats
+{
+    uint64_t published;
+    uint64_t acknowledged;  // released because the consumer moved past them
+    uint64_t expired;       // released because the grace period ran out
+    uint64_t evicted;       // released early, too many were retiring
+    uint32_t retiring;
+};
+
+//-----------------------------------------------------------------------------
+// HandleGenerations
+//
+// Lifetime of the swap chain handles the renderer hands to the foreground.
+// Every handle gets a new generation when it is published. The one it
+// replaces keeps retiring, still open, until the foreground acknowledges
+// a later generation or the grace period runs out, so a consumer that is
+// still duplicating it never sees it closed. Any number can retire at
+// once, up to maxRetiring; past that the oldest goes first.
+//
+// Each call reports the generations whose handles can now be closed.
+// Not thread safe.
+//-----------------------------------------------------------------------------
+class HandleGenerations
+{
+public:
+    HandleGenerations(uint64_t graceMs, uint32_t maxRetiring, uint64_t nowMs);
+
+    // Makes a new generation current and returns it; the previous one, if
+    // any, starts retiring.
+    uint64_t Publish(uint64_t nowMs, std::vector<uint64_t>* release);
+
+    // 0 until the first Publish, and after Clear.
+    uint64_t Current() const { return _current; }
+
+    // The consumer has switched to generation; everything retiring before
+    // it is released. Unknown generations are ignored.
+    void Acknowledge(uint64_t generation, std::vector<uint64_t>* release);
+
+    // Releases the generations whose grace period is over.
+    void Advance(uint64_t nowMs, std::vector<uint64_t>* release);
+
+    // Releases everything, the current generation included.
+    void Clear(std::vector<uint64_t>* release);
+
+    bool IsRetiring() const { return !_retiring.empty(); }
+
+    void GetStats(HandleGenerationStats* stats) const;
+
+private:
+    HandleGenerations(const HandleGenerations&);
+    HandleGenerations& operator=(const HandleGenerations&);
+
+    TimerWheel _expiry;
+    std::deque<uint64_t> _retiring;     // oldest first
+    uint64_t _graceMs;
+    uint32_t _maxRetiring;
+    uint64_t _current;
+    uint64_t _lastGeneration;
+
+    uint64_t _published;
+    uint64_t _acknowledged;
+    uint64_t _expired;
+    uint64_t _evicted;
+};
+
+}}}
@@ -0,0 +1,47 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <windows.h>
+#include <inspectable.h>
+#include <wrl\client.h>
+
+#include "ResolveMetrics.h"
+#include "SourceRegistry.h"
+
+namespace ChatterBoxClient { namespace Universal { namespace BackgroundRenderer {
+
+using MEDIA::ResolveMetrics;
+using MEDIA::SourceRegistry;
+
+typedef SourceRegistry<Microsoft::WRL::ComPtr<IInspectable>> MediaSourceRegistry;
+
+// Sources the media engine never asked for are released after this.
+const uint64_t c_mediaSourceTimeToLiveMs = 30000;
+
+// The renderers register their sources here and the scheme handler takes
+// them, both in this DLL, so every renderer's source stays put until its
+// own URL is resolved. Never destroyed, like the trace recorder.
+inline MediaSourceRegistry& MediaSources()
+{
+    static MediaSourceRegistry* s_sources = new MediaSourceRegistry(c_mediaSourceTimeToLiveMs);
+    return *s_sources;
+}
+
+// How the scheme handler's requests for those sources ended.
+inline ResolveMetrics& SourceResolveMetrics()
+{
+    static ResolveMetrics* s_metrics = new ResolveMetrics();
+    return *s_metrics;
+}
+
+}}}
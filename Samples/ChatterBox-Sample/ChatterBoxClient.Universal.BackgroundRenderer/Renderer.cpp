@@ -12,10 +12,15 @@
 #include <mfapi.h>
 #include <mfidl.h>
 #include <DXGI.h>
+#include <memory>
 #include "Renderer.h"
 #include "MediaEngineNotify.h"
+#include "MediaSourceRegistry.h"
+#include "TraceSpans.h"
+#include "WarmPool.h"
 
 using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+using namespace MEDIA;
 using namespace Platform;
 using Microsoft::WRL::Wrappers::HStringReference;
 using Microsoft::WRL::ComPtr;
@@ -23,13 +28,111 @@ using Microsoft::WRL::Details::Make;
 using ABI::Windows::Foundation::Collections::IMap;
 using ABI::Windows::Foundation::Collections::IPropertySet;
 
+namespace ChatterBoxClient { namespace Universal { namespace BackgroundRenderer {
+
+// D3D device, context and DXGI manager shared by every renderer.
+struct SharedDevice
+{
+  ComPtr<ID3D11Device> device;
+  ComPtr<ID3D11DeviceContext> context;
+  ComPtr<IMFDXGIDeviceManager> manager;
+};
+
+class SharedDeviceFactory : public IDeviceFactory
+{
+public:
+  SharedDeviceFactory() : _lastError(S_OK) {}
+  virtual void* Create(const DeviceKey& key) override;
+  virtual void Destroy(void* device) override;
+  HRESULT LastError() const { return _lastError; }
+private:
+  HRESULT _lastError;
+};
+
+// Everything SetupRenderer needs before it can set a source: the scheme
+// handler registration and a media engine on the shared device.
+struct RendererEngine
+{
+  RendererEngine() : sharedDevice(nullptr), mirrorWorkaround(false) {}
+  ComPtr<ABI::Windows::Media::IMediaExtensionManager> extensionManager;
+  ComPtr<IMap<HSTRING, IInspectable*>> properties;
+  SharedDevice* sharedDevice;
+  // The broker client holding sharedDevice, one per engine.
+  std::string deviceClient;
+  ComPtr<MediaEngineNotify> notify;
+  ComPtr<IMFMediaEngine> mediaEngine;
+  ComPtr<IMFMediaEngineEx> mediaEngineEx;
+  bool mirrorWorkaround;
+};
+
+// Builds engines for the pool on its own thread.
+class RendererEngineFactory : public IWarmPoolFactory
+{
+public:
+  virtual void* Create() override;
+  virtual void Destroy(void* engine) override;
+  virtual void OnThreadStart() override;
+  virtual void OnThreadStop() override;
+};
+
+// Hands media engine events from the loop thread to the renderer. Holds
+// the renderer only while the loop runs, from SetupRenderer to Teardown.
+class RendererEventHandler : public IEventHandler
+{
+public:
+  virtual void OnEvent(const QueuedEvent& event) override;
+  virtual void OnThreadStart() override;
+  virtual void OnThreadStop() override;
+  Renderer^ renderer;
+};
+
+}}}
+
+static SharedDeviceFactory s_deviceFactory;
+static DeviceBroker s_deviceBroker(&s_deviceFactory);
+static RendererEngineFactory s_engineFactory;
+
+// Keeps the foreground process open between swap chain handles.
+static const uint32_t c_idleHandleProcesses = 2;
+static Win32HandleTransport s_handleTransport;
+static HandleBroker s_handleBroker(&s_handleTransport, c_idleHandleProcesses);
+static volatile LONG64 s_lastHandleOwner = 0;
+static volatile LONG64 s_lastEngine = 0;
+
+static const uint32_t c_defaultEnginePoolSize = 1;
+
+static RendererEngine* CreateEngine();
+static void DestroyEngine(RendererEngine* engine);
+static bool TestForSkylakeDisplayAdapter();
+
+// Leaked on purpose, so its thread is never joined while the DLL unloads.
+static WarmPool& EnginePool()
+{
+  static WarmPool* pool = new WarmPool(&s_engineFactory, c_defaultEnginePoolSize);
+  return *pool;
+}
+
 Renderer::Renderer() :
     _foregroundProcessId(0),
-    _staleHandleTimestamp(0LL),
-    _foregroundProcessIdChange(0),
-    _newforegroundProcessId(0)
+    _swapChainHandle(INVALID_HANDLE_VALUE),
+    _remoteSwapChainHandle(INVALID_HANDLE_VALUE),
+    _handleOwner((uint64_t)InterlockedIncrement64(&s_lastHandleOwner)),
+    _handleGenerations(StaleHandleTimeoutMS, MaxRetiredHandles, GetTickCount64()),
+    _mailboxMapping(nullptr),
+    _mailboxView(nullptr),
+    _sharedDevice(nullptr),
+    _firstFramePending(false),
+    _engineFromPool(false),
+    _appliedConfigVersion(0),
+    _mirrored(false),
+    _mirrorWorkaround(false),
+    _scaleRequests(0)
 {
     InitializeCriticalSection(&_lock);
+    _eventHandler.reset(new RendererEventHandler());
+    _eventLoop.reset(new EventLoop(_eventHandler.get()));
+    // Have an engine ready for the next call; no-op once running.
+    EnginePool().Start();
 }
 
 Renderer::~Renderer()
@@ -41,20 +144,15 @@ Renderer::~Renderer()
 
 void Renderer::Teardown() {
   OutputDebugString(L"Renderer::Teardown()\n");
-  if (_dx11DeviceContext != nullptr)
-  {
-      // End pipeline
-      _dx11DeviceContext->ClearState();
-  }
-  if (_device != nullptr)
-  {
-      ComPtr<IDXGIDevice3> dxDevice;
-      if (SUCCEEDED(_device.As(&dxDevice)))
-      {
-          // Release all temporary buffers allocated for the app
-          dxDevice->Trim();
-      }
-  }
+  // First, so nothing below can still post a format to a mailbox that the
+  // next renderer may already be opening.
+  CloseFrameFormatMailbox();
+  // Stop handling events before the engine goes away under the handler;
+  // whatever the engine still reports is dropped.
+  _eventLoop->Stop();
+  _eventHandler->renderer = nullptr;
+  // The device is shared with other renderers, the broker clears and
+  // trims it once the last one is gone.
   if (_mediaEngine != nullptr) {
     OutputDebugString(L"_mediaEngine->Shutdown()\n");
     _mediaEngine->Shutdown();
@@ -63,9 +161,23 @@ void Renderer::Teardown() {
   _mediaEngineEx.Reset();
   _mediaExtensionManager.Reset();
   _extensionManagerProperties.Reset();
-  _device.Reset();
-  _dx11DeviceContext.Reset();
-  _swapChainHandle.Close();
+  ReleaseDXDevice();
+  EnterCriticalSection(&_lock);
+  if (_handleExpiryTimer != nullptr)
+  {
+    _handleExpiryTimer->Cancel();
+    _handleExpiryTimer = nullptr;
+  }
+  std::vector<uint64_t> released;
+  _handleGenerations.Clear(&released);
+  ReleaseSwapChainHandles(released);
+  if (_swapChainHandle != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(_swapChainHandle);
+    _swapChainHandle = INVALID_HANDLE_VALUE;
+  }
+  _remoteSwapChainHandle = INVALID_HANDLE_VALUE;
+  LeaveCriticalSection(&_lock);
 
   _streamSource = nullptr;
 }
@@ -77,13 +189,37 @@ bool Renderer::IsInitialized::get() {
 void Renderer::SetupRenderer(uint32 foregroundProcessId, Windows::Media::Core::IMediaSource^ streamSource,
     Windows::Foundation::Size videoControlSize)
 {
+    ME_TRACE_SPAN("Renderer::SetupRenderer");
     OutputDebugString(L"Renderer::SetupRenderer\n");
-    _renderControlSize = videoControlSize;
+    _setupStarted = std::chrono::steady_clock::now();
     _streamSource = streamSource;
     _foregroundProcessId = foregroundProcessId;
-    SetupSchemeHandler();
-    SetupDirectX();
-    boolean replaced;
+    RenderConfig config = BeginConfigUpdate();
+    config.controlWidth = videoControlSize.Width;
+    config.controlHeight = videoControlSize.Height;
+    if (config.foregroundProcessId == 0)
+    {
+      // An UpdateForegroundProcessId that came first still wins.
+      config.foregroundProcessId = foregroundProcessId;
+    }
+    EndConfigUpdate(config);
+    // Events start as soon as the engine has this renderer as its callback.
+    if (_eventHandler->renderer == nullptr)
+    {
+      _eventHandler->renderer = this;
+      _eventLoop->Start();
+    }
+    if (_mediaEngine == nullptr)
+    {
+      // Only build the engine here when the pool has none ready.
+      RendererEngine* engine = static_cast<RendererEngine*>(EnginePool().Acquire());
+      _engineFromPool = (engine != nullptr);
+      if (engine == nullptr)
+      {
+        engine = CreateEngine();
+      }
+      AdoptEngine(engine);
+    }
     auto streamInspect = reinterpret_cast<IInspectable*>(streamSource);
     // Create a random URL that we'll use to map to the media source.
     std::wstring url(L"webrtc://");
@@ -95,11 +231,12 @@ void Renderer::SetupRenderer(uint32 foregroundProcessId, Windows::Media::Core::I
     }
     Guid gd(result);
     url += gd.ToString()->Data();
-    // Insert the url and the media source in the map.
-    hr = _extensionManagerProperties->Insert(HStringReference(url.c_str()).Get(), streamInspect, &replaced);
-    if (FAILED(hr))
+    // Register the media source under the url; the scheme handler takes it
+    // once, leaving the sources of other renderers alone.
+    if (!MediaSources().Register(url, ComPtr<IInspectable>(streamInspect), GetTickCount64()))
     {
-      throw ref new COMException(hr, ref new String(L"Failed to insert a media stream into media properties"));
+      throw ref new COMException(HRESULT_FROM_WIN32(ERROR_ALREADY_EXISTS),
+        ref new String(L"Failed to register a media stream with the source registry"));
     }
     // Set the source URL on the media engine.
     // The scheme handler will find the media source for the given URL and
@@ -113,6 +250,7 @@ void Renderer::SetupRenderer(uint32 foregroundProcessId, Windows::Media::Core::I
       throw ref new COMException(hr, ref new String(L"Failed to set media source"));
     }
     // Finally, trigger a load on the media engine.
+    _firstFramePending = true;
     hr = _mediaEngine->Load();
     if (FAILED(hr))
     {
@@ -122,18 +260,50 @@ void Renderer::SetupRenderer(uint32 foregroundProcessId, Windows::Media::Core::I
 
 void Renderer::SetRenderControlSize(Windows::Foundation::Size size)
 {
-    EnterCriticalSection(&_lock);
-    _renderControlSize = size;
+    RenderConfig config = BeginConfigUpdate();
+    config.controlWidth = size.Width;
+    config.controlHeight = size.Height;
+    EndConfigUpdate(config);
+    AsyncRecalculateScale();
+}
+
+void Renderer::SetVideoScaling(VideoScaling scaling)
+{
+    RenderConfig config = BeginConfigUpdate();
+    config.scaleMode = (VideoScaleMode)scaling;
+    EndConfigUpdate(config);
     AsyncRecalculateScale();
-    LeaveCriticalSection(&_lock);
+}
+
+void Renderer::SetMirrorMode(bool mirror)
+{
+    // Applied on the event loop thread at the next engine event.
+    RenderConfig config = BeginConfigUpdate();
+    config.mirror = mirror;
+    EndConfigUpdate(config);
 }
 
 void Renderer::UpdateForegroundProcessId(uint32 foregroundProcessId)
+{
+    RenderConfig config = BeginConfigUpdate();
+    config.foregroundProcessId = foregroundProcessId;
+    EndConfigUpdate(config);
+}
+
+// Writers read-modify-write the snapshot under _lock, so they never lose
+// each other's fields; readers go through _config alone.
+RenderConfig Renderer::BeginConfigUpdate()
 {
     EnterCriticalSection(&_lock);
-    _newforegroundProcessId = foregroundProcessId;
+    RenderConfig config;
+    _config.Read(&config);
+    return config;
+}
+
+void Renderer::EndConfigUpdate(const RenderConfig& config)
+{
+    _config.Write(config);
     LeaveCriticalSection(&_lock);
-    InterlockedIncrement(&_foregroundProcessIdChange);
 }
 
 uint32 Renderer::GetProcessId()
@@ -141,15 +311,127 @@ uint32 Renderer::GetProcessId()
     return ::GetCurrentProcessId();
 }
 
-bool Renderer::GetRenderFormat(int64* swapChainHandle, uint32* width, uint32* height, uint32* foregroundProcessId)
+void Renderer::StartTrace()
+{
+    TraceRecorder::Instance().Start();
+}
+
+void Renderer::StopTrace()
+{
+    TraceRecorder::Instance().Stop();
+}
+
+void Renderer::GetSourceResolveStats(uint64* resolved, uint64* failed, uint64* cancelled, uint64* timedOut,
+  uint64* latencyP50, uint64* latencyP99)
+{
+    ResolveStats stats;
+    SourceResolveMetrics().GetStats(&stats);
+    *resolved = stats.resolved;
+    *failed = stats.failed;
+    *cancelled = stats.cancelled;
+    *timedOut = stats.timedOut;
+    *latencyP50 = stats.latency.p50;
+    *latencyP99 = stats.latency.p99;
+}
+
+void Renderer::SetEnginePoolSize(uint32 size)
+{
+    EnginePool().SetTarget(size);
+}
+
+void Renderer::GetEnginePoolStats(uint32* ready, uint64* hits, uint64* misses,
+  uint64* warmFirstFrameP50, uint64* warmFirstFrameP99,
+  uint64* coldFirstFrameP50, uint64* coldFirstFrameP99)
+{
+    WarmPoolStats stats;
+    EnginePool().GetStats(&stats);
+    *ready = stats.ready;
+    *hits = stats.hits;
+    *misses = stats.misses;
+    *warmFirstFrameP50 = stats.firstFrameWarm.p50;
+    *warmFirstFrameP99 = stats.firstFrameWarm.p99;
+    *coldFirstFrameP50 = stats.firstFrameCold.p50;
+    *coldFirstFrameP99 = stats.firstFrameCold.p99;
+}
+
+String^ Renderer::GetTraceJson()
+{
+    std::string json = TraceRecorder::Instance().ExportJson();
+    int length = MultiByteToWideChar(CP_UTF8, 0, json.c_str(), (int)json.size(), nullptr, 0);
+    if (length <= 0)
+    {
+        return ref new String();
+    }
+
+    std::wstring text(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, json.c_str(), (int)json.size(), &text[0], length);
+    return ref new String(text.c_str(), (unsigned int)text.size());
+}
+
+bool Renderer::OpenFrameFormatMailbox(String^ name)
+{
+    if (name == nullptr)
+    {
+        return false;
+    }
+    EnterCriticalSection(&_lock);
+    DetachFrameFormatMailbox();
+    // Opens the mapping instead if the panel, or an earlier renderer, made
+    // it first; named objects are shared within the app's package.
+    _mailboxMapping = CreateFileMappingFromApp(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        FrameFormatMailbox::c_size, name->Data());
+    if (_mailboxMapping != nullptr)
+    {
+        _mailboxView = MapViewOfFileFromApp(_mailboxMapping, FILE_MAP_READ | FILE_MAP_WRITE, 0,
+            FrameFormatMailbox::c_size);
+    }
+    bool attached = _mailbox.AttachWriter(_mailboxView, FrameFormatMailbox::c_size);
+    if (!attached)
+    {
+        OutputDebugString(L"Failed to open the frame format mailbox\n");
+        DetachFrameFormatMailbox();
+    }
+    LeaveCriticalSection(&_lock);
+    return attached;
+}
+
+void Renderer::CloseFrameFormatMailbox()
+{
+    EnterCriticalSection(&_lock);
+    DetachFrameFormatMailbox();
+    LeaveCriticalSection(&_lock);
+}
+
+// Called with _lock held.
+void Renderer::DetachFrameFormatMailbox()
+{
+    _mailbox.Detach();
+    if (_mailboxView != nullptr)
+    {
+        UnmapViewOfFile(_mailboxView);
+        _mailboxView = nullptr;
+    }
+    if (_mailboxMapping != nullptr)
+    {
+        CloseHandle(_mailboxMapping);
+        _mailboxMapping = nullptr;
+    }
+}
+
+bool Renderer::GetRenderFormat(int64* swapChainHandle, uint32* width, uint32* height, uint32* foregroundProcessId,
+    uint64* generation)
 {
-    if (_swapChainHandle.GetRemoteHandle() == INVALID_HANDLE_VALUE ||
-        swapChainHandle == nullptr || width == nullptr || height == nullptr || foregroundProcessId == nullptr)
+    if (_remoteSwapChainHandle == INVALID_HANDLE_VALUE ||
+        swapChainHandle == nullptr || width == nullptr || height == nullptr || foregroundProcessId == nullptr ||
+        generation == nullptr)
     {
         return false;
     }
 
-    *swapChainHandle = (int64)_swapChainHandle.GetRemoteHandle();
+    EnterCriticalSection(&_lock);
+    *swapChainHandle = (int64)_remoteSwapChainHandle;
+    *generation = _handleGenerations.Current();
+    LeaveCriticalSection(&_lock);
     
     DWORD w, h;
     _mediaEngine->GetNativeVideoSize(&w, &h);
@@ -159,48 +441,96 @@ bool Renderer::GetRenderFormat(int64* swapChainHandle, uint32* width, uint32* he
     return true;
 }
 
+void Renderer::GetHandleBrokerStats(uint64* processOpens, uint64* processHits, uint64* sent, uint64* failed,
+  uint32* outstanding)
+{
+    HandleBrokerStats stats;
+    s_handleBroker.GetStats(&stats);
+    *processOpens = stats.processOpens;
+    *processHits = stats.processHits;
+    *sent = stats.sent;
+    *failed = stats.failed;
+    *outstanding = stats.outstanding;
+}
+
+void Renderer::GetEventLoopStats(uint64* posted, uint64* coalesced, uint32* maxDepth,
+  uint64* waitP50, uint64* waitP99, uint64* handlingP50, uint64* handlingP99)
+{
+    EventLoopStats stats;
+    _eventLoop->GetStats(&stats);
+    *posted = stats.posted;
+    *coalesced = stats.coalesced;
+    *maxDepth = stats.maxDepth;
+    *waitP50 = stats.wait.p50;
+    *waitP99 = stats.wait.p99;
+    *handlingP50 = stats.handling.p50;
+    *handlingP99 = stats.handling.p99;
+}
+
 void Renderer::OnMediaEngineEvent(uint32 meEvent, uintptr_t param1, uint32 param2)
+{
+  // Called on the Media Foundation thread, which goes straight back to its
+  // work. A storm of format changes comes down to one new swap chain
+  // handle, and timed checks do not pile up behind a slow one.
+  bool coalesce = (meEvent == MF_MEDIA_ENGINE_EVENT_FORMATCHANGE) ||
+    (meEvent == MF_MEDIA_ENGINE_EVENT_TIMEUPDATE);
+  _eventLoop->Post(meEvent, (uint64_t)param1, param2, coalesce);
+}
+
+void Renderer::HandleMediaEngineEvent(const QueuedEvent& event)
 {
   HANDLE swapChainHandle;
-  switch ((DWORD)meEvent)
+  switch ((DWORD)event.id)
   {
   case MF_MEDIA_ENGINE_EVENT_ERROR:
     // Throw media engine errors so we catch them in the debugger.
-    throw ref new COMException((HRESULT)param2, ref new String(L"Failed OnMediaEngineEvent"));
+    throw ref new COMException((HRESULT)event.param2, ref new String(L"Failed OnMediaEngineEvent"));
     break;
   case MF_MEDIA_ENGINE_EVENT_FORMATCHANGE:
     // When the format changes, get a new swap chain handle and
-    // send it to the foreground process.
-    ReleaseStaleSwapChainHandleWhenExpired();
-    CheckForegroundProcessId();
+    // send it to the foreground process. The engine's current handle, so
+    // one event stands for any that were coalesced into it.
+    ApplyRenderConfig();
     if ((SUCCEEDED(_mediaEngineEx->GetVideoSwapchainHandle(&swapChainHandle))) &&
       (swapChainHandle != nullptr) && (swapChainHandle != INVALID_HANDLE_VALUE))
     {
       SendSwapChainHandle(swapChainHandle);
     }
     break;
+  case MF_MEDIA_ENGINE_EVENT_FIRSTFRAMEREADY:
+    // Time to first frame, kept apart for pooled and freshly built engines.
+    // Up to when the engine reported it, not when it got its turn here.
+    if (_firstFramePending)
+    {
+      _firstFramePending = false;
+      auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        event.posted - _setupStarted);
+      EnginePool().RecordFirstFrame(_engineFromPool, (uint64_t)elapsed.count());
+    }
+    break;
   case MF_MEDIA_ENGINE_EVENT_CANPLAY:
     // Start playing automatically.
     _mediaEngine->Play();
     break;
   case MF_MEDIA_ENGINE_EVENT_TIMEUPDATE:
-    // Various timed checks and cleanups.
-    ReleaseStaleSwapChainHandleWhenExpired();
-    CheckForegroundProcessId();
+    // Various timed checks. Replaced swap chain handles expire on their
+    // own timer, even while the stream is paused.
+    ApplyRenderConfig();
     break;
   }
 }
 
-void Renderer::SetupSchemeHandler()
+static void SetupSchemeHandler(RendererEngine* engine)
 {
   using Windows::Foundation::ActivateInstance;
   // Create a media extension manager.  It's used to register a scheme handler.
-  HRESULT hr = ActivateInstance(HStringReference(RuntimeClass_Windows_Media_MediaExtensionManager).Get(), &_mediaExtensionManager);
+  HRESULT hr = ActivateInstance(HStringReference(RuntimeClass_Windows_Media_MediaExtensionManager).Get(), &engine->extensionManager);
   if (FAILED(hr))
   {
     throw ref new COMException(hr, ref new String(L"Failed to create media extension manager"));
   }
-  // Create an IMap container.  It maps a source URL with an IMediaSource so it can be retrieved by the scheme handler.
+  // Create an IMap container for the scheme handler's settings.  The media sources themselves go
+  // through MediaSources(), keyed by their URL.
   ComPtr<IMap<HSTRING, IInspectable*>> props;
   hr = ActivateInstance(HStringReference(RuntimeClass_Windows_Foundation_Collections_PropertySet).Get(), &props);
   if (FAILED(hr))
@@ -209,20 +539,20 @@ void Renderer::SetupSchemeHandler()
   }
   // Register the scheme handler.  It takes the IMap container so it can be passed to the scheme
   // handler when its invoked with a given source URL.
-  // The SchemeHandler will extract the IMediaSource from the map.
+  // The SchemeHandler will take the IMediaSource from MediaSources().
   ComPtr<IPropertySet> propSet;
   props.As(&propSet);
   HStringReference clsid(L"ChatterBoxClient.Universal.BackgroundRenderer.SchemeHandler");
   HStringReference scheme(L"webrtc:");
-  hr = _mediaExtensionManager->RegisterSchemeHandlerWithSettings(clsid.Get(), scheme.Get(), propSet.Get());
+  hr = engine->extensionManager->RegisterSchemeHandlerWithSettings(clsid.Get(), scheme.Get(), propSet.Get());
   if (FAILED(hr))
   {
     throw ref new COMException(hr, ref new String(L"Failed to to register scheme handler"));
   }
-  _extensionManagerProperties = props;
+  engine->properties = props;
 }
 
-void Renderer::SetupDirectX()
+static void SetupDirectX(RendererEngine* engine)
 {
     HRESULT hr = MFStartup(MF_VERSION);
     if (FAILED(hr))
@@ -230,21 +560,16 @@ void Renderer::SetupDirectX()
         throw ref new COMException(hr, ref new String(L"MFStartup failed"));
     }
 
-    CreateDXDevice();
-    UINT resetToken;
-    // Create a device manager
-    Microsoft::WRL::ComPtr<IMFDXGIDeviceManager> dxGIManager;
-    hr = MFCreateDXGIDeviceManager(&resetToken, &dxGIManager);
-    if (FAILED(hr))
-    {
-      throw ref new COMException(hr, ref new String(L"MFCreateDXGIDeviceManager failed"));
-    }
-    // Pass is the DirectX device created above.
-    hr = dxGIManager->ResetDevice(_device.Get(), resetToken);
-    if (FAILED(hr))
+    // Every renderer in the process shares one device and DXGI manager.
+    DeviceKey key = { 0, D3D11_CREATE_DEVICE_VIDEO_SUPPORT };
+    engine->deviceClient = "RendererEngine" + std::to_string(InterlockedIncrement64(&s_lastEngine));
+    engine->sharedDevice = static_cast<SharedDevice*>(s_deviceBroker.Acquire(key, engine->deviceClient));
+    if (engine->sharedDevice == nullptr)
     {
-      throw ref new COMException(hr, ref new String(L"ResetDevice failed"));
+      throw ref new COMException(s_deviceFactory.LastError(), ref new String(L"Failed to create a DX device"));
     }
+    // The device manager comes with the shared device.
+    Microsoft::WRL::ComPtr<IMFDXGIDeviceManager> dxGIManager = engine->sharedDevice->manager;
     // These attributes will be passed to the media engine created below.
     ComPtr<IMFAttributes> attributes;
     hr = MFCreateAttributes(&attributes, 3);
@@ -258,11 +583,10 @@ void Renderer::SetupDirectX()
     {
       throw ref new COMException(hr, ref new String(L"Failed to set the DXGI manager"));
     }
-    // Set a callback to receive media engine events.
-    ComPtr<MediaEngineNotify> notify;
-    notify = Make<MediaEngineNotify>();
-    notify->SetCallback(this);
-    hr = attributes->SetUnknown(MF_MEDIA_ENGINE_CALLBACK, (IUnknown*)notify.Get());
+    // Set a callback to receive media engine events. The renderer that
+    // adopts the engine hooks itself up to it.
+    engine->notify = Make<MediaEngineNotify>();
+    hr = attributes->SetUnknown(MF_MEDIA_ENGINE_CALLBACK, (IUnknown*)engine->notify.Get());
     if (FAILED(hr))
     {
       throw ref new COMException(hr, ref new String(L"attributes->SetUnknown(MF_MEDIA_ENGINE_CALLBACK, (IUnknown*)notify.Get()) failed"));
@@ -283,7 +607,7 @@ void Renderer::SetupDirectX()
     }
     hr = factory->CreateInstance(
       MF_MEDIA_ENGINE_REAL_TIME_MODE | MF_MEDIA_ENGINE_WAITFORSTABLE_STATE,
-      attributes.Get(), &_mediaEngine);
+      attributes.Get(), &engine->mediaEngine);
     if (FAILED(hr))
     {
       throw ref new COMException(hr, ref new String(L"Failed to create media engine"));
@@ -291,28 +615,145 @@ void Renderer::SetupDirectX()
 
     // Query the IMFMediaEngineEx interface.
     // It contains additional functions used throughout the code.
-    hr = _mediaEngine.As(&_mediaEngineEx);
+    hr = engine->mediaEngine.As(&engine->mediaEngineEx);
     if (FAILED(hr))
     {
       throw ref new COMException(hr, ref new String(L"Failed to create media engineex"));
     }
 
     // This call allows us to get a swap chain HANDLE to pass to the UI.
-    hr = _mediaEngineEx->EnableWindowlessSwapchainMode(TRUE);
+    hr = engine->mediaEngineEx->EnableWindowlessSwapchainMode(TRUE);
     if (FAILED(hr))
     {
       throw ref new COMException(hr, ref new String(L"Failed to enable Windowsless swapchain mode"));
     }
-    _mediaEngineEx->SetRealTimeMode(TRUE);
+    engine->mediaEngineEx->SetRealTimeMode(TRUE);
     // Skylake video adapter has an issue with scaling. Using mirror mode for this device is a workaround.
     if (TestForSkylakeDisplayAdapter())
     {
       OutputDebugString(L"Skylake display adapter detected, switching to mirror mode\n");
-      _mediaEngineEx->EnableHorizontalMirrorMode(TRUE);
+      engine->mediaEngineEx->EnableHorizontalMirrorMode(TRUE);
+      engine->mirrorWorkaround = true;
     }
 }
 
-void Renderer::CreateDXDevice()
+static RendererEngine* CreateEngine()
+{
+  ME_TRACE_SPAN("Renderer::CreateEngine");
+  std::unique_ptr<RendererEngine> engine(new RendererEngine());
+  try
+  {
+    SetupSchemeHandler(engine.get());
+    SetupDirectX(engine.get());
+  }
+  catch (...)
+  {
+    DestroyEngine(engine.release());
+    throw;
+  }
+  return engine.release();
+}
+
+static void DestroyEngine(RendererEngine* engine)
+{
+  std::unique_ptr<RendererEngine> owned(engine);
+  if (engine->mediaEngine != nullptr)
+  {
+    engine->mediaEngine->Shutdown();
+  }
+  if (engine->sharedDevice != nullptr)
+  {
+    s_deviceBroker.Release(engine->sharedDevice, engine->deviceClient);
+  }
+}
+
+void Renderer::AdoptEngine(RendererEngine* engine)
+{
+  std::unique_ptr<RendererEngine> owned(engine);
+  _mediaExtensionManager = engine->extensionManager;
+  _extensionManagerProperties = engine->properties;
+  // The device reference moves to the renderer, ReleaseDXDevice returns it.
+  _sharedDevice = engine->sharedDevice;
+  _deviceClient = engine->deviceClient;
+  _device = _sharedDevice->device;
+  _dx11DeviceContext = _sharedDevice->context;
+  _mediaEngine = engine->mediaEngine;
+  _mediaEngineEx = engine->mediaEngineEx;
+  _mirrorWorkaround = engine->mirrorWorkaround;
+  engine->notify->SetCallback(this);
+}
+
+void* RendererEngineFactory::Create()
+{
+  try
+  {
+    return CreateEngine();
+  }
+  catch (Platform::Exception^)
+  {
+    OutputDebugString(L"Failed to prepare a media engine for the pool\n");
+    return nullptr;
+  }
+  catch (const std::bad_alloc&)
+  {
+    return nullptr;
+  }
+}
+
+void RendererEngineFactory::Destroy(void* engine)
+{
+  DestroyEngine(static_cast<RendererEngine*>(engine));
+}
+
+void RendererEngineFactory::OnThreadStart()
+{
+  // The extension manager and property set are activated on this thread.
+  RoInitialize(RO_INIT_MULTITHREADED);
+}
+
+void RendererEngineFactory::OnThreadStop()
+{
+  RoUninitialize();
+}
+
+void RendererEventHandler::OnEvent(const QueuedEvent& event)
+{
+  try
+  {
+    renderer->HandleMediaEngineEvent(event);
+  }
+  catch (Platform::Exception^ e)
+  {
+    // Nothing above this thread to pass it to.
+    OutputDebugString(L"Failed to handle a media engine event: ");
+    OutputDebugString(e->Message->Data());
+    OutputDebugString(L"\n");
+  }
+}
+
+void RendererEventHandler::OnThreadStart()
+{
+  // RenderFormatUpdate is raised on this thread.
+  RoInitialize(RO_INIT_MULTITHREADED);
+}
+
+void RendererEventHandler::OnThreadStop()
+{
+  RoUninitialize();
+}
+
+void Renderer::ReleaseDXDevice()
+{
+  _device.Reset();
+  _dx11DeviceContext.Reset();
+  if (_sharedDevice != nullptr)
+  {
+    s_deviceBroker.Release(_sharedDevice, _deviceClient);
+    _sharedDevice = nullptr;
+  }
+}
+
+void* SharedDeviceFactory::Create(const DeviceKey& key)
 {
   static const D3D_FEATURE_LEVEL levels[] =
   {
@@ -328,79 +769,162 @@ void Renderer::CreateDXDevice()
   D3D_FEATURE_LEVEL featureLevel;
   HRESULT hr = S_OK;
 
-  // First attempt to use hardware device.
-  hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr,
-    D3D11_CREATE_DEVICE_VIDEO_SUPPORT,
-    levels, ARRAYSIZE(levels), D3D11_SDK_VERSION, &_device, &featureLevel,
-    &_dx11DeviceContext);
-
-  if (SUCCEEDED(hr))
+  ComPtr<IDXGIAdapter1> adapter;
+  if (key.adapterLuid != 0)
   {
-    ComPtr<ID3D10Multithread> multithread;
-    hr = _device.Get()->QueryInterface(IID_PPV_ARGS(&multithread));
-    if (FAILED(hr))
+    ComPtr<IDXGIFactory1> factory;
+    hr = CreateDXGIFactory1(IID_PPV_ARGS(&factory));
+    for (UINT i = 0; SUCCEEDED(hr); i++)
+    {
+      ComPtr<IDXGIAdapter1> candidate;
+      hr = factory->EnumAdapters1(i, &candidate);
+      DXGI_ADAPTER_DESC1 desc;
+      if (SUCCEEDED(hr) && SUCCEEDED(candidate->GetDesc1(&desc)) &&
+        (((uint64_t)desc.AdapterLuid.HighPart << 32) | desc.AdapterLuid.LowPart) == key.adapterLuid)
+      {
+        adapter = candidate;
+        break;
+      }
+    }
+    if (adapter == nullptr)
     {
-      throw ref new COMException(hr, ref new String(L"Failed to set device to multithreaded"));
+      _lastError = DXGI_ERROR_NOT_FOUND;
+      return nullptr;
     }
-    multithread->SetMultithreadProtected(TRUE);
   }
-  else // Fallback to software implementation
+
+  std::unique_ptr<SharedDevice> device(new SharedDevice());
+
+  // First attempt to use hardware device.
+  hr = D3D11CreateDevice(adapter.Get(),
+    (adapter != nullptr) ? D3D_DRIVER_TYPE_UNKNOWN : D3D_DRIVER_TYPE_HARDWARE, nullptr,
+    key.flags,
+    levels, ARRAYSIZE(levels), D3D11_SDK_VERSION, &device->device, &featureLevel,
+    &device->context);
+
+  if (FAILED(hr)) // Fallback to software implementation
   {
     hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr,
-      D3D11_CREATE_DEVICE_VIDEO_SUPPORT, levels, ARRAYSIZE(levels),
-      D3D11_SDK_VERSION, &_device, &featureLevel, &_dx11DeviceContext);
+      key.flags, levels, ARRAYSIZE(levels),
+      D3D11_SDK_VERSION, &device->device, &featureLevel, &device->context);
     if (FAILED(hr))
     {
-      throw ref new COMException(hr, ref new String(L"Failed to create a DX device"));
+      OutputDebugString(L"Failed to create a DX device\n");
+      _lastError = hr;
+      return nullptr;
     }
   }
+
+  // Every renderer's engine uses the device, WARP or not.
+  ComPtr<ID3D10Multithread> multithread;
+  hr = device->device.Get()->QueryInterface(IID_PPV_ARGS(&multithread));
+  if (FAILED(hr))
+  {
+    OutputDebugString(L"Failed to set device to multithreaded\n");
+    _lastError = hr;
+    return nullptr;
+  }
+  multithread->SetMultithreadProtected(TRUE);
+
+  // Create a device manager, shared by all media engines using this device.
+  UINT resetToken;
+  hr = MFCreateDXGIDeviceManager(&resetToken, &device->manager);
+  if (SUCCEEDED(hr))
+  {
+    hr = device->manager->ResetDevice(device->device.Get(), resetToken);
+  }
+  if (FAILED(hr))
+  {
+    OutputDebugString(L"Failed to create the DXGI device manager\n");
+    _lastError = hr;
+    return nullptr;
+  }
+
+  return device.release();
+}
+
+void SharedDeviceFactory::Destroy(void* device)
+{
+  std::unique_ptr<SharedDevice> sharedDevice(static_cast<SharedDevice*>(device));
+  OutputDebugString(L"Releasing the shared DX device\n");
+  if (sharedDevice->context != nullptr)
+  {
+    // End pipeline
+    sharedDevice->context->ClearState();
+  }
+  ComPtr<IDXGIDevice3> dxDevice;
+  if (SUCCEEDED(sharedDevice->device.As(&dxDevice)))
+  {
+    // Release all temporary buffers allocated for the app
+    dxDevice->Trim();
+  }
 }
 
 void Renderer::SendSwapChainHandle(HANDLE swapChain)
 {
+  ME_TRACE_SPAN("Renderer::SendSwapChainHandle");
   // Update the remote swap chain handle.
+  EnterCriticalSection(&_lock);
   if (swapChain != INVALID_HANDLE_VALUE)
   {
-    _swapChainHandle.DetachMove(_staleSwapChainHandle);
-    _staleHandleTimestamp = GetTickCount64();
-    _swapChainHandle.AssignHandle(swapChain, _foregroundProcessId);
+    RetireSwapChainHandle();
+    _swapChainHandle = swapChain;
+    ShareSwapChainHandle();
   }
+  HANDLE remoteHandle = _remoteSwapChainHandle;
+  uint64 generation = _handleGenerations.Current();
+  LeaveCriticalSection(&_lock);
   // Along with the handle, we also send the dimensions of the video.
   DWORD width;
   DWORD height;
   _mediaEngine->GetNativeVideoSize(&width, &height);
 
-  if (_swapChainHandle.GetRemoteHandle() != INVALID_HANDLE_VALUE)
+  if (remoteHandle != INVALID_HANDLE_VALUE)
   {
-    RenderFormatUpdate((int64)_swapChainHandle.GetRemoteHandle(), width, height, _foregroundProcessId);
+    // The panel picks this up on its next frame; the event is the fallback.
+    EnterCriticalSection(&_lock);
+    if (_mailbox.IsAttached())
+    {
+      _mailbox.Post((uint64_t)(uintptr_t)remoteHandle, width, height, _foregroundProcessId, generation);
+    }
+    LeaveCriticalSection(&_lock);
+    RenderFormatUpdate((int64)remoteHandle, width, height, _foregroundProcessId, generation);
   }
   // Save the video dimensions and recalculate the scaling/cropping.
-  Windows::Foundation::Size size;
-  size.Width = (float)width;
-  size.Height = (float)height;
-  EnterCriticalSection(&_lock);
-  _videoSize = size;
+  RenderConfig config = BeginConfigUpdate();
+  config.videoWidth = (float)width;
+  config.videoHeight = (float)height;
+  EndConfigUpdate(config);
   AsyncRecalculateScale();
-  LeaveCriticalSection(&_lock);
 }
 
+// Latest wins: _scaleRequests counts requests the task has not seen yet.
+// Only the call that raises it from 0 starts a task, and that task keeps
+// applying the newest sizes until no request came in while it worked, so
+// a window drag has at most one recalculation in flight.
 void Renderer::AsyncRecalculateScale()
 {
-    EnterCriticalSection(&_lock);
-    Windows::Foundation::Size renderControlSize = _renderControlSize;
-    Windows::Foundation::Size videoSize = _videoSize;
-    LeaveCriticalSection(&_lock);
-    concurrency::create_async([this, renderControlSize, videoSize]
+    if (InterlockedIncrement(&_scaleRequests) != 1)
     {
-        RecalculateScale(renderControlSize, videoSize);
+        return;
+    }
+    concurrency::create_async([this]
+    {
+        LONG handled;
+        do
+        {
+            handled = InterlockedCompareExchange(&_scaleRequests, 0, 0);
+            RenderConfig config;
+            _config.Read(&config);
+            RecalculateScale(config);
+        } while (InterlockedExchangeAdd(&_scaleRequests, -handled) != handled);
     });
 }
 
-void Renderer::RecalculateScale(Windows::Foundation::Size renderControlSize,
-    Windows::Foundation::Size videoSize)
+void Renderer::RecalculateScale(const RenderConfig& config)
 {
-    if ((renderControlSize.Width <= 0.0f) || (renderControlSize.Height <= 0.0f) ||
-        (videoSize.Width <= 0.0f) || (videoSize.Height <= 0.0f))
+    ME_TRACE_SPAN("Renderer::RecalculateScale");
+    if (!CanLayOutVideo(config.controlWidth, config.controlHeight, config.videoWidth, config.videoHeight))
     {
         return;
     }
@@ -409,74 +933,154 @@ void Renderer::RecalculateScale(Windows::Foundation::Size renderControlSize,
         return;
     }
 
-    double videoAspect = double(videoSize.Width) / double(videoSize.Height);
-    double renderControlAspect = double(renderControlSize.Width) / double(renderControlSize.Height);
-    // Scale to fill the swap chain panel.
-    double scalingFactor = (videoAspect > renderControlAspect) ?
-      (double(renderControlSize.Height) / double(videoSize.Height)) :
-      (double(renderControlSize.Width) / double(videoSize.Width));
-    if (scalingFactor == 0.0)
-    {
-      scalingFactor = 0.0001;
-    }
-    int scaledRenderControlWidth = int(double(renderControlSize.Width) / scalingFactor);
-    int scaledRenderControlHeight = int(double(renderControlSize.Height) / scalingFactor);
-    // Amount to crop from the width and height.
-    int cropX = max((int)videoSize.Width - scaledRenderControlWidth, 0);
-    int cropY = max((int)videoSize.Height - scaledRenderControlHeight, 0);
-    // Convert crop to percentage and divide by 2 to share the crop equally
-    // on both edges.  This centers the final image.
-    float cropFrX = float((double(cropX) / double(videoSize.Width)) / 2.0);
-    float cropFrY = float((double(cropY) / double(videoSize.Height)) / 2.0);
-    // The final crop/scale rectangle with values between 0.0 and 1.0.
-    MFVideoNormalizedRect rect = MFVideoNormalizedRect{ cropFrX, cropFrY, 1.0f - cropFrX, 1.0f - cropFrY };
-    RECT r = { 0, 0, (LONG)renderControlSize.Width , (LONG)renderControlSize.Height };
+    VideoLayout layout = ComputeVideoLayout(config.scaleMode,
+      config.controlWidth, config.controlHeight, config.videoWidth, config.videoHeight);
+    // The crop/scale rectangle with values between 0.0 and 1.0.
+    MFVideoNormalizedRect rect = MFVideoNormalizedRect{
+      layout.sourceLeft, layout.sourceTop, layout.sourceRight, layout.sourceBottom };
+    RECT r = { layout.destinationLeft, layout.destinationTop, layout.destinationRight, layout.destinationBottom };
     MFARGB borderColour = { 0, 0, 0, 0xFF };
     _mediaEngineEx->UpdateVideoStream(&rect, &r, &borderColour);
 }
 
-void Renderer::ReleaseStaleSwapChainHandle()
+void Renderer::AcknowledgeSwapChainHandle(uint64 generation)
+{
+    std::vector<uint64_t> released;
+    EnterCriticalSection(&_lock);
+    _handleGenerations.Acknowledge(generation, &released);
+    ReleaseSwapChainHandles(released);
+    LeaveCriticalSection(&_lock);
+}
+
+// Called with _lock held. The current handle moves aside under its
+// generation and a new generation becomes current, for the handle the
+// caller assigns next.
+void Renderer::RetireSwapChainHandle()
 {
-    _staleSwapChainHandle.Close();
-    _staleHandleTimestamp = 0;
+    uint64_t retiring = _handleGenerations.Current();
+    if (retiring != 0)
+    {
+        // The duplicate stays with the broker under the same generation.
+        _retiredSwapChainHandles[retiring] = _swapChainHandle;
+    }
+    else if (_swapChainHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(_swapChainHandle);
+    }
+    _swapChainHandle = INVALID_HANDLE_VALUE;
+    _remoteSwapChainHandle = INVALID_HANDLE_VALUE;
+
+    std::vector<uint64_t> released;
+    _handleGenerations.Publish(GetTickCount64(), &released);
+    ReleaseSwapChainHandles(released);
+    ArmHandleExpiryTimer();
+}
+
+// Called with _lock held. Shares the local handle with the foreground
+// process under the current generation.
+void Renderer::ShareSwapChainHandle()
+{
+    _remoteSwapChainHandle = INVALID_HANDLE_VALUE;
+    if (_swapChainHandle == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+    uint64_t remote = s_handleBroker.Share(_handleOwner, _handleGenerations.Current(),
+        Win32HandleTransport::FromHandle(_swapChainHandle), _foregroundProcessId);
+    _remoteSwapChainHandle = Win32HandleTransport::ToHandle(remote);
 }
 
-void Renderer::ReleaseStaleSwapChainHandleWhenExpired()
+// Called with _lock held.
+void Renderer::ReleaseSwapChainHandles(const std::vector<uint64_t>& generations)
 {
-    if (!_staleSwapChainHandle.IsValid())
+    if (generations.empty())
     {
         return;
     }
-    ULONGLONG currentTime = GetTickCount64();
-    if ((currentTime - _staleHandleTimestamp) >= StaleHandleTimeoutMS)
+    for (uint64_t generation : generations)
     {
-        ReleaseStaleSwapChainHandle();
+        auto retired = _retiredSwapChainHandles.find(generation);
+        if (retired != _retiredSwapChainHandles.end())
+        {
+            if (retired->second != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(retired->second);
+            }
+            _retiredSwapChainHandles.erase(retired);
+        }
     }
+    // The foreground's duplicates, one batch per process.
+    s_handleBroker.Release(_handleOwner, generations.data(), generations.size());
 }
 
-void Renderer::CheckForegroundProcessId()
+void Renderer::ExpireSwapChainHandles()
 {
-  if (_foregroundProcessIdChange > 0)
-  {
+    std::vector<uint64_t> released;
     EnterCriticalSection(&_lock);
-    uint32 newForegroundProcessId = _newforegroundProcessId;
+    _handleExpiryTimer = nullptr;
+    // Acknowledgements through the mailbox do not wait for the app service.
+    uint64_t acknowledged;
+    if (_mailbox.IsAttached() && _mailbox.TakeAcknowledged(&acknowledged))
+    {
+        _handleGenerations.Acknowledge(acknowledged, &released);
+    }
+    _handleGenerations.Advance(GetTickCount64(), &released);
+    ReleaseSwapChainHandles(released);
+    ArmHandleExpiryTimer();
     LeaveCriticalSection(&_lock);
-    InterlockedDecrement(&_foregroundProcessIdChange);
-    if (newForegroundProcessId == _foregroundProcessId)
-    {
-      return;
-    }
-    _foregroundProcessId = newForegroundProcessId;
-    HANDLE swapChainHandle = _swapChainHandle.DetachLocalHandle();
-    ReleaseStaleSwapChainHandle();
-    _swapChainHandle.DetachMove(_staleSwapChainHandle);
-    _staleHandleTimestamp = GetTickCount64();
-    _swapChainHandle.AssignHandle(swapChainHandle, _foregroundProcessId);
-    SendSwapChainHandle(INVALID_HANDLE_VALUE);
+}
+
+// Called with _lock held. One timer at a time, and only while some handle
+// is waiting to expire.
+void Renderer::ArmHandleExpiryTimer()
+{
+    if ((_handleExpiryTimer != nullptr) || !_handleGenerations.IsRetiring())
+    {
+        return;
+    }
+
+    Windows::Foundation::TimeSpan delay;
+    delay.Duration = HandleExpiryTickMS * 10000LL;
+    _handleExpiryTimer = Windows::System::Threading::ThreadPoolTimer::CreateTimer(
+      ref new Windows::System::Threading::TimerElapsedHandler([this](Windows::System::Threading::ThreadPoolTimer^)
+      {
+        ExpireSwapChainHandles();
+      }), delay);
+}
+
+// Event loop thread. Costs one atomic load unless the UI side changed
+// something since the last event.
+void Renderer::ApplyRenderConfig()
+{
+  RenderConfig config;
+  if (!_config.ReadIfChanged(&_appliedConfigVersion, &config))
+  {
+    return;
+  }
+  if (config.mirror != _mirrored)
+  {
+    _mirrored = config.mirror;
+    // The Skylake workaround keeps mirror mode on either way.
+    _mediaEngineEx->EnableHorizontalMirrorMode((_mirrored || _mirrorWorkaround) ? TRUE : FALSE);
   }
+  if ((config.foregroundProcessId == 0) || (config.foregroundProcessId == _foregroundProcessId))
+  {
+    return;
+  }
+  _foregroundProcessId = config.foregroundProcessId;
+  // The old process keeps its duplicate until it expires; the local
+  // handle stays and is duplicated into the new process.
+  EnterCriticalSection(&_lock);
+  HANDLE swapChainHandle = _swapChainHandle;
+  _swapChainHandle = INVALID_HANDLE_VALUE;
+  RetireSwapChainHandle();
+  _swapChainHandle = swapChainHandle;
+  ShareSwapChainHandle();
+  LeaveCriticalSection(&_lock);
+  SendSwapChainHandle(INVALID_HANDLE_VALUE);
 }
 
-bool Renderer::TestForSkylakeDisplayAdapter()
+static bool TestForSkylakeDisplayAdapter()
 {
     ComPtr<IDXGIFactory> factory;
     if (FAILED(CreateDXGIFactory1(__uuidof(IDXGIFactory), (void**)factory.GetAddressOf())))
@@ -11,7 +11,13 @@
 
 #pragma once
 #include "MediaEngineNotifyCallback.h"
-#include "RemoteHandle.h"
+#include "Win32HandleTransport.h"
+#include "DeviceBroker.h"
+#include "VideoLayout.h"
+#include "HandleGenerations.h"
+#include "SeqLock.h"
+#include "EventLoop.h"
+#include "FrameFormatMailbox.h"
 #include <collection.h>
 #include <ppltasks.h>
 #include <d3d11_2.h>
@@ -27,10 +33,39 @@
 #include <windows.media.mediaproperties.h>
 #include <Mfmediaengine.h>
 #include <wrl\wrappers\corewrappers.h>
+#include <chrono>
+#include <map>
+#include <memory>
 
 namespace ChatterBoxClient { namespace Universal { namespace BackgroundRenderer {
 
-public delegate void RenderFormatUpdateHandler(int64 swapChainHandle, uint32 width, uint32 height, uint32 foregroundProcessId);
+struct SharedDevice;
+struct RendererEngine;
+class RendererEventHandler;
+
+// Everything the UI side sets that the event loop thread acts on,
+// published as one snapshot.
+struct RenderConfig
+{
+    uint32_t foregroundProcessId;
+    float controlWidth;
+    float controlHeight;
+    float videoWidth;
+    float videoHeight;
+    VideoScaleMode scaleMode;
+    bool mirror;
+};
+
+/// How the video is placed in the render control.
+public enum class VideoScaling
+{
+    Fill = VideoScaleMode_Fill,       // cover the control, cropping the video
+    Fit = VideoScaleMode_Fit,         // show the whole video with bars
+    Stretch = VideoScaleMode_Stretch  // cover the control, ignoring the aspect ratio
+};
+
+public delegate void RenderFormatUpdateHandler(int64 swapChainHandle, uint32 width, uint32 height, uint32 foregroundProcessId,
+    uint64 generation);
 
 [Windows::Foundation::Metadata::WebHostHidden]
 public ref class Renderer sealed :
@@ -56,50 +91,141 @@ public:
     /// Should be called whenever the swap chain panel is resized.
     void SetRenderControlSize(Windows::Foundation::Size size);
 
+    /// Fill by default.
+    void SetVideoScaling(VideoScaling scaling);
+
+    /// Mirrors the video horizontally, e.g. for a self view. Off by default.
+    void SetMirrorMode(bool mirror);
+
     void UpdateForegroundProcessId(uint32 foregroundProcessId);
     static uint32 GetProcessId();
 
+    /// Span tracing of the render path for this process. StartTrace
+    /// discards the previous capture; GetTraceJson returns it as Chrome
+    /// trace-event JSON, which Perfetto opens directly.
+    static void StartTrace();
+    static void StopTrace();
+    static Platform::String^ GetTraceJson();
+
+    /// How the scheme handler's requests for media sources ended in this
+    /// process; latencies of resolved requests are in microseconds.
+    static void GetSourceResolveStats(uint64* resolved, uint64* failed, uint64* cancelled, uint64* timedOut,
+      uint64* latencyP50, uint64* latencyP99);
+
+    /// Renderers take their media engine from a pool kept ready in the
+    /// background, so a call does not wait for it to be built. 0 turns the
+    /// pool off; it holds one engine by default.
+    static void SetEnginePoolSize(uint32 size);
+
+    /// Pool usage, and time from SetupRenderer to the first frame in
+    /// microseconds for renderers with a pooled engine (warm) and with one
+    /// built on demand (cold).
+    static void GetEnginePoolStats(uint32* ready, uint64* hits, uint64* misses,
+      uint64* warmFirstFrameP50, uint64* warmFirstFrameP99,
+      uint64* coldFirstFrameP50, uint64* coldFirstFrameP99);
+
+    /// Swap chain handles shared with foreground processes by all
+    /// renderers: process opens and reuses, handles duplicated and failed,
+    /// and duplicates still open in a foreground process.
+    static void GetHandleBrokerStats(uint64* processOpens, uint64* processHits, uint64* sent, uint64* failed,
+      uint32* outstanding);
+
     property bool IsInitialized
     {
       bool get();
     }
 
-    bool GetRenderFormat(int64* swapChainHandle, uint32* width, uint32* height, uint32* foregroundProcessId);
+    /// Also publishes render formats in shared memory under this name,
+    /// where a WebRTCSwapChainPanel with the same FrameFormatMailboxName
+    /// picks them up on its next frame and acknowledges them.
+    /// RenderFormatUpdate is still raised as the fallback. False if the
+    /// shared memory is not available.
+    bool OpenFrameFormatMailbox(Platform::String^ name);
+
+    /// Stops publishing to the mailbox. Mailbox names are shared, so a
+    /// renderer being replaced closes its mailbox before the next one
+    /// opens the same name; otherwise both would write to it.
+    void CloseFrameFormatMailbox();
+
+    bool GetRenderFormat(int64* swapChainHandle, uint32* width, uint32* height, uint32* foregroundProcessId,
+      uint64* generation);
     event RenderFormatUpdateHandler^ RenderFormatUpdate;
 
+    /// Media engine events are handled on a thread of this renderer's own.
+    /// How many were posted, how many a storm of format changes collapsed,
+    /// the deepest the queue got, and in microseconds how long events
+    /// waited and how long handling them took.
+    void GetEventLoopStats(uint64* posted, uint64* coalesced, uint32* maxDepth,
+      uint64* waitP50, uint64* waitP99, uint64* handlingP50, uint64* handlingP99);
+
+    /// The foreground has switched to the swap chain handle of the given
+    /// generation, as sent with RenderFormatUpdate. Older handles are
+    /// closed now; without this they stay open for a grace period.
+    void AcknowledgeSwapChainHandle(uint64 generation);
+
     // Implement MediaEngineNotifyCallback
     virtual void OnMediaEngineEvent(uint32 meEvent, uintptr_t param1, uint32 param2);
+internal:
+    // On the event loop thread.
+    void HandleMediaEngineEvent(const QueuedEvent& event);
 private:
-    void SetupSchemeHandler();
-    void SetupDirectX();
-    void CreateDXDevice();
+    void AdoptEngine(RendererEngine* engine);
+    void ReleaseDXDevice();
     void SendSwapChainHandle(HANDLE swapChain);
     void AsyncRecalculateScale();
-    void RecalculateScale(Windows::Foundation::Size renderControlSize,
-        Windows::Foundation::Size videoSize);
-    void ReleaseStaleSwapChainHandle();
-    void ReleaseStaleSwapChainHandleWhenExpired();
-    void CheckForegroundProcessId();
-    static bool TestForSkylakeDisplayAdapter();
+    void RecalculateScale(const RenderConfig& config);
+    void RetireSwapChainHandle();
+    void ShareSwapChainHandle();
+    void ReleaseSwapChainHandles(const std::vector<uint64_t>& generations);
+    void ExpireSwapChainHandles();
+    void ArmHandleExpiryTimer();
+    void ApplyRenderConfig();
+    void DetachFrameFormatMailbox();
+    RenderConfig BeginConfigUpdate();
+    void EndConfigUpdate(const RenderConfig& config);
 
     Microsoft::WRL::ComPtr<ABI::Windows::Media::IMediaExtensionManager> _mediaExtensionManager;
     Microsoft::WRL::ComPtr<ABI::Windows::Foundation::Collections::IMap<HSTRING, IInspectable*>> _extensionManagerProperties;
+    SharedDevice* _sharedDevice;
+    // Taken over from the engine, so each renderer is its own broker client.
+    std::string _deviceClient;
     Microsoft::WRL::ComPtr<ID3D11Device> _device;
     Microsoft::WRL::ComPtr<ID3D11DeviceContext> _dx11DeviceContext;
     Microsoft::WRL::ComPtr<IMFMediaEngine> _mediaEngine;
     Microsoft::WRL::ComPtr<IMFMediaEngineEx> _mediaEngineEx;
     DWORD _foregroundProcessId;
-    RemoteHandle _swapChainHandle;
-    RemoteHandle _staleSwapChainHandle;
-    ULONGLONG _staleHandleTimestamp;
+    // The local handle is ours; its duplicate in the foreground belongs to
+    // the handle broker, under _handleOwner and the handle's generation.
+    HANDLE _swapChainHandle;
+    HANDLE _remoteSwapChainHandle;
+    uint64_t _handleOwner;
+    HandleGenerations _handleGenerations;
+    std::map<uint64_t, HANDLE> _retiredSwapChainHandles;
+    Windows::System::Threading::ThreadPoolTimer^ _handleExpiryTimer;
+    // Under _lock.
+    HANDLE _mailboxMapping;
+    void* _mailboxView;
+    FrameFormatMailbox _mailbox;
     Windows::Media::Core::IMediaSource^ _streamSource;
-    Windows::Foundation::Size _renderControlSize;
-    Windows::Foundation::Size _videoSize;
+    // Written under _lock, read without it. Only the event loop thread
+    // touches the applied version and mirror state.
+    SeqLock<RenderConfig> _config;
+    uint64_t _appliedConfigVersion;
+    bool _mirrored;
+    bool _mirrorWorkaround;
+    LONG _scaleRequests;
+    std::unique_ptr<RendererEventHandler> _eventHandler;
+    std::unique_ptr<EventLoop> _eventLoop;
     CRITICAL_SECTION _lock;
-    LONG _foregroundProcessIdChange;
-    uint32 _newforegroundProcessId;
+    std::chrono::steady_clock::time_point _setupStarted;
+    bool _firstFramePending;
+    bool _engineFromPool;
 
+    // How long a replaced handle stays open without an acknowledgement,
+    // and how many may be waiting at once.
     static const ULONGLONG StaleHandleTimeoutMS = 2000LL;
+    static const uint32 MaxRetiredHandles = 8;
+    static const ULONGLONG HandleExpiryTickMS = 250LL;
 };
 
 }}}
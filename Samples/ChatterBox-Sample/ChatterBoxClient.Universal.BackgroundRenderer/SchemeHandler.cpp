@@ -10,19 +10,22 @@
 //*********************************************************
 
 #include "SchemeHandler.h"
+#include "TraceSpans.h"
+#include "MediaSourceRegistry.h"
 
 using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+using namespace MEDIA;
 using namespace Microsoft::WRL::Wrappers;
 using namespace Microsoft::WRL;
 
 SchemeHandler::SchemeHandler()
 {
-  OutputDebugString(L"SchemeHandler::SchemeHandler()");
+  SCHEME_TRACE(L"SchemeHandler::SchemeHandler()");
 }
 
 SchemeHandler::~SchemeHandler()
 {
-  OutputDebugString(L"SchemeHandler::~SchemeHandler()");
+  SCHEME_TRACE(L"SchemeHandler::~SchemeHandler()");
 }
 
 // IMediaExtension methods
@@ -32,6 +35,170 @@ IFACEMETHODIMP SchemeHandler::SetProperties(ABI::Windows::Foundation::Collection
     return S_OK;
 }
 
+// A source normally shows up well within this; after it the request fails.
+static const ULONGLONG c_resolveTimeoutMs = 2000;
+
+// Backoff between lookups while the source is not registered yet.
+static const DWORD c_firstRetryDelayMs = 2;
+static const DWORD c_maxRetryDelayMs = 64;
+
+SourceRequest::SourceRequest() :
+    _deadline(0),
+    _retryDelayMs(c_firstRetryDelayMs),
+    _retries(0),
+    _retryKey(0)
+{
+}
+
+HRESULT SourceRequest::RuntimeClassInitialize(
+    _In_ LPCWSTR url,
+    _In_ IMFAsyncCallback *callback,
+    _In_opt_ IUnknown *state,
+    ULONGLONG timeoutMs)
+{
+    if ((url == nullptr) || (callback == nullptr))
+    {
+        return E_INVALIDARG;
+    }
+
+    try
+    {
+        _url = url;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    _callback = callback;
+    _state = state;
+    _started = std::chrono::steady_clock::now();
+    _deadline = GetTickCount64() + timeoutMs;
+    return S_OK;
+}
+
+HRESULT SourceRequest::Start()
+{
+    return MFPutWorkItem2(MFASYNC_CALLBACK_QUEUE_MULTITHREADED, 0, this, nullptr);
+}
+
+IFACEMETHODIMP SourceRequest::GetParameters(_Out_ DWORD *pdwFlags, _Out_ DWORD *pdwQueue)
+{
+    // retries scheduled with MFScheduleWorkItem land on the same queue
+    *pdwFlags = 0;
+    *pdwQueue = MFASYNC_CALLBACK_QUEUE_MULTITHREADED;
+    return S_OK;
+}
+
+IFACEMETHODIMP SourceRequest::Invoke(_In_opt_ IMFAsyncResult *pAsyncResult)
+{
+    UNREFERENCED_PARAMETER(pAsyncResult);
+    ME_TRACE_SPAN("SourceRequest::Invoke");
+
+    if (_gate.IsFinished())
+    {
+      return S_OK;
+    }
+
+    ComPtr<IInspectable> source;
+    bool found;
+    try
+    {
+      found = MediaSources().Take(_url, GetTickCount64(), &source);
+    }
+    catch (const std::bad_alloc&)
+    {
+      Complete(ResolveOutcome_Failed, E_OUTOFMEMORY, nullptr);
+      return S_OK;
+    }
+    if (found)
+    {
+      Complete(ResolveOutcome_Resolved, S_OK, source.Get());
+      return S_OK;
+    }
+    if (GetTickCount64() >= _deadline)
+    {
+      SCHEME_TRACE(L"SchemeHandler: timed out waiting for a media source\n");
+      Complete(ResolveOutcome_TimedOut, HRESULT_FROM_WIN32(ERROR_TIMEOUT), nullptr);
+      return S_OK;
+    }
+
+    // Not registered yet, look again shortly. The retry may run before
+    // this returns, so nothing but the key is touched after scheduling.
+    DWORD delayMs = _retryDelayMs;
+    _retryDelayMs = (delayMs * 2 < c_maxRetryDelayMs) ? delayMs * 2 : c_maxRetryDelayMs;
+    _retries.fetch_add(1, std::memory_order_relaxed);
+
+    MFWORKITEM_KEY key = 0;
+    HRESULT hr = MFScheduleWorkItem(this, nullptr, -(INT64)delayMs, &key);
+    if (FAILED(hr))
+    {
+      Complete(ResolveOutcome_Failed, hr, nullptr);
+      return S_OK;
+    }
+
+    _retryKey.store(key, std::memory_order_release);
+    if (_gate.IsFinished())
+    {
+      // cancelled while scheduling, Cancel may have missed the key
+      key = _retryKey.exchange(0, std::memory_order_acq_rel);
+      if (key != 0)
+      {
+        MFCancelWorkItem(key);
+      }
+    }
+    return S_OK;
+}
+
+IFACEMETHODIMP SourceRequest::Cancel()
+{
+    if (!_gate.TryFinish())
+    {
+      // already resolved, failed or timed out
+      return S_OK;
+    }
+
+    MFWORKITEM_KEY key = _retryKey.exchange(0, std::memory_order_acq_rel);
+    if (key != 0)
+    {
+      MFCancelWorkItem(key);
+    }
+
+    Report(ResolveOutcome_Cancelled);
+    return S_OK;
+}
+
+void SourceRequest::Complete(ResolveOutcome outcome, HRESULT status, _In_opt_ IUnknown *source)
+{
+    if (!_gate.TryFinish())
+    {
+      // cancelled; a source taken meanwhile is released with this request
+      return;
+    }
+
+    ComPtr<IMFAsyncResult> result;
+    HRESULT hr = MFCreateAsyncResult(source, _callback.Get(), _state.Get(), &result);
+    if (SUCCEEDED(hr))
+    {
+      result->SetStatus(status);
+      hr = MFInvokeCallback(result.Get());
+    }
+    if (FAILED(hr))
+    {
+      SCHEME_TRACE(L"SchemeHandler: failed to complete a source request\n");
+      outcome = ResolveOutcome_Failed;
+    }
+
+    Report(outcome);
+}
+
+void SourceRequest::Report(ResolveOutcome outcome)
+{
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - _started);
+    SourceResolveMetrics().Record(outcome, (uint64_t)latency.count(), _retries.load(std::memory_order_relaxed));
+}
+
 // IMFSchemeHandler methods
 IFACEMETHODIMP SchemeHandler::BeginCreateObject(
     _In_ LPCWSTR pwszURL,
@@ -41,6 +208,8 @@ IFACEMETHODIMP SchemeHandler::BeginCreateObject(
     _In_ IMFAsyncCallback *pCallback,
     _In_ IUnknown *punkState)
 {
+    ME_TRACE_SPAN("SchemeHandler::BeginCreateObject");
+
     if (ppIUnknownCancelCookie != nullptr)
     {
         *ppIUnknownCancelCookie = nullptr;
@@ -55,41 +224,28 @@ IFACEMETHODIMP SchemeHandler::BeginCreateObject(
     {
       return E_INVALIDARG;
     }
-    // Cast the IPropertySet to an IMap and extract the media source that
-    ComPtr<ABI::Windows::Foundation::Collections::IMap<HSTRING, IInspectable*>> propMap;
-    HRESULT hr = _extensionManagerProperties.As(&propMap);
+    // Take the media source the renderer registered for this URL on the
+    // work queue and return it through the callback. Sources registered
+    // for other URLs stay where they are.
+    ComPtr<SourceRequest> request;
+    HRESULT hr = MakeAndInitialize<SourceRequest>(&request, pwszURL, pCallback, punkState, c_resolveTimeoutMs);
     if (FAILED(hr))
     {
       return hr;
     }
-    ComPtr<IInspectable> frameSourceInspectable;
-    hr = propMap->Lookup(HStringReference(pwszURL).Get(), &frameSourceInspectable);
+    hr = request->Start();
     if (FAILED(hr))
     {
-      unsigned int size;
-      hr = propMap->get_Size(&size);
-      if (size == 0)
-      {
-        return E_FAIL;
-      }
       return hr;
     }
-    propMap->Clear();
 
-
-    // Asynchronously return the media source.
-    ComPtr<IMFAsyncResult> result;
-    hr = MFCreateAsyncResult(frameSourceInspectable.Get(), pCallback, punkState, &result);
-    if (FAILED(hr))
-    {
-      return hr;
-    }
-    hr = pCallback->Invoke(result.Get());
-    if (FAILED(hr))
+    if (ppIUnknownCancelCookie != nullptr)
     {
-      return hr;
+      ComPtr<IUnknown> cookie;
+      request.As(&cookie);
+      *ppIUnknownCancelCookie = cookie.Detach();
     }
-    return result->GetStatus();
+    return S_OK;
 }
 
 IFACEMETHODIMP SchemeHandler::EndCreateObject(
@@ -124,5 +280,16 @@ IFACEMETHODIMP SchemeHandler::EndCreateObject(
 IFACEMETHODIMP SchemeHandler::CancelObjectCreation(
     _In_ IUnknown *pIUnknownCancelCookie)
 {
-    return E_NOTIMPL;
+    if (pIUnknownCancelCookie == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+
+    ComPtr<ISourceRequest> request;
+    HRESULT hr = pIUnknownCancelCookie->QueryInterface(IID_PPV_ARGS(&request));
+    if (FAILED(hr))
+    {
+        return E_INVALIDARG;
+    }
+    return request->Cancel();
 }
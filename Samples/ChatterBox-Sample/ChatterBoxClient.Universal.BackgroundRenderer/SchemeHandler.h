@@ -22,8 +22,78 @@
 #include <mfidl.h>
 #include <mfapi.h>
 
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "ResolveMetrics.h"
+
+// Debug builds only; in release builds the call compiles to nothing.
+#if defined(_DEBUG)
+#define SCHEME_TRACE(message) OutputDebugString(message)
+#else
+#define SCHEME_TRACE(message) ((void)0)
+#endif
+
 namespace ChatterBoxClient { namespace Universal { namespace BackgroundRenderer {
 
+using MEDIA::ResolveGate;
+using MEDIA::ResolveOutcome;
+
+// The cancel cookie BeginCreateObject hands out.
+MIDL_INTERFACE("5d91b2e6-0f48-4c7a-b3d5-8e26a1f49c03")
+ISourceRequest : public IUnknown
+{
+public:
+    virtual HRESULT STDMETHODCALLTYPE Cancel() = 0;
+};
+
+// One BeginCreateObject call. The lookup runs on the multithreaded MF work
+// queue, retrying with backoff while the source is not registered yet,
+// until it resolves, times out or is cancelled. Whichever comes first
+// finishes the request; the caller's callback runs at most once and never
+// after a cancel.
+class SourceRequest :
+    public Microsoft::WRL::RuntimeClass<
+    Microsoft::WRL::RuntimeClassFlags< Microsoft::WRL::RuntimeClassType::ClassicCom>,
+    IMFAsyncCallback,
+    ISourceRequest,
+    Microsoft::WRL::FtmBase>
+{
+public:
+    SourceRequest();
+
+    HRESULT RuntimeClassInitialize(
+        _In_ LPCWSTR url,
+        _In_ IMFAsyncCallback *callback,
+        _In_opt_ IUnknown *state,
+        ULONGLONG timeoutMs);
+
+    // Queues the first lookup.
+    HRESULT Start();
+
+    // IMFAsyncCallback
+    IFACEMETHOD(GetParameters) (_Out_ DWORD *pdwFlags, _Out_ DWORD *pdwQueue);
+    IFACEMETHOD(Invoke) (_In_opt_ IMFAsyncResult *pAsyncResult);
+
+    // ISourceRequest
+    IFACEMETHOD(Cancel) ();
+
+private:
+    void Complete(ResolveOutcome outcome, HRESULT status, _In_opt_ IUnknown *source);
+    void Report(ResolveOutcome outcome);
+
+    std::wstring _url;
+    Microsoft::WRL::ComPtr<IMFAsyncCallback> _callback;
+    Microsoft::WRL::ComPtr<IUnknown> _state;
+    std::chrono::steady_clock::time_point _started;
+    ULONGLONG _deadline;
+    DWORD _retryDelayMs;    // only touched by Invoke, one lookup at a time
+    std::atomic<UINT32> _retries;
+    ResolveGate _gate;
+    std::atomic<MFWORKITEM_KEY> _retryKey;
+};
+
 class DECLSPEC_UUID("E2CFE911-260A-4169-90E1-B51AD2B08711") SchemeHandler :
     public Microsoft::WRL::RuntimeClass<
     Microsoft::WRL::RuntimeClassFlags< Microsoft::WRL::RuntimeClassType::WinRtClassicComMix>,
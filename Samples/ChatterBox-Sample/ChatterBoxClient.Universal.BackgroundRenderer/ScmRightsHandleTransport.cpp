@@ -0,0 +1,286 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "ScmRightsHandleTransport.h"
+
+#if !defined(_WIN32)
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+
+// One message is a header, count tokens and, for a send, count descriptors
+// in the same order. Well under the kernel's limit of descriptors per
+// message.
+static const uint32_t c_maxHandlesPerMessage = 64;
+
+enum ScmRightsOp
+{
+    ScmRightsOp_Send = 1,
+    ScmRightsOp_Close = 2
+};
+
+struct ScmRightsHeader
+{
+    uint32_t op;
+    uint32_t count;
+};
+
+struct ScmRightsMessage
+{
+    ScmRightsHeader header;
+    uint64_t tokens[c_maxHandlesPerMessage];
+};
+
+struct ScmRightsPeer
+{
+    int socket;
+};
+
+static bool SendMessage(int socket, uint32_t op, const uint64_t* tokens, const int* descriptors, uint32_t count)
+{
+    ScmRightsMessage message;
+    message.header.op = op;
+    message.header.count = count;
+    std::memcpy(message.tokens, tokens, count * sizeof(uint64_t));
+
+    iovec io;
+    io.iov_base = &message;
+    io.iov_len = sizeof(ScmRightsHeader) + count * sizeof(uint64_t);
+
+    msghdr header;
+    std::memset(&header, 0, sizeof(header));
+    header.msg_iov = &io;
+    header.msg_iovlen = 1;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * c_maxHandlesPerMessage)];
+    if (descriptors != nullptr)
+    {
+        std::memset(control, 0, sizeof(control));
+        header.msg_control = control;
+        header.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+        cmsghdr* rights = CMSG_FIRSTHDR(&header);
+        rights->cmsg_level = SOL_SOCKET;
+        rights->cmsg_type = SCM_RIGHTS;
+        rights->cmsg_len = CMSG_LEN(sizeof(int) * count);
+        std::memcpy(CMSG_DATA(rights), descriptors, sizeof(int) * count);
+    }
+
+    ssize_t sent;
+    do
+    {
+        sent = sendmsg(socket, &header, MSG_NOSIGNAL);
+    } while ((sent < 0) && (errno == EINTR));
+    return sent == (ssize_t)io.iov_len;
+}
+
+ScmRightsHandleTransport::ScmRightsHandleTransport() :
+    _lastToken(0)
+{
+}
+
+ScmRightsHandleTransport::~ScmRightsHandleTransport()
+{
+    for (auto& socket : _sockets)
+    {
+        close(socket.second);
+    }
+}
+
+void ScmRightsHandleTransport::Connect(uint32_t processId, int socket)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    auto found = _sockets.find(processId);
+    if (found != _sockets.end())
+    {
+        close(found->second);
+    }
+    _sockets[processId] = socket;
+}
+
+void ScmRightsHandleTransport::Disconnect(uint32_t processId)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    auto found = _sockets.find(processId);
+    if (found != _sockets.end())
+    {
+        close(found->second);
+        _sockets.erase(found);
+    }
+}
+
+// The peer keeps its own descriptor for the socket, so a process the
+// broker still has open keeps working after a Disconnect.
+void* ScmRightsHandleTransport::OpenProcess(uint32_t processId)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    auto found = _sockets.find(processId);
+    if (found == _sockets.end())
+    {
+        return nullptr;
+    }
+
+    int socket = fcntl(found->second, F_DUPFD_CLOEXEC, 0);
+    if (socket < 0)
+    {
+        return nullptr;
+    }
+
+    ScmRightsPeer* peer = new ScmRightsPeer();
+    peer->socket = socket;
+    return peer;
+}
+
+void ScmRightsHandleTransport::CloseProcess(void* process)
+{
+    ScmRightsPeer* peer = static_cast<ScmRightsPeer*>(process);
+    close(peer->socket);
+    delete peer;
+}
+
+void ScmRightsHandleTransport::Send(void* process, const uint64_t* local, size_t count, uint64_t* remote)
+{
+    ScmRightsPeer* peer = static_cast<ScmRightsPeer*>(process);
+    uint64_t tokens[c_maxHandlesPerMessage];
+    int descriptors[c_maxHandlesPerMessage];
+    for (size_t first = 0; first < count; first += c_maxHandlesPerMessage)
+    {
+        uint32_t chunk = (uint32_t)((count - first < c_maxHandlesPerMessage) ? count - first : c_maxHandlesPerMessage);
+        for (uint32_t i = 0; i < chunk; i++)
+        {
+            tokens[i] = ++_lastToken;
+            descriptors[i] = (int)local[first + i];
+        }
+
+        bool sent = SendMessage(peer->socket, ScmRightsOp_Send, tokens, descriptors, chunk);
+        for (uint32_t i = 0; i < chunk; i++)
+        {
+            remote[first + i] = sent ? tokens[i] : c_invalidRemoteHandle;
+        }
+    }
+}
+
+void ScmRightsHandleTransport::CloseRemote(void* process, const uint64_t* remote, size_t count)
+{
+    ScmRightsPeer* peer = static_cast<ScmRightsPeer*>(process);
+    for (size_t first = 0; first < count; first += c_maxHandlesPerMessage)
+    {
+        uint32_t chunk = (uint32_t)((count - first < c_maxHandlesPerMessage) ? count - first : c_maxHandlesPerMessage);
+        SendMessage(peer->socket, ScmRightsOp_Close, remote + first, nullptr, chunk);
+    }
+}
+
+ScmRightsHandleReceiver::ScmRightsHandleReceiver(int socket) :
+    _socket(socket)
+{
+}
+
+ScmRightsHandleReceiver::~ScmRightsHandleReceiver()
+{
+    for (auto& descriptor : _descriptors)
+    {
+        close(descriptor.second);
+    }
+    close(_socket);
+}
+
+bool ScmRightsHandleReceiver::Receive()
+{
+    ScmRightsMessage message;
+    iovec io;
+    io.iov_base = &message;
+    io.iov_len = sizeof(message);
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * c_maxHandlesPerMessage)];
+    msghdr header;
+    std::memset(&header, 0, sizeof(header));
+    header.msg_iov = &io;
+    header.msg_iovlen = 1;
+    header.msg_control = control;
+    header.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do
+    {
+        received = recvmsg(_socket, &header, MSG_CMSG_CLOEXEC);
+    } while ((received < 0) && (errno == EINTR));
+    if (received <= 0)
+    {
+        return false;
+    }
+
+    // Whatever arrives is ours to close, even in a message that makes no
+    // sense.
+    int descriptors[c_maxHandlesPerMessage];
+    uint32_t descriptorCount = 0;
+    for (cmsghdr* rights = CMSG_FIRSTHDR(&header); rights != nullptr; rights = CMSG_NXTHDR(&header, rights))
+    {
+        if ((rights->cmsg_level != SOL_SOCKET) || (rights->cmsg_type != SCM_RIGHTS))
+        {
+            continue;
+        }
+        uint32_t count = (uint32_t)((rights->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        for (uint32_t i = 0; (i < count) && (descriptorCount < c_maxHandlesPerMessage); i++)
+        {
+            std::memcpy(&descriptors[descriptorCount++], CMSG_DATA(rights) + i * sizeof(int), sizeof(int));
+        }
+    }
+
+    bool valid = ((size_t)received >= sizeof(ScmRightsHeader)) &&
+        (message.header.count <= c_maxHandlesPerMessage) &&
+        ((size_t)received == sizeof(ScmRightsHeader) + message.header.count * sizeof(uint64_t)) &&
+        ((header.msg_flags & MSG_CTRUNC) == 0);
+
+    if (valid && (message.header.op == ScmRightsOp_Send) && (descriptorCount == message.header.count))
+    {
+        for (uint32_t i = 0; i < descriptorCount; i++)
+        {
+            auto found = _descriptors.find(message.tokens[i]);
+            if (found != _descriptors.end())
+            {
+                close(found->second);
+            }
+            _descriptors[message.tokens[i]] = descriptors[i];
+        }
+        return true;
+    }
+
+    for (uint32_t i = 0; i < descriptorCount; i++)
+    {
+        close(descriptors[i]);
+    }
+
+    if (valid && (message.header.op == ScmRightsOp_Close))
+    {
+        for (uint32_t i = 0; i < message.header.count; i++)
+        {
+            auto found = _descriptors.find(message.tokens[i]);
+            if (found != _descriptors.end())
+            {
+                close(found->second);
+                _descriptors.erase(found);
+            }
+        }
+    }
+    return true;
+}
+
+int ScmRightsHandleReceiver::Find(uint64_t token) const
+{
+    auto found = _descriptors.find(token);
+    return (found != _descriptors.end()) ? found->second : -1;
+}
+
+#endif
@@ -0,0 +1,91 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// File descriptor passing for HandleBroker on POSIX systems, so sharing
+// and lifetimes can be exercised away from Windows. Empty on Windows.
+#if !defined(_WIN32)
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include "HandleBroker.h"
+
+namespace ChatterBoxClient { namespace Universal { namespace BackgroundRenderer {
+
+//-----------------------------------------------------------------------------
+// ScmRightsHandleTransport
+//
+// Sends file descriptors over a connected AF_UNIX SOCK_SEQPACKET socket
+// per process, as SCM_RIGHTS. The receiving process gets new descriptor
+// numbers the sender never learns, so each copy is named by a token
+// instead, and CloseRemote asks the receiver to close the descriptors by
+// token. pidfd_getfd would let the receiver pull descriptors itself, but
+// needs ptrace rights over the sender.
+//-----------------------------------------------------------------------------
+class ScmRightsHandleTransport : public IHandleTransport
+{
+public:
+    ScmRightsHandleTransport();
+    ~ScmRightsHandleTransport();
+
+    // Handles for processId go over socket from now on; the transport
+    // takes it over.
+    void Connect(uint32_t processId, int socket);
+    void Disconnect(uint32_t processId);
+
+    virtual void* OpenProcess(uint32_t processId) override;
+    virtual void CloseProcess(void* process) override;
+    virtual void Send(void* process, const uint64_t* local, size_t count, uint64_t* remote) override;
+    virtual void CloseRemote(void* process, const uint64_t* remote, size_t count) override;
+
+private:
+    ScmRightsHandleTransport(const ScmRightsHandleTransport&);
+    ScmRightsHandleTransport& operator=(const ScmRightsHandleTransport&);
+
+    std::mutex _lock;
+    std::map<uint32_t, int> _sockets;
+    std::atomic<uint64_t> _lastToken;
+};
+
+//-----------------------------------------------------------------------------
+// ScmRightsHandleReceiver
+//
+// The receiving end: keeps the descriptors sent to it by token until the
+// sender closes them. Not thread safe.
+//-----------------------------------------------------------------------------
+class ScmRightsHandleReceiver
+{
+public:
+    // Takes the socket over.
+    explicit ScmRightsHandleReceiver(int socket);
+    ~ScmRightsHandleReceiver();
+
+    // Waits for one message and applies it. False once the socket is
+    // closed or broken.
+    bool Receive();
+
+    // -1 for a token it does not hold. The descriptor stays owned here.
+    int Find(uint64_t token) const;
+    size_t Count() const { return _descriptors.size(); }
+
+private:
+    ScmRightsHandleReceiver(const ScmRightsHandleReceiver&);
+    ScmRightsHandleReceiver& operator=(const ScmRightsHandleReceiver&);
+
+    int _socket;
+    std::map<uint64_t, int> _descriptors;
+};
+
+}}}
+
+#endif
@@ -0,0 +1,148 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ChatterBoxClient { namespace Universal { namespace BackgroundRenderer {
+
+//-----------------------------------------------------------------------------
+// SeqLock
+//
+// One value of a small, trivially copyable type, written rarely and read
+// often. Readers never block and never make a writer wait: they copy the
+// value and retry only if a write overlapped the copy. The version is even
+// between writes and goes up by two with each one, so a reader can tell
+// whether anything changed since it last looked.
+//
+// Writers must be serialized by the caller. The value is kept in atomic
+// words so a torn copy, which is thrown away, is still not a data race.
+// Where the writer can stop for good in the middle of a write, as in
+// memory shared with another process, readers use TryRead.
+//-----------------------------------------------------------------------------
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock values are copied word by word");
+
+public:
+    SeqLock() :
+        _sequence(0)
+    {
+        for (auto& word : _words)
+        {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    explicit SeqLock(const T& value) :
+        SeqLock()
+    {
+        Write(value);
+    }
+
+    void Write(const T& value)
+    {
+        uint64_t words[c_wordCount] = {};
+        std::memcpy(words, &value, sizeof(T));
+
+        // Even unless a writer stopped half way; this one starts past it.
+        uint64_t sequence = (_sequence.load(std::memory_order_relaxed) + 1) & ~1ull;
+        _sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < c_wordCount; i++)
+        {
+            _words[i].store(words[i], std::memory_order_relaxed);
+        }
+        _sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Copies a consistent value and returns its version.
+    uint64_t Read(T* value) const
+    {
+        uint64_t version;
+        while (!TryReadOnce(value, &version))
+        {
+        }
+        return version;
+    }
+
+    // Like Read, but gives up after attempts copies that found a write in
+    // progress. Read spins for good if the writer stops half way, which a
+    // writer in another process can do by dying or being suspended.
+    bool TryRead(T* value, uint64_t* version, uint32_t attempts) const
+    {
+        for (uint32_t i = 0; i < attempts; i++)
+        {
+            if (TryReadOnce(value, version))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Reads only when the version differs from *version, and updates it.
+    bool ReadIfChanged(uint64_t* version, T* value) const
+    {
+        if (_sequence.load(std::memory_order_acquire) == *version)
+        {
+            return false;
+        }
+
+        *version = Read(value);
+        return true;
+    }
+
+    uint64_t Version() const
+    {
+        return _sequence.load(std::memory_order_acquire);
+    }
+
+private:
+    SeqLock(const SeqLock&);
+    SeqLock& operator=(const SeqLock&);
+
+    bool TryReadOnce(T* value, uint64_t* version) const
+    {
+        uint64_t before = _sequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0)
+        {
+            return false;
+        }
+
+        uint64_t words[c_wordCount];
+        for (size_t i = 0; i < c_wordCount; i++)
+        {
+            words[i] = _words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_sequence.load(std::memory_order_relaxed) != before)
+        {
+            return false;
+        }
+
+        std::memcpy(value, words, sizeof(T));
+        *version = before;
+        return true;
+    }
+
+    static const size_t c_wordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> _sequence;
+    std::atomic<uint64_t> _words[c_wordCount];
+};
+
+}}}
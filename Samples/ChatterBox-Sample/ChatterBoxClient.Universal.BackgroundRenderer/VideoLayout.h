@@ -0,0 +1,106 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Plain arithmetic, no Windows headers; every function is a single
+// expression so the VS2015 compiler can evaluate it at compile time.
+#include <cstdint>
+
+namespace ChatterBoxClient { namespace Universal { namespace BackgroundRenderer {
+
+// How the video is placed in the render control.
+enum VideoScaleMode
+{
+    VideoScaleMode_Fill = 0,    // cover the control, cropping the video evenly on both edges
+    VideoScaleMode_Fit = 1,     // show the whole video, bars on the sides or top and bottom
+    VideoScaleMode_Stretch = 2, // cover the control, ignoring the aspect ratio
+};
+
+//-----------------------------------------------------------------------------
+// VideoLayout
+//
+// What IMFMediaEngineEx::UpdateVideoStream takes: the part of the video to
+// show, normalized to 0..1, and where to draw it in the control, in pixels.
+//-----------------------------------------------------------------------------
+struct VideoLayout
+{
+    float sourceLeft;
+    float sourceTop;
+    float sourceRight;
+    float sourceBottom;
+    int32_t destinationLeft;
+    int32_t destinationTop;
+    int32_t destinationRight;
+    int32_t destinationBottom;
+};
+
+// Layout is only defined for sizes that are positive; NaN fails too.
+constexpr bool CanLayOutVideo(float controlWidth, float controlHeight, float videoWidth, float videoHeight)
+{
+    return (controlWidth > 0.0f) && (controlHeight > 0.0f) && (videoWidth > 0.0f) && (videoHeight > 0.0f);
+}
+
+constexpr int32_t RoundToPixel(double value)
+{
+    return (int32_t)(value + 0.5);
+}
+
+constexpr VideoLayout MakeVideoLayout(double cropX, double cropY,
+    double left, double top, double right, double bottom)
+{
+    return VideoLayout{
+        float(cropX), float(cropY), float(1.0 - cropX), float(1.0 - cropY),
+        RoundToPixel(left), RoundToPixel(top), RoundToPixel(right), RoundToPixel(bottom) };
+}
+
+// The video keeps its aspect ratio and covers the control; the fraction of
+// the wider dimension that does not fit is cropped, half from each edge.
+constexpr VideoLayout LayOutVideoFill(double controlWidth, double controlHeight,
+    double videoAspect, double controlAspect)
+{
+    return (videoAspect > controlAspect) ?
+        MakeVideoLayout((1.0 - controlAspect / videoAspect) / 2.0, 0.0, 0.0, 0.0, controlWidth, controlHeight) :
+        MakeVideoLayout(0.0, (1.0 - videoAspect / controlAspect) / 2.0, 0.0, 0.0, controlWidth, controlHeight);
+}
+
+// The video keeps its aspect ratio and fits inside the control, centered.
+constexpr VideoLayout LayOutVideoFit(double controlWidth, double controlHeight,
+    double videoAspect, double controlAspect)
+{
+    return (videoAspect > controlAspect) ?
+        MakeVideoLayout(0.0, 0.0,
+            0.0, (controlHeight - controlWidth / videoAspect) / 2.0,
+            controlWidth, (controlHeight + controlWidth / videoAspect) / 2.0) :
+        MakeVideoLayout(0.0, 0.0,
+            (controlWidth - controlHeight * videoAspect) / 2.0, 0.0,
+            (controlWidth + controlHeight * videoAspect) / 2.0, controlHeight);
+}
+
+//-----------------------------------------------------------------------------
+// ComputeVideoLayout
+//
+// Where the video goes in a control of the given size. Check the sizes
+// with CanLayOutVideo first; the result is meaningless otherwise.
+//-----------------------------------------------------------------------------
+constexpr VideoLayout ComputeVideoLayout(VideoScaleMode mode,
+    float controlWidth, float controlHeight, float videoWidth, float videoHeight)
+{
+    return (mode == VideoScaleMode_Fit) ?
+        LayOutVideoFit(controlWidth, controlHeight,
+            double(videoWidth) / double(videoHeight), double(controlWidth) / double(controlHeight)) :
+        (mode == VideoScaleMode_Stretch) ?
+        MakeVideoLayout(0.0, 0.0, 0.0, 0.0, controlWidth, controlHeight) :
+        LayOutVideoFill(controlWidth, controlHeight,
+            double(videoWidth) / double(videoHeight), double(controlWidth) / double(controlHeight));
+}
+
+}}}
@@ -0,0 +1,51 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Win32HandleTransport.h"
+
+using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+
+void* Win32HandleTransport::OpenProcess(uint32_t processId)
+{
+    HANDLE process = ::OpenProcess(PROCESS_DUP_HANDLE, TRUE, processId);
+    if ((process == nullptr) || (process == INVALID_HANDLE_VALUE))
+    {
+        return nullptr;
+    }
+    return process;
+}
+
+void Win32HandleTransport::CloseProcess(void* process)
+{
+    CloseHandle((HANDLE)process);
+}
+
+void Win32HandleTransport::Send(void* process, const uint64_t* local, size_t count, uint64_t* remote)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        HANDLE duplicate = INVALID_HANDLE_VALUE;
+        if (!DuplicateHandle(GetCurrentProcess(), ToHandle(local[i]), (HANDLE)process, &duplicate,
+            0, TRUE, DUPLICATE_SAME_ACCESS))
+        {
+            duplicate = INVALID_HANDLE_VALUE;
+        }
+        remote[i] = FromHandle(duplicate);
+    }
+}
+
+void Win32HandleTransport::CloseRemote(void* process, const uint64_t* remote, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        DuplicateHandle((HANDLE)process, ToHandle(remote[i]), nullptr, nullptr, 0, TRUE, DUPLICATE_CLOSE_SOURCE);
+    }
+}
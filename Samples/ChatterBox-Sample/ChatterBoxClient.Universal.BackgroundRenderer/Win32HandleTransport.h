@@ -0,0 +1,46 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include "HandleBroker.h"
+
+namespace ChatterBoxClient { namespace Universal { namespace BackgroundRenderer {
+
+//-----------------------------------------------------------------------------
+// Win32HandleTransport
+//
+// Duplicates HANDLEs into processes opened with PROCESS_DUP_HANDLE and
+// closes the duplicates there with DUPLICATE_CLOSE_SOURCE. Windows has no
+// call that duplicates several at once; a batch still costs one process
+// lookup and one broker lock.
+//-----------------------------------------------------------------------------
+class Win32HandleTransport : public IHandleTransport
+{
+public:
+    virtual void* OpenProcess(uint32_t processId) override;
+    virtual void CloseProcess(void* process) override;
+    virtual void Send(void* process, const uint64_t* local, size_t count, uint64_t* remote) override;
+    virtual void CloseRemote(void* process, const uint64_t* remote, size_t count) override;
+
+    static uint64_t FromHandle(HANDLE handle)
+    {
+        return (handle == INVALID_HANDLE_VALUE) ? c_invalidRemoteHandle : (uint64_t)(uintptr_t)handle;
+    }
+
+    static HANDLE ToHandle(uint64_t handle)
+    {
+        return (handle == c_invalidRemoteHandle) ? INVALID_HANDLE_VALUE : (HANDLE)(uintptr_t)handle;
+    }
+};
+
+}}}
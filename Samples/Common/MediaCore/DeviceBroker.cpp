@@ -0,0 +1,168 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "DeviceBroker.h"
+
+using namespace MEDIA;
+
+DeviceBroker::DeviceBroker(IDeviceFactory* factory) :
+    m_factory(factory),
+    m_created(0),
+    m_destroyed(0),
+    m_acquisitions(0),
+    m_failures(0)
+{
+}
+
+DeviceBroker::~DeviceBroker()
+{
+    // Clients are expected to release before the broker goes away; don't
+    // leak whatever is left if they didn't.
+    for (auto& entry : m_entries)
+    {
+        m_factory->Destroy(entry.device);
+    }
+}
+
+void* DeviceBroker::Acquire(const DeviceKey& key, const std::string& client)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    for (auto& entry : m_entries)
+    {
+        if (entry.key == key)
+        {
+            entry.references++;
+            entry.clients[client]++;
+            m_acquisitions++;
+            return entry.device;
+        }
+    }
+
+    void* device = m_factory->Create(key);
+    if (device == nullptr)
+    {
+        m_failures++;
+        return nullptr;
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.device = device;
+    entry.references = 1;
+    entry.clients[client] = 1;
+    m_entries.push_back(entry);
+
+    m_created++;
+    m_acquisitions++;
+    return device;
+}
+
+void DeviceBroker::Release(void* device, const std::string& client)
+{
+    if (device == nullptr)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        auto it = m_entries.begin();
+        for (; it != m_entries.end(); ++it)
+        {
+            if (it->device == device)
+            {
+                break;
+            }
+        }
+
+        if (it == m_entries.end())
+        {
+            return;
+        }
+
+        auto clientIt = it->clients.find(client);
+        if (clientIt == it->clients.end())
+        {
+            // Not one of this client's references, leave the count alone.
+            return;
+        }
+
+        if (--clientIt->second == 0)
+        {
+            it->clients.erase(clientIt);
+        }
+
+        if (--it->references > 0)
+        {
+            return;
+        }
+
+        m_entries.erase(it);
+        m_destroyed++;
+    }
+
+    m_factory->Destroy(device);
+}
+
+uint32_t DeviceBroker::ReferenceCount(void* device) const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    for (auto& entry : m_entries)
+    {
+        if (entry.device == device)
+        {
+            return entry.references;
+        }
+    }
+
+    return 0;
+}
+
+uint32_t DeviceBroker::ClientReferences(const std::string& client) const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    uint32_t references = 0;
+    for (auto& entry : m_entries)
+    {
+        auto it = entry.clients.find(client);
+        if (it != entry.clients.end())
+        {
+            references += it->second;
+        }
+    }
+
+    return references;
+}
+
+void DeviceBroker::GetStats(DeviceBrokerStats* stats) const
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    stats->created = m_created;
+    stats->destroyed = m_destroyed;
+    stats->acquisitions = m_acquisitions;
+    stats->failures = m_failures;
+    stats->liveDevices = (uint32_t)m_entries.size();
+    stats->liveReferences = 0;
+    for (auto& entry : m_entries)
+    {
+        stats->liveReferences += entry.references;
+    }
+}
@@ -0,0 +1,109 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Only reference counting lives here; device creation is behind
+// IDeviceFactory so lifetimes can be checked without a GPU.
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MEDIA
+{
+    // adapterLuid 0 selects the default adapter.
+    struct DeviceKey
+    {
+        uint64_t adapterLuid;
+        uint32_t flags;
+
+        bool operator==(const DeviceKey& other) const
+        {
+            return adapterLuid == other.adapterLuid && flags == other.flags;
+        }
+    };
+
+    //-----------------------------------------------------------------------------
+    // IDeviceFactory
+    //
+    // Creates the shared object for a key, nullptr on failure. Destroy is
+    // called once the last client released it.
+    //-----------------------------------------------------------------------------
+    struct IDeviceFactory
+    {
+        virtual ~IDeviceFactory() {}
+        virtual void* Create(const DeviceKey& key) = 0;
+        virtual void Destroy(void* device) = 0;
+    };
+
+    struct DeviceBrokerStats
+    {
+        uint64_t created;
+        uint64_t destroyed;
+        uint64_t acquisitions;
+        uint64_t failures;
+        uint32_t liveDevices;
+        uint32_t liveReferences;
+    };
+
+    //-----------------------------------------------------------------------------
+    // DeviceBroker
+    //
+    // Hands out one shared device per key to any number of clients. Each
+    // Acquire takes a reference on behalf of the named client and has to be
+    // paired with a Release from the same client; the device is destroyed
+    // when the last reference goes away.
+    //
+    // Creation happens under the broker lock so concurrent first users of a
+    // key never end up with two devices; destruction happens outside of it.
+    //-----------------------------------------------------------------------------
+    class DeviceBroker
+    {
+    public:
+        explicit DeviceBroker(IDeviceFactory* factory);
+        ~DeviceBroker();
+
+        void* Acquire(const DeviceKey& key, const std::string& client);
+        void Release(void* device, const std::string& client);
+
+        // Total references held on a device, 0 if it is not live.
+        uint32_t ReferenceCount(void* device) const;
+
+        // References a client holds across all devices.
+        uint32_t ClientReferences(const std::string& client) const;
+
+        void GetStats(DeviceBrokerStats* stats) const;
+
+    private:
+        DeviceBroker(const DeviceBroker&);
+        DeviceBroker& operator=(const DeviceBroker&);
+
+        struct Entry
+        {
+            DeviceKey key;
+            void* device;
+            uint32_t references;
+            std::map<std::string, uint32_t> clients;
+        };
+
+        IDeviceFactory* m_factory;
+
+        mutable std::mutex m_lock;
+        std::vector<Entry> m_entries;
+
+        uint64_t m_created;
+        uint64_t m_destroyed;
+        uint64_t m_acquisitions;
+        uint64_t m_failures;
+    };
+}
@@ -0,0 +1,178 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace MEDIA
+{
+    // Plain snapshot of a histogram; layout is shared with the Unity export.
+    struct LatencySummary
+    {
+        uint64_t count;
+        uint64_t p50;
+        uint64_t p95;
+        uint64_t p99;
+        uint64_t max;
+    };
+
+    //-----------------------------------------------------------------------------
+    // LatencyHistogram
+    //
+    // Fixed-memory log-linear histogram. Values below 2^SubBucketBits get a
+    // bucket each; every power of two above that is split into 2^SubBucketBits
+    // linear sub-buckets, so the relative error stays under 1/2^SubBucketBits
+    // across the whole 32 bit range. Record is a single relaxed atomic add and
+    // is safe from any thread; readers see a slightly stale but usable view.
+    //-----------------------------------------------------------------------------
+    class LatencyHistogram
+    {
+    public:
+        static const uint32_t c_subBucketBits = 3;
+        static const uint32_t c_subBucketCount = 1u << c_subBucketBits;
+        static const uint32_t c_bucketCount = c_subBucketCount + (32 - c_subBucketBits) * c_subBucketCount;
+
+        LatencyHistogram()
+        {
+            Reset();
+        }
+
+        void Record(uint64_t value)
+        {
+            if (value > 0xffffffffull)
+            {
+                value = 0xffffffffull;
+            }
+
+            m_counts[BucketIndex((uint32_t)value)].fetch_add(1, std::memory_order_relaxed);
+
+            uint64_t max = m_max.load(std::memory_order_relaxed);
+            while (value > max &&
+                !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        void Reset()
+        {
+            for (uint32_t i = 0; i < c_bucketCount; i++)
+            {
+                m_counts[i].store(0, std::memory_order_relaxed);
+            }
+            m_max.store(0, std::memory_order_relaxed);
+        }
+
+        // Computes count, p50/p95/p99 and max in two passes without allocating.
+        // Percentiles report the upper bound of the bucket they fall into.
+        void Summarize(LatencySummary* summary) const
+        {
+            if (summary == nullptr)
+            {
+                return;
+            }
+
+            uint64_t total = 0;
+            for (uint32_t i = 0; i < c_bucketCount; i++)
+            {
+                total += m_counts[i].load(std::memory_order_relaxed);
+            }
+
+            summary->count = total;
+            summary->p50 = 0;
+            summary->p95 = 0;
+            summary->p99 = 0;
+            summary->max = m_max.load(std::memory_order_relaxed);
+            if (total == 0)
+            {
+                return;
+            }
+
+            // ceil(total * p) ranks, always at least 1.
+            const uint64_t rank50 = (total * 50 + 99) / 100;
+            const uint64_t rank95 = (total * 95 + 99) / 100;
+            const uint64_t rank99 = (total * 99 + 99) / 100;
+
+            uint64_t seen = 0;
+            bool found50 = false;
+            bool found95 = false;
+            for (uint32_t i = 0; i < c_bucketCount; i++)
+            {
+                uint64_t count = m_counts[i].load(std::memory_order_relaxed);
+                if (count == 0)
+                {
+                    continue;
+                }
+
+                seen += count;
+                uint64_t upper = BucketUpperBound(i);
+                if (!found50 && seen >= rank50)
+                {
+                    summary->p50 = upper;
+                    found50 = true;
+                }
+                if (!found95 && seen >= rank95)
+                {
+                    summary->p95 = upper;
+                    found95 = true;
+                }
+                if (seen >= rank99)
+                {
+                    summary->p99 = upper;
+                    break;
+                }
+            }
+
+            // Never report a percentile above the largest recorded value.
+            if (summary->p50 > summary->max) summary->p50 = summary->max;
+            if (summary->p95 > summary->max) summary->p95 = summary->max;
+            if (summary->p99 > summary->max) summary->p99 = summary->max;
+        }
+
+        static uint32_t BucketIndex(uint32_t value)
+        {
+            if (value < c_subBucketCount)
+            {
+                return value;
+            }
+
+            uint32_t msb = 0;
+            for (uint32_t v = value; v > 1; v >>= 1)
+            {
+                msb++;
+            }
+
+            uint32_t shift = msb - c_subBucketBits;
+            uint32_t subBucket = (value >> shift) & (c_subBucketCount - 1);
+            return c_subBucketCount + shift * c_subBucketCount + subBucket;
+        }
+
+        static uint64_t BucketUpperBound(uint32_t index)
+        {
+            if (index < c_subBucketCount)
+            {
+                return index;
+            }
+
+            uint32_t shift = (index - c_subBucketCount) / c_subBucketCount;
+            uint64_t subBucket = (index - c_subBucketCount) % c_subBucketCount;
+            return ((c_subBucketCount + subBucket + 1) << shift) - 1;
+        }
+
+    private:
+        LatencyHistogram(const LatencyHistogram&);
+        LatencyHistogram& operator=(const LatencyHistogram&);
+
+        std::atomic<uint32_t> m_counts[c_bucketCount];
+        std::atomic<uint64_t> m_max;
+    };
+}
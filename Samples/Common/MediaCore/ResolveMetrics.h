@@ -0,0 +1,140 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "LatencyHistogram.h"
+
+namespace MEDIA
+{
+    // How a scheme handler request for a media source ended.
+    enum ResolveOutcome
+    {
+        ResolveOutcome_Resolved = 0,
+        ResolveOutcome_Failed = 1,
+        ResolveOutcome_Cancelled = 2,
+        ResolveOutcome_TimedOut = 3,
+    };
+
+    // Layout is shared with the Unity export.
+    struct ResolveStats
+    {
+        uint64_t resolved;
+        uint64_t failed;
+        uint64_t cancelled;
+        uint64_t timedOut;
+        uint64_t retries;       // lookups repeated because the source was not there yet
+        LatencySummary latency; // microseconds from the request to a resolved source
+    };
+
+    //-----------------------------------------------------------------------------
+    // ResolveMetrics
+    //
+    // Outcome counters and resolution latency for the scheme handler. Only
+    // resolved requests feed the histogram; timeouts would just pile up at
+    // the timeout and cancellations say nothing about the lookup.
+    //-----------------------------------------------------------------------------
+    class ResolveMetrics
+    {
+    public:
+        ResolveMetrics() :
+            m_resolved(0),
+            m_failed(0),
+            m_cancelled(0),
+            m_timedOut(0),
+            m_retries(0)
+        {
+        }
+
+        void Record(ResolveOutcome outcome, uint64_t latencyMicroseconds, uint32_t retries)
+        {
+            switch (outcome)
+            {
+            case ResolveOutcome_Resolved:
+                m_resolved.fetch_add(1, std::memory_order_relaxed);
+                m_latency.Record(latencyMicroseconds);
+                break;
+            case ResolveOutcome_Cancelled:
+                m_cancelled.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case ResolveOutcome_TimedOut:
+                m_timedOut.fetch_add(1, std::memory_order_relaxed);
+                break;
+            default:
+                m_failed.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            m_retries.fetch_add(retries, std::memory_order_relaxed);
+        }
+
+        void GetStats(ResolveStats* stats) const
+        {
+            if (stats == nullptr)
+            {
+                return;
+            }
+
+            stats->resolved = m_resolved.load(std::memory_order_relaxed);
+            stats->failed = m_failed.load(std::memory_order_relaxed);
+            stats->cancelled = m_cancelled.load(std::memory_order_relaxed);
+            stats->timedOut = m_timedOut.load(std::memory_order_relaxed);
+            stats->retries = m_retries.load(std::memory_order_relaxed);
+            m_latency.Summarize(&stats->latency);
+        }
+
+    private:
+        ResolveMetrics(const ResolveMetrics&);
+        ResolveMetrics& operator=(const ResolveMetrics&);
+
+        std::atomic<uint64_t> m_resolved;
+        std::atomic<uint64_t> m_failed;
+        std::atomic<uint64_t> m_cancelled;
+        std::atomic<uint64_t> m_timedOut;
+        std::atomic<uint64_t> m_retries;
+        LatencyHistogram m_latency;
+    };
+
+    //-----------------------------------------------------------------------------
+    // ResolveGate
+    //
+    // Decides which of completion, cancellation and timeout finishes a
+    // request: the first to call TryFinish wins, everyone after it backs
+    // off, so the caller's callback runs at most once.
+    //-----------------------------------------------------------------------------
+    class ResolveGate
+    {
+    public:
+        ResolveGate() :
+            m_finished(false)
+        {
+        }
+
+        bool TryFinish()
+        {
+            bool expected = false;
+            return m_finished.compare_exchange_strong(expected, true, std::memory_order_acq_rel);
+        }
+
+        bool IsFinished() const
+        {
+            return m_finished.load(std::memory_order_acquire);
+        }
+
+    private:
+        ResolveGate(const ResolveGate&);
+        ResolveGate& operator=(const ResolveGate&);
+
+        std::atomic<bool> m_finished;
+    };
+}
@@ -0,0 +1,255 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MEDIA
+{
+    struct SourceRegistryStats
+    {
+        uint32_t live;
+        uint64_t registered;
+        uint64_t taken;
+        uint64_t expired;       // dropped unclaimed after the time to live
+        uint64_t misses;        // takes that found nothing
+        uint64_t duplicates;    // registrations refused for a key in use
+    };
+
+    //-----------------------------------------------------------------------------
+    // SourceRegistry
+    //
+    // Hands media sources from the code that creates them to the scheme
+    // handler that resolves their URL. Each key can be taken exactly once;
+    // entries nobody takes are dropped once their time to live has passed,
+    // so a URL the media engine never resolved does not keep its source
+    // alive.
+    //
+    // Keys are spread over independently locked shards, so streams starting
+    // together rarely touch the same lock. Times are whatever monotonic unit
+    // the caller passes as now, milliseconds in practice. Expired values are
+    // released after the shard lock is dropped, since releasing a source
+    // can run arbitrary code.
+    //-----------------------------------------------------------------------------
+    template <typename T, uint32_t ShardCount = 16>
+    class SourceRegistry
+    {
+        static_assert(ShardCount > 0, "SourceRegistry needs at least one shard");
+
+    public:
+        explicit SourceRegistry(uint64_t timeToLive) :
+            m_timeToLive(timeToLive),
+            m_live(0),
+            m_registered(0),
+            m_taken(0),
+            m_expired(0),
+            m_misses(0),
+            m_duplicates(0)
+        {
+        }
+
+        // False when the key is already registered and has not expired.
+        bool Register(const std::wstring& key, const T& value, uint64_t now)
+        {
+            std::vector<T> expired;
+            bool inserted;
+            {
+                Shard& shard = ShardFor(key);
+                std::lock_guard<std::mutex> lock(shard.lock);
+
+                if (now >= shard.nextDeadline)
+                {
+                    SweepShard(shard, now, &expired);
+                }
+
+                Entry entry = { value, now + m_timeToLive };
+                inserted = shard.entries.emplace(key, entry).second;
+                if (inserted && entry.deadline < shard.nextDeadline)
+                {
+                    shard.nextDeadline = entry.deadline;
+                }
+            }
+
+            if (inserted)
+            {
+                m_live.fetch_add(1, std::memory_order_relaxed);
+                m_registered.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                m_duplicates.fetch_add(1, std::memory_order_relaxed);
+            }
+            return inserted;
+        }
+
+        // Removes the entry and hands its value over. False when there is
+        // none, because it was never registered, was already taken, or
+        // expired.
+        bool Take(const std::wstring& key, uint64_t now, T* value)
+        {
+            T stale;
+            bool found = false;
+            bool expired = false;
+            {
+                Shard& shard = ShardFor(key);
+                std::lock_guard<std::mutex> lock(shard.lock);
+
+                auto it = shard.entries.find(key);
+                if (it != shard.entries.end())
+                {
+                    if (now < it->second.deadline)
+                    {
+                        *value = std::move(it->second.value);
+                        found = true;
+                    }
+                    else
+                    {
+                        stale = std::move(it->second.value);
+                        expired = true;
+                    }
+                    shard.entries.erase(it);
+                }
+            }
+
+            // an expired value is released on return, after the lock is
+            // dropped; the cast keeps a trivial T from looking unused
+            (void)stale;
+
+            if (found || expired)
+            {
+                m_live.fetch_sub(1, std::memory_order_relaxed);
+            }
+            if (found)
+            {
+                m_taken.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                m_misses.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (expired)
+            {
+                m_expired.fetch_add(1, std::memory_order_relaxed);
+            }
+            return found;
+        }
+
+        // Drops every expired entry; registrations also sweep their own
+        // shard as they go. Returns how many were dropped.
+        uint32_t Sweep(uint64_t now)
+        {
+            uint32_t dropped = 0;
+            for (uint32_t i = 0; i < ShardCount; i++)
+            {
+                std::vector<T> expired;
+                {
+                    std::lock_guard<std::mutex> lock(m_shards[i].lock);
+                    if (now >= m_shards[i].nextDeadline)
+                    {
+                        SweepShard(m_shards[i], now, &expired);
+                    }
+                }
+                dropped += (uint32_t)expired.size();
+            }
+            return dropped;
+        }
+
+        void GetStats(SourceRegistryStats* stats) const
+        {
+            if (stats == nullptr)
+            {
+                return;
+            }
+
+            stats->live = m_live.load(std::memory_order_relaxed);
+            stats->registered = m_registered.load(std::memory_order_relaxed);
+            stats->taken = m_taken.load(std::memory_order_relaxed);
+            stats->expired = m_expired.load(std::memory_order_relaxed);
+            stats->misses = m_misses.load(std::memory_order_relaxed);
+            stats->duplicates = m_duplicates.load(std::memory_order_relaxed);
+        }
+
+    private:
+        SourceRegistry(const SourceRegistry&);
+        SourceRegistry& operator=(const SourceRegistry&);
+
+        struct Entry
+        {
+            T value;
+            uint64_t deadline;
+        };
+
+        struct Shard
+        {
+            Shard() : nextDeadline(UINT64_MAX) {}
+
+            std::mutex lock;
+            std::unordered_map<std::wstring, Entry> entries;
+            uint64_t nextDeadline;  // no entry expires before this
+        };
+
+        Shard& ShardFor(const std::wstring& key)
+        {
+            // spread the hash so shards differing in low bits still mix
+            uint64_t hash = (uint64_t)std::hash<std::wstring>()(key);
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdull;
+            hash ^= hash >> 33;
+            return m_shards[hash % ShardCount];
+        }
+
+        // Caller holds the shard lock; the values go out through expired.
+        void SweepShard(Shard& shard, uint64_t now, std::vector<T>* expired)
+        {
+            uint64_t nextDeadline = UINT64_MAX;
+            for (auto it = shard.entries.begin(); it != shard.entries.end();)
+            {
+                if (now >= it->second.deadline)
+                {
+                    expired->push_back(std::move(it->second.value));
+                    it = shard.entries.erase(it);
+                }
+                else
+                {
+                    if (it->second.deadline < nextDeadline)
+                    {
+                        nextDeadline = it->second.deadline;
+                    }
+                    ++it;
+                }
+            }
+            shard.nextDeadline = nextDeadline;
+
+            if (!expired->empty())
+            {
+                m_live.fetch_sub((uint32_t)expired->size(), std::memory_order_relaxed);
+                m_expired.fetch_add(expired->size(), std::memory_order_relaxed);
+            }
+        }
+
+        const uint64_t m_timeToLive;
+        Shard m_shards[ShardCount];
+
+        std::atomic<uint32_t> m_live;
+        std::atomic<uint64_t> m_registered;
+        std::atomic<uint64_t> m_taken;
+        std::atomic<uint64_t> m_expired;
+        std::atomic<uint64_t> m_misses;
+        std::atomic<uint64_t> m_duplicates;
+    };
+}
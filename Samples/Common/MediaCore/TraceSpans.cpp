@@ -0,0 +1,276 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "TraceSpans.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace MEDIA;
+
+namespace
+{
+    uint32_t CurrentThreadId()
+    {
+#if defined(_WIN32)
+        return (uint32_t)GetCurrentThreadId();
+#else
+        return (uint32_t)syscall(SYS_gettid);
+#endif
+    }
+
+    uint32_t CurrentProcessId()
+    {
+#if defined(_WIN32)
+        return (uint32_t)GetCurrentProcessId();
+#else
+        return (uint32_t)getpid();
+#endif
+    }
+
+    void AppendJsonString(std::string& out, const char* text)
+    {
+        out.push_back('"');
+        for (const char* p = (text != nullptr) ? text : ""; *p != '\0'; p++)
+        {
+            unsigned char c = (unsigned char)*p;
+            if (c == '"' || c == '\\')
+            {
+                out.push_back('\\');
+                out.push_back((char)c);
+            }
+            else if (c < 0x20)
+            {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            }
+            else
+            {
+                out.push_back((char)c);
+            }
+        }
+        out.push_back('"');
+    }
+
+    // nanoseconds as microseconds with three decimals
+    void AppendMicroseconds(std::string& out, uint64_t nanoseconds)
+    {
+        char number[32];
+        snprintf(number, sizeof(number), "%llu.%03llu",
+            (unsigned long long)(nanoseconds / 1000), (unsigned long long)(nanoseconds % 1000));
+        out += number;
+    }
+}
+
+TraceRecorder& TraceRecorder::Instance()
+{
+    static TraceRecorder* s_recorder = new TraceRecorder();
+    return *s_recorder;
+}
+
+TraceRecorder::TraceRecorder() :
+    m_start(std::chrono::steady_clock::now()),
+    m_enabled(false),
+    m_generation(0)
+{
+}
+
+void TraceRecorder::Start()
+{
+    std::lock_guard<std::mutex> lock(m_bufferLock);
+
+    // buffers of threads that are gone only held the previous capture
+    m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(),
+        [](const std::shared_ptr<ThreadBuffer>& buffer) { return buffer->retired.load(std::memory_order_acquire); }),
+        m_buffers.end());
+
+    // the others clear themselves when they next record
+    m_generation.fetch_add(1, std::memory_order_acq_rel);
+    m_enabled.store(true, std::memory_order_release);
+}
+
+void TraceRecorder::Stop()
+{
+    m_enabled.store(false, std::memory_order_release);
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::CurrentBuffer()
+{
+    // Marks the buffer retired when the thread exits; the next Start
+    // drops it.
+    struct BufferOwner
+    {
+        BufferOwner() : buffer(nullptr) {}
+        ~BufferOwner()
+        {
+            if (buffer != nullptr)
+            {
+                buffer->retired.store(true, std::memory_order_release);
+            }
+        }
+
+        ThreadBuffer* buffer;
+    };
+
+    thread_local BufferOwner owner;
+    if (owner.buffer == nullptr)
+    {
+        std::shared_ptr<ThreadBuffer> buffer;
+        try
+        {
+            buffer = std::make_shared<ThreadBuffer>();
+        }
+        catch (const std::bad_alloc&)
+        {
+            return nullptr;
+        }
+
+        buffer->threadId = CurrentThreadId();
+
+        std::lock_guard<std::mutex> lock(m_bufferLock);
+        m_buffers.push_back(buffer);
+        owner.buffer = buffer.get();
+    }
+    return owner.buffer;
+}
+
+void TraceRecorder::Record(const char* name, const char* category, uint64_t begin, uint64_t end)
+{
+    ThreadBuffer* buffer = CurrentBuffer();
+    if (buffer == nullptr)
+    {
+        return;
+    }
+
+    uint64_t generation = m_generation.load(std::memory_order_acquire);
+
+    std::lock_guard<std::mutex> lock(buffer->lock);
+    if (buffer->generation != generation)
+    {
+        buffer->events.clear();
+        buffer->dropped = 0;
+        buffer->generation = generation;
+    }
+
+    if (buffer->events.size() >= c_eventsPerThread)
+    {
+        buffer->dropped++;
+        return;
+    }
+
+    Event event = { name, category, begin, (end > begin) ? end - begin : 0 };
+    try
+    {
+        buffer->events.push_back(event);
+    }
+    catch (const std::bad_alloc&)
+    {
+        buffer->dropped++;
+    }
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Function:   TraceRecorder::ExportJson
+//
+//  Synopsis:   Chrome trace-event JSON for the current capture. Each span is
+//              a complete event; pid and tid let the viewer group them by
+//              thread.
+//
+//-----------------------------------------------------------------------------
+std::string TraceRecorder::ExportJson()
+{
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(m_bufferLock);
+        buffers = m_buffers;
+    }
+
+    uint64_t generation = m_generation.load(std::memory_order_acquire);
+
+    char pid[16];
+    snprintf(pid, sizeof(pid), "%u", CurrentProcessId());
+
+    std::string json = "{\"traceEvents\":[";
+    bool first = true;
+    for (auto& buffer : buffers)
+    {
+        std::lock_guard<std::mutex> lock(buffer->lock);
+        if (buffer->generation != generation)
+        {
+            continue;
+        }
+
+        char tid[16];
+        snprintf(tid, sizeof(tid), "%u", buffer->threadId);
+
+        for (const Event& event : buffer->events)
+        {
+            json += first ? "\n" : ",\n";
+            first = false;
+
+            json += "{\"name\":";
+            AppendJsonString(json, event.name);
+            json += ",\"cat\":";
+            AppendJsonString(json, event.category);
+            json += ",\"ph\":\"X\",\"ts\":";
+            AppendMicroseconds(json, event.begin);
+            json += ",\"dur\":";
+            AppendMicroseconds(json, event.duration);
+            json += ",\"pid\":";
+            json += pid;
+            json += ",\"tid\":";
+            json += tid;
+            json += "}";
+        }
+    }
+    json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return json;
+}
+
+void TraceRecorder::GetStats(TraceStats* stats)
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(m_bufferLock);
+        buffers = m_buffers;
+    }
+
+    uint64_t generation = m_generation.load(std::memory_order_acquire);
+
+    stats->recorded = 0;
+    stats->dropped = 0;
+    stats->threads = 0;
+    stats->enabled = IsEnabled();
+    for (auto& buffer : buffers)
+    {
+        std::lock_guard<std::mutex> lock(buffer->lock);
+        if (buffer->generation == generation)
+        {
+            stats->recorded += buffer->events.size();
+            stats->dropped += buffer->dropped;
+            stats->threads++;
+        }
+    }
+}
@@ -0,0 +1,157 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MEDIA
+{
+    struct TraceStats
+    {
+        uint64_t recorded;
+        uint64_t dropped;   // spans that found their thread's buffer full
+        uint32_t threads;
+        bool enabled;
+    };
+
+    //-----------------------------------------------------------------------------
+    // TraceRecorder
+    //
+    // Collects timed spans for a Chrome trace-event capture, which Perfetto
+    // and chrome://tracing open directly. Each thread appends to its own
+    // buffer, so recording threads never contend with each other; the
+    // buffer's lock is only shared with an export. While tracing is off a
+    // span costs one relaxed load. Names and categories are not copied and
+    // must be string literals.
+    //-----------------------------------------------------------------------------
+    class TraceRecorder
+    {
+    public:
+        // Spans kept per thread and capture; later ones are dropped.
+        static const uint32_t c_eventsPerThread = 16384;
+
+        // Never destroyed, so spans closing during shutdown are safe.
+        static TraceRecorder& Instance();
+
+        // Discards the previous capture and starts recording.
+        void Start();
+        void Stop();
+
+        bool IsEnabled() const
+        {
+            return m_enabled.load(std::memory_order_relaxed);
+        }
+
+        // Nanoseconds since the recorder was created.
+        uint64_t Now() const
+        {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - m_start).count();
+        }
+
+        void Record(const char* name, const char* category, uint64_t begin, uint64_t end);
+
+        // The capture as {"traceEvents":[...]}, complete ("X") events with
+        // microsecond timestamps. Can be called while recording.
+        std::string ExportJson();
+
+        void GetStats(TraceStats* stats);
+
+    private:
+        // Threads cache their buffer per thread, not per recorder, so there
+        // is only ever the one instance.
+        TraceRecorder();
+        TraceRecorder(const TraceRecorder&);
+        TraceRecorder& operator=(const TraceRecorder&);
+
+        struct Event
+        {
+            const char* name;
+            const char* category;
+            uint64_t begin;
+            uint64_t duration;
+        };
+
+        struct ThreadBuffer
+        {
+            ThreadBuffer() : threadId(0), generation(0), dropped(0), retired(false) {}
+
+            std::mutex lock;
+            std::vector<Event> events;
+            uint32_t threadId;
+            uint64_t generation;    // capture the events belong to
+            uint64_t dropped;
+            std::atomic<bool> retired;
+        };
+
+        ThreadBuffer* CurrentBuffer();
+
+        std::chrono::steady_clock::time_point m_start;
+        std::atomic<bool> m_enabled;
+        std::atomic<uint64_t> m_generation;
+
+        std::mutex m_bufferLock;
+        std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+    };
+
+    //-----------------------------------------------------------------------------
+    // TraceSpan
+    //
+    // Records the time between construction and destruction, if tracing
+    // was on when it started.
+    //-----------------------------------------------------------------------------
+    class TraceSpan
+    {
+    public:
+        explicit TraceSpan(const char* name, const char* category = "media") :
+            m_name(nullptr),
+            m_category(category),
+            m_begin(0)
+        {
+            TraceRecorder& recorder = TraceRecorder::Instance();
+            if (recorder.IsEnabled())
+            {
+                m_name = name;
+                m_begin = recorder.Now();
+            }
+        }
+
+        ~TraceSpan()
+        {
+            if (m_name != nullptr)
+            {
+                TraceRecorder& recorder = TraceRecorder::Instance();
+                recorder.Record(m_name, m_category, m_begin, recorder.Now());
+            }
+        }
+
+    private:
+        TraceSpan(const TraceSpan&);
+        TraceSpan& operator=(const TraceSpan&);
+
+        const char* m_name;
+        const char* m_category;
+        uint64_t m_begin;
+    };
+}
+
+#define ME_TRACE_CONCAT_(a, b) a##b
+#define ME_TRACE_CONCAT(a, b) ME_TRACE_CONCAT_(a, b)
+
+// Times the rest of the enclosing scope.
+#define ME_TRACE_SPAN(name) MEDIA::TraceSpan ME_TRACE_CONCAT(traceSpan, __LINE__)(name)
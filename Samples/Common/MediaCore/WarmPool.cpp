@@ -0,0 +1,209 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "WarmPool.h"
+
+#include <chrono>
+#include <new>
+
+using namespace MEDIA;
+
+WarmPool::WarmPool(IWarmPoolFactory* factory, uint32_t target) :
+    m_factory(factory),
+    m_target(target),
+    m_running(false),
+    m_stopping(false),
+    m_created(0),
+    m_hits(0),
+    m_misses(0),
+    m_failures(0)
+{
+}
+
+WarmPool::~WarmPool()
+{
+    Stop();
+}
+
+void WarmPool::Start()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_running)
+    {
+        return;
+    }
+
+    m_stopping = false;
+    m_thread = std::thread(&WarmPool::Run, this);
+    m_running = true;
+}
+
+void WarmPool::Stop()
+{
+    std::vector<void*> unused;
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        if (!m_running)
+        {
+            return;
+        }
+
+        m_stopping = true;
+        m_wake.notify_all();
+        lock.unlock();
+
+        m_thread.join();
+
+        lock.lock();
+        m_running = false;
+        unused.swap(m_ready);
+    }
+
+    for (void* item : unused)
+    {
+        m_factory->Destroy(item);
+    }
+}
+
+void WarmPool::SetTarget(uint32_t target)
+{
+    std::vector<void*> surplus;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_target = target;
+        while (m_ready.size() > target)
+        {
+            surplus.push_back(m_ready.back());
+            m_ready.pop_back();
+        }
+        m_wake.notify_all();
+    }
+
+    for (void* item : surplus)
+    {
+        m_factory->Destroy(item);
+    }
+}
+
+void* WarmPool::Acquire()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_ready.empty())
+    {
+        m_misses++;
+        return nullptr;
+    }
+
+    void* item = m_ready.back();
+    m_ready.pop_back();
+    m_hits++;
+
+    // one fewer ready, let the thread build the replacement
+    m_wake.notify_all();
+    return item;
+}
+
+void WarmPool::RecordFirstFrame(bool pooled, uint64_t microseconds)
+{
+    if (pooled)
+    {
+        m_firstFrameWarm.Record(microseconds);
+    }
+    else
+    {
+        m_firstFrameCold.Record(microseconds);
+    }
+}
+
+void WarmPool::GetStats(WarmPoolStats* stats) const
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        stats->ready = (uint32_t)m_ready.size();
+        stats->target = m_target;
+        stats->created = m_created;
+        stats->hits = m_hits;
+        stats->misses = m_misses;
+        stats->failures = m_failures;
+    }
+
+    m_firstFrameWarm.Summarize(&stats->firstFrameWarm);
+    m_firstFrameCold.Summarize(&stats->firstFrameCold);
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Function:   WarmPool::Run
+//
+//  Synopsis:   Refill thread. Builds one item at a time outside the lock, so
+//              Acquire is never held up by a slow Create.
+//
+//-----------------------------------------------------------------------------
+void WarmPool::Run()
+{
+    m_factory->OnThreadStart();
+
+    uint32_t retryDelayMs = c_retryDelayMs;
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (!m_stopping)
+    {
+        if (m_ready.size() >= m_target)
+        {
+            m_wake.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        void* item = m_factory->Create();
+        lock.lock();
+
+        if (item == nullptr)
+        {
+            m_failures++;
+            m_wake.wait_for(lock, std::chrono::milliseconds(retryDelayMs));
+            retryDelayMs = (retryDelayMs * 2 < c_maxRetryDelayMs) ? retryDelayMs * 2 : c_maxRetryDelayMs;
+            continue;
+        }
+
+        retryDelayMs = c_retryDelayMs;
+        m_created++;
+
+        // the target may have dropped, or Stop come in, while it was built
+        if (m_stopping || m_ready.size() >= m_target)
+        {
+            lock.unlock();
+            m_factory->Destroy(item);
+            lock.lock();
+            continue;
+        }
+
+        try
+        {
+            m_ready.push_back(item);
+        }
+        catch (const std::bad_alloc&)
+        {
+            lock.unlock();
+            m_factory->Destroy(item);
+            lock.lock();
+            m_wake.wait_for(lock, std::chrono::milliseconds(retryDelayMs));
+        }
+    }
+    lock.unlock();
+
+    m_factory->OnThreadStop();
+}
@@ -0,0 +1,115 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Only the bookkeeping lives here; what a pooled item is and how it is
+// built is behind IWarmPoolFactory, like devices behind IDeviceFactory.
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "LatencyHistogram.h"
+
+namespace MEDIA
+{
+    //-----------------------------------------------------------------------------
+    // IWarmPoolFactory
+    //
+    // Builds one ready-to-use item, nullptr on failure. Create runs on the
+    // pool thread, bracketed by OnThreadStart/OnThreadStop for per-thread
+    // setup such as COM. Destroy gets items nobody acquired.
+    //-----------------------------------------------------------------------------
+    struct IWarmPoolFactory
+    {
+        virtual ~IWarmPoolFactory() {}
+        virtual void* Create() = 0;
+        virtual void Destroy(void* item) = 0;
+        virtual void OnThreadStart() {}
+        virtual void OnThreadStop() {}
+    };
+
+    struct WarmPoolStats
+    {
+        uint32_t ready;
+        uint32_t target;
+        uint64_t created;
+        uint64_t hits;          // acquisitions served from the pool
+        uint64_t misses;        // acquisitions that found it empty
+        uint64_t failures;      // Create calls that returned nothing
+        LatencySummary firstFrameWarm;  // microseconds, pooled items
+        LatencySummary firstFrameCold;  // microseconds, built on demand
+    };
+
+    //-----------------------------------------------------------------------------
+    // WarmPool
+    //
+    // Keeps up to target items built ahead of time so a call can start
+    // without paying for their setup. Acquire never waits: it hands out a
+    // ready item or nullptr, and the caller builds one itself. One thread
+    // refills the pool in the background, backing off while Create fails.
+    //
+    // Callers report time to first frame for both kinds of item, so the
+    // stats show what the pool buys.
+    //-----------------------------------------------------------------------------
+    class WarmPool
+    {
+    public:
+        // First wait after a failed Create; doubles up to the maximum.
+        static const uint32_t c_retryDelayMs = 500;
+        static const uint32_t c_maxRetryDelayMs = 30000;
+
+        WarmPool(IWarmPoolFactory* factory, uint32_t target);
+        ~WarmPool();
+
+        // Starts the refill thread; no-op while it runs.
+        void Start();
+
+        // Joins the refill thread and destroys the items nobody acquired.
+        void Stop();
+
+        // 0 drains the pool and stops refilling.
+        void SetTarget(uint32_t target);
+
+        // A ready item, or nullptr when there is none. The caller owns it.
+        void* Acquire();
+
+        void RecordFirstFrame(bool pooled, uint64_t microseconds);
+
+        void GetStats(WarmPoolStats* stats) const;
+
+    private:
+        WarmPool(const WarmPool&);
+        WarmPool& operator=(const WarmPool&);
+
+        void Run();
+
+        IWarmPoolFactory* m_factory;
+
+        mutable std::mutex m_lock;
+        std::condition_variable m_wake;
+        std::thread m_thread;
+        std::vector<void*> m_ready;
+        uint32_t m_target;
+        bool m_running;
+        bool m_stopping;
+
+        uint64_t m_created;
+        uint64_t m_hits;
+        uint64_t m_misses;
+        uint64_t m_failures;
+
+        LatencyHistogram m_firstFrameWarm;
+        LatencyHistogram m_firstFrameCold;
+    };
+}
@@ -59,6 +59,8 @@ public class ControlScript : MonoBehaviour
 
     private void Update()
     {
+        // copies the newest frames into the primary textures on the render thread
+        GL.IssuePluginEvent(Plugin.GetRenderEventFunc(), 1);
     }
 
     public void CreateLocalMediaStreamSource(object track, string type, string id)
@@ -134,5 +136,8 @@ public class ControlScript : MonoBehaviour
 
         [DllImport("MediaEngineUWP", CallingConvention = CallingConvention.StdCall, EntryPoint = "RemotePause")]
         internal static extern void RemotePause();
+
+        [DllImport("MediaEngineUWP", CallingConvention = CallingConvention.StdCall, EntryPoint = "GetRenderEventFunc")]
+        internal static extern IntPtr GetRenderEventFunc();
     }
 }
@@ -115,6 +115,9 @@ public class ControlScript : MonoBehaviour
 
     private void Update()
     {
+        // copies the newest frames into the primary textures on the render thread
+        GL.IssuePluginEvent(Plugin.GetRenderEventFunc(), 1);
+
 #if !UNITY_EDITOR
         lock (this)
         {
@@ -713,5 +716,8 @@ public class ControlScript : MonoBehaviour
 
         [DllImport("MediaEngineUWP", CallingConvention = CallingConvention.StdCall, EntryPoint = "RemotePause")]
         internal static extern void RemotePause();
+
+        [DllImport("MediaEngineUWP", CallingConvention = CallingConvention.StdCall, EntryPoint = "GetRenderEventFunc")]
+        internal static extern IntPtr GetRenderEventFunc();
     }
 }
@@ -0,0 +1,856 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "AsyncLogger.h"
+
+#include <algorithm>
+#include <cwchar>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace MEDIA;
+
+namespace
+{
+    const size_t c_formatCapacity = 2048;
+
+    uint32_t CurrentThreadId()
+    {
+#if defined(_WIN32)
+        return (uint32_t)GetCurrentThreadId();
+#else
+        return (uint32_t)syscall(SYS_gettid);
+#endif
+    }
+
+    bool IsSignedArg(LogArgType type)
+    {
+        return type == LogArg_Int || type == LogArg_Pts || type == LogArg_PlayerId;
+    }
+
+    const char* LevelName(uint32_t level)
+    {
+        static const char* const names[] = { "ANY", "ERROR", "WARN", "INFO" };
+        return (level < sizeof(names) / sizeof(names[0])) ? names[level] : "?";
+    }
+
+    // Walks the arguments LogRecordWriter stored in a record.
+    class LogRecordReader
+    {
+    public:
+        explicit LogRecordReader(const LogRecord& record) :
+            m_cursor(record.data),
+            m_end(record.data + record.size)
+        {
+        }
+
+        bool Next(LogArgType* type, uint64_t* scalar, double* real, const uint8_t** string, size_t* length)
+        {
+            if (m_cursor >= m_end)
+            {
+                return false;
+            }
+
+            *type = (LogArgType)*m_cursor++;
+            switch (*type)
+            {
+            case LogArg_Double:
+                memcpy(real, m_cursor, sizeof(double));
+                m_cursor += sizeof(double);
+                return true;
+
+            case LogArg_WString:
+            case LogArg_String:
+            {
+                uint16_t units;
+                memcpy(&units, m_cursor, sizeof(units));
+                m_cursor += sizeof(units);
+                *string = m_cursor;
+                *length = units;
+                m_cursor += units * ((*type == LogArg_WString) ? sizeof(wchar_t) : sizeof(char));
+                return true;
+            }
+
+            default:
+                memcpy(scalar, m_cursor, sizeof(uint64_t));
+                m_cursor += sizeof(uint64_t);
+                return true;
+            }
+        }
+
+    private:
+        const uint8_t* m_cursor;
+        const uint8_t* m_end;
+    };
+
+    void AppendUtf8(std::vector<char>& out, const wchar_t* text, size_t length)
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            uint32_t c = (uint32_t)text[i];
+
+            // UTF-16 surrogate pair where wchar_t is 16 bit
+            if (sizeof(wchar_t) == 2 && c >= 0xd800 && c < 0xdc00 && i + 1 < length)
+            {
+                uint32_t low = (uint32_t)text[i + 1];
+                if (low >= 0xdc00 && low < 0xe000)
+                {
+                    c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+                    i++;
+                }
+            }
+
+            if (c < 0x80)
+            {
+                out.push_back((char)c);
+            }
+            else if (c < 0x800)
+            {
+                out.push_back((char)(0xc0 | (c >> 6)));
+                out.push_back((char)(0x80 | (c & 0x3f)));
+            }
+            else if (c < 0x10000)
+            {
+                out.push_back((char)(0xe0 | (c >> 12)));
+                out.push_back((char)(0x80 | ((c >> 6) & 0x3f)));
+                out.push_back((char)(0x80 | (c & 0x3f)));
+            }
+            else
+            {
+                out.push_back((char)(0xf0 | (c >> 18)));
+                out.push_back((char)(0x80 | ((c >> 12) & 0x3f)));
+                out.push_back((char)(0x80 | ((c >> 6) & 0x3f)));
+                out.push_back((char)(0x80 | (c & 0x3f)));
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// LogRecordWriter
+//-----------------------------------------------------------------------------
+void LogRecordWriter::PutString(LogArgType type, const void* value, size_t length, size_t unit)
+{
+    size_t available = (size_t)(m_end - m_cursor);
+    if (available < 1 + sizeof(uint16_t))
+    {
+        m_record->truncated = 1;
+        return;
+    }
+
+    size_t units = std::min(length, (available - 1 - sizeof(uint16_t)) / unit);
+    units = std::min(units, (size_t)UINT16_MAX);
+    if (units < length)
+    {
+        m_record->truncated = 1;
+    }
+
+    uint16_t stored = (uint16_t)units;
+    *m_cursor++ = type;
+    memcpy(m_cursor, &stored, sizeof(stored));
+    m_cursor += sizeof(stored);
+    if (units > 0)
+    {
+        memcpy(m_cursor, value, units * unit);
+        m_cursor += units * unit;
+    }
+    m_record->argCount++;
+}
+
+//-----------------------------------------------------------------------------
+// Sinks
+//-----------------------------------------------------------------------------
+FileLogSink::FileLogSink() :
+    m_file(nullptr)
+{
+}
+
+FileLogSink::~FileLogSink()
+{
+    if (m_file != nullptr)
+    {
+        fclose(m_file);
+    }
+}
+
+bool FileLogSink::Open(const char* path)
+{
+    if (m_file != nullptr)
+    {
+        fclose(m_file);
+    }
+
+#if defined(_MSC_VER)
+    if (fopen_s(&m_file, path, "ab") != 0)
+    {
+        m_file = nullptr;
+    }
+#else
+    m_file = fopen(path, "ab");
+#endif
+    return m_file != nullptr;
+}
+
+void FileLogSink::Write(const LogEntry& entry)
+{
+    if (m_file == nullptr)
+    {
+        return;
+    }
+
+    // one entry per line, whatever newlines the message ends with
+    size_t length = entry.length;
+    while (length > 0 && (entry.text[length - 1] == L'\n' || entry.text[length - 1] == L'\r'))
+    {
+        length--;
+    }
+
+    char prefix[64];
+    int prefixLength = snprintf(prefix, sizeof(prefix), "%llu.%06llu [%u] %s ",
+        (unsigned long long)(entry.timestamp / 1000000), (unsigned long long)(entry.timestamp % 1000000),
+        entry.threadId, LevelName(entry.level));
+
+    m_line.assign(prefix, prefix + std::max(prefixLength, 0));
+    AppendUtf8(m_line, entry.text, length);
+    m_line.push_back('\n');
+
+    fwrite(m_line.data(), 1, m_line.size(), m_file);
+}
+
+void FileLogSink::Flush()
+{
+    if (m_file != nullptr)
+    {
+        fflush(m_file);
+    }
+}
+
+BinaryFileLogSink::BinaryFileLogSink() :
+    m_file(nullptr)
+{
+}
+
+BinaryFileLogSink::~BinaryFileLogSink()
+{
+    if (m_file != nullptr)
+    {
+        fclose(m_file);
+    }
+}
+
+bool BinaryFileLogSink::Open(const char* path)
+{
+    if (m_file != nullptr)
+    {
+        fclose(m_file);
+    }
+    m_formatIds.clear();
+
+    // a new file each time, ids are only valid within one
+#if defined(_MSC_VER)
+    if (fopen_s(&m_file, path, "wb") != 0)
+    {
+        m_file = nullptr;
+    }
+#else
+    m_file = fopen(path, "wb");
+#endif
+    if (m_file == nullptr)
+    {
+        return false;
+    }
+
+    uint8_t header[8] = { 'M', 'E', 'L', 'B', 0, 0, (uint8_t)sizeof(wchar_t), 0 };
+    uint16_t version = c_version;
+    memcpy(header + 4, &version, sizeof(version));
+    fwrite(header, 1, sizeof(header), m_file);
+    return true;
+}
+
+void BinaryFileLogSink::Write(const LogEntry& entry)
+{
+    if (m_file == nullptr || entry.record == nullptr)
+    {
+        return;
+    }
+
+    const LogRecord& record = *entry.record;
+    const wchar_t* format = (record.format != nullptr) ? record.format : L"";
+
+    auto Append = [this](const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        m_chunk.insert(m_chunk.end(), bytes, bytes + size);
+    };
+
+    m_chunk.clear();
+
+    uint32_t formatId;
+    auto known = m_formatIds.find(format);
+    if (known != m_formatIds.end())
+    {
+        formatId = known->second;
+    }
+    else
+    {
+        formatId = (uint32_t)m_formatIds.size();
+        m_formatIds[format] = formatId;
+
+        std::vector<char> text;
+        AppendUtf8(text, format, wcslen(format));
+        uint16_t length = (uint16_t)std::min(text.size(), (size_t)UINT16_MAX);
+
+        m_chunk.push_back('F');
+        Append(&formatId, sizeof(formatId));
+        Append(&length, sizeof(length));
+        Append(text.data(), length);
+    }
+
+    uint8_t level = (uint8_t)record.level;
+    m_chunk.push_back('R');
+    Append(&formatId, sizeof(formatId));
+    Append(&record.timestamp, sizeof(record.timestamp));
+    Append(&entry.threadId, sizeof(entry.threadId));
+    Append(&level, sizeof(level));
+    Append(&record.truncated, sizeof(record.truncated));
+    Append(&record.size, sizeof(record.size));
+    Append(record.data, record.size);
+
+    fwrite(m_chunk.data(), 1, m_chunk.size(), m_file);
+}
+
+void BinaryFileLogSink::Flush()
+{
+    if (m_file != nullptr)
+    {
+        fflush(m_file);
+    }
+}
+
+#if defined(_WIN32)
+void DebugOutputLogSink::Write(const LogEntry& entry)
+{
+    // same text Log() used to print synchronously
+    m_line.assign(entry.text, entry.text + entry.length);
+    m_line.push_back(L'\0');
+    OutputDebugStringW(m_line.data());
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// AsyncLogger
+//-----------------------------------------------------------------------------
+AsyncLogger& AsyncLogger::Instance()
+{
+    static AsyncLogger* s_logger = new AsyncLogger();
+    return *s_logger;
+}
+
+AsyncLogger::AsyncLogger() :
+    m_start(std::chrono::steady_clock::now()),
+    m_retiredLogged(0),
+    m_retiredDropped(0),
+    m_retiredTruncated(0),
+    m_running(false),
+    m_stopRequested(false),
+    m_passesStarted(0),
+    m_passesCompleted(0),
+    m_wakeRequested(false),
+    m_written(0)
+{
+}
+
+uint64_t AsyncLogger::Now() const
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - m_start).count();
+}
+
+AsyncLogger::ThreadRing* AsyncLogger::CurrentRing()
+{
+    // Marks the ring retired when the thread exits; the drain thread frees
+    // it once it is empty.
+    struct RingOwner
+    {
+        RingOwner() : ring(nullptr) {}
+        ~RingOwner()
+        {
+            if (ring != nullptr)
+            {
+                ring->retired.store(true, std::memory_order_release);
+            }
+        }
+
+        ThreadRing* ring;
+    };
+
+    thread_local RingOwner owner;
+    if (owner.ring == nullptr)
+    {
+        owner.ring = RegisterThread();
+    }
+    return owner.ring;
+}
+
+AsyncLogger::ThreadRing* AsyncLogger::RegisterThread()
+{
+    std::shared_ptr<ThreadRing> ring;
+    try
+    {
+        ring = std::make_shared<ThreadRing>();
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+
+    ring->threadId = CurrentThreadId();
+
+    std::lock_guard<std::mutex> lock(m_ringLock);
+    m_rings.push_back(ring);
+    return ring.get();
+}
+
+void AsyncLogger::Wake(uint32_t level, uint32_t queued)
+{
+    if (!m_running.load(std::memory_order_acquire))
+    {
+        EnsureStarted();
+    }
+
+    // errors go out right away, and a ring filling up gets drained before
+    // it starts dropping; everything else waits for the next pass
+    if (level == c_logLevelError || queued == c_ringCapacity / 2)
+    {
+        m_wakeRequested.store(true, std::memory_order_release);
+        m_drainWake.notify_one();
+    }
+}
+
+void AsyncLogger::EnsureStarted()
+{
+    std::lock_guard<std::mutex> lock(m_drainLock);
+    if (m_running.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    try
+    {
+        m_drainThread = std::thread(&AsyncLogger::DrainLoop, this);
+        m_running.store(true, std::memory_order_release);
+    }
+    catch (const std::system_error&)
+    {
+        // records stay queued until a later call manages to start it
+    }
+}
+
+void AsyncLogger::AddSink(const std::shared_ptr<ILogSink>& sink)
+{
+    if (sink == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_sinkLock);
+    m_sinks.push_back(sink);
+}
+
+void AsyncLogger::RemoveSink(const std::shared_ptr<ILogSink>& sink)
+{
+    std::lock_guard<std::mutex> lock(m_sinkLock);
+    m_sinks.erase(std::remove(m_sinks.begin(), m_sinks.end(), sink), m_sinks.end());
+}
+
+void AsyncLogger::Flush()
+{
+    std::unique_lock<std::mutex> lock(m_drainLock);
+    if (!m_running.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    // wait for a pass that started after this call
+    uint64_t target = m_passesStarted + 1;
+    m_wakeRequested.store(true, std::memory_order_release);
+    m_drainWake.notify_one();
+    m_drainDone.wait(lock, [this, target] {
+        return m_passesCompleted >= target || !m_running.load(std::memory_order_relaxed);
+    });
+}
+
+void AsyncLogger::Stop()
+{
+    std::thread drainThread;
+    {
+        std::lock_guard<std::mutex> lock(m_drainLock);
+        if (!m_running.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        m_stopRequested = true;
+        drainThread = std::move(m_drainThread);
+    }
+
+    m_drainWake.notify_one();
+    drainThread.join();
+
+    std::lock_guard<std::mutex> lock(m_drainLock);
+    m_stopRequested = false;
+    m_running.store(false, std::memory_order_release);
+    m_drainDone.notify_all();
+}
+
+void AsyncLogger::DrainLoop()
+{
+    std::vector<wchar_t> text(c_formatCapacity);
+
+    std::unique_lock<std::mutex> lock(m_drainLock);
+    for (;;)
+    {
+        bool stopping = m_stopRequested;
+        m_passesStarted++;
+        lock.unlock();
+
+        bool wroteAny = false;
+        while (DrainOnce(text))
+        {
+            wroteAny = true;
+        }
+
+        if (wroteAny)
+        {
+            std::lock_guard<std::mutex> sinkLock(m_sinkLock);
+            for (auto& sink : m_sinks)
+            {
+                sink->Flush();
+            }
+        }
+
+        lock.lock();
+        m_passesCompleted++;
+        m_drainDone.notify_all();
+
+        if (stopping)
+        {
+            break;
+        }
+
+        m_drainWake.wait_for(lock, std::chrono::milliseconds(10), [this] {
+            return m_stopRequested || m_wakeRequested.exchange(false, std::memory_order_acq_rel);
+        });
+    }
+}
+
+bool AsyncLogger::DrainOnce(std::vector<wchar_t>& text)
+{
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(m_ringLock);
+        rings = m_rings;
+    }
+
+    std::lock_guard<std::mutex> sinkLock(m_sinkLock);
+
+    // binary sinks take the record as captured, skip formatting for them
+    bool wantsText = false;
+    for (auto& sink : m_sinks)
+    {
+        wantsText = wantsText || sink->WantsText();
+    }
+
+    bool drained = false;
+    for (auto& ring : rings)
+    {
+        // read before tail, so a retired ring seen empty stays empty
+        bool retired = ring->retired.load(std::memory_order_acquire);
+
+        uint32_t head = ring->head.load(std::memory_order_relaxed);
+        uint32_t tail = ring->tail.load(std::memory_order_acquire);
+        for (; head != tail; head++)
+        {
+            const LogRecord& record = ring->records[head % c_ringCapacity];
+
+            LogEntry entry;
+            entry.timestamp = record.timestamp;
+            entry.threadId = ring->threadId;
+            entry.level = record.level;
+            entry.text = text.data();
+            entry.length = wantsText ? Format(record, text.data(), text.size()) : 0;
+            entry.record = &record;
+            if (!wantsText)
+            {
+                text[0] = L'\0';
+            }
+
+            for (auto& sink : m_sinks)
+            {
+                sink->Write(entry);
+            }
+
+            ring->head.store(head + 1, std::memory_order_release);
+            m_written.fetch_add(1, std::memory_order_relaxed);
+            drained = true;
+        }
+
+        if (retired)
+        {
+            std::lock_guard<std::mutex> lock(m_ringLock);
+            m_retiredLogged += ring->logged.load(std::memory_order_relaxed);
+            m_retiredDropped += ring->dropped.load(std::memory_order_relaxed);
+            m_retiredTruncated += ring->truncated.load(std::memory_order_relaxed);
+            m_rings.erase(std::remove(m_rings.begin(), m_rings.end(), ring), m_rings.end());
+        }
+    }
+
+    return drained;
+}
+
+void AsyncLogger::GetStats(LogStats* stats)
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_ringLock);
+
+    stats->logged = m_retiredLogged;
+    stats->dropped = m_retiredDropped;
+    stats->truncated = m_retiredTruncated;
+    for (auto& ring : m_rings)
+    {
+        stats->logged += ring->logged.load(std::memory_order_relaxed);
+        stats->dropped += ring->dropped.load(std::memory_order_relaxed);
+        stats->truncated += ring->truncated.load(std::memory_order_relaxed);
+    }
+    stats->written = m_written.load(std::memory_order_relaxed);
+    stats->threads = (uint32_t)m_rings.size();
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Function:   AsyncLogger::Format
+//
+//  Synopsis:   printf-style formatting of a record. Each conversion is
+//              rebuilt around the type the argument was captured with, so
+//              a mismatched specifier prints the wrong way round instead of
+//              reading garbage. Missing arguments leave the specifier as is.
+//
+//-----------------------------------------------------------------------------
+size_t AsyncLogger::Format(const LogRecord& record, wchar_t* text, size_t capacity)
+{
+    if (capacity == 0)
+    {
+        return 0;
+    }
+
+    LogRecordReader reader(record);
+    size_t length = 0;
+    const wchar_t* p = (record.format != nullptr) ? record.format : L"";
+
+    while (*p != L'\0' && length + 1 < capacity)
+    {
+        if (*p != L'%')
+        {
+            text[length++] = *p++;
+            continue;
+        }
+
+        if (p[1] == L'%')
+        {
+            text[length++] = L'%';
+            p += 2;
+            continue;
+        }
+
+        const wchar_t* specStart = p++;
+        wchar_t flags[8];
+        size_t flagCount = 0;
+        while (*p != L'\0' && wcschr(L"-+ #0", *p) != nullptr)
+        {
+            if (flagCount + 1 < sizeof(flags) / sizeof(flags[0]))
+            {
+                flags[flagCount++] = *p;
+            }
+            p++;
+        }
+        flags[flagCount] = L'\0';
+
+        LogArgType type;
+        uint64_t scalar = 0;
+        double real = 0;
+        const uint8_t* string = nullptr;
+        size_t stringLength = 0;
+        bool haveArg = true;
+
+        int width = -1;
+        if (*p == L'*')
+        {
+            p++;
+            haveArg = reader.Next(&type, &scalar, &real, &string, &stringLength);
+            width = (int)scalar;
+        }
+        else
+        {
+            for (; *p >= L'0' && *p <= L'9'; p++)
+            {
+                width = (width < 0 ? 0 : width * 10) + (*p - L'0');
+            }
+        }
+
+        int precision = -1;
+        if (*p == L'.')
+        {
+            p++;
+            precision = 0;
+            if (*p == L'*')
+            {
+                p++;
+                haveArg = haveArg && reader.Next(&type, &scalar, &real, &string, &stringLength);
+                precision = (int)scalar;
+            }
+            else
+            {
+                for (; *p >= L'0' && *p <= L'9'; p++)
+                {
+                    precision = precision * 10 + (*p - L'0');
+                }
+            }
+        }
+
+        // the captured type decides the length modifier, skip the caller's
+        while (*p != L'\0' && wcschr(L"hlLqjztIw", *p) != nullptr)
+        {
+            if (*p == L'I' && ((p[1] == L'6' && p[2] == L'4') || (p[1] == L'3' && p[2] == L'2')))
+            {
+                p += 2;
+            }
+            p++;
+        }
+
+        wchar_t conversion = *p;
+        if (conversion == L'\0')
+        {
+            break;
+        }
+        p++;
+
+        if (!haveArg || !reader.Next(&type, &scalar, &real, &string, &stringLength))
+        {
+            for (const wchar_t* s = specStart; s < p && length + 1 < capacity; s++)
+            {
+                text[length++] = *s;
+            }
+            continue;
+        }
+
+        // %<flags><width>.<precision><length><conversion>
+        wchar_t spec[32];
+        int specLength = swprintf(spec, 32, L"%%%ls", flags);
+        if (width >= 0)
+        {
+            specLength += swprintf(spec + specLength, 32 - specLength, L"%d", width);
+        }
+        if (precision >= 0)
+        {
+            specLength += swprintf(spec + specLength, 32 - specLength, L".%d", precision);
+        }
+
+        int written;
+        size_t room = capacity - length;
+        switch (type)
+        {
+        case LogArg_Int:
+        case LogArg_UInt:
+        case LogArg_HResult:
+        case LogArg_Pts:
+        case LogArg_Width:
+        case LogArg_Height:
+        case LogArg_PlayerId:
+            if (conversion == L'c')
+            {
+                swprintf(spec + specLength, 32 - specLength, L"lc");
+                written = swprintf(text + length, room, spec, (wint_t)scalar);
+            }
+            else
+            {
+                wchar_t integer = wcschr(L"diuxXo", conversion) ? conversion : (IsSignedArg(type) ? L'd' : L'u');
+                swprintf(spec + specLength, 32 - specLength, L"ll%lc", (wint_t)integer);
+                written = swprintf(text + length, room, spec, (long long)scalar);
+            }
+            break;
+
+        case LogArg_Double:
+        {
+            wchar_t floating = wcschr(L"fFeEgGaA", conversion) ? conversion : L'g';
+            swprintf(spec + specLength, 32 - specLength, L"%lc", (wint_t)floating);
+            written = swprintf(text + length, room, spec, real);
+            break;
+        }
+
+        case LogArg_Pointer:
+            if (conversion == L'x' || conversion == L'X')
+            {
+                swprintf(spec + specLength, 32 - specLength, L"ll%lc", (wint_t)conversion);
+                written = swprintf(text + length, room, spec, (unsigned long long)scalar);
+            }
+            else
+            {
+                swprintf(spec + specLength, 32 - specLength, L"p");
+                written = swprintf(text + length, room, spec, (void*)(uintptr_t)scalar);
+            }
+            break;
+
+        case LogArg_WString:
+        {
+            // the record only guarantees byte alignment
+            wchar_t value[c_logRecordBytes / sizeof(wchar_t) + 1];
+            memcpy(value, string, stringLength * sizeof(wchar_t));
+            value[stringLength] = L'\0';
+            swprintf(spec + specLength, 32 - specLength, L"ls");
+            written = swprintf(text + length, room, spec, value);
+            break;
+        }
+
+        case LogArg_String:
+        default:
+        {
+            char value[c_logRecordBytes + 1];
+            memcpy(value, string, stringLength);
+            value[stringLength] = '\0';
+#if defined(_MSC_VER)
+            swprintf(spec + specLength, 32 - specLength, L"hs");
+#else
+            swprintf(spec + specLength, 32 - specLength, L"s");
+#endif
+            written = swprintf(text + length, room, spec, value);
+            break;
+        }
+        }
+
+        if (written < 0)
+        {
+            // did not fit, the message ends before this argument
+            break;
+        }
+        length += (size_t)written;
+    }
+
+    text[length] = L'\0';
+    return length;
+}
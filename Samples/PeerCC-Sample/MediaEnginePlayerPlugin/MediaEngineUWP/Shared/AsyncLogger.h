@@ -0,0 +1,575 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace MEDIA
+{
+    // Levels follow Log_Level in MediaEngine.h: 0 any, 1 error, 2 warning,
+    // 3 info.
+    const uint32_t c_logLevelError = 1;
+
+    struct LogRecord;
+
+    struct LogEntry
+    {
+        uint64_t timestamp;     // microseconds since the logger was created
+        uint32_t threadId;
+        uint32_t level;
+        const wchar_t* text;    // formatted, no trailing newline added; empty
+                                // when no sink wants text
+        size_t length;
+        const LogRecord* record;
+    };
+
+    struct LogStats
+    {
+        uint64_t logged;
+        uint64_t dropped;
+        uint64_t truncated;
+        uint64_t written;
+        uint32_t threads;
+    };
+
+    //-----------------------------------------------------------------------------
+    // ILogSink
+    //
+    // Receives entries on the drain thread, one at a time. Records are only
+    // formatted when at least one sink wants text.
+    //-----------------------------------------------------------------------------
+    class ILogSink
+    {
+    public:
+        virtual ~ILogSink() {}
+        virtual void Write(const LogEntry& entry) = 0;
+        virtual void Flush() {}
+        virtual bool WantsText() const { return true; }
+    };
+
+    // Appends UTF-8 lines to a file.
+    class FileLogSink : public ILogSink
+    {
+    public:
+        FileLogSink();
+        virtual ~FileLogSink();
+
+        bool Open(const char* path);
+        virtual void Write(const LogEntry& entry);
+        virtual void Flush();
+
+    private:
+        FileLogSink(const FileLogSink&);
+        FileLogSink& operator=(const FileLogSink&);
+
+        FILE* m_file;
+        std::vector<char> m_line;
+    };
+
+    // Appends the captured records unformatted. The file starts with
+    //   "MELB", uint16 version, uint8 sizeof(wchar_t), uint8 0
+    // followed by chunks, each introduced by one byte:
+    //   'F' uint32 id, uint16 length, UTF-8 format text
+    //   'R' uint32 format id, uint64 timestamp, uint32 thread id,
+    //       uint8 level, uint8 truncated, uint16 size, LogRecord::data
+    // A format is written once, before the first record that uses it.
+    // Integers are little endian on every platform this runs on.
+    class BinaryFileLogSink : public ILogSink
+    {
+    public:
+        static const uint16_t c_version = 1;
+
+        BinaryFileLogSink();
+        virtual ~BinaryFileLogSink();
+
+        bool Open(const char* path);
+        virtual void Write(const LogEntry& entry);
+        virtual void Flush();
+        virtual bool WantsText() const { return false; }
+
+    private:
+        BinaryFileLogSink(const BinaryFileLogSink&);
+        BinaryFileLogSink& operator=(const BinaryFileLogSink&);
+
+        FILE* m_file;
+        std::unordered_map<const wchar_t*, uint32_t> m_formatIds;
+        std::vector<char> m_chunk;
+    };
+
+#if defined(_WIN32)
+    // Sends every entry to OutputDebugStringW.
+    class DebugOutputLogSink : public ILogSink
+    {
+    public:
+        virtual void Write(const LogEntry& entry);
+
+    private:
+        std::vector<wchar_t> m_line;
+    };
+#endif
+
+    //-----------------------------------------------------------------------------
+    // Log records
+    //
+    // The calling thread only copies the format pointer and the arguments,
+    // tagged by type, into a fixed size record; formatting happens on the
+    // drain thread. The format must therefore outlive the logger, which a
+    // string literal does. Strings are copied and truncated to what fits.
+    //-----------------------------------------------------------------------------
+    enum LogArgType : uint8_t
+    {
+        LogArg_Int,
+        LogArg_UInt,
+        LogArg_Double,
+        LogArg_Pointer,
+        LogArg_WString,
+        LogArg_String,
+        LogArg_HResult,
+        LogArg_Pts,
+        LogArg_Width,
+        LogArg_Height,
+        LogArg_PlayerId
+    };
+
+    //-----------------------------------------------------------------------------
+    // Typed fields
+    //
+    // Wrapping a value records what it is, not just how to print it. Text
+    // sinks format it like the integer it holds; binary records keep the
+    // tag, so a reader can pull out every HRESULT or presentation time
+    // without parsing messages.
+    //-----------------------------------------------------------------------------
+    template <LogArgType Type, typename T>
+    struct LogField
+    {
+        explicit LogField(T fieldValue) : value(fieldValue) {}
+        T value;
+    };
+
+    typedef LogField<LogArg_HResult, uint32_t> LogHResult;
+    typedef LogField<LogArg_Pts, int64_t> LogPts;          // 100 ns units
+    typedef LogField<LogArg_Width, uint32_t> LogWidth;
+    typedef LogField<LogArg_Height, uint32_t> LogHeight;
+    typedef LogField<LogArg_PlayerId, int32_t> LogPlayerId;
+
+    const uint32_t c_logRecordBytes = 512;
+
+    struct LogRecord
+    {
+        uint64_t timestamp;
+        const wchar_t* format;
+        uint32_t level;
+        uint16_t argCount;
+        uint16_t size;
+        uint8_t truncated;
+        uint8_t data[c_logRecordBytes - 8 - sizeof(const wchar_t*) - 4 - 2 - 2 - 1];
+    };
+
+    class LogRecordWriter
+    {
+    public:
+        explicit LogRecordWriter(LogRecord* record) :
+            m_record(record),
+            m_cursor(record->data),
+            m_end(record->data + sizeof(record->data))
+        {
+            record->argCount = 0;
+            record->truncated = 0;
+        }
+
+        void Put(const wchar_t* value) { PutString(LogArg_WString, value, value ? wcslen(value) : 0, sizeof(wchar_t)); }
+        void Put(wchar_t* value) { Put(static_cast<const wchar_t*>(value)); }
+        void Put(const char* value) { PutString(LogArg_String, value, value ? strlen(value) : 0, sizeof(char)); }
+        void Put(char* value) { Put(static_cast<const char*>(value)); }
+        void Put(bool value) { PutScalar(LogArg_Int, (int64_t)value); }
+        void Put(float value) { PutScalar(LogArg_Double, (double)value); }
+        void Put(double value) { PutScalar(LogArg_Double, value); }
+
+        template <typename T>
+        void Put(T* value)
+        {
+            PutScalar(LogArg_Pointer, (uint64_t)(uintptr_t)value);
+        }
+
+        // integers and enums
+        template <typename T>
+        typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type Put(T value)
+        {
+            PutInteger(value, std::is_signed<typename Underlying<T>::type>());
+        }
+
+        // stored as 64 bits like the plain integers, signed ones extended
+        template <LogArgType Type, typename T>
+        void Put(const LogField<Type, T>& field)
+        {
+            PutScalar(Type, std::is_signed<T>::value ? (uint64_t)(int64_t)field.value : (uint64_t)field.value);
+        }
+
+        void Finish()
+        {
+            m_record->size = (uint16_t)(m_cursor - m_record->data);
+        }
+
+    private:
+        template <typename T, bool = std::is_enum<T>::value>
+        struct Underlying { typedef T type; };
+        template <typename T>
+        struct Underlying<T, true> { typedef typename std::underlying_type<T>::type type; };
+
+        template <typename T>
+        void PutInteger(T value, std::true_type) { PutScalar(LogArg_Int, (int64_t)value); }
+        template <typename T>
+        void PutInteger(T value, std::false_type) { PutScalar(LogArg_UInt, (uint64_t)value); }
+
+        template <typename T>
+        void PutScalar(LogArgType type, T value)
+        {
+            if ((size_t)(m_end - m_cursor) < 1 + sizeof(T))
+            {
+                m_record->truncated = 1;
+                return;
+            }
+
+            *m_cursor++ = type;
+            memcpy(m_cursor, &value, sizeof(T));
+            m_cursor += sizeof(T);
+            m_record->argCount++;
+        }
+
+        void PutString(LogArgType type, const void* value, size_t length, size_t unit);
+
+        LogRecord* m_record;
+        uint8_t* m_cursor;
+        uint8_t* m_end;
+    };
+
+    //-----------------------------------------------------------------------------
+    // Format checking
+    //
+    // LogFormatMatches walks a printf-style format at compile time and checks
+    // every conversion against the kind of argument it consumes, so the
+    // logging macros reject a missing argument or an integer passed for %s
+    // before anything runs. Conversions follow the Microsoft wide printf:
+    // %s and %ls take wide strings, %hs and %S narrow ones.
+    //-----------------------------------------------------------------------------
+    enum LogArgKind : uint8_t
+    {
+        LogKind_End,
+        LogKind_Integer,
+        LogKind_Real,
+        LogKind_Pointer,
+        LogKind_WString,
+        LogKind_String,
+        LogKind_Unsupported
+    };
+
+    template <typename T, typename D = typename std::decay<T>::type>
+    struct LogArgKindOf : std::integral_constant<uint8_t,
+        std::is_floating_point<D>::value ? LogKind_Real :
+        (std::is_integral<D>::value || std::is_enum<D>::value) ? LogKind_Integer :
+        std::is_pointer<D>::value ? LogKind_Pointer :
+        LogKind_Unsupported>
+    {
+    };
+
+    template <typename T>
+    struct LogArgKindOf<T, const wchar_t*> : std::integral_constant<uint8_t, LogKind_WString> {};
+    template <typename T>
+    struct LogArgKindOf<T, wchar_t*> : std::integral_constant<uint8_t, LogKind_WString> {};
+    template <typename T>
+    struct LogArgKindOf<T, const char*> : std::integral_constant<uint8_t, LogKind_String> {};
+    template <typename T>
+    struct LogArgKindOf<T, char*> : std::integral_constant<uint8_t, LogKind_String> {};
+    template <typename T, LogArgType Type, typename V>
+    struct LogArgKindOf<T, LogField<Type, V>> : std::integral_constant<uint8_t, LogKind_Integer> {};
+
+    template <uint8_t... Kinds>
+    struct LogArgKindList
+    {
+    };
+
+    // Only named in decltype, never called.
+    template <typename... Args>
+    LogArgKindList<LogArgKindOf<Args>::value...> LogArgKindsOf(const Args&...);
+
+    constexpr bool LogIsDigit(wchar_t c)
+    {
+        return c >= L'0' && c <= L'9';
+    }
+
+    constexpr bool LogConversionAccepts(wchar_t conversion, bool narrow, bool wide, uint8_t kind)
+    {
+        return (conversion == L'x' || conversion == L'X') ? (kind == LogKind_Integer || kind == LogKind_Pointer) :
+            (conversion == L'd' || conversion == L'i' || conversion == L'u' || conversion == L'o' || conversion == L'c') ? kind == LogKind_Integer :
+            (conversion == L'f' || conversion == L'F' || conversion == L'e' || conversion == L'E' ||
+             conversion == L'g' || conversion == L'G' || conversion == L'a' || conversion == L'A') ? kind == LogKind_Real :
+            (conversion == L'p') ? kind == LogKind_Pointer :
+            (conversion == L's') ? kind == (narrow ? LogKind_String : LogKind_WString) :
+            (conversion == L'S') ? kind == (wide ? LogKind_WString : LogKind_String) :
+            false;
+    }
+
+    constexpr bool LogFormatMatchesKinds(const wchar_t* format, const uint8_t* kinds, size_t count)
+    {
+        size_t next = 0;
+        for (const wchar_t* p = format; *p != L'\0'; p++)
+        {
+            if (*p != L'%')
+            {
+                continue;
+            }
+
+            p++;
+            if (*p == L'%')
+            {
+                continue;
+            }
+
+            while (*p == L'-' || *p == L'+' || *p == L' ' || *p == L'#' || *p == L'0')
+            {
+                p++;
+            }
+
+            // width and precision given as arguments take an integer each
+            for (int part = 0; part < 2; part++)
+            {
+                if (part == 1)
+                {
+                    if (*p != L'.')
+                    {
+                        break;
+                    }
+                    p++;
+                }
+
+                if (*p == L'*')
+                {
+                    if (next >= count || kinds[next++] != LogKind_Integer)
+                    {
+                        return false;
+                    }
+                    p++;
+                }
+                else
+                {
+                    while (LogIsDigit(*p))
+                    {
+                        p++;
+                    }
+                }
+            }
+
+            bool narrow = false;
+            bool wide = false;
+            for (;;)
+            {
+                if (*p == L'h')
+                {
+                    narrow = true;
+                }
+                else if (*p == L'l' || *p == L'w')
+                {
+                    wide = true;
+                }
+                else if (*p == L'I' && ((p[1] == L'6' && p[2] == L'4') || (p[1] == L'3' && p[2] == L'2')))
+                {
+                    p += 2;
+                }
+                else if (*p != L'L' && *p != L'q' && *p != L'j' && *p != L'z' && *p != L't' && *p != L'I')
+                {
+                    break;
+                }
+                p++;
+            }
+
+            if (*p == L'\0' || next >= count || !LogConversionAccepts(*p, narrow, wide, kinds[next++]))
+            {
+                return false;
+            }
+        }
+
+        return next == count;
+    }
+
+    template <uint8_t... Kinds>
+    constexpr bool LogFormatMatches(const wchar_t* format, LogArgKindList<Kinds...>)
+    {
+        // the end marker keeps the array from being empty
+        const uint8_t kinds[] = { Kinds..., LogKind_End };
+        return LogFormatMatchesKinds(format, kinds, sizeof...(Kinds));
+    }
+
+    //-----------------------------------------------------------------------------
+    // AsyncLogger
+    //
+    // Each logging thread gets its own single-producer ring of records, so
+    // logging never takes a lock or waits. A full ring drops the new record
+    // and counts it. One drain thread empties the rings, formats the records
+    // and hands them to the sinks; it is started by the first record and
+    // stopped by Stop, which writes out whatever is still queued.
+    //-----------------------------------------------------------------------------
+    class AsyncLogger
+    {
+    public:
+        // Records per thread.
+        static const uint32_t c_ringCapacity = 128;
+
+        // Never destroyed, so it outlives every thread that logs.
+        static AsyncLogger& Instance();
+
+        template <typename... Args>
+        void Log(uint32_t level, const wchar_t* format, const Args&... args)
+        {
+            ThreadRing* ring = CurrentRing();
+            if (ring == nullptr)
+            {
+                return;
+            }
+
+            LogRecord* record = ring->BeginWrite();
+            if (record == nullptr)
+            {
+                ring->dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            record->timestamp = Now();
+            record->format = format;
+            record->level = level;
+
+            LogRecordWriter writer(record);
+            PutAll(writer, args...);
+            writer.Finish();
+
+            if (record->truncated)
+            {
+                ring->truncated.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            uint32_t queued = ring->EndWrite();
+            Wake(level, queued);
+        }
+
+        void AddSink(const std::shared_ptr<ILogSink>& sink);
+        void RemoveSink(const std::shared_ptr<ILogSink>& sink);
+
+        // Blocks until everything logged before the call reached the sinks.
+        void Flush();
+
+        // Writes out the queue and stops the drain thread. Logging again
+        // starts a new one.
+        void Stop();
+
+        void GetStats(LogStats* stats);
+
+        // Formats one record; used by the drain thread.
+        static size_t Format(const LogRecord& record, wchar_t* text, size_t capacity);
+
+    private:
+        struct ThreadRing
+        {
+            ThreadRing() :
+                head(0),
+                tail(0),
+                logged(0),
+                dropped(0),
+                truncated(0),
+                threadId(0),
+                retired(false)
+            {
+            }
+
+            LogRecord* BeginWrite()
+            {
+                uint32_t t = tail.load(std::memory_order_relaxed);
+                if (t - head.load(std::memory_order_acquire) >= c_ringCapacity)
+                {
+                    return nullptr;
+                }
+                return &records[t % c_ringCapacity];
+            }
+
+            // Returns how many records are now queued.
+            uint32_t EndWrite()
+            {
+                uint32_t t = tail.load(std::memory_order_relaxed) + 1;
+                tail.store(t, std::memory_order_release);
+                logged.fetch_add(1, std::memory_order_relaxed);
+                return t - head.load(std::memory_order_relaxed);
+            }
+
+            LogRecord records[c_ringCapacity];
+            std::atomic<uint32_t> head;
+            std::atomic<uint32_t> tail;
+            std::atomic<uint64_t> logged;
+            std::atomic<uint64_t> dropped;
+            std::atomic<uint64_t> truncated;
+            uint32_t threadId;
+            std::atomic<bool> retired;
+        };
+
+        AsyncLogger();
+        AsyncLogger(const AsyncLogger&);
+        AsyncLogger& operator=(const AsyncLogger&);
+
+        static void PutAll(LogRecordWriter&) {}
+
+        template <typename First, typename... Rest>
+        static void PutAll(LogRecordWriter& writer, const First& first, const Rest&... rest)
+        {
+            writer.Put(first);
+            PutAll(writer, rest...);
+        }
+
+        ThreadRing* CurrentRing();
+        ThreadRing* RegisterThread();
+        uint64_t Now() const;
+        void Wake(uint32_t level, uint32_t queued);
+        void EnsureStarted();
+        void DrainLoop();
+        bool DrainOnce(std::vector<wchar_t>& text);
+
+        std::chrono::steady_clock::time_point m_start;
+
+        std::mutex m_ringLock;
+        std::vector<std::shared_ptr<ThreadRing>> m_rings;
+        uint64_t m_retiredLogged;
+        uint64_t m_retiredDropped;
+        uint64_t m_retiredTruncated;
+
+        std::mutex m_sinkLock;
+        std::vector<std::shared_ptr<ILogSink>> m_sinks;
+
+        std::mutex m_drainLock;
+        std::condition_variable m_drainWake;
+        std::condition_variable m_drainDone;
+        std::thread m_drainThread;
+        std::atomic<bool> m_running;
+        bool m_stopRequested;
+        uint64_t m_passesStarted;
+        uint64_t m_passesCompleted;
+        std::atomic<bool> m_wakeRequested;
+        std::atomic<uint64_t> m_written;
+    };
+}
@@ -0,0 +1,165 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace MEDIA
+{
+    struct CoalescingQueueStats
+    {
+        uint64_t posted;
+        uint64_t coalesced;
+        uint64_t dropped;
+        uint64_t taken;
+    };
+
+    //-----------------------------------------------------------------------------
+    // CoalescingQueue
+    //
+    // Bounded single-producer/single-consumer queue of notifications that
+    // never blocks either side. A notification is a non-zero 64 bit value
+    // whose top byte is its kind. Posting a notification while the most
+    // recent one of the same kind is still waiting replaces that one instead
+    // of queueing behind it, so a slow consumer only ever sees the latest
+    // state. When the queue is full the new notification is dropped.
+    //
+    // Each cell holds the payload itself, 0 marks it empty. The consumer
+    // empties a cell with a single exchange and the producer only replaces
+    // a waiting payload with a compare-exchange, so a payload is either
+    // taken or replaced, never both.
+    //-----------------------------------------------------------------------------
+    template <uint32_t Capacity>
+    class CoalescingQueue
+    {
+        static_assert(Capacity >= 2, "CoalescingQueue needs at least two cells");
+
+    public:
+        static uint64_t MakePayload(uint8_t kind, uint64_t value)
+        {
+            return ((uint64_t)kind << 56) | (value & 0x00ffffffffffffffull);
+        }
+
+        static uint8_t Kind(uint64_t payload)
+        {
+            return (uint8_t)(payload >> 56);
+        }
+
+        static uint64_t Value(uint64_t payload)
+        {
+            return payload & 0x00ffffffffffffffull;
+        }
+
+        CoalescingQueue() :
+            m_tail(0),
+            m_hasLast(false),
+            m_head(0),
+            m_posted(0),
+            m_coalesced(0),
+            m_dropped(0),
+            m_taken(0)
+        {
+            for (uint32_t i = 0; i < Capacity; i++)
+            {
+                m_cells[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        // Producer. Returns false when the notification was dropped.
+        bool Post(uint64_t payload)
+        {
+            m_posted.fetch_add(1, std::memory_order_relaxed);
+
+            if (m_hasLast)
+            {
+                std::atomic<uint64_t>& last = m_cells[(m_tail + Capacity - 1) % Capacity];
+                uint64_t waiting = last.load(std::memory_order_relaxed);
+                while (waiting != 0 && Kind(waiting) == Kind(payload))
+                {
+                    if (last.compare_exchange_weak(waiting, payload, std::memory_order_release, std::memory_order_relaxed))
+                    {
+                        m_coalesced.fetch_add(1, std::memory_order_relaxed);
+                        return true;
+                    }
+                }
+            }
+
+            std::atomic<uint64_t>& cell = m_cells[m_tail];
+            if (cell.load(std::memory_order_acquire) != 0)
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            cell.store(payload, std::memory_order_release);
+            m_tail = (m_tail + 1) % Capacity;
+            m_hasLast = true;
+            return true;
+        }
+
+        // Consumer. Returns false when nothing is waiting.
+        bool TryTake(uint64_t* payload)
+        {
+            uint64_t value = m_cells[m_head].exchange(0, std::memory_order_acq_rel);
+            if (value == 0)
+            {
+                return false;
+            }
+
+            m_head = (m_head + 1) % Capacity;
+            m_taken.fetch_add(1, std::memory_order_relaxed);
+            if (payload != nullptr)
+            {
+                *payload = value;
+            }
+            return true;
+        }
+
+        // Consumer. True when a notification is waiting to be taken.
+        bool HasPending() const
+        {
+            return m_cells[m_head].load(std::memory_order_acquire) != 0;
+        }
+
+        void GetStats(CoalescingQueueStats* stats) const
+        {
+            if (stats == nullptr)
+            {
+                return;
+            }
+
+            stats->posted = m_posted.load(std::memory_order_relaxed);
+            stats->coalesced = m_coalesced.load(std::memory_order_relaxed);
+            stats->dropped = m_dropped.load(std::memory_order_relaxed);
+            stats->taken = m_taken.load(std::memory_order_relaxed);
+        }
+
+    private:
+        CoalescingQueue(const CoalescingQueue&);
+        CoalescingQueue& operator=(const CoalescingQueue&);
+
+        std::atomic<uint64_t> m_cells[Capacity];
+
+        // Producer side.
+        uint32_t m_tail;
+        bool m_hasLast;
+
+        // Consumer side.
+        uint32_t m_head;
+
+        std::atomic<uint64_t> m_posted;
+        std::atomic<uint64_t> m_coalesced;
+        std::atomic<uint64_t> m_dropped;
+        std::atomic<uint64_t> m_taken;
+    };
+}
@@ -0,0 +1,593 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "ColorConvert.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define ME_COLOR_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define ME_TARGET_SSE41
+#define ME_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define ME_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define ME_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace MEDIA;
+
+namespace
+{
+    // Every kernel evaluates exactly this integer arithmetic, which is what
+    // keeps their output bit-identical:
+    //
+    //   y' = (Y - yOffset) * yScale + round
+    //   R  = (y' + crv * V') >> shift
+    //   G  = (y' - cgu * U' - cgv * V') >> shift
+    //   B  = (y' + cbu * U') >> shift
+    //
+    // with U' and V' the chroma values minus cOffset, and each result
+    // clamped to [0, 255]. Coefficients carry 14 fractional bits; samples
+    // deeper than 8 bit are treated as 8 bit values scaled up, so only the
+    // offsets and the shift depend on the bit depth.
+    struct Coefficients
+    {
+        int32_t yScale;
+        int32_t yOffset;
+        int32_t cOffset;
+        int32_t crv;
+        int32_t cgu;
+        int32_t cgv;
+        int32_t cbu;
+        int32_t round;
+        int shift;
+    };
+
+    const int c_fractionBits = 14;
+
+    Coefficients MakeCoefficients(const ColorConvertParams& params, int bitDepth)
+    {
+        double kr = 0.299;
+        double kb = 0.114;
+        if (params.matrix == ColorMatrix_BT709)
+        {
+            kr = 0.2126;
+            kb = 0.0722;
+        }
+        double kg = 1.0 - kr - kb;
+
+        double yScale = 1.0;
+        double cScale = 1.0;
+        int32_t yOffset = 0;
+        if (params.range == ColorRange_Limited)
+        {
+            yScale = 255.0 / 219.0;
+            cScale = 255.0 / 224.0;
+            yOffset = 16;
+        }
+
+        const double one = (double)(1 << c_fractionBits);
+        const int depthShift = bitDepth - 8;
+
+        Coefficients c;
+        c.yScale = (int32_t)std::floor(yScale * one + 0.5);
+        c.yOffset = yOffset << depthShift;
+        c.cOffset = 128 << depthShift;
+        c.crv = (int32_t)std::floor(2.0 * (1.0 - kr) * cScale * one + 0.5);
+        c.cgu = (int32_t)std::floor(2.0 * (1.0 - kb) * kb / kg * cScale * one + 0.5);
+        c.cgv = (int32_t)std::floor(2.0 * (1.0 - kr) * kr / kg * cScale * one + 0.5);
+        c.cbu = (int32_t)std::floor(2.0 * (1.0 - kb) * cScale * one + 0.5);
+        c.shift = c_fractionBits + depthShift;
+        c.round = 1 << (c.shift - 1);
+        return c;
+    }
+
+    inline uint8_t Clamp8(int32_t value)
+    {
+        return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+    }
+
+    inline void StorePixel(uint8_t* bgra, int32_t y, int32_t u, int32_t v, const Coefficients& c)
+    {
+        int32_t yy = (y - c.yOffset) * c.yScale + c.round;
+        u -= c.cOffset;
+        v -= c.cOffset;
+        bgra[0] = Clamp8((yy + c.cbu * u) >> c.shift);
+        bgra[1] = Clamp8((yy - c.cgu * u - c.cgv * v) >> c.shift);
+        bgra[2] = Clamp8((yy + c.crv * v) >> c.shift);
+        bgra[3] = 255;
+    }
+
+    //-------------------------------------------------------------------------
+    // Scalar rows, also used for the tail the vector kernels leave behind.
+    //-------------------------------------------------------------------------
+    void RowNV12Scalar(const uint8_t* y, const uint8_t* uv, uint8_t* bgra, int x, int width, const Coefficients& c)
+    {
+        for (; x < width; x++)
+        {
+            StorePixel(bgra + x * 4, y[x], uv[(x & ~1)], uv[(x & ~1) + 1], c);
+        }
+    }
+
+    void RowI420Scalar(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* bgra, int x, int width, const Coefficients& c)
+    {
+        for (; x < width; x++)
+        {
+            StorePixel(bgra + x * 4, y[x], u[x >> 1], v[x >> 1], c);
+        }
+    }
+
+    void RowP010Scalar(const uint16_t* y, const uint16_t* uv, uint8_t* bgra, int x, int width, const Coefficients& c)
+    {
+        for (; x < width; x++)
+        {
+            StorePixel(bgra + x * 4, y[x] >> 6, uv[(x & ~1)] >> 6, uv[(x & ~1) + 1] >> 6, c);
+        }
+    }
+
+#if defined(ME_COLOR_X86)
+    //-------------------------------------------------------------------------
+    // SSE4.1 rows, 8 pixels per step with 32 bit lanes (_mm_mullo_epi32).
+    //-------------------------------------------------------------------------
+    struct VectorCoefficients128
+    {
+        __m128i yScale, yOffset, cOffset, crv, cgu, cgv, cbu, round, shift;
+    };
+
+    ME_TARGET_SSE41 VectorCoefficients128 Load128(const Coefficients& c)
+    {
+        VectorCoefficients128 vc;
+        vc.yScale = _mm_set1_epi32(c.yScale);
+        vc.yOffset = _mm_set1_epi32(c.yOffset);
+        vc.cOffset = _mm_set1_epi32(c.cOffset);
+        vc.crv = _mm_set1_epi32(c.crv);
+        vc.cgu = _mm_set1_epi32(c.cgu);
+        vc.cgv = _mm_set1_epi32(c.cgv);
+        vc.cbu = _mm_set1_epi32(c.cbu);
+        vc.round = _mm_set1_epi32(c.round);
+        vc.shift = _mm_cvtsi32_si128(c.shift);
+        return vc;
+    }
+
+    ME_TARGET_SSE41 inline void Convert4(__m128i y, __m128i u, __m128i v, const VectorCoefficients128& vc,
+        __m128i* b, __m128i* g, __m128i* r)
+    {
+        __m128i yy = _mm_add_epi32(_mm_mullo_epi32(_mm_sub_epi32(y, vc.yOffset), vc.yScale), vc.round);
+        u = _mm_sub_epi32(u, vc.cOffset);
+        v = _mm_sub_epi32(v, vc.cOffset);
+        *b = _mm_sra_epi32(_mm_add_epi32(yy, _mm_mullo_epi32(vc.cbu, u)), vc.shift);
+        *g = _mm_sra_epi32(_mm_sub_epi32(_mm_sub_epi32(yy, _mm_mullo_epi32(vc.cgu, u)), _mm_mullo_epi32(vc.cgv, v)), vc.shift);
+        *r = _mm_sra_epi32(_mm_add_epi32(yy, _mm_mullo_epi32(vc.crv, v)), vc.shift);
+    }
+
+    // Saturating packs clamp to [0, 255] exactly like Clamp8.
+    ME_TARGET_SSE41 inline __m128i Pack8(__m128i lo, __m128i hi)
+    {
+        return _mm_packus_epi16(_mm_packs_epi32(lo, hi), _mm_setzero_si128());
+    }
+
+    ME_TARGET_SSE41 inline void Store8(uint8_t* bgra, __m128i b, __m128i g, __m128i r)
+    {
+        __m128i bg = _mm_unpacklo_epi8(b, g);
+        __m128i ra = _mm_unpacklo_epi8(r, _mm_set1_epi8((char)0xff));
+        _mm_storeu_si128((__m128i*)bgra, _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i*)(bgra + 16), _mm_unpackhi_epi16(bg, ra));
+    }
+
+    ME_TARGET_SSE41 inline void Convert8(__m128i y0, __m128i y1, __m128i u0, __m128i u1, __m128i v0, __m128i v1,
+        const VectorCoefficients128& vc, uint8_t* bgra)
+    {
+        __m128i b0, g0, r0, b1, g1, r1;
+        Convert4(y0, u0, v0, vc, &b0, &g0, &r0);
+        Convert4(y1, u1, v1, vc, &b1, &g1, &r1);
+        Store8(bgra, Pack8(b0, b1), Pack8(g0, g1), Pack8(r0, r1));
+    }
+
+    inline __m128i Load4Bytes(const uint8_t* p)
+    {
+        int32_t value;
+        memcpy(&value, p, sizeof(value));
+        return _mm_cvtsi32_si128(value);
+    }
+
+    ME_TARGET_SSE41 int RowNV12SSE41(const uint8_t* y, const uint8_t* uv, uint8_t* bgra, int width, const Coefficients& c)
+    {
+        const VectorCoefficients128 vc = Load128(c);
+        const __m128i uMask = _mm_setr_epi8(0, 0, 2, 2, 4, 4, 6, 6, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i vMask = _mm_setr_epi8(1, 1, 3, 3, 5, 5, 7, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+
+        int x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i yb = _mm_loadl_epi64((const __m128i*)(y + x));
+            __m128i uvb = _mm_loadl_epi64((const __m128i*)(uv + x));
+            __m128i ub = _mm_shuffle_epi8(uvb, uMask);
+            __m128i vb = _mm_shuffle_epi8(uvb, vMask);
+            Convert8(
+                _mm_cvtepu8_epi32(yb), _mm_cvtepu8_epi32(_mm_srli_si128(yb, 4)),
+                _mm_cvtepu8_epi32(ub), _mm_cvtepu8_epi32(_mm_srli_si128(ub, 4)),
+                _mm_cvtepu8_epi32(vb), _mm_cvtepu8_epi32(_mm_srli_si128(vb, 4)),
+                vc, bgra + x * 4);
+        }
+        return x;
+    }
+
+    ME_TARGET_SSE41 int RowI420SSE41(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* bgra, int width, const Coefficients& c)
+    {
+        const VectorCoefficients128 vc = Load128(c);
+        const __m128i dupMask = _mm_setr_epi8(0, 0, 1, 1, 2, 2, 3, 3, -1, -1, -1, -1, -1, -1, -1, -1);
+
+        int x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i yb = _mm_loadl_epi64((const __m128i*)(y + x));
+            __m128i ub = _mm_shuffle_epi8(Load4Bytes(u + x / 2), dupMask);
+            __m128i vb = _mm_shuffle_epi8(Load4Bytes(v + x / 2), dupMask);
+            Convert8(
+                _mm_cvtepu8_epi32(yb), _mm_cvtepu8_epi32(_mm_srli_si128(yb, 4)),
+                _mm_cvtepu8_epi32(ub), _mm_cvtepu8_epi32(_mm_srli_si128(ub, 4)),
+                _mm_cvtepu8_epi32(vb), _mm_cvtepu8_epi32(_mm_srli_si128(vb, 4)),
+                vc, bgra + x * 4);
+        }
+        return x;
+    }
+
+    ME_TARGET_SSE41 int RowP010SSE41(const uint16_t* y, const uint16_t* uv, uint8_t* bgra, int width, const Coefficients& c)
+    {
+        const VectorCoefficients128 vc = Load128(c);
+        const __m128i uMask = _mm_setr_epi8(0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13);
+        const __m128i vMask = _mm_setr_epi8(2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15);
+
+        int x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i yw = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(y + x)), 6);
+            __m128i uvw = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(uv + x)), 6);
+            __m128i uw = _mm_shuffle_epi8(uvw, uMask);
+            __m128i vw = _mm_shuffle_epi8(uvw, vMask);
+            Convert8(
+                _mm_cvtepu16_epi32(yw), _mm_cvtepu16_epi32(_mm_srli_si128(yw, 8)),
+                _mm_cvtepu16_epi32(uw), _mm_cvtepu16_epi32(_mm_srli_si128(uw, 8)),
+                _mm_cvtepu16_epi32(vw), _mm_cvtepu16_epi32(_mm_srli_si128(vw, 8)),
+                vc, bgra + x * 4);
+        }
+        return x;
+    }
+
+    //-------------------------------------------------------------------------
+    // AVX2 rows, the same 8 pixel steps with all eight products in one
+    // 256 bit multiply; packing and stores are shared with SSE4.1.
+    //-------------------------------------------------------------------------
+    struct VectorCoefficients256
+    {
+        __m256i yScale, yOffset, cOffset, crv, cgu, cgv, cbu, round;
+        __m128i shift;
+    };
+
+    ME_TARGET_AVX2 VectorCoefficients256 Load256(const Coefficients& c)
+    {
+        VectorCoefficients256 vc;
+        vc.yScale = _mm256_set1_epi32(c.yScale);
+        vc.yOffset = _mm256_set1_epi32(c.yOffset);
+        vc.cOffset = _mm256_set1_epi32(c.cOffset);
+        vc.crv = _mm256_set1_epi32(c.crv);
+        vc.cgu = _mm256_set1_epi32(c.cgu);
+        vc.cgv = _mm256_set1_epi32(c.cgv);
+        vc.cbu = _mm256_set1_epi32(c.cbu);
+        vc.round = _mm256_set1_epi32(c.round);
+        vc.shift = _mm_cvtsi32_si128(c.shift);
+        return vc;
+    }
+
+    ME_TARGET_AVX2 inline __m128i Pack8x32(__m256i value)
+    {
+        return _mm_packus_epi16(
+            _mm_packs_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1)),
+            _mm_setzero_si128());
+    }
+
+    ME_TARGET_AVX2 inline void Convert8x32(__m256i y, __m256i u, __m256i v, const VectorCoefficients256& vc, uint8_t* bgra)
+    {
+        __m256i yy = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(y, vc.yOffset), vc.yScale), vc.round);
+        u = _mm256_sub_epi32(u, vc.cOffset);
+        v = _mm256_sub_epi32(v, vc.cOffset);
+        __m256i b = _mm256_sra_epi32(_mm256_add_epi32(yy, _mm256_mullo_epi32(vc.cbu, u)), vc.shift);
+        __m256i g = _mm256_sra_epi32(_mm256_sub_epi32(_mm256_sub_epi32(yy, _mm256_mullo_epi32(vc.cgu, u)), _mm256_mullo_epi32(vc.cgv, v)), vc.shift);
+        __m256i r = _mm256_sra_epi32(_mm256_add_epi32(yy, _mm256_mullo_epi32(vc.crv, v)), vc.shift);
+
+        __m128i bg = _mm_unpacklo_epi8(Pack8x32(b), Pack8x32(g));
+        __m128i ra = _mm_unpacklo_epi8(Pack8x32(r), _mm_set1_epi8((char)0xff));
+        _mm_storeu_si128((__m128i*)bgra, _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i*)(bgra + 16), _mm_unpackhi_epi16(bg, ra));
+    }
+
+    ME_TARGET_AVX2 int RowNV12AVX2(const uint8_t* y, const uint8_t* uv, uint8_t* bgra, int width, const Coefficients& c)
+    {
+        const VectorCoefficients256 vc = Load256(c);
+        const __m128i uMask = _mm_setr_epi8(0, 0, 2, 2, 4, 4, 6, 6, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i vMask = _mm_setr_epi8(1, 1, 3, 3, 5, 5, 7, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+
+        int x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i yb = _mm_loadl_epi64((const __m128i*)(y + x));
+            __m128i uvb = _mm_loadl_epi64((const __m128i*)(uv + x));
+            Convert8x32(
+                _mm256_cvtepu8_epi32(yb),
+                _mm256_cvtepu8_epi32(_mm_shuffle_epi8(uvb, uMask)),
+                _mm256_cvtepu8_epi32(_mm_shuffle_epi8(uvb, vMask)),
+                vc, bgra + x * 4);
+        }
+        return x;
+    }
+
+    ME_TARGET_AVX2 int RowI420AVX2(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* bgra, int width, const Coefficients& c)
+    {
+        const VectorCoefficients256 vc = Load256(c);
+        const __m128i dupMask = _mm_setr_epi8(0, 0, 1, 1, 2, 2, 3, 3, -1, -1, -1, -1, -1, -1, -1, -1);
+
+        int x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i yb = _mm_loadl_epi64((const __m128i*)(y + x));
+            Convert8x32(
+                _mm256_cvtepu8_epi32(yb),
+                _mm256_cvtepu8_epi32(_mm_shuffle_epi8(Load4Bytes(u + x / 2), dupMask)),
+                _mm256_cvtepu8_epi32(_mm_shuffle_epi8(Load4Bytes(v + x / 2), dupMask)),
+                vc, bgra + x * 4);
+        }
+        return x;
+    }
+
+    ME_TARGET_AVX2 int RowP010AVX2(const uint16_t* y, const uint16_t* uv, uint8_t* bgra, int width, const Coefficients& c)
+    {
+        const VectorCoefficients256 vc = Load256(c);
+        const __m128i uMask = _mm_setr_epi8(0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13);
+        const __m128i vMask = _mm_setr_epi8(2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15);
+
+        int x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i yw = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(y + x)), 6);
+            __m128i uvw = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(uv + x)), 6);
+            Convert8x32(
+                _mm256_cvtepu16_epi32(yw),
+                _mm256_cvtepu16_epi32(_mm_shuffle_epi8(uvw, uMask)),
+                _mm256_cvtepu16_epi32(_mm_shuffle_epi8(uvw, vMask)),
+                vc, bgra + x * 4);
+        }
+        return x;
+    }
+
+    //-------------------------------------------------------------------------
+    // CPU feature detection.
+    //-------------------------------------------------------------------------
+    void CpuId(int leaf, int subleaf, int regs[4])
+    {
+#if defined(_MSC_VER)
+        __cpuidex(regs, leaf, subleaf);
+#else
+        unsigned int a = 0, b = 0, c = 0, d = 0;
+        __cpuid_count(leaf, subleaf, a, b, c, d);
+        regs[0] = (int)a;
+        regs[1] = (int)b;
+        regs[2] = (int)c;
+        regs[3] = (int)d;
+#endif
+    }
+
+    uint64_t XGetBV()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        uint32_t eax = 0, edx = 0;
+        __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return ((uint64_t)edx << 32) | eax;
+#endif
+    }
+
+    ConvertKernel DetectKernel()
+    {
+        int regs[4];
+        CpuId(0, 0, regs);
+        int maxLeaf = regs[0];
+
+        CpuId(1, 0, regs);
+        const bool ssse3 = (regs[2] & (1 << 9)) != 0;
+        const bool sse41 = (regs[2] & (1 << 19)) != 0;
+        const bool osxsave = (regs[2] & (1 << 27)) != 0;
+        const bool avx = (regs[2] & (1 << 28)) != 0;
+
+        if (!ssse3 || !sse41)
+        {
+            return ConvertKernel_Scalar;
+        }
+
+        // AVX2 also needs the OS to save the YMM registers.
+        if (maxLeaf >= 7 && osxsave && avx && (XGetBV() & 0x6) == 0x6)
+        {
+            CpuId(7, 0, regs);
+            if ((regs[1] & (1 << 5)) != 0)
+            {
+                return ConvertKernel_AVX2;
+            }
+        }
+
+        return ConvertKernel_SSE41;
+    }
+#else
+    ConvertKernel DetectKernel()
+    {
+        return ConvertKernel_Scalar;
+    }
+#endif
+
+    bool ResolveKernel(ConvertKernel requested, ConvertKernel* kernel)
+    {
+        if (requested == ConvertKernel_Auto)
+        {
+            *kernel = BestConvertKernel();
+            return true;
+        }
+
+        *kernel = requested;
+        return IsConvertKernelSupported(requested);
+    }
+
+    bool ValidArguments(const void* y, const void* c0, const void* c1, const void* bgra, int width, int height)
+    {
+        return y != nullptr && c0 != nullptr && c1 != nullptr && bgra != nullptr && width > 0 && height > 0;
+    }
+}
+
+ConvertKernel MEDIA::BestConvertKernel()
+{
+    // Detected once; later calls only read the cached value.
+    static const ConvertKernel s_kernel = DetectKernel();
+    return s_kernel;
+}
+
+bool MEDIA::IsConvertKernelSupported(ConvertKernel kernel)
+{
+    switch (kernel)
+    {
+    case ConvertKernel_Auto:
+    case ConvertKernel_Scalar:
+        return true;
+    case ConvertKernel_SSE41:
+        return BestConvertKernel() >= ConvertKernel_SSE41;
+    case ConvertKernel_AVX2:
+        return BestConvertKernel() >= ConvertKernel_AVX2;
+    }
+    return false;
+}
+
+bool MEDIA::ConvertNV12ToBGRA(
+    const uint8_t* y, int yStride,
+    const uint8_t* uv, int uvStride,
+    uint8_t* bgra, int bgraStride,
+    int width, int height,
+    const ColorConvertParams& params)
+{
+    ConvertKernel kernel;
+    if (!ValidArguments(y, uv, uv, bgra, width, height) || !ResolveKernel(params.kernel, &kernel))
+    {
+        return false;
+    }
+
+    const Coefficients c = MakeCoefficients(params, 8);
+    for (int row = 0; row < height; row++)
+    {
+        const uint8_t* yRow = y + (ptrdiff_t)row * yStride;
+        const uint8_t* uvRow = uv + (ptrdiff_t)(row >> 1) * uvStride;
+        uint8_t* bgraRow = bgra + (ptrdiff_t)row * bgraStride;
+
+        int x = 0;
+#if defined(ME_COLOR_X86)
+        if (kernel == ConvertKernel_AVX2)
+        {
+            x = RowNV12AVX2(yRow, uvRow, bgraRow, width, c);
+        }
+        else if (kernel == ConvertKernel_SSE41)
+        {
+            x = RowNV12SSE41(yRow, uvRow, bgraRow, width, c);
+        }
+#endif
+        RowNV12Scalar(yRow, uvRow, bgraRow, x, width, c);
+    }
+
+    return true;
+}
+
+bool MEDIA::ConvertI420ToBGRA(
+    const uint8_t* y, int yStride,
+    const uint8_t* u, int uStride,
+    const uint8_t* v, int vStride,
+    uint8_t* bgra, int bgraStride,
+    int width, int height,
+    const ColorConvertParams& params)
+{
+    ConvertKernel kernel;
+    if (!ValidArguments(y, u, v, bgra, width, height) || !ResolveKernel(params.kernel, &kernel))
+    {
+        return false;
+    }
+
+    const Coefficients c = MakeCoefficients(params, 8);
+    for (int row = 0; row < height; row++)
+    {
+        const uint8_t* yRow = y + (ptrdiff_t)row * yStride;
+        const uint8_t* uRow = u + (ptrdiff_t)(row >> 1) * uStride;
+        const uint8_t* vRow = v + (ptrdiff_t)(row >> 1) * vStride;
+        uint8_t* bgraRow = bgra + (ptrdiff_t)row * bgraStride;
+
+        int x = 0;
+#if defined(ME_COLOR_X86)
+        if (kernel == ConvertKernel_AVX2)
+        {
+            x = RowI420AVX2(yRow, uRow, vRow, bgraRow, width, c);
+        }
+        else if (kernel == ConvertKernel_SSE41)
+        {
+            x = RowI420SSE41(yRow, uRow, vRow, bgraRow, width, c);
+        }
+#endif
+        RowI420Scalar(yRow, uRow, vRow, bgraRow, x, width, c);
+    }
+
+    return true;
+}
+
+bool MEDIA::ConvertP010ToBGRA(
+    const uint16_t* y, int yStride,
+    const uint16_t* uv, int uvStride,
+    uint8_t* bgra, int bgraStride,
+    int width, int height,
+    const ColorConvertParams& params)
+{
+    ConvertKernel kernel;
+    if (!ValidArguments(y, uv, uv, bgra, width, height) || !ResolveKernel(params.kernel, &kernel))
+    {
+        return false;
+    }
+
+    const Coefficients c = MakeCoefficients(params, 10);
+    const uint8_t* yBytes = reinterpret_cast<const uint8_t*>(y);
+    const uint8_t* uvBytes = reinterpret_cast<const uint8_t*>(uv);
+    for (int row = 0; row < height; row++)
+    {
+        const uint16_t* yRow = reinterpret_cast<const uint16_t*>(yBytes + (ptrdiff_t)row * yStride);
+        const uint16_t* uvRow = reinterpret_cast<const uint16_t*>(uvBytes + (ptrdiff_t)(row >> 1) * uvStride);
+        uint8_t* bgraRow = bgra + (ptrdiff_t)row * bgraStride;
+
+        int x = 0;
+#if defined(ME_COLOR_X86)
+        if (kernel == ConvertKernel_AVX2)
+        {
+            x = RowP010AVX2(yRow, uvRow, bgraRow, width, c);
+        }
+        else if (kernel == ConvertKernel_SSE41)
+        {
+            x = RowP010SSE41(yRow, uvRow, bgraRow, width, c);
+        }
+#endif
+        RowP010Scalar(yRow, uvRow, bgraRow, x, width, c);
+    }
+
+    return true;
+}
@@ -0,0 +1,80 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// CPU color conversion for the software (WARP) path. Standard library
+// only, so the kernels can be built and compared on any x86 or ARM host.
+#include <cstdint>
+
+namespace MEDIA
+{
+    enum ColorMatrix
+    {
+        ColorMatrix_BT601,
+        ColorMatrix_BT709
+    };
+
+    enum ColorRange
+    {
+        ColorRange_Limited,
+        ColorRange_Full
+    };
+
+    // Auto picks the fastest kernel the CPU and OS support. All kernels
+    // produce bit-identical output.
+    enum ConvertKernel
+    {
+        ConvertKernel_Auto,
+        ConvertKernel_Scalar,
+        ConvertKernel_SSE41,
+        ConvertKernel_AVX2
+    };
+
+    struct ColorConvertParams
+    {
+        ColorMatrix matrix;
+        ColorRange range;
+        ConvertKernel kernel;
+    };
+
+    // Fastest kernel available on this machine, never ConvertKernel_Auto.
+    ConvertKernel BestConvertKernel();
+
+    // Returns false when the requested kernel is not supported here.
+    bool IsConvertKernelSupported(ConvertKernel kernel);
+
+    // The converters write BGRA8 with alpha 255. Strides are in bytes;
+    // chroma is 2x2 subsampled and odd sizes round the chroma plane up.
+    // They return false for bad arguments or an unsupported kernel.
+    bool ConvertNV12ToBGRA(
+        const uint8_t* y, int yStride,
+        const uint8_t* uv, int uvStride,
+        uint8_t* bgra, int bgraStride,
+        int width, int height,
+        const ColorConvertParams& params);
+
+    bool ConvertI420ToBGRA(
+        const uint8_t* y, int yStride,
+        const uint8_t* u, int uStride,
+        const uint8_t* v, int vStride,
+        uint8_t* bgra, int bgraStride,
+        int width, int height,
+        const ColorConvertParams& params);
+
+    // P010 samples are 10 bit values in the high bits of 16 bit words.
+    bool ConvertP010ToBGRA(
+        const uint16_t* y, int yStride,
+        const uint16_t* uv, int uvStride,
+        uint8_t* bgra, int bgraStride,
+        int width, int height,
+        const ColorConvertParams& params);
+}
@@ -0,0 +1,313 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "ErrorCounters.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+using namespace MEDIA;
+
+namespace
+{
+    const uint64_t c_usedBit = 1ull << 32;
+
+    uint64_t Mix(uint64_t value)
+    {
+        // splitmix64 finalizer
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ull;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebull;
+        value ^= value >> 31;
+        return value;
+    }
+
+    void CopyName(wchar_t* target, const wchar_t* source)
+    {
+        size_t length = 0;
+        if (source != nullptr)
+        {
+            for (; length + 1 < c_errorSiteNameLength && source[length] != L'\0'; length++)
+            {
+                target[length] = source[length];
+            }
+        }
+        target[length] = L'\0';
+    }
+}
+
+const wchar_t* MEDIA::ErrorSiteFileName(const wchar_t* path)
+{
+    if (path == nullptr)
+    {
+        return L"";
+    }
+
+    const wchar_t* name = path;
+    for (const wchar_t* p = path; *p != L'\0'; p++)
+    {
+        if (*p == L'\\' || *p == L'/')
+        {
+            name = p + 1;
+        }
+    }
+    return name;
+}
+
+//-----------------------------------------------------------------------------
+// ErrorSiteTable
+//-----------------------------------------------------------------------------
+ErrorSiteTable& ErrorSiteTable::Instance()
+{
+    static ErrorSiteTable* s_table = new ErrorSiteTable();
+    return *s_table;
+}
+
+ErrorSiteTable::ErrorSiteTable() :
+    m_sites(0),
+    m_overflowed(0)
+{
+    for (auto& slot : m_slots)
+    {
+        slot.key.store(0, std::memory_order_relaxed);
+        slot.ready.store(false, std::memory_order_relaxed);
+        slot.file = nullptr;
+        slot.fileName = nullptr;
+        slot.function = nullptr;
+        slot.line = 0;
+        slot.hr = 0;
+        slot.count.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t ErrorSiteTable::Record(const wchar_t* file, const wchar_t* function, uint32_t line, uint32_t hr,
+    const wchar_t** fileName)
+{
+    uint64_t key = Mix(Mix((uint64_t)(uintptr_t)file) ^ ((uint64_t)line << 32 | hr));
+    if (key == 0)
+    {
+        key = 1;
+    }
+
+    for (uint32_t probe = 0; probe < c_capacity; probe++)
+    {
+        Slot& slot = m_slots[(key + probe) % c_capacity];
+
+        uint64_t current = slot.key.load(std::memory_order_acquire);
+        if (current == 0)
+        {
+            if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel))
+            {
+                // the site's first failure pays for the path walk
+                slot.file = file;
+                slot.fileName = ErrorSiteFileName(file);
+                slot.function = function;
+                slot.line = line;
+                slot.hr = hr;
+                slot.count.store(1, std::memory_order_relaxed);
+                slot.ready.store(true, std::memory_order_release);
+                m_sites.fetch_add(1, std::memory_order_relaxed);
+
+                if (fileName != nullptr)
+                {
+                    *fileName = slot.fileName;
+                }
+                return 1;
+            }
+            // lost the race, current now holds the winner's key
+        }
+
+        if (current != key)
+        {
+            continue;
+        }
+
+        // claimed, wait for the claimant to fill it in
+        while (!slot.ready.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+
+        // a different site with the same 64 bit key probes on
+        if (slot.file != file || slot.line != line || slot.hr != hr)
+        {
+            continue;
+        }
+
+        if (fileName != nullptr)
+        {
+            *fileName = slot.fileName;
+        }
+        return slot.count.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    m_overflowed.fetch_add(1, std::memory_order_relaxed);
+    if (fileName != nullptr)
+    {
+        *fileName = ErrorSiteFileName(file);
+    }
+    return 0;
+}
+
+uint32_t ErrorSiteTable::Snapshot(ErrorSiteSample* samples, uint32_t capacity) const
+{
+    if (samples == nullptr)
+    {
+        return 0;
+    }
+
+    uint32_t copied = 0;
+    for (uint32_t i = 0; i < c_capacity && copied < capacity; i++)
+    {
+        const Slot& slot = m_slots[i];
+        if (!slot.ready.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+
+        ErrorSiteSample& sample = samples[copied++];
+        sample.hr = slot.hr;
+        sample.line = slot.line;
+        sample.count = slot.count.load(std::memory_order_relaxed);
+        CopyName(sample.file, slot.fileName);
+        CopyName(sample.function, slot.function);
+    }
+
+    return copied;
+}
+
+void ErrorSiteTable::GetStats(ErrorCounterStats* stats) const
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+
+    uint64_t overflowed = m_overflowed.load(std::memory_order_relaxed);
+    uint64_t errors = overflowed;
+    for (const auto& slot : m_slots)
+    {
+        if (slot.ready.load(std::memory_order_acquire))
+        {
+            errors += slot.count.load(std::memory_order_relaxed);
+        }
+    }
+
+    stats->sites = m_sites.load(std::memory_order_relaxed);
+    stats->errors = errors;
+    stats->overflowed = overflowed;
+}
+
+//-----------------------------------------------------------------------------
+// ErrorMessageCache
+//-----------------------------------------------------------------------------
+ErrorMessageCache& ErrorMessageCache::Instance()
+{
+    static ErrorMessageCache* s_cache = new ErrorMessageCache();
+    return *s_cache;
+}
+
+ErrorMessageCache::ErrorMessageCache() :
+    m_count(0),
+    m_misses(0)
+{
+    for (auto& slot : m_slots)
+    {
+        slot.key.store(0, std::memory_order_relaxed);
+        slot.message = nullptr;
+    }
+}
+
+const wchar_t* ErrorMessageCache::Find(uint32_t hr) const
+{
+    uint64_t key = c_usedBit | hr;
+    uint32_t start = (uint32_t)Mix(hr) % c_capacity;
+
+    for (uint32_t probe = 0; probe < c_capacity; probe++)
+    {
+        const Slot& slot = m_slots[(start + probe) % c_capacity];
+
+        // the key is published after the message
+        uint64_t current = slot.key.load(std::memory_order_acquire);
+        if (current == key)
+        {
+            return slot.message;
+        }
+        if (current == 0)
+        {
+            break;
+        }
+    }
+
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+const wchar_t* ErrorMessageCache::Intern(uint32_t hr, const wchar_t* message, size_t length)
+{
+    uint64_t key = c_usedBit | hr;
+    uint32_t start = (uint32_t)Mix(hr) % c_capacity;
+
+    std::lock_guard<std::mutex> lock(m_internLock);
+
+    for (uint32_t probe = 0; probe < c_capacity; probe++)
+    {
+        Slot& slot = m_slots[(start + probe) % c_capacity];
+
+        uint64_t current = slot.key.load(std::memory_order_relaxed);
+        if (current == key)
+        {
+            return slot.message;
+        }
+        if (current != 0)
+        {
+            continue;
+        }
+
+        std::unique_ptr<wchar_t[]> copy;
+        try
+        {
+            copy.reset(new wchar_t[length + 1]);
+            m_storage.reserve(m_storage.size() + 1);
+        }
+        catch (const std::bad_alloc&)
+        {
+            return L"";
+        }
+
+        if (length > 0)
+        {
+            memcpy(copy.get(), message, length * sizeof(wchar_t));
+        }
+        copy[length] = L'\0';
+
+        slot.message = copy.get();
+        m_storage.push_back(std::move(copy));
+        slot.key.store(key, std::memory_order_release);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        return slot.message;
+    }
+
+    return L"";
+}
+
+void ErrorMessageCache::GetStats(ErrorCounterStats* stats) const
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+
+    stats->messages = m_count.load(std::memory_order_relaxed);
+    stats->messageMisses = m_misses.load(std::memory_order_relaxed);
+}
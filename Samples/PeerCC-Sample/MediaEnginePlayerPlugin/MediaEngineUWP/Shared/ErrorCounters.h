@@ -0,0 +1,146 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace MEDIA
+{
+    const uint32_t c_errorSiteNameLength = 64;
+
+    // One call site as returned by ErrorSiteTable::Snapshot. Names are
+    // copied and truncated so the struct can be handed to managed code.
+    struct ErrorSiteSample
+    {
+        uint32_t hr;
+        uint32_t line;
+        uint64_t count;
+        wchar_t file[c_errorSiteNameLength];
+        wchar_t function[c_errorSiteNameLength];
+    };
+
+    struct ErrorCounterStats
+    {
+        uint32_t sites;
+        uint64_t errors;
+        uint64_t overflowed;    // errors from sites that did not fit
+        uint32_t messages;
+        uint64_t messageMisses; // lookups that had to call the system
+    };
+
+    // The part of a path after the last separator.
+    const wchar_t* ErrorSiteFileName(const wchar_t* path);
+
+    //-----------------------------------------------------------------------------
+    // ErrorSiteTable
+    //
+    // Counts failures per (file, line, HRESULT). Open addressing over a fixed
+    // number of slots: the first failure at a site claims a slot with a
+    // compare-exchange, later ones only increment its counter, so recording
+    // never takes a lock or allocates. File and function are the pointers
+    // of __FILEW__ and __FUNCTIONW__ and must outlive the table, which
+    // string literals do. Sites beyond the capacity are only counted as
+    // overflowed.
+    //-----------------------------------------------------------------------------
+    class ErrorSiteTable
+    {
+    public:
+        static const uint32_t c_capacity = 256;
+
+        // Never destroyed, so failures during shutdown still count.
+        static ErrorSiteTable& Instance();
+
+        ErrorSiteTable();
+
+        // Returns how many times the site has failed with hr, this time
+        // included, or 0 when the table is full. fileName receives the file
+        // without its path.
+        uint64_t Record(const wchar_t* file, const wchar_t* function, uint32_t line, uint32_t hr,
+            const wchar_t** fileName);
+
+        // Copies up to capacity sites, returns how many were copied.
+        uint32_t Snapshot(ErrorSiteSample* samples, uint32_t capacity) const;
+
+        // Fills sites, errors and overflowed.
+        void GetStats(ErrorCounterStats* stats) const;
+
+    private:
+        ErrorSiteTable(const ErrorSiteTable&);
+        ErrorSiteTable& operator=(const ErrorSiteTable&);
+
+        struct Slot
+        {
+            std::atomic<uint64_t> key;      // 0 while the slot is free
+            std::atomic<bool> ready;        // the fields below are written
+            const wchar_t* file;
+            const wchar_t* fileName;
+            const wchar_t* function;
+            uint32_t line;
+            uint32_t hr;
+            std::atomic<uint64_t> count;
+        };
+
+        Slot m_slots[c_capacity];
+        std::atomic<uint32_t> m_sites;
+        std::atomic<uint64_t> m_overflowed;
+    };
+
+    //-----------------------------------------------------------------------------
+    // ErrorMessageCache
+    //
+    // HRESULT to message text, looked up once per code. Find is lock-free;
+    // Intern copies a message in under a lock and the copy lives as long as
+    // the cache, so callers can keep the pointer.
+    //-----------------------------------------------------------------------------
+    class ErrorMessageCache
+    {
+    public:
+        static const uint32_t c_capacity = 128;
+
+        // Never destroyed, like ErrorSiteTable.
+        static ErrorMessageCache& Instance();
+
+        ErrorMessageCache();
+
+        // nullptr when hr has not been interned yet.
+        const wchar_t* Find(uint32_t hr) const;
+
+        // Returns the interned copy, the one interned first if another
+        // thread raced this one, or an empty string when the cache is full.
+        const wchar_t* Intern(uint32_t hr, const wchar_t* message, size_t length);
+
+        // Fills messages and messageMisses.
+        void GetStats(ErrorCounterStats* stats) const;
+
+    private:
+        ErrorMessageCache(const ErrorMessageCache&);
+        ErrorMessageCache& operator=(const ErrorMessageCache&);
+
+        struct Slot
+        {
+            std::atomic<uint64_t> key;      // hr | c_usedBit once published
+            const wchar_t* message;
+        };
+
+        Slot m_slots[c_capacity];
+        std::atomic<uint32_t> m_count;
+        mutable std::atomic<uint64_t> m_misses;
+
+        std::mutex m_internLock;
+        std::vector<std::unique_ptr<wchar_t[]>> m_storage;
+    };
+}
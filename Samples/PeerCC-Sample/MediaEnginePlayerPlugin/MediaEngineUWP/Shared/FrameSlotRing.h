@@ -0,0 +1,170 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace MEDIA
+{
+    struct FrameSlotRingStats
+    {
+        uint64_t published;
+        uint64_t overwritten;
+        uint64_t acquired;
+        uint64_t stale;
+    };
+
+    //-----------------------------------------------------------------------------
+    // FrameSlotRing
+    //
+    // Hands frame slots from a single producer to a single consumer without
+    // locks. Every slot is always owned by exactly one party: the consumer
+    // holds the slot it is reading, one slot is parked in the shared "ready"
+    // word, and the producer owns the rest. Publishing and acquiring are a
+    // single atomic exchange on the ready word, so the producer never blocks
+    // and the consumer always gets the newest complete frame.
+    //
+    // Only slot indices are managed here; the caller owns the slot storage.
+    // There must be one consumer at a time: a second, concurrent caller of
+    // AcquireLatest would park a slot the first one is still reading. Callers
+    // with more than one consumer path serialize them. ReadSlot may be read
+    // from any thread but is only a snapshot.
+    //-----------------------------------------------------------------------------
+    template <uint32_t SlotCount>
+    class FrameSlotRing
+    {
+        static_assert(SlotCount >= 3, "FrameSlotRing needs at least three slots");
+
+    public:
+        FrameSlotRing() :
+            m_published(0),
+            m_overwritten(0),
+            m_acquired(0),
+            m_stale(0)
+        {
+            Reset();
+        }
+
+        // Returns every slot to its initial owner, nothing is ready afterwards.
+        // Not thread safe; only call while neither side is active.
+        void Reset()
+        {
+            m_readSlot.store(0, std::memory_order_relaxed);
+            m_ready.store(1, std::memory_order_relaxed);
+            m_ownedHead = 0;
+            for (uint32_t i = 0; i < c_ownedCount; i++)
+            {
+                m_owned[i] = i + 2;
+            }
+        }
+
+        // Producer: slot to render the next frame into. Stable until Publish.
+        uint32_t WriteSlot() const
+        {
+            return m_owned[m_ownedHead];
+        }
+
+        // Producer: makes the write slot the latest ready frame.
+        void Publish()
+        {
+            uint32_t written = m_owned[m_ownedHead];
+            uint32_t previous = m_ready.exchange(written | c_freshFlag, std::memory_order_acq_rel);
+            if ((previous & c_freshFlag) != 0)
+            {
+                m_overwritten.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // The displaced slot goes to the back so it is reused last,
+            // giving the GPU as long as possible to finish with it.
+            m_owned[m_ownedHead] = previous & c_slotMask;
+            m_ownedHead = (m_ownedHead + 1) % c_ownedCount;
+            m_published.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Consumer: swaps in the newest ready frame. Returns false and keeps
+        // the current slot when nothing new was published since last time.
+        bool AcquireLatest(uint32_t* slot)
+        {
+            uint32_t current = m_readSlot.load(std::memory_order_relaxed);
+            uint32_t ready = m_ready.load(std::memory_order_acquire);
+            while ((ready & c_freshFlag) != 0)
+            {
+                if (m_ready.compare_exchange_weak(ready, current, std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    current = ready & c_slotMask;
+                    m_readSlot.store(current, std::memory_order_relaxed);
+                    m_acquired.fetch_add(1, std::memory_order_relaxed);
+                    if (slot != nullptr)
+                    {
+                        *slot = current;
+                    }
+                    return true;
+                }
+            }
+
+            m_stale.fetch_add(1, std::memory_order_relaxed);
+            if (slot != nullptr)
+            {
+                *slot = current;
+            }
+            return false;
+        }
+
+        // Consumer: slot returned by the last AcquireLatest.
+        uint32_t ReadSlot() const
+        {
+            return m_readSlot.load(std::memory_order_relaxed);
+        }
+
+        void GetStats(FrameSlotRingStats* stats) const
+        {
+            if (stats == nullptr)
+            {
+                return;
+            }
+
+            stats->published = m_published.load(std::memory_order_relaxed);
+            stats->overwritten = m_overwritten.load(std::memory_order_relaxed);
+            stats->acquired = m_acquired.load(std::memory_order_relaxed);
+            stats->stale = m_stale.load(std::memory_order_relaxed);
+        }
+
+        static uint32_t Count()
+        {
+            return SlotCount;
+        }
+
+    private:
+        FrameSlotRing(const FrameSlotRing&);
+        FrameSlotRing& operator=(const FrameSlotRing&);
+
+        static const uint32_t c_freshFlag = 0x80000000u;
+        static const uint32_t c_slotMask = 0x7fffffffu;
+        static const uint32_t c_ownedCount = SlotCount - 2;
+
+        // Producer side.
+        uint32_t m_owned[c_ownedCount];
+        uint32_t m_ownedHead;
+
+        // Shared; slot index plus c_freshFlag when not yet consumed.
+        std::atomic<uint32_t> m_ready;
+
+        // Consumer side; atomic so ReadSlot is safe off the consumer thread.
+        std::atomic<uint32_t> m_readSlot;
+
+        std::atomic<uint64_t> m_published;
+        std::atomic<uint64_t> m_overwritten;
+        std::atomic<uint64_t> m_acquired;
+        std::atomic<uint64_t> m_stale;
+    };
+}
@@ -0,0 +1,255 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "FrameTap.h"
+
+#include <cstring>
+#include <new>
+
+using namespace MEDIA;
+
+namespace
+{
+    // keeps every slot, and the pixels after its header, cache line aligned;
+    // only called with slotBytes within c_frameTapMaxSlotBytes
+    uint32_t SlotStride(uint32_t slotBytes)
+    {
+        return (uint32_t)(sizeof(FrameTapSlot) + (((uint64_t)slotBytes + 63) & ~(uint64_t)63));
+    }
+
+    // header plus slotCount slots, 0 when it does not fit in size_t
+    size_t LayoutBytes(uint32_t slotCount, uint32_t slotStride)
+    {
+        uint64_t total = sizeof(FrameTapHeader) + (uint64_t)slotCount * slotStride;
+        if (total > (uint64_t)SIZE_MAX)
+        {
+            return 0;
+        }
+        return (size_t)total;
+    }
+}
+
+size_t MEDIA::FrameTapRequiredBytes(uint32_t slotCount, uint32_t slotBytes)
+{
+    if (slotCount == 0 || slotCount > c_frameTapMaxSlots ||
+        slotBytes == 0 || slotBytes > c_frameTapMaxSlotBytes)
+    {
+        return 0;
+    }
+
+    return LayoutBytes(slotCount, SlotStride(slotBytes));
+}
+
+FrameTapWriter::FrameTapWriter(void* memory, size_t size, uint32_t slotCount, uint32_t slotBytes) :
+    m_header(nullptr),
+    m_slots(nullptr),
+    m_frameNumber(0),
+    m_written(0),
+    m_dropped(0)
+{
+    size_t required = FrameTapRequiredBytes(slotCount, slotBytes);
+    if (memory == nullptr || required == 0 || size < required)
+    {
+        return;
+    }
+
+    m_header = new (memory) FrameTapHeader();
+    m_slots = static_cast<uint8_t*>(memory) + sizeof(FrameTapHeader);
+
+    uint32_t slotStride = SlotStride(slotBytes);
+    for (uint32_t i = 0; i < slotCount; i++)
+    {
+        FrameTapSlot* slot = new (m_slots + (size_t)i * slotStride) FrameTapSlot();
+        slot->sequence.store(0, std::memory_order_relaxed);
+        slot->frameNumber.store(0, std::memory_order_relaxed);
+    }
+
+    m_header->slotCount = slotCount;
+    m_header->slotBytes = slotBytes;
+    m_header->slotStride = slotStride;
+    m_header->version = c_frameTapVersion;
+    m_header->latest.store(0, std::memory_order_relaxed);
+
+    // readers check the magic first, so it goes in last
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = c_frameTapMagic;
+}
+
+bool FrameTapWriter::IsValid() const
+{
+    return m_header != nullptr;
+}
+
+bool FrameTapWriter::Write(const uint8_t* pixels, uint32_t sourceStride,
+    uint32_t width, uint32_t height, uint32_t format, int64_t timestamp)
+{
+    if (m_header == nullptr || pixels == nullptr)
+    {
+        return false;
+    }
+
+    // 4 bytes per pixel, rows stored tightly packed
+    uint32_t stride = width * 4;
+    if (width == 0 || height == 0 || (uint64_t)stride * height > m_header->slotBytes || sourceStride < stride)
+    {
+        m_dropped++;
+        return false;
+    }
+
+    uint64_t frameNumber = ++m_frameNumber;
+    uint32_t index = (uint32_t)((frameNumber - 1) % m_header->slotCount);
+    uint8_t* base = m_slots + (size_t)index * m_header->slotStride;
+    FrameTapSlot* slot = reinterpret_cast<FrameTapSlot*>(base);
+
+    uint32_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->width.store(width, std::memory_order_relaxed);
+    slot->height.store(height, std::memory_order_relaxed);
+    slot->stride.store(stride, std::memory_order_relaxed);
+    slot->format.store(format, std::memory_order_relaxed);
+    slot->frameNumber.store(frameNumber, std::memory_order_relaxed);
+    slot->timestamp.store(timestamp, std::memory_order_relaxed);
+
+    uint8_t* destination = base + sizeof(FrameTapSlot);
+    if (sourceStride == stride)
+    {
+        memcpy(destination, pixels, (size_t)stride * height);
+    }
+    else
+    {
+        for (uint32_t row = 0; row < height; row++)
+        {
+            memcpy(destination + (size_t)row * stride, pixels + (size_t)row * sourceStride, stride);
+        }
+    }
+
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    m_header->latest.store(frameNumber, std::memory_order_release);
+
+    m_written++;
+    return true;
+}
+
+void FrameTapWriter::GetStats(FrameTapStats* stats) const
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+
+    stats->written = m_written;
+    stats->dropped = m_dropped;
+}
+
+FrameTapReader::FrameTapReader(const void* memory, size_t size) :
+    m_header(nullptr),
+    m_slots(nullptr)
+{
+    if (memory == nullptr || size < sizeof(FrameTapHeader))
+    {
+        return;
+    }
+
+    const FrameTapHeader* header = static_cast<const FrameTapHeader*>(memory);
+    if (header->magic != c_frameTapMagic)
+    {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // the header comes from another process, so check it the same way
+    // the writer checked its arguments
+    if (header->version != c_frameTapVersion ||
+        header->slotCount == 0 || header->slotCount > c_frameTapMaxSlots ||
+        header->slotBytes > c_frameTapMaxSlotBytes ||
+        (uint64_t)header->slotStride < sizeof(FrameTapSlot) + (uint64_t)header->slotBytes)
+    {
+        return;
+    }
+
+    size_t required = LayoutBytes(header->slotCount, header->slotStride);
+    if (required == 0 || size < required)
+    {
+        return;
+    }
+
+    m_header = header;
+    m_slots = static_cast<const uint8_t*>(memory) + sizeof(FrameTapHeader);
+}
+
+bool FrameTapReader::IsValid() const
+{
+    return m_header != nullptr;
+}
+
+uint64_t FrameTapReader::Latest() const
+{
+    return (m_header != nullptr) ? m_header->latest.load(std::memory_order_acquire) : 0;
+}
+
+const FrameTapSlot* FrameTapReader::Slot(uint32_t index) const
+{
+    return reinterpret_cast<const FrameTapSlot*>(m_slots + (size_t)index * m_header->slotStride);
+}
+
+bool FrameTapReader::BeginRead(const uint8_t** pixels, FrameTapInfo* info, FrameTapReadToken* token) const
+{
+    if (m_header == nullptr || pixels == nullptr || info == nullptr || token == nullptr)
+    {
+        return false;
+    }
+
+    uint64_t latest = m_header->latest.load(std::memory_order_acquire);
+    if (latest == 0)
+    {
+        return false;
+    }
+
+    uint32_t index = (uint32_t)((latest - 1) % m_header->slotCount);
+    const FrameTapSlot* slot = Slot(index);
+
+    uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+    if ((sequence & 1) != 0)
+    {
+        return false;
+    }
+
+    info->width = slot->width.load(std::memory_order_relaxed);
+    info->height = slot->height.load(std::memory_order_relaxed);
+    info->stride = slot->stride.load(std::memory_order_relaxed);
+    info->format = slot->format.load(std::memory_order_relaxed);
+    info->frameNumber = slot->frameNumber.load(std::memory_order_relaxed);
+    info->timestamp = slot->timestamp.load(std::memory_order_relaxed);
+
+    // a torn header could describe more pixels than the slot holds
+    if ((uint64_t)info->stride * info->height > m_header->slotBytes)
+    {
+        return false;
+    }
+
+    *pixels = reinterpret_cast<const uint8_t*>(slot) + sizeof(FrameTapSlot);
+    token->slot = index;
+    token->sequence = sequence;
+    return true;
+}
+
+bool FrameTapReader::EndRead(const FrameTapReadToken& token) const
+{
+    if (m_header == nullptr || token.slot >= m_header->slotCount)
+    {
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return Slot(token.slot)->sequence.load(std::memory_order_relaxed) == token.sequence;
+}
@@ -0,0 +1,166 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace MEDIA
+{
+    const uint32_t c_frameTapMagic = 0x50415446; // "FTAP"
+    const uint32_t c_frameTapVersion = 1;
+
+    // Same value as DXGI_FORMAT_B8G8R8A8_UNORM.
+    const uint32_t c_frameTapFormatBGRA8 = 87;
+
+    // Limits on the layout. A slot holds at most an 8K BGRA frame; larger
+    // requests, and anything whose total size would not fit in size_t, are
+    // rejected rather than wrapped.
+    const uint32_t c_frameTapMaxSlots = 64;
+    const uint32_t c_frameTapMaxSlotBytes = 8192 * 8192 * 4;
+
+    //-----------------------------------------------------------------------------
+    // Frame tap layout
+    //
+    // A block of memory, usually shared between processes, holding a header
+    // followed by slotCount slots. Each slot is a 64 byte FrameTapSlot header
+    // followed by slotBytes of pixels, so slot i starts at
+    // sizeof(FrameTapHeader) + i * slotStride.
+    //
+    // There is one writer. Frames go to the slots in turn and each slot is a
+    // seqlock: its sequence is odd while the writer is inside it. Readers
+    // never write to the block, they read the latest frame in place and check
+    // afterwards that the sequence did not move.
+    //-----------------------------------------------------------------------------
+    struct FrameTapHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t slotCount;
+        uint32_t slotBytes;
+        uint32_t slotStride;
+        uint32_t reserved[3];
+
+        // frameNumber of the newest complete frame, 0 before the first one
+        std::atomic<uint64_t> latest;
+
+        uint8_t padding[24];
+    };
+
+    struct FrameTapSlot
+    {
+        std::atomic<uint32_t> sequence;
+        std::atomic<uint32_t> width;
+        std::atomic<uint32_t> height;
+        std::atomic<uint32_t> stride;
+        std::atomic<uint32_t> format;
+        uint32_t reserved;
+        std::atomic<uint64_t> frameNumber;
+        std::atomic<int64_t> timestamp;
+
+        uint8_t padding[24];
+    };
+
+    static_assert(sizeof(FrameTapHeader) == 64, "FrameTapHeader is part of the shared layout");
+    static_assert(sizeof(FrameTapSlot) == 64, "FrameTapSlot is part of the shared layout");
+
+    struct FrameTapInfo
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t stride;
+        uint32_t format;
+        uint64_t frameNumber;
+        int64_t timestamp;
+    };
+
+    struct FrameTapStats
+    {
+        uint64_t written;
+        uint64_t dropped;
+    };
+
+    // Bytes needed for slotCount slots of slotBytes pixels each, 0 when
+    // either is 0, beyond the limits above, or the total overflows size_t.
+    size_t FrameTapRequiredBytes(uint32_t slotCount, uint32_t slotBytes);
+
+    //-----------------------------------------------------------------------------
+    // FrameTapWriter
+    //
+    // Formats the block on construction. Not thread safe, there is exactly
+    // one writer per block.
+    //-----------------------------------------------------------------------------
+    class FrameTapWriter
+    {
+    public:
+        FrameTapWriter(void* memory, size_t size, uint32_t slotCount, uint32_t slotBytes);
+
+        // False when the block is too small for the requested slots.
+        bool IsValid() const;
+
+        // Copies a frame into the next slot and publishes it. Frames that
+        // do not fit in a slot are dropped.
+        bool Write(const uint8_t* pixels, uint32_t sourceStride,
+            uint32_t width, uint32_t height, uint32_t format, int64_t timestamp);
+
+        void GetStats(FrameTapStats* stats) const;
+
+    private:
+        FrameTapWriter(const FrameTapWriter&);
+        FrameTapWriter& operator=(const FrameTapWriter&);
+
+        FrameTapHeader* m_header;
+        uint8_t* m_slots;
+        uint64_t m_frameNumber;
+        uint64_t m_written;
+        uint64_t m_dropped;
+    };
+
+    // Identifies a read in progress, see FrameTapReader::EndRead.
+    struct FrameTapReadToken
+    {
+        uint32_t slot;
+        uint32_t sequence;
+    };
+
+    //-----------------------------------------------------------------------------
+    // FrameTapReader
+    //
+    // Reads the latest frame without copying it. BeginRead points at the
+    // pixels inside the block; once the caller is done with them EndRead
+    // says whether the writer reused the slot in the meantime, in which case
+    // whatever was read must be thrown away.
+    //-----------------------------------------------------------------------------
+    class FrameTapReader
+    {
+    public:
+        FrameTapReader(const void* memory, size_t size);
+
+        // False when the block does not hold a compatible frame tap.
+        bool IsValid() const;
+
+        // frameNumber of the newest published frame, 0 when there is none.
+        uint64_t Latest() const;
+
+        // False when there is no frame yet or the writer is inside the
+        // latest slot right now.
+        bool BeginRead(const uint8_t** pixels, FrameTapInfo* info, FrameTapReadToken* token) const;
+        bool EndRead(const FrameTapReadToken& token) const;
+
+    private:
+        const FrameTapSlot* Slot(uint32_t index) const;
+
+        const FrameTapHeader* m_header;
+        const uint8_t* m_slots;
+    };
+}
@@ -0,0 +1,92 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+namespace MEDIA
+{
+    //-----------------------------------------------------------------------------
+    // FrameUpdateTable
+    //
+    // What the batched render event found for each player slot, until a
+    // script reads it. Update is a plain struct with handle, textureSRV and
+    // newFrame members; a handle of 0 marks an empty slot.
+    //
+    // Publish replaces the whole table with the latest batch, but a new
+    // frame the script has not read yet stays flagged as long as the slot
+    // still holds the same player. Take copies the live slots out and
+    // clears their flags, so every new frame is reported exactly once even
+    // when the script polls less often than Unity renders.
+    //-----------------------------------------------------------------------------
+    template <typename Update, uint32_t Capacity>
+    class FrameUpdateTable
+    {
+    public:
+        FrameUpdateTable()
+        {
+            for (uint32_t i = 0; i < Capacity; i++)
+            {
+                m_updates[i] = Update();
+            }
+        }
+
+        // batch holds Capacity entries, indexed by player slot.
+        void Publish(const Update* batch)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            for (uint32_t i = 0; i < Capacity; i++)
+            {
+                Update update = batch[i];
+                // keep a new frame the script has not seen yet
+                if (update.handle != 0 && update.handle == m_updates[i].handle && m_updates[i].newFrame)
+                {
+                    update.newFrame = true;
+                }
+                m_updates[i] = update;
+            }
+        }
+
+        // Returns the number of entries written.
+        uint32_t Take(Update* updates, uint32_t capacity)
+        {
+            if (updates == nullptr)
+            {
+                return 0;
+            }
+
+            uint32_t count = 0;
+
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            for (uint32_t i = 0; i < Capacity && count < capacity; i++)
+            {
+                if (m_updates[i].handle != 0)
+                {
+                    updates[count++] = m_updates[i];
+                    m_updates[i].newFrame = false;
+                }
+            }
+
+            return count;
+        }
+
+    private:
+        FrameUpdateTable(const FrameUpdateTable&);
+        FrameUpdateTable& operator=(const FrameUpdateTable&);
+
+        std::mutex m_lock;
+        Update m_updates[Capacity];
+    };
+}
@@ -0,0 +1,295 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace MEDIA
+{
+    struct HandleTableStats
+    {
+        uint32_t live;
+        uint64_t inserted;
+        uint64_t removed;
+        uint64_t lookupMisses;
+        uint64_t removeWaits;
+    };
+
+    //-----------------------------------------------------------------------------
+    // HandleTable
+    //
+    // Fixed number of slots addressed by integer handles. A handle packs the
+    // slot index (low 16 bits, plus one so 0 is never valid) with the slot's
+    // generation, so a handle that was removed never finds the object that
+    // reuses its slot.
+    //
+    // Lookups take no lock: a reader announces itself on the slot, then
+    // checks the slot still holds its handle. Remove marks the slot dead
+    // first and then waits for the announced readers to leave, so a value is
+    // never released while a ReadGuard still points at it. Insert and Remove
+    // are serialized by a mutex.
+    //-----------------------------------------------------------------------------
+    template <typename T, uint32_t Capacity>
+    class HandleTable
+    {
+        static_assert(Capacity > 0 && Capacity < 0xffff, "HandleTable index must fit in 16 bits");
+
+        struct Slot
+        {
+            // generation << 1, low bit set while the slot is live
+            std::atomic<uint32_t> state;
+            std::atomic<uint32_t> readers;
+            T value;
+        };
+
+    public:
+        typedef int32_t Handle;
+        static const Handle InvalidHandle = 0;
+
+        class ReadGuard
+        {
+        public:
+            ReadGuard() :
+                m_slot(nullptr)
+            {
+            }
+
+            ReadGuard(ReadGuard&& other) :
+                m_slot(other.m_slot)
+            {
+                other.m_slot = nullptr;
+            }
+
+            ~ReadGuard()
+            {
+                if (m_slot != nullptr)
+                {
+                    m_slot->readers.fetch_sub(1, std::memory_order_release);
+                }
+            }
+
+            explicit operator bool() const
+            {
+                return m_slot != nullptr;
+            }
+
+            T& operator*() const
+            {
+                return m_slot->value;
+            }
+
+        private:
+            friend class HandleTable;
+
+            explicit ReadGuard(Slot* slot) :
+                m_slot(slot)
+            {
+            }
+
+            ReadGuard(const ReadGuard&);
+            ReadGuard& operator=(const ReadGuard&);
+
+            Slot* m_slot;
+        };
+
+        HandleTable() :
+            m_freeCount(Capacity),
+            m_inserted(0),
+            m_removed(0),
+            m_lookupMisses(0),
+            m_removeWaits(0)
+        {
+            for (uint32_t i = 0; i < Capacity; i++)
+            {
+                m_slots[i].state.store(0, std::memory_order_relaxed);
+                m_slots[i].readers.store(0, std::memory_order_relaxed);
+                m_freeList[i] = Capacity - 1 - i;
+            }
+        }
+
+        // Returns InvalidHandle when every slot is taken.
+        Handle Insert(const T& value)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            if (m_freeCount == 0)
+            {
+                return InvalidHandle;
+            }
+
+            uint32_t index = m_freeList[--m_freeCount];
+            Slot& slot = m_slots[index];
+
+            // the slot is dead, so no reader can be looking at the value
+            slot.value = value;
+
+            uint32_t state = (slot.state.load(std::memory_order_relaxed) | 1);
+            slot.state.store(state, std::memory_order_seq_cst);
+
+            m_inserted++;
+            return MakeHandle(index, state);
+        }
+
+        // Removes the handle and hands its value back once no reader holds
+        // it any more. Returns false when the handle is not live.
+        bool Remove(Handle handle, T* value)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            uint32_t index;
+            uint32_t state;
+            if (!SplitHandle(handle, &index, &state))
+            {
+                return false;
+            }
+
+            Slot& slot = m_slots[index];
+            if (!slot.state.compare_exchange_strong(state, NextGeneration(state), std::memory_order_seq_cst))
+            {
+                return false;
+            }
+
+            // new readers now fail the state check, wait out the old ones
+            if (slot.readers.load(std::memory_order_seq_cst) != 0)
+            {
+                m_removeWaits++;
+                while (slot.readers.load(std::memory_order_seq_cst) != 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            if (value != nullptr)
+            {
+                *value = slot.value;
+            }
+            slot.value = T();
+
+            m_freeList[m_freeCount++] = index;
+            m_removed++;
+            return true;
+        }
+
+        // Lock-free. The guard is empty when the handle is not live.
+        ReadGuard Lookup(Handle handle)
+        {
+            uint32_t index;
+            uint32_t state;
+            if (SplitHandle(handle, &index, &state))
+            {
+                Slot& slot = m_slots[index];
+                slot.readers.fetch_add(1, std::memory_order_seq_cst);
+                if (slot.state.load(std::memory_order_seq_cst) == state)
+                {
+                    return ReadGuard(&slot);
+                }
+                slot.readers.fetch_sub(1, std::memory_order_release);
+            }
+
+            m_lookupMisses.fetch_add(1, std::memory_order_relaxed);
+            return ReadGuard();
+        }
+
+        // Lock-free. Calls visit(handle, value) for every live slot, each
+        // one held like a ReadGuard for the duration of the call.
+        template <typename F>
+        void ForEach(F visit)
+        {
+            for (uint32_t i = 0; i < Capacity; i++)
+            {
+                Slot& slot = m_slots[i];
+                uint32_t state = slot.state.load(std::memory_order_acquire);
+                if ((state & 1) == 0)
+                {
+                    continue;
+                }
+
+                slot.readers.fetch_add(1, std::memory_order_seq_cst);
+                if (slot.state.load(std::memory_order_seq_cst) == state)
+                {
+                    visit(MakeHandle(i, state), slot.value);
+                }
+                slot.readers.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        // Slot a handle refers to, -1 when the handle is malformed. Handles
+        // that share a slot never exist at the same time.
+        static int32_t SlotIndex(Handle handle)
+        {
+            uint32_t index;
+            uint32_t state;
+            return SplitHandle(handle, &index, &state) ? (int32_t)index : -1;
+        }
+
+        void GetStats(HandleTableStats* stats) const
+        {
+            if (stats == nullptr)
+            {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            stats->live = Capacity - m_freeCount;
+            stats->inserted = m_inserted;
+            stats->removed = m_removed;
+            stats->lookupMisses = m_lookupMisses.load(std::memory_order_relaxed);
+            stats->removeWaits = m_removeWaits;
+        }
+
+    private:
+        HandleTable(const HandleTable&);
+        HandleTable& operator=(const HandleTable&);
+
+        static const uint32_t c_generationMask = 0xfffe;
+
+        static Handle MakeHandle(uint32_t index, uint32_t state)
+        {
+            // 15 bit generation above the index keeps handles positive
+            return (Handle)(((state & c_generationMask) << 15) | (index + 1));
+        }
+
+        static bool SplitHandle(Handle handle, uint32_t* index, uint32_t* state)
+        {
+            uint32_t value = (uint32_t)handle;
+            uint32_t slot = value & 0xffff;
+            if (handle <= 0 || slot == 0 || slot > Capacity)
+            {
+                return false;
+            }
+
+            *index = slot - 1;
+            *state = ((value >> 15) & c_generationMask) | 1;
+            return true;
+        }
+
+        static uint32_t NextGeneration(uint32_t state)
+        {
+            return ((state & c_generationMask) + 2) & c_generationMask;
+        }
+
+        Slot m_slots[Capacity];
+
+        mutable std::mutex m_lock;
+        uint32_t m_freeList[Capacity];
+        uint32_t m_freeCount;
+
+        uint64_t m_inserted;
+        uint64_t m_removed;
+        std::atomic<uint64_t> m_lookupMisses;
+        uint64_t m_removeWaits;
+    };
+}
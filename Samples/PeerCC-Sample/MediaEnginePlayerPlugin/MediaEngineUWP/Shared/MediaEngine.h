@@ -60,6 +60,9 @@
 #include "Unity\IUnityGraphicsD3D11.h"
 
 // project
+#include "AsyncLogger.h"
+#include "ErrorCounters.h"
+
 typedef enum Log_Level
 {
     Log_Level_Any,
@@ -76,68 +79,79 @@ typedef enum Log_Level
 #endif
 #endif
 
-inline void __stdcall Log(
-    _In_ Log_Level level,
-    _In_ _Printf_format_string_ STRSAFE_LPCWSTR pszFormat,
-    ...)
+// The process wide logger, writing to the debugger output.
+inline MEDIA::AsyncLogger& MELogger()
 {
-    if (LOG_LEVEL < level)
+    static MEDIA::AsyncLogger& s_logger = []() -> MEDIA::AsyncLogger&
     {
-        return;
-    }
-
-    wchar_t szTextBuf[2048];
+        MEDIA::AsyncLogger& logger = MEDIA::AsyncLogger::Instance();
+        logger.AddSink(std::make_shared<MEDIA::DebugOutputLogSink>());
+        return logger;
+    }();
 
-    va_list args;
-    va_start(args, pszFormat);
-
-    StringCchVPrintf(szTextBuf, _countof(szTextBuf), pszFormat, args);
-
-    va_end(args);
-
-    OutputDebugStringW(szTextBuf);
+    return s_logger;
 }
 
-#define FORMAT_MESSAGE_ALLOCATE_BUFFER 0x00000100
+// Compile-time level check. A statement below the level is dead code, so
+// its arguments are never evaluated and nothing of it is left in the binary.
+template <Log_Level level>
+struct LogLevelEnabled : std::integral_constant<bool, (LOG_LEVEL >= level)>
+{
+};
 
-inline const TCHAR * ErrorMessage(HRESULT hr)
+// Only captures the arguments; formatting and OutputDebugString happen on
+// the logger's drain thread, see AsyncLogger.h. The format must be a string
+// literal and is checked against the arguments at compile time; wrap
+// HRESULTs, presentation times, sizes and player ids in the MEDIA::Log*
+// fields so binary sinks can tell them apart.
+#define ME_LOG(level, format, ...) \
+    do \
+    { \
+        static_assert(MEDIA::LogFormatMatches(format, decltype(MEDIA::LogArgKindsOf(__VA_ARGS__))()), \
+            "log arguments do not match the format " #format); \
+        if (LogLevelEnabled<level>::value) \
+        { \
+            MELogger().Log((uint32_t)(level), format, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define ME_LOG_ERROR(format, ...) ME_LOG(Log_Level_Error, format, ##__VA_ARGS__)
+#define ME_LOG_WARNING(format, ...) ME_LOG(Log_Level_Warning, format, ##__VA_ARGS__)
+#define ME_LOG_INFO(format, ...) ME_LOG(Log_Level_Info, format, ##__VA_ARGS__)
+
+// System message for hr, without the trailing newline. Looked up once per
+// code and kept for the life of the process, so the pointer stays valid.
+inline const wchar_t* ErrorMessage(HRESULT hr)
 {
-    TCHAR * pszMsg;
+    MEDIA::ErrorMessageCache& cache = MEDIA::ErrorMessageCache::Instance();
+
+    const wchar_t* cached = cache.Find((uint32_t)hr);
+    if (cached != nullptr)
+    {
+        return cached;
+    }
 
-    FormatMessage(FORMAT_MESSAGE_ALLOCATE_BUFFER |
-        FORMAT_MESSAGE_FROM_SYSTEM |
-        FORMAT_MESSAGE_IGNORE_INSERTS,
+    WCHAR szMsg[512];
+    DWORD nLen = FormatMessageW(
+        FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
         NULL,
         hr,
         MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
-        (LPTSTR)&pszMsg,
-        0,
+        szMsg,
+        ARRAYSIZE(szMsg),
         NULL);
 
-    if (pszMsg != NULL) 
+    while (nLen > 0 && (szMsg[nLen - 1] == L'\n' || szMsg[nLen - 1] == L'\r'))
     {
-#ifdef UNICODE
-        size_t const nLen = wcslen(pszMsg);
-#else
-        size_t const nLen = strlen(m_pszMsg);
-#endif
-        if (nLen > 1 && pszMsg[nLen - 1] == '\n') 
-        {
-            pszMsg[nLen - 1] = 0;
-            
-            if (pszMsg[nLen - 2] == '\r') 
-            {
-                pszMsg[nLen - 2] = 0;
-            }
-        }
+        nLen--;
     }
 
-    return pszMsg;
+    return cache.Intern((uint32_t)hr, szMsg, nLen);
 }
 
 inline void __stdcall LogResult(
-    _In_ LPWSTR pszFile, //__FILEW__
-    _In_ LPWSTR pszFunc, //__FUNCTIONW__
+    _In_ LPCWSTR pszFile, //__FILEW__
+    _In_ LPCWSTR pszFunc, //__FUNCTIONW__
     _In_ long nLine, //__LINE__
     _In_ HRESULT hr,
     _In_ LPCWSTR message = L"")
@@ -147,26 +161,25 @@ inline void __stdcall LogResult(
         return;
     }
 
-    // if filename contains a path, move the ptr to the first char of name
-    LPWSTR psz = pszFile + wcsnlen_s(pszFile, 255);
-    for (; psz > pszFile; psz--)
+    // counted per call site; the table also strips the path, once per site
+    LPCWSTR pszFileName;
+    uint64_t count = MEDIA::ErrorSiteTable::Instance().Record(pszFile, pszFunc, (uint32_t)nLine, (uint32_t)hr, &pszFileName);
+
+    // a storm of the same failure logs its 1st, 2nd, 4th, 8th... occurrence;
+    // GetErrorSites has the exact counts
+    if (count != 0 && (count & (count - 1)) != 0)
     {
-        if (*psz == L'\\')
-        {
-            pszFile = psz + 1;
-            break;
-        }
+        return;
     }
 
     // Gets the plain text error message
-    Log(
-        Log_Level_Error,
-        L"%sHR: 0x%x - %s\r\n\t%s(%d): %s\n"
-        , message, hr, ErrorMessage(hr), pszFile, nLine, pszFunc);
+    ME_LOG_ERROR(
+        L"%sHR: 0x%x - %s\r\n\t%s(%d): %s (%llu times)\n"
+        , message, MEDIA::LogHResult(hr), ErrorMessage(hr), pszFileName, nLine, pszFunc, count);
 }
 
 #ifndef LOG_RESULT
-#define LOG_RESULT_MSG(hrToCheck, message) LogResult(__FILEW__, __FUNCTIONW__, __LINE__, hrToCheck, message);
+#define LOG_RESULT_MSG(hrToCheck, message) if (LogLevelEnabled<Log_Level_Error>::value) { LogResult(__FILEW__, __FUNCTIONW__, __LINE__, hrToCheck, message); }
 #define LOG_RESULT(hrToCheck) LOG_RESULT_MSG(hrToCheck, L"");
 #endif
 
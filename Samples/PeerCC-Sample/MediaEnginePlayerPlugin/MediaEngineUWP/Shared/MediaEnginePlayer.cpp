@@ -98,32 +98,161 @@ public:
 	}
 };
 
+// DXGIVSyncClock: Paces the shared scheduler on the primary output's vblank.
+class DXGIVSyncClock : public MEDIA::IVSyncClock
+{
+	SRWLOCK m_outputLock;
+	ComPtr<IDXGIFactory1> m_spFactory;
+	ComPtr<IDXGIOutput> m_spOutput;
+	LARGE_INTEGER m_frequency;
+
+public:
+	DXGIVSyncClock()
+	{
+		InitializeSRWLock(&m_outputLock);
+		QueryPerformanceFrequency(&m_frequency);
+	}
+
+	// Finds the primary output on first use and again only once DXGI
+	// reports that the adapters changed, so resuming playback is cheap.
+	HRESULT RefreshOutput()
+	{
+		HRESULT hr = S_OK;
+
+		AcquireSRWLockExclusive(&m_outputLock);
+
+		if (m_spOutput == nullptr || m_spFactory == nullptr || !m_spFactory->IsCurrent())
+		{
+			ComPtr<IDXGIFactory1> spFactory;
+			ComPtr<IDXGIAdapter> spAdapter;
+			ComPtr<IDXGIOutput> spOutput;
+
+			hr = CreateDXGIFactory1(IID_PPV_ARGS(&spFactory));
+			if (SUCCEEDED(hr))
+			{
+				hr = spFactory->EnumAdapters(0, &spAdapter);
+			}
+			if (SUCCEEDED(hr))
+			{
+				hr = spAdapter->EnumOutputs(0, &spOutput);
+			}
+			if (SUCCEEDED(hr))
+			{
+				m_spFactory = spFactory;
+				m_spOutput = spOutput;
+			}
+		}
+
+		ReleaseSRWLockExclusive(&m_outputLock);
+
+		return hr;
+	}
+
+	int64_t NowMicroseconds()
+	{
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		return (counter.QuadPart / m_frequency.QuadPart) * 1000000LL +
+			((counter.QuadPart % m_frequency.QuadPart) * 1000000LL) / m_frequency.QuadPart;
+	}
+
+	bool WaitForVBlank()
+	{
+		AcquireSRWLockShared(&m_outputLock);
+		ComPtr<IDXGIOutput> spOutput = m_spOutput;
+		ReleaseSRWLockShared(&m_outputLock);
+
+		return (spOutput != nullptr) && SUCCEEDED(spOutput->WaitForVBlank());
+	}
+};
+
+// MEPlayerVSyncTarget: Forwards scheduler ticks to a player without keeping it alive.
+class MEPlayerVSyncTarget : public MEDIA::IVSyncTarget
+{
+	Platform::WeakReference m_player;
+
+public:
+	MEPlayerVSyncTarget(MEPlayer^ player) : m_player(player)
+	{
+	}
+
+	bool HasPendingFrame()
+	{
+		MEPlayer^ player = m_player.Resolve<MEPlayer>();
+		return (player != nullptr) && player->OnVSyncWakeup();
+	}
+
+	bool OnVSync(int64_t /*nowMicroseconds*/)
+	{
+		MEPlayer^ player = m_player.Resolve<MEPlayer>();
+		return (player != nullptr) && player->OnTimer();
+	}
+};
+
+// Enough for a few sets of 1080p frame slots, so oscillating between
+// two sizes during a resize drag never reallocates.
+static const uint64_t c_texturePoolBudgetBytes = 128 * 1024 * 1024;
+
+// One device and DXGI manager per adapter, shared by every player.
+static MEDeviceFactory s_deviceFactory;
+static MEDIA::DeviceBroker s_deviceBroker(&s_deviceFactory);
+
+// One pacing thread for every player in the process.
+static const int64_t c_nominalVSyncIntervalMicroseconds = 16667;
+static DXGIVSyncClock s_vsyncClock;
+static MEDIA::VSyncScheduler s_vsyncScheduler(&s_vsyncClock, c_nominalVSyncIntervalMicroseconds);
+
 MEPlayer::MEPlayer(Microsoft::WRL::ComPtr<ID3D11Device> unityD3DDevice, Platform::String^ textureName,
-	Microsoft::WRL::ComPtr<ABI::Windows::Foundation::Collections::IMap<HSTRING, IInspectable*>> extensionManagerProperties) :
+	Microsoft::WRL::ComPtr<MEDIA::MediaSourceRegistry> sourceRegistry) :
 	m_spDX11Device(nullptr),
 	m_spDX11UnityDevice(unityD3DDevice),
 	m_spDX11DeviceContext(nullptr),
-	m_spDXGIOutput(nullptr),
 	m_spDX11SwapChain(nullptr),
 	m_spDXGIManager(nullptr),
 	m_spMediaEngine(nullptr),
 	m_spEngineEx(nullptr),
 	m_bstrURL(nullptr),
-	m_TimerThreadHandle(nullptr),
 	m_fPlaying(FALSE),
 	m_fLoop(FALSE),
 	m_fEOS(FALSE),
 	m_fStopTimer(TRUE),
 	m_d3dFormat(DXGI_FORMAT_B8G8R8A8_UNORM),
-	m_sharedTextureHandle(0),
 	m_fInitSuccess(FALSE),
+	m_fMFStarted(FALSE),
+	m_pSharedDevice(nullptr),
+	m_pendingFrameNotifications(0),
+	m_softwareHeight(0),
+	m_tapStagingIndex(0),
+	m_fTapPending(FALSE),
+	m_tapPendingPts(0),
+	m_pFirstFramePool(nullptr),
+	m_fFirstFramePending(FALSE),
+	m_fFromPool(FALSE),
 	m_fExitApp(FALSE),
 	m_fUseDX(TRUE),
-	m_extensionManagerProperties(extensionManagerProperties)
+	m_sourceRegistry(sourceRegistry),
+	m_texturePool(&m_frameSlotAllocator, c_texturePoolBudgetBytes),
+	_frameCounter(0),
+	_minPresentationOffset(0),
+	_fHasPresentationOffset(FALSE)
 {
 	memset(&m_bkgColor, 0, sizeof(MFARGB));
+	memset(&m_frameSlotKey, 0, sizeof(m_frameSlotKey));
+	memset(&m_stableSlotKey, 0, sizeof(m_stableSlotKey));
+
+	m_colorParams.matrix = MEDIA::ColorMatrix_BT601;
+	m_colorParams.range = MEDIA::ColorRange_Limited;
+	m_colorParams.kernel = MEDIA::ConvertKernel_Auto;
+	memset(&m_initStats, 0, sizeof(m_initStats));
 
 	InitializeCriticalSectionEx(&m_critSec, 0, 0);
+	InitializeSRWLock(&m_frameSlotLock);
+
+	for (UINT32 i = 0; i < c_frameSlotCount; i++)
+	{
+		m_frameSlots[i] = nullptr;
+	}
+	m_stableSlot = nullptr;
 
 	size_t cchAllocationSize = 1 + ::wcslen(textureName->Data());
 	m_pszTextureName = (LPWSTR)::CoTaskMemAlloc(sizeof(WCHAR)*(cchAllocationSize));
@@ -134,13 +263,22 @@ MEPlayer::MEPlayer(Microsoft::WRL::ComPtr<ID3D11Device> unityD3DDevice, Platform
 	}
 
 	StringCchCopyW(m_pszTextureName, cchAllocationSize, textureName->Data());
+
+	// texture names are plain ASCII, good enough to tell the players apart
+	for (LPCWSTR psz = m_pszTextureName; *psz != L'\0'; psz++)
+	{
+		m_deviceClient.push_back((char)*psz);
+	}
 }
 
 MEPlayer::~MEPlayer()
 {
 	Shutdown();
 
-	MFShutdown();
+	if (m_fMFStarted)
+	{
+		MFShutdown();
+	}
 
 	DeleteCriticalSection(&m_critSec);
 }
@@ -149,10 +287,65 @@ MEPlayer::~MEPlayer()
 //
 //  Function:   CreateDX11Device()
 //
-//  Synopsis:   creates a default device
+//  Synopsis:   takes a reference on the device shared by all players
 //
 //--------------------------------------------------------------------------
 void MEPlayer::CreateDX11Device()
+{
+	if (m_pSharedDevice == nullptr)
+	{
+		MEDIA::DeviceKey key = { 0, D3D11_CREATE_DEVICE_VIDEO_SUPPORT | D3D11_CREATE_DEVICE_BGRA_SUPPORT };
+		m_pSharedDevice = static_cast<MESharedDevice*>(s_deviceBroker.Acquire(key, m_deviceClient));
+		if (m_pSharedDevice == nullptr)
+		{
+			MEDIA::ThrowIfFailed(s_deviceFactory.LastError());
+		}
+	}
+
+	m_spDX11Device = m_pSharedDevice->device;
+	m_spDX11DeviceContext = m_pSharedDevice->context;
+	m_spDXGIManager = m_pSharedDevice->manager;
+	m_fUseDX = m_pSharedDevice->fHardware;
+
+	return;
+}
+
+//+-------------------------------------------------------------------------
+//
+//  Function:   ReleaseDX11Device()
+//
+//  Synopsis:   drops this player's reference on the shared device, the
+//              last player to leave tears it down
+//
+//--------------------------------------------------------------------------
+void MEPlayer::ReleaseDX11Device()
+{
+	m_frameSlotAllocator.SetDevices(nullptr, nullptr);
+	m_spDXGIManager.Reset();
+	m_spDX11DeviceContext.Reset();
+	m_spDX11Device.Reset();
+
+	if (m_pSharedDevice != nullptr)
+	{
+		s_deviceBroker.Release(m_pSharedDevice, m_deviceClient);
+		m_pSharedDevice = nullptr;
+	}
+}
+
+void MEPlayer::GetDeviceBrokerStats(MEDIA::DeviceBrokerStats* stats)
+{
+	s_deviceBroker.GetStats(stats);
+}
+
+//+-------------------------------------------------------------------------
+//
+//  Function:   MEDeviceFactory::Create
+//
+//  Synopsis:   creates a device on the requested adapter, falling back to
+//              WARP, together with the DXGI manager the engines share
+//
+//--------------------------------------------------------------------------
+void* MEDeviceFactory::Create(const MEDIA::DeviceKey& key)
 {
 	static const D3D_FEATURE_LEVEL levels[] = {
 		D3D_FEATURE_LEVEL_11_1,
@@ -167,54 +360,111 @@ void MEPlayer::CreateDX11Device()
 	D3D_FEATURE_LEVEL FeatureLevel;
 	HRESULT hr = S_OK;
 
-	if (m_fUseDX)
+	ComPtr<IDXGIAdapter1> spAdapter;
+	if (key.adapterLuid != 0)
 	{
-		hr = D3D11CreateDevice(
-			nullptr,
-			D3D_DRIVER_TYPE_HARDWARE,
-			nullptr,
-			D3D11_CREATE_DEVICE_VIDEO_SUPPORT | D3D11_CREATE_DEVICE_BGRA_SUPPORT,
-			levels,
-			ARRAYSIZE(levels),
-			D3D11_SDK_VERSION,
-			&m_spDX11Device,
-			&FeatureLevel,
-			&m_spDX11DeviceContext
-		);
+		ComPtr<IDXGIFactory1> spFactory;
+		hr = CreateDXGIFactory1(IID_PPV_ARGS(&spFactory));
+		for (UINT i = 0; SUCCEEDED(hr); i++)
+		{
+			ComPtr<IDXGIAdapter1> spCandidate;
+			hr = spFactory->EnumAdapters1(i, &spCandidate);
+			DXGI_ADAPTER_DESC1 desc;
+			if (SUCCEEDED(hr) && SUCCEEDED(spCandidate->GetDesc1(&desc)) &&
+				(((uint64_t)desc.AdapterLuid.HighPart << 32) | desc.AdapterLuid.LowPart) == key.adapterLuid)
+			{
+				spAdapter = spCandidate;
+				break;
+			}
+		}
+
+		if (spAdapter == nullptr)
+		{
+			m_hrLastError = DXGI_ERROR_NOT_FOUND;
+			return nullptr;
+		}
 	}
 
-	//Failed to create DX11 Device (using VM?), create device using WARP
-	if (FAILED(hr))
+	MESharedDevice* pDevice = new (std::nothrow) MESharedDevice();
+	if (pDevice == nullptr)
 	{
-		m_fUseDX = FALSE;
+		m_hrLastError = E_OUTOFMEMORY;
+		return nullptr;
 	}
 
-	if (!m_fUseDX)
+	pDevice->fHardware = TRUE;
+	hr = D3D11CreateDevice(
+		spAdapter.Get(),
+		(spAdapter != nullptr) ? D3D_DRIVER_TYPE_UNKNOWN : D3D_DRIVER_TYPE_HARDWARE,
+		nullptr,
+		key.flags,
+		levels,
+		ARRAYSIZE(levels),
+		D3D11_SDK_VERSION,
+		&pDevice->device,
+		&FeatureLevel,
+		&pDevice->context
+	);
+
+	//Failed to create DX11 Device (using VM?), create device using WARP
+	if (FAILED(hr))
 	{
-		MEDIA::ThrowIfFailed(D3D11CreateDevice(
+		pDevice->fHardware = FALSE;
+		hr = D3D11CreateDevice(
 			nullptr,
 			D3D_DRIVER_TYPE_WARP,
 			nullptr,
-			D3D11_CREATE_DEVICE_BGRA_SUPPORT,
+			key.flags & ~D3D11_CREATE_DEVICE_VIDEO_SUPPORT,
 			levels,
 			ARRAYSIZE(levels),
 			D3D11_SDK_VERSION,
-			&m_spDX11Device,
+			&pDevice->device,
 			&FeatureLevel,
-			&m_spDX11DeviceContext
-		));
+			&pDevice->context
+		);
 	}
 
-	if (m_fUseDX)
+	// the device is used by every player's engine and pacing callback, and
+	// on WARP also by the software path's copies and uploads
+	if (SUCCEEDED(hr))
 	{
 		ComPtr<ID3D10Multithread> spMultithread;
-		MEDIA::ThrowIfFailed(
-			m_spDX11Device.Get()->QueryInterface(IID_PPV_ARGS(&spMultithread))
-		);
-		spMultithread->SetMultithreadProtected(TRUE);
+		hr = pDevice->device.Get()->QueryInterface(IID_PPV_ARGS(&spMultithread));
+		if (SUCCEEDED(hr))
+		{
+			spMultithread->SetMultithreadProtected(TRUE);
+		}
 	}
 
-	return;
+	UINT resetToken;
+	if (SUCCEEDED(hr))
+	{
+		hr = MFCreateDXGIDeviceManager(&resetToken, &pDevice->manager);
+	}
+	if (SUCCEEDED(hr))
+	{
+		hr = pDevice->manager->ResetDevice(pDevice->device.Get(), resetToken);
+	}
+
+	if (FAILED(hr))
+	{
+		LOG_RESULT(hr);
+		m_hrLastError = hr;
+		delete pDevice;
+		return nullptr;
+	}
+
+	return pDevice;
+}
+
+void MEDeviceFactory::Destroy(void* device)
+{
+	MESharedDevice* pDevice = static_cast<MESharedDevice*>(device);
+	if (pDevice->context != nullptr)
+	{
+		pDevice->context->ClearState();
+	}
+	delete pDevice;
 }
 
 //+-----------------------------------------------------------------------------
@@ -226,6 +476,8 @@ void MEPlayer::CreateDX11Device()
 //------------------------------------------------------------------------------
 void MEPlayer::CreateBackBuffers()
 {
+	ME_TRACE_SPAN("MEPlayer::CreateBackBuffers");
+
 	EnterCriticalSection(&m_critSec);
 
 	// make sure everything is released first;    
@@ -252,53 +504,79 @@ void MEPlayer::CreateBackBuffers()
 			spDXGIDevice->SetMaximumFrameLatency(1)
 		);
 
-		// create the video texture description based on texture format
-		auto m_textureDesc = CD3D11_TEXTURE2D_DESC(DXGI_FORMAT_B8G8R8A8_UNORM, m_rcTarget.right, m_rcTarget.bottom);
-		m_textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
-		m_textureDesc.MipLevels = 1;
-		m_textureDesc.MiscFlags = D3D11_RESOURCE_MISC_SHARED | D3D11_RESOURCE_MISC_SHARED_NTHANDLE;
-		m_textureDesc.Usage = D3D11_USAGE_DEFAULT;
+		ComPtr<ID3D11Device1> spMediaDevice;
+		MEDIA::ThrowIfFailed(spDevice.As(&spMediaDevice));
 
-		// create staging texture on unity device
-		ComPtr<ID3D11Texture2D> spTexture;
-		MEDIA::ThrowIfFailed(m_spDX11UnityDevice->CreateTexture2D(&m_textureDesc, nullptr, &spTexture));
+		m_frameSlotAllocator.SetDevices(m_spDX11UnityDevice, spMediaDevice);
 
-		auto srvDesc = CD3D11_SHADER_RESOURCE_VIEW_DESC(spTexture.Get(), D3D11_SRV_DIMENSION_TEXTURE2D);
-		ComPtr<ID3D11ShaderResourceView> spSRV;
-		MEDIA::ThrowIfFailed(m_spDX11UnityDevice->CreateShaderResourceView(spTexture.Get(), &srvDesc, &spSRV));
+		// Unity always samples BGRA, whatever the engine renders into
+		MEDIA::TextureKey key = { (uint32_t)m_rcTarget.right, (uint32_t)m_rcTarget.bottom, (uint32_t)DXGI_FORMAT_B8G8R8A8_UNORM };
+		if (m_frameSlots[0] != nullptr && key == m_frameSlotKey)
+		{
+			// same size as before, keep the slots and whatever is in them
+			LeaveCriticalSection(&m_critSec);
+			return;
+		}
 
-		// create shared texture from the unity texture
-		ComPtr<IDXGIResource1> spDXGIResource;
-		MEDIA::ThrowIfFailed(spTexture.As(&spDXGIResource));
+		if (!m_fUseDX)
+		{
+			HRESULT hr = CreateSoftwareTargets(spDevice.Get(), key.width, key.height);
+			if (FAILED(hr))
+			{
+				LeaveCriticalSection(&m_critSec);
+				MEDIA::ThrowIfFailed(hr);
+				return;
+			}
+		}
 
-		HANDLE sharedHandle;
-		ComPtr<ID3D11Texture2D> spMediaTexture;
-		ComPtr<IDirect3DSurface> spMediaSurface;
-		HRESULT hr = spDXGIResource->CreateSharedHandle(
-			nullptr,
-			DXGI_SHARED_RESOURCE_READ | DXGI_SHARED_RESOURCE_WRITE,
-			m_pszTextureName,
-			&sharedHandle);
-		if (SUCCEEDED(hr))
+		// one shared texture per frame slot, so the media engine never
+		// renders into the texture Unity is sampling
+		MEFrameSlot* slots[c_frameSlotCount] = {};
+		for (UINT32 i = 0; i < c_frameSlotCount; i++)
 		{
-			m_sharedTextureHandle = sharedHandle;
-			ComPtr<ID3D11Device1> spMediaDevice;
-			hr = spDevice.As(&spMediaDevice);
-			if (SUCCEEDED(hr))
+			slots[i] = static_cast<MEFrameSlot*>(m_texturePool.Acquire(key));
+			if (slots[i] == nullptr)
 			{
-				hr = spMediaDevice->OpenSharedResource1(sharedHandle, IID_PPV_ARGS(&spMediaTexture));
-				if (SUCCEEDED(hr))
+				for (UINT32 j = 0; j < i; j++)
 				{
-					hr = GetSurfaceFromTexture(spMediaTexture.Get(), &spMediaSurface);
+					m_texturePool.Release(slots[j]);
 				}
+
+				LeaveCriticalSection(&m_critSec);
+				MEDIA::ThrowIfFailed(m_frameSlotAllocator.LastError());
+				return;
 			}
 		}
 
-		m_primarySharedHandle = sharedHandle;
-		m_primaryMediaTexture.Attach(spMediaTexture.Detach());
-		m_primaryMediaSurface.Attach(spMediaSurface.Detach());
+		// the producer is excluded by m_critSec, the consumer by the slot lock
+		MEFrameSlot* previous[c_frameSlotCount];
 
-		m_primaryTextureSRV.Attach(spSRV.Detach());
+		AcquireSRWLockExclusive(&m_frameSlotLock);
+
+		for (UINT32 i = 0; i < c_frameSlotCount; i++)
+		{
+			previous[i] = m_frameSlots[i];
+			m_frameSlots[i] = slots[i];
+		}
+		m_frameSlotKey = key;
+		m_frameRing.Reset();
+
+		ReleaseSRWLockExclusive(&m_frameSlotLock);
+
+		ME_LOG_INFO(L"MEPlayer::CreateBackBuffers() %ux%u", MEDIA::LogWidth(key.width), MEDIA::LogHeight(key.height));
+
+		// the old size stays pooled in case the window is resized back
+		for (UINT32 i = 0; i < c_frameSlotCount; i++)
+		{
+			m_texturePool.Release(previous[i]);
+		}
+
+		// a stable texture of the old size cannot take the new frames
+		if (m_stableSlot != nullptr)
+		{
+			HRESULT hr = EnsureStableSlot();
+			LOG_RESULT(hr);
+		}
 	}
 
 	high_resolution_clock::time_point now = high_resolution_clock::now();
@@ -309,94 +587,532 @@ void MEPlayer::CreateBackBuffers()
 	return;
 }
 
-// Create a new instance of the Media Engine.
+//+-----------------------------------------------------------------------------
+//
+//  Function:   CreateSoftwareTargets
+//
+//  Synopsis:   Creates the NV12 render target and staging texture used by
+//              the software path, and the BGRA buffer the frames are
+//              converted into. Called with m_critSec held.
+//
+//------------------------------------------------------------------------------
+HRESULT MEPlayer::CreateSoftwareTargets(ID3D11Device* pDevice, UINT32 width, UINT32 height)
+{
+	// NV12 textures need even dimensions
+	UINT32 nv12Width = (width + 1) & ~1;
+	UINT32 nv12Height = (height + 1) & ~1;
+
+	auto targetDesc = CD3D11_TEXTURE2D_DESC(DXGI_FORMAT_NV12, nv12Width, nv12Height, 1, 1, D3D11_BIND_RENDER_TARGET);
+	auto stagingDesc = CD3D11_TEXTURE2D_DESC(DXGI_FORMAT_NV12, nv12Width, nv12Height, 1, 1, 0,
+		D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ);
+
+	ComPtr<ID3D11Texture2D> spTarget;
+	HRESULT hr = pDevice->CreateTexture2D(&targetDesc, nullptr, &spTarget);
+	IFR(hr);
+
+	ComPtr<ID3D11Texture2D> spStaging;
+	hr = pDevice->CreateTexture2D(&stagingDesc, nullptr, &spStaging);
+	IFR(hr);
+
+	try
+	{
+		m_softwareFrame.resize((size_t)width * height * 4);
+	}
+	catch (const std::bad_alloc&)
+	{
+		IFR(E_OUTOFMEMORY);
+	}
+
+	m_spSoftwareTarget = spTarget;
+	m_spSoftwareStaging = spStaging;
+	m_softwareHeight = nv12Height;
+
+	return S_OK;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:   UpdateColorMatrix
+//
+//  Synopsis:   Picks the software path's YUV matrix from the source: its
+//              MF_MT_YUV_MATRIX when the source reports one, otherwise its
+//              native height, HD being BT.709 and anything smaller BT.601.
+//              The output size says nothing about it; an HD stream shown
+//              small is still BT.709. Called when the source's metadata
+//              is loaded or its format changes.
+//
+//------------------------------------------------------------------------------
+void MEPlayer::UpdateColorMatrix()
+{
+	if (m_spMediaEngine == nullptr)
+	{
+		return;
+	}
+
+	MEDIA::ColorMatrix matrix = MEDIA::ColorMatrix_BT601;
+	BOOL fKnown = FALSE;
+
+	DWORD streams = 0;
+	if (m_spEngineEx != nullptr && SUCCEEDED(m_spEngineEx->GetNumberOfStreams(&streams)))
+	{
+		for (DWORD i = 0; i < streams && !fKnown; i++)
+		{
+			PROPVARIANT var;
+			PropVariantInit(&var);
+			if (SUCCEEDED(m_spEngineEx->GetStreamAttribute(i, MF_MT_YUV_MATRIX, &var)) && var.vt == VT_UI4)
+			{
+				switch (var.ulVal)
+				{
+				case MFVideoTransferMatrix_BT709:
+					matrix = MEDIA::ColorMatrix_BT709;
+					fKnown = TRUE;
+					break;
+				case MFVideoTransferMatrix_BT601:
+					matrix = MEDIA::ColorMatrix_BT601;
+					fKnown = TRUE;
+					break;
+				}
+			}
+			PropVariantClear(&var);
+		}
+	}
+
+	DWORD nativeWidth = 0;
+	DWORD nativeHeight = 0;
+	if (!fKnown && SUCCEEDED(m_spMediaEngine->GetNativeVideoSize(&nativeWidth, &nativeHeight)) && nativeHeight >= 720)
+	{
+		matrix = MEDIA::ColorMatrix_BT709;
+	}
+
+	EnterCriticalSection(&m_critSec);
+	m_colorParams.matrix = matrix;
+	LeaveCriticalSection(&m_critSec);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:   TransferSoftwareFrame
+//
+//  Synopsis:   Software path for OnTimer: transfers the frame as NV12,
+//              reads it back and uploads the converted BGRA frame into
+//              pTexture. Called with m_critSec held.
+//
+//------------------------------------------------------------------------------
+HRESULT MEPlayer::TransferSoftwareFrame(ID3D11Texture2D* pTexture)
+{
+	if (m_spSoftwareTarget == nullptr || m_spSoftwareStaging == nullptr)
+	{
+		IFR(E_NOT_VALID_STATE);
+	}
+
+	HRESULT hr = m_spMediaEngine->TransferVideoFrame(m_spSoftwareTarget.Get(), &m_nRect, &m_rcTarget, &m_bkgColor);
+	IFR(hr);
+
+	m_spDX11DeviceContext->CopyResource(m_spSoftwareStaging.Get(), m_spSoftwareTarget.Get());
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	hr = m_spDX11DeviceContext->Map(m_spSoftwareStaging.Get(), 0, D3D11_MAP_READ, 0, &mapped);
+	IFR(hr);
+
+	// the chroma plane follows the luma plane at the same pitch
+	const uint8_t* pY = static_cast<const uint8_t*>(mapped.pData);
+	const uint8_t* pUV = pY + (size_t)mapped.RowPitch * m_softwareHeight;
+
+	int width = m_rcTarget.right;
+	int height = m_rcTarget.bottom;
+	bool converted = MEDIA::ConvertNV12ToBGRA(
+		pY, (int)mapped.RowPitch,
+		pUV, (int)mapped.RowPitch,
+		m_softwareFrame.data(), width * 4,
+		width, height,
+		m_colorParams);
+
+	m_spDX11DeviceContext->Unmap(m_spSoftwareStaging.Get(), 0);
+
+	if (!converted)
+	{
+		IFR(E_UNEXPECTED);
+	}
+
+	m_spDX11DeviceContext->UpdateSubresource(pTexture, 0, nullptr, m_softwareFrame.data(), width * 4, 0);
+
+	return S_OK;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:   ReleaseFrameSlots
+//
+//  Synopsis:   Returns the slots to the texture pool. Callers must exclude
+//              both the producer and the consumer.
+//
+//------------------------------------------------------------------------------
+void MEPlayer::ReleaseFrameSlots()
+{
+	for (UINT32 i = 0; i < c_frameSlotCount; i++)
+	{
+		m_texturePool.Release(m_frameSlots[i]);
+		m_frameSlots[i] = nullptr;
+	}
+
+	m_texturePool.Release(m_stableSlot);
+	m_stableSlot = nullptr;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:   EnsureStableSlot
+//
+//  Synopsis:   Makes sure the stable texture exists and matches the frame
+//              slots. Called with m_critSec held; a texture of another size
+//              goes back to the pool and is replaced, so callers must hand
+//              the new one out again.
+//
+//------------------------------------------------------------------------------
+HRESULT MEPlayer::EnsureStableSlot()
+{
+	if (m_frameSlots[0] == nullptr)
+	{
+		IFR(E_NOT_VALID_STATE);
+	}
+
+	if (m_stableSlot != nullptr && m_stableSlotKey == m_frameSlotKey)
+	{
+		return S_OK;
+	}
+
+	MEFrameSlot* slot = static_cast<MEFrameSlot*>(m_texturePool.Acquire(m_frameSlotKey));
+
+	AcquireSRWLockExclusive(&m_frameSlotLock);
+	MEFrameSlot* previous = m_stableSlot;
+	m_stableSlot = slot;
+	m_stableSlotKey = m_frameSlotKey;
+	ReleaseSRWLockExclusive(&m_frameSlotLock);
+
+	m_texturePool.Release(previous);
+
+	if (slot == nullptr)
+	{
+		IFR(m_frameSlotAllocator.LastError());
+	}
+
+	return S_OK;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:   MEFrameSlotAllocator::Allocate
+//
+//  Synopsis:   Creates a texture on the Unity device and opens it on the
+//              media engine device through an unnamed NT handle.
+//
+//------------------------------------------------------------------------------
+void* MEFrameSlotAllocator::Allocate(const MEDIA::TextureKey& key)
+{
+	auto textureDesc = CD3D11_TEXTURE2D_DESC((DXGI_FORMAT)key.format, key.width, key.height);
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+	textureDesc.MipLevels = 1;
+	textureDesc.MiscFlags = D3D11_RESOURCE_MISC_SHARED | D3D11_RESOURCE_MISC_SHARED_NTHANDLE;
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+
+	MEFrameSlot* slot = new (std::nothrow) MEFrameSlot();
+	if (slot == nullptr)
+	{
+		m_hrLastError = E_OUTOFMEMORY;
+		return nullptr;
+	}
+	slot->sharedHandle = nullptr;
+
+	// create staging texture on unity device
+	ComPtr<ID3D11Texture2D> spTexture;
+	HRESULT hr = m_spUnityDevice->CreateTexture2D(&textureDesc, nullptr, &spTexture);
+	if (SUCCEEDED(hr))
+	{
+		auto srvDesc = CD3D11_SHADER_RESOURCE_VIEW_DESC(spTexture.Get(), D3D11_SRV_DIMENSION_TEXTURE2D);
+		hr = m_spUnityDevice->CreateShaderResourceView(spTexture.Get(), &srvDesc, &slot->textureSRV);
+	}
+
+	// create shared texture from the unity texture; the handles are
+	// unnamed because a name can only be bound to one texture at a time
+	ComPtr<IDXGIResource1> spDXGIResource;
+	if (SUCCEEDED(hr))
+	{
+		hr = spTexture.As(&spDXGIResource);
+	}
+	if (SUCCEEDED(hr))
+	{
+		hr = spDXGIResource->CreateSharedHandle(
+			nullptr,
+			DXGI_SHARED_RESOURCE_READ | DXGI_SHARED_RESOURCE_WRITE,
+			nullptr,
+			&slot->sharedHandle);
+	}
+	if (SUCCEEDED(hr))
+	{
+		hr = m_spMediaDevice->OpenSharedResource1(slot->sharedHandle, IID_PPV_ARGS(&slot->mediaTexture));
+	}
+	if (SUCCEEDED(hr))
+	{
+		hr = GetSurfaceFromTexture(slot->mediaTexture.Get(), &slot->mediaSurface);
+	}
+
+	if (FAILED(hr))
+	{
+		LOG_RESULT(hr);
+		m_hrLastError = hr;
+		Free(slot);
+		return nullptr;
+	}
+
+	return slot;
+}
+
+void MEFrameSlotAllocator::Free(void* texture)
+{
+	MEFrameSlot* slot = static_cast<MEFrameSlot*>(texture);
+	if (slot->sharedHandle != nullptr)
+	{
+		CloseHandle(slot->sharedHandle);
+	}
+	delete slot;
+}
+
+uint64_t MEFrameSlotAllocator::SizeInBytes(const MEDIA::TextureKey& key)
+{
+	uint64_t bytesPerPixel = 4;
+	switch ((DXGI_FORMAT)key.format)
+	{
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+		bytesPerPixel = 8;
+		break;
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		bytesPerPixel = 16;
+		break;
+	}
+
+	return (uint64_t)key.width * key.height * bytesPerPixel;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:   Initialize
+//
+//  Synopsis:   Creates the device and media engine on the first call. Later
+//              calls only make sure the output matches the requested size,
+//              so it is cheap to call whenever Unity asks for the texture.
+//
+//------------------------------------------------------------------------------
 void MEPlayer::Initialize(float width, float height)
 {
-	ComPtr<IMFMediaEngineClassFactory> spFactory;
-	ComPtr<IMFAttributes> spAttributes;
-	ComPtr<MediaEngineNotify> spNotify;
+	high_resolution_clock::time_point start = high_resolution_clock::now();
 
-	HRESULT hr = S_OK;
+	EnterCriticalSection(&m_critSec);
 
+	BOOL fCold = !m_fInitSuccess;
+	if (fCold)
+	{
+		InitializeEngine(width, height);
+	}
+	else
+	{
+		EnsureOutputSize(width, height);
+	}
+
+	LONGLONG elapsed = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+	if (fCold)
+	{
+		m_initStats.coldInits++;
+		m_initStats.lastColdInitMicroseconds = elapsed;
+	}
+	else
+	{
+		m_initStats.warmInits++;
+		m_initStats.lastWarmInitMicroseconds = elapsed;
+		if (elapsed > m_initStats.maxWarmInitMicroseconds)
+		{
+			m_initStats.maxWarmInitMicroseconds = elapsed;
+		}
+	}
+
+	LeaveCriticalSection(&m_critSec);
+
+	return;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:   EnsureOutputSize
+//
+//  Synopsis:   Recreates the back buffers only when the size changed or the
+//              previous attempt left no slots behind.
+//
+//------------------------------------------------------------------------------
+void MEPlayer::EnsureOutputSize(float width, float height)
+{
+	if (m_frameSlots[0] != nullptr &&
+		m_rcTarget.right == (LONG)width &&
+		m_rcTarget.bottom == (LONG)height)
+	{
+		return;
+	}
+
+	try
+	{
+		UpdateForWindowSizeChange(width, height);
+	}
+	catch (Platform::Exception^)
+	{
+	}
+}
+
+// Create a new instance of the Media Engine. Called with m_critSec held.
+void MEPlayer::InitializeEngine(float width, float height)
+{
 	// Get the bounding rectangle of the window.
 	m_rcTarget.left = 0;
 	m_rcTarget.top = 0;
 	m_rcTarget.right = width;
 	m_rcTarget.bottom = height;
 
-	MEDIA::ThrowIfFailed(MFStartup(MF_VERSION));
-
-	EnterCriticalSection(&m_critSec);
-
 	try
 	{
-		// Create DX11 device.    
-		CreateDX11Device();
-
-		UINT resetToken;
-		MEDIA::ThrowIfFailed(
-			MFCreateDXGIDeviceManager(&resetToken, &m_spDXGIManager)
-		);
+		// Already there when the player came from the pool.
+		CreateEngine();
 
-		MEDIA::ThrowIfFailed(
-			m_spDXGIManager->ResetDevice(m_spDX11Device.Get(), resetToken)
-		);
+		// Create/Update swap chain
+		UpdateForWindowSizeChange(width, height);
 
-		// Create our event callback object.
-		spNotify = new MediaEngineNotify(nullptr);
-		if (spNotify == nullptr)
+		m_fInitSuccess = TRUE;
+	}
+	catch (Platform::Exception^)
+	{
+		// don't leak a half-initialized engine, the next call starts over
+		if (m_spMediaEngine)
 		{
-			MEDIA::ThrowIfFailed(E_OUTOFMEMORY);
+			m_spMediaEngine->Shutdown();
 		}
+		m_spEngineEx.Reset();
+		m_spMediaEngine.Reset();
+	}
+
+	return;
+}
 
-		spNotify->MediaEngineNotifyCallback(this);
+//+-----------------------------------------------------------------------------
+//
+//  Function:   CreateEngine
+//
+//  Synopsis:   Starts MF, takes the shared device and creates the media
+//              engine; everything that does not depend on the output size.
+//              Does nothing once the engine exists. Called with m_critSec
+//              held, throws on failure.
+//
+//------------------------------------------------------------------------------
+void MEPlayer::CreateEngine()
+{
+	ComPtr<IMFMediaEngineClassFactory> spFactory;
+	ComPtr<IMFAttributes> spAttributes;
+	ComPtr<MediaEngineNotify> spNotify;
 
-		// Create the class factory for the Media Engine.
-		MEDIA::ThrowIfFailed(
-			CoCreateInstance(CLSID_MFMediaEngineClassFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&spFactory))
-		);
+	if (m_spMediaEngine)
+	{
+		return;
+	}
 
-		// Set configuration attribiutes.
-		MEDIA::ThrowIfFailed(
-			MFCreateAttributes(&spAttributes, 1)
-		);
+	if (!m_fMFStarted)
+	{
+		MEDIA::ThrowIfFailed(MFStartup(MF_VERSION));
+		m_fMFStarted = TRUE;
+	}
 
-		MEDIA::ThrowIfFailed(
-			spAttributes->SetUnknown(MF_MEDIA_ENGINE_DXGI_MANAGER, (IUnknown*)m_spDXGIManager.Get())
-		);
+	// Get the shared DX11 device and DXGI manager.
+	CreateDX11Device();
 
-		MEDIA::ThrowIfFailed(
-			spAttributes->SetUnknown(MF_MEDIA_ENGINE_CALLBACK, (IUnknown*)spNotify.Get())
-		);
+	// Without hardware video support the engine renders NV12 and the
+	// frames are converted on the CPU, see TransferSoftwareFrame.
+	m_d3dFormat = m_fUseDX ? DXGI_FORMAT_B8G8R8A8_UNORM : DXGI_FORMAT_NV12;
 
-		MEDIA::ThrowIfFailed(
-			spAttributes->SetUINT32(MF_MEDIA_ENGINE_VIDEO_OUTPUT_FORMAT, m_d3dFormat)
-		);
+	// Create our event callback object.
+	spNotify = new MediaEngineNotify(nullptr);
+	if (spNotify == nullptr)
+	{
+		MEDIA::ThrowIfFailed(E_OUTOFMEMORY);
+	}
 
-		// Create the Media Engine.
-		const DWORD flags = MF_MEDIA_ENGINE_WAITFORSTABLE_STATE;
-		MEDIA::ThrowIfFailed(
-			spFactory->CreateInstance(flags, spAttributes.Get(), &m_spMediaEngine)
-		);
+	spNotify->MediaEngineNotifyCallback(this);
+
+	// Create the class factory for the Media Engine.
+	MEDIA::ThrowIfFailed(
+		CoCreateInstance(CLSID_MFMediaEngineClassFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&spFactory))
+	);
+
+	// Set configuration attribiutes.
+	MEDIA::ThrowIfFailed(
+		MFCreateAttributes(&spAttributes, 1)
+	);
+
+	MEDIA::ThrowIfFailed(
+		spAttributes->SetUnknown(MF_MEDIA_ENGINE_DXGI_MANAGER, (IUnknown*)m_spDXGIManager.Get())
+	);
+
+	MEDIA::ThrowIfFailed(
+		spAttributes->SetUnknown(MF_MEDIA_ENGINE_CALLBACK, (IUnknown*)spNotify.Get())
+	);
+
+	MEDIA::ThrowIfFailed(
+		spAttributes->SetUINT32(MF_MEDIA_ENGINE_VIDEO_OUTPUT_FORMAT, m_d3dFormat)
+	);
+
+	// Create the Media Engine.
+	const DWORD flags = MF_MEDIA_ENGINE_WAITFORSTABLE_STATE;
+	MEDIA::ThrowIfFailed(
+		spFactory->CreateInstance(flags, spAttributes.Get(), &m_spMediaEngine)
+	);
+
+	MEDIA::ThrowIfFailed(
+		m_spMediaEngine.Get()->QueryInterface(__uuidof(IMFMediaEngine), (void**)&m_spEngineEx)
+	);
+
+	m_spEngineEx->SetRealTimeMode(TRUE);
 
-		MEDIA::ThrowIfFailed(
-			m_spMediaEngine.Get()->QueryInterface(__uuidof(IMFMediaEngine), (void**)&m_spEngineEx)
-		);
+	return;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:   Prewarm
+//
+//  Synopsis:   Runs CreateEngine ahead of the first Initialize, on the pool
+//              thread. A failure leaves the player as if never prewarmed.
+//
+//------------------------------------------------------------------------------
+HRESULT MEPlayer::Prewarm()
+{
+	ME_TRACE_SPAN("MEPlayer::Prewarm");
 
-		m_spEngineEx->SetRealTimeMode(TRUE);
+	HRESULT hr = S_OK;
 
-		// Create/Update swap chain
-		UpdateForWindowSizeChange(width, height);
+	EnterCriticalSection(&m_critSec);
 
-		m_fInitSuccess = TRUE;
+	try
+	{
+		CreateEngine();
 	}
-	catch (Platform::Exception^)
+	catch (Platform::Exception^ e)
 	{
+		hr = e->HResult;
+		if (m_spMediaEngine)
+		{
+			m_spMediaEngine->Shutdown();
+		}
+		m_spEngineEx.Reset();
+		m_spMediaEngine.Reset();
 	}
 
 	LeaveCriticalSection(&m_critSec);
 
-	return;
+	return hr;
 }
 
 // Shut down the player and release all interface pointers.
@@ -404,15 +1120,26 @@ void MEPlayer::Shutdown()
 {
 	EnterCriticalSection(&m_critSec);
 
-	StopTimer();
+	SetRunState(MEDIA::RunState_Shutdown);
+
+	AcquireSRWLockExclusive(&m_frameSlotLock);
+	ReleaseFrameSlots();
+	ReleaseSRWLockExclusive(&m_frameSlotLock);
+	m_texturePool.Trim();
 
-	CloseHandle(m_sharedTextureHandle);
+	m_spSoftwareStaging.Reset();
+	m_spSoftwareTarget.Reset();
+	m_softwareFrame.clear();
+
+	DisableFrameTap();
 
 	if (m_spMediaEngine)
 	{
 		m_spMediaEngine->Shutdown();
 	}
 
+	ReleaseDX11Device();
+
 	if (nullptr != m_bstrURL)
 	{
 		::CoTaskMemFree(m_bstrURL);
@@ -471,8 +1198,17 @@ HRESULT MEPlayer::GetPrimaryTexture(UINT32 width, UINT32 height, void ** primary
 
 	Initialize(width, height);
 
+	// The stable texture, not a ring slot: the caller keeps it and the
+	// ring would only ever show it the slot it started with.
 	ComPtr<ID3D11ShaderResourceView> spSRV;
-	IFR(m_primaryTextureSRV.CopyTo(&spSRV));
+	EnterCriticalSection(&m_critSec);
+	HRESULT hr = EnsureStableSlot();
+	if (SUCCEEDED(hr))
+	{
+		hr = m_stableSlot->textureSRV.CopyTo(&spSRV);
+	}
+	LeaveCriticalSection(&m_critSec);
+	IFR(hr);
 
 	*primarySRV = spSRV.Detach();
 
@@ -487,23 +1223,102 @@ HRESULT MEPlayer::GetPrimary2DTexture(UINT32 width, UINT32 height, ID3D11Texture
 	Initialize(width, height);
 
 	ComPtr<ID3D11Texture2D> spTexture;
-	IFR(m_primaryMediaTexture.CopyTo(&spTexture));
+	EnterCriticalSection(&m_critSec);
+	HRESULT hr = EnsureStableSlot();
+	if (SUCCEEDED(hr))
+	{
+		hr = m_stableSlot->mediaTexture.CopyTo(&spTexture);
+	}
+	LeaveCriticalSection(&m_critSec);
+	IFR(hr);
 
 	*primaryTexture = spTexture.Detach();
 
 	return S_OK;
 }
 
+HRESULT MEPlayer::AcquireLatestTexture(void ** primarySRV)
+{
+	if (nullptr == primarySRV)
+		IFR(E_INVALIDARG);
+
+	*primarySRV = nullptr;
+
+	// Exclusive: the render event and AcquirePrimaryTexture may both consume
+	// this ring, and FrameSlotRing allows only one consumer at a time.
+	AcquireSRWLockExclusive(&m_frameSlotLock);
+
+	UINT32 slot;
+	bool newFrame = m_frameRing.AcquireLatest(&slot);
+	if (m_frameSlots[slot] != nullptr)
+	{
+		*primarySRV = m_frameSlots[slot]->textureSRV.Get();
+	}
+
+	ReleaseSRWLockExclusive(&m_frameSlotLock);
+
+	if (nullptr == *primarySRV)
+		IFR(E_NOT_VALID_STATE);
+
+	return newFrame ? S_OK : S_FALSE;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:   UpdatePrimaryTexture
+//
+//  Synopsis:   Copies the frame the last AcquireLatestTexture returned into
+//              the stable texture. Runs on the Unity render thread, on the
+//              Unity device, so Unity's own sampling of the stable texture
+//              is ordered after the copy instead of racing it.
+//
+//------------------------------------------------------------------------------
+HRESULT MEPlayer::UpdatePrimaryTexture()
+{
+	HRESULT hr = S_FALSE;
+
+	AcquireSRWLockExclusive(&m_frameSlotLock);
+
+	MEFrameSlot* source = m_frameSlots[m_frameRing.ReadSlot()];
+	if (m_stableSlot != nullptr && source != nullptr && m_stableSlotKey == m_frameSlotKey)
+	{
+		ComPtr<ID3D11Resource> spSource;
+		ComPtr<ID3D11Resource> spTarget;
+		source->textureSRV->GetResource(&spSource);
+		m_stableSlot->textureSRV->GetResource(&spTarget);
+
+		ComPtr<ID3D11DeviceContext> spUnityContext;
+		m_spDX11UnityDevice->GetImmediateContext(&spUnityContext);
+		spUnityContext->CopyResource(spTarget.Get(), spSource.Get());
+		hr = S_OK;
+	}
+
+	ReleaseSRWLockExclusive(&m_frameSlotLock);
+
+	return hr;
+}
+
 HRESULT MEPlayer::SetMediaStreamSource(Windows::Media::Core::IMediaStreamSource^ streamSource)
 {
+	ME_TRACE_SPAN("MEPlayer::SetMediaStreamSource");
+
 	HRESULT hr;
 	if (streamSource == nullptr)
 	{
+		SetRunState(MEDIA::RunState_NoSource);
 		hr = m_spEngineEx->SetSource(nullptr);
 		return S_OK;
 	}
 
-	boolean replaced;
+	// parked until the engine reports it can play the new source
+	SetRunState(MEDIA::RunState_Loading);
+
+	// A new source has its own pts timeline, restart the lag baseline.
+	EnterCriticalSection(&m_critSec);
+	_fHasPresentationOffset = FALSE;
+	_lastFramePresented = high_resolution_clock::time_point();
+	LeaveCriticalSection(&m_critSec);
+
 	auto streamInspect = reinterpret_cast<IInspectable*>(streamSource);
 	// Create a random URL that we'll use to map to the media source.
 	std::wstring url(L"webrtc://");
@@ -515,11 +1330,12 @@ HRESULT MEPlayer::SetMediaStreamSource(Windows::Media::Core::IMediaStreamSource^
 	}
 	Guid gd(result);
 	url += gd.ToString()->Data();
-	// Insert the url and the media source in the map.
-	hr = m_extensionManagerProperties->Insert(HStringReference(url.c_str()).Get(), streamInspect, &replaced);
+	// Register the media source under the url; the scheme handler takes it
+	// once, leaving the sources of other players alone.
+	hr = m_sourceRegistry->RegisterSource(url.c_str(), streamInspect);
 	if (FAILED(hr))
 	{
-		throw ref new COMException(hr, ref new String(L"Failed to insert a media stream into media properties"));
+		throw ref new COMException(hr, ref new String(L"Failed to register a media stream with the source registry"));
 	}
 
 	// Set the source URL on the media engine.
@@ -550,8 +1366,12 @@ void MEPlayer::OnMediaEngineEvent(DWORD meEvent)
 	case MF_MEDIA_ENGINE_EVENT_LOADEDMETADATA:
 	{
 		m_fEOS = FALSE;
+		UpdateColorMatrix();
 	}
 	break;
+	case MF_MEDIA_ENGINE_EVENT_FORMATCHANGE:
+		UpdateColorMatrix();
+		break;
 	case MF_MEDIA_ENGINE_EVENT_CANPLAY:
 	{
 		// Start the Playback
@@ -559,18 +1379,14 @@ void MEPlayer::OnMediaEngineEvent(DWORD meEvent)
 	}
 	break;
 	case MF_MEDIA_ENGINE_EVENT_PLAY:
-		m_fPlaying = TRUE;
+		SetRunState(MEDIA::RunState_Playing);
 		break;
 	case MF_MEDIA_ENGINE_EVENT_PAUSE:
-		m_fPlaying = FALSE;
+		SetRunState(MEDIA::RunState_Paused);
 		break;
 	case MF_MEDIA_ENGINE_EVENT_ENDED:
-
-		if (m_spMediaEngine->HasVideo())
-		{
-			StopTimer();
-		}
 		m_fEOS = TRUE;
+		SetRunState(MEDIA::RunState_Ended);
 		break;
 	case MF_MEDIA_ENGINE_EVENT_TIMEUPDATE:
 		break;
@@ -586,12 +1402,12 @@ void MEPlayer::Play()
 {
 	if (m_spMediaEngine)
 	{
-		StartTimer();
-
+		// the PLAY event resumes pacing, except when restarting from the
+		// end where no event follows the seek
 		if (m_fEOS)
 		{
 			SetPlaybackPosition(0);
-			m_fPlaying = TRUE;
+			SetRunState(MEDIA::RunState_Playing);
 		}
 		else
 		{
@@ -781,12 +1597,31 @@ void MEPlayer::UpdateForWindowSizeChange(float width, float height)
 
 //Timer related
 
-void MEPlayer::UpdateFrameRate()
+void MEPlayer::UpdateFrameRate(LONGLONG pts,
+	high_resolution_clock::time_point transferStart,
+	high_resolution_clock::time_point transferEnd)
 {
+	// Record latency; pts is in 100ns units.
+	LONGLONG presentationOffset = duration_cast<microseconds>(transferEnd.time_since_epoch()).count() - pts / 10;
+	if (!_fHasPresentationOffset || presentationOffset < _minPresentationOffset)
+	{
+		_minPresentationOffset = presentationOffset;
+		_fHasPresentationOffset = TRUE;
+	}
+	_presentationLag.Record(presentationOffset - _minPresentationOffset);
+
+	_transferDuration.Record(duration_cast<microseconds>(transferEnd - transferStart).count());
+
+	if (_lastFramePresented != high_resolution_clock::time_point())
+	{
+		_frameInterval.Record(duration_cast<microseconds>(transferEnd - _lastFramePresented).count());
+	}
+	_lastFramePresented = transferEnd;
+
 	// Do FPS calculation and notification.
 	_frameCounter++;
 
-	high_resolution_clock::time_point now = high_resolution_clock::now();
+	high_resolution_clock::time_point now = transferEnd;
 	duration<double, std::milli> time_span = now - _lastTimeFPSCalculated;
 	if (time_span.count() > 1000) {
 
@@ -801,35 +1636,34 @@ void MEPlayer::UpdateFrameRate()
 //
 //  Function:   StartTimer
 //
-//  Synopsis:   Our timer is based on the displays VBlank interval
+//  Synopsis:   Our timer is based on the displays VBlank interval. All players
+//              share one scheduler thread, the first player to register
+//              starts it and it exits once the last one is removed. The
+//              clock has its output before the thread can start.
 //
 //------------------------------------------------------------------------------
 void MEPlayer::StartTimer()
 {
-	ComPtr<IDXGIFactory1> spFactory;
-	MEDIA::ThrowIfFailed(
-		CreateDXGIFactory1(IID_PPV_ARGS(&spFactory))
-	);
-
-	ComPtr<IDXGIAdapter> spAdapter;
 	MEDIA::ThrowIfFailed(
-		spFactory->EnumAdapters(0, &spAdapter)
+		s_vsyncClock.RefreshOutput()
 	);
 
-	ComPtr<IDXGIOutput> spOutput;
-	MEDIA::ThrowIfFailed(
-		spAdapter->EnumOutputs(0, &m_spDXGIOutput)
-	);
+	if (m_spVSyncTarget == nullptr)
+	{
+		m_spVSyncTarget = std::make_shared<MEPlayerVSyncTarget>(this);
+	}
 
 	m_fStopTimer = FALSE;
 
-	auto vidPlayer = this;
-	task<void> workItem(ThreadPool::RunAsync(ref new WorkItemHandler([=](IAsyncAction^ /*sender*/) {
-		vidPlayer->RealVSyncTimer();
+	if (s_vsyncScheduler.AddTarget(m_spVSyncTarget))
+	{
+		task<void> workItem(ThreadPool::RunAsync(ref new WorkItemHandler([=](IAsyncAction^ /*sender*/) {
+			s_vsyncScheduler.Run();
+		}
+		),
+			WorkItemPriority::High
+			));
 	}
-	),
-		WorkItemPriority::High
-		));
 
 	return;
 }
@@ -838,7 +1672,7 @@ void MEPlayer::StartTimer()
 //
 //  Function:   StopTimer
 //
-//  Synopsis:   Stops the Timer and releases all its resources
+//  Synopsis:   Removes the player from the shared vsync scheduler
 //
 //------------------------------------------------------------------------------
 void MEPlayer::StopTimer()
@@ -846,34 +1680,255 @@ void MEPlayer::StopTimer()
 	m_fStopTimer = TRUE;
 	m_fPlaying = FALSE;
 
+	if (m_spVSyncTarget != nullptr)
+	{
+		s_vsyncScheduler.RemoveTarget(m_spVSyncTarget);
+	}
+
 	return;
 }
 
+void MEPlayer::GetVSyncStats(MEDIA::VSyncSchedulerStats* stats)
+{
+	s_vsyncScheduler.GetStats(stats);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:   SetRunState
+//
+//  Synopsis:   Moves the run state machine. Entering PLAYING registers the
+//              player with the vsync scheduler, leaving it unregisters, so
+//              a paused, ended or empty player costs no wakeups at all and
+//              the pump thread exits once no player is playing.
+//
+//------------------------------------------------------------------------------
+void MEPlayer::SetRunState(MEDIA::RunState state)
+{
+	m_runState.Set(state,
+		[this]() {
+			StartTimer();
+			m_fPlaying = TRUE;
+		},
+		[this]() {
+			StopTimer();
+		});
+}
+
+BOOL MEPlayer::OnVSyncWakeup()
+{
+	return m_runState.RecordWakeup(IsTimerRunning() != FALSE) ? TRUE : FALSE;
+}
+
+void MEPlayer::GetRunStats(MERunStats* stats)
+{
+	if (stats == nullptr)
+	{
+		return;
+	}
+
+	MEDIA::RunStateStats runStats;
+	m_runState.GetStats(&runStats);
+
+	stats->state = runStats.state;
+	stats->wakeups = runStats.wakeups;
+	stats->idleWakeups = runStats.idleWakeups;
+	stats->parks = runStats.parks;
+	stats->resumes = runStats.resumes;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:   EnableFrameTap
+//
+//  Synopsis:   Starts copying every presented frame into a named shared
+//              memory ring (see FrameTap.h) that other processes can map.
+//              Replaces any tap that was already enabled.
+//
+//------------------------------------------------------------------------------
+HRESULT MEPlayer::EnableFrameTap(Platform::String^ name, UINT32 slotCount, UINT32 maxWidth, UINT32 maxHeight)
+{
+	if (name == nullptr || name->IsEmpty() || slotCount < 2 || slotCount > MEDIA::c_frameTapMaxSlots || maxWidth == 0 || maxHeight == 0)
+		IFR(E_INVALIDARG);
+
+	UINT64 slotBytes = (UINT64)maxWidth * maxHeight * 4;
+	if (slotBytes > MEDIA::c_frameTapMaxSlotBytes)
+		IFR(E_INVALIDARG);
+
+	size_t requiredBytes = MEDIA::FrameTapRequiredBytes(slotCount, (uint32_t)slotBytes);
+	if (requiredBytes == 0)
+		IFR(E_INVALIDARG);
+
+	int length = WideCharToMultiByte(CP_UTF8, 0, name->Data(), -1, nullptr, 0, nullptr, nullptr);
+	if (length <= 1)
+		IFR(E_INVALIDARG);
+
+	std::string utf8Name(length, '\0');
+	WideCharToMultiByte(CP_UTF8, 0, name->Data(), -1, &utf8Name[0], length, nullptr, nullptr);
+	utf8Name.resize(length - 1);
+
+	std::unique_ptr<MEDIA::SharedMemory> spMemory(new (std::nothrow) MEDIA::SharedMemory());
+	if (spMemory == nullptr)
+		IFR(E_OUTOFMEMORY);
+
+	if (!spMemory->Create(utf8Name, requiredBytes))
+	{
+		HRESULT hr = HRESULT_FROM_WIN32(spMemory->LastError());
+		IFR(hr);
+	}
+
+	std::unique_ptr<MEDIA::FrameTapWriter> spWriter(
+		new (std::nothrow) MEDIA::FrameTapWriter(spMemory->Data(), spMemory->Size(), slotCount, (uint32_t)slotBytes));
+	if (spWriter == nullptr || !spWriter->IsValid())
+		IFR(E_OUTOFMEMORY);
+
+	EnterCriticalSection(&m_critSec);
+
+	// the old writer goes before the memory it points into
+	m_frameTap = std::move(spWriter);
+	m_frameTapMemory = std::move(spMemory);
+	m_fTapPending = FALSE;
+
+	LeaveCriticalSection(&m_critSec);
+
+	return S_OK;
+}
+
+void MEPlayer::DisableFrameTap()
+{
+	EnterCriticalSection(&m_critSec);
+
+	m_frameTap.reset();
+	m_frameTapMemory.reset();
+	m_spTapStaging[0].Reset();
+	m_spTapStaging[1].Reset();
+	m_fTapPending = FALSE;
+
+	LeaveCriticalSection(&m_critSec);
+}
+
+BOOL MEPlayer::GetFrameTapStats(MEDIA::FrameTapStats* stats)
+{
+	if (stats == nullptr)
+		return FALSE;
+
+	EnterCriticalSection(&m_critSec);
+
+	BOOL enabled = (m_frameTap != nullptr);
+	if (enabled)
+	{
+		m_frameTap->GetStats(stats);
+	}
+
+	LeaveCriticalSection(&m_critSec);
+
+	return enabled;
+}
+
 //+-----------------------------------------------------------------------------
 //
-//  Function:   realVSyncTimer
+//  Function:   TapFrame
 //
-//  Synopsis:   A real VSyncTimer - a timer that fires at approx 60 Hz 
-//              synchronized with the display's real VBlank interrupt.
+//  Synopsis:   Writes the frame just transferred into pTexture to the frame
+//              tap. On the GPU path the readback lags one frame behind, so
+//              Map never waits for the copy issued on this tick. Called
+//              with m_critSec held.
 //
 //------------------------------------------------------------------------------
-DWORD MEPlayer::RealVSyncTimer()
+void MEPlayer::TapFrame(ID3D11Texture2D* pTexture, LONGLONG pts)
 {
-	for (;; )
+	if (!m_fUseDX)
+	{
+		// the software path already has the frame in memory
+		int width = m_rcTarget.right;
+		int height = m_rcTarget.bottom;
+		m_frameTap->Write(m_softwareFrame.data(), width * 4, width, height, MEDIA::c_frameTapFormatBGRA8, pts);
+		return;
+	}
+
+	D3D11_TEXTURE2D_DESC desc;
+	pTexture->GetDesc(&desc);
+
+	ComPtr<ID3D11Texture2D>& spStaging = m_spTapStaging[m_tapStagingIndex];
+	D3D11_TEXTURE2D_DESC stagingDesc;
+	if (spStaging != nullptr)
 	{
-		if (m_fStopTimer)
+		spStaging->GetDesc(&stagingDesc);
+	}
+
+	if (spStaging == nullptr || stagingDesc.Width != desc.Width || stagingDesc.Height != desc.Height)
+	{
+		spStaging.Reset();
+		stagingDesc = CD3D11_TEXTURE2D_DESC(desc.Format, desc.Width, desc.Height, 1, 1, 0,
+			D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ);
+
+		HRESULT hr = m_spDX11Device->CreateTexture2D(&stagingDesc, nullptr, &spStaging);
+		if (FAILED(hr))
 		{
-			break;
+			LOG_RESULT(hr);
+			return;
 		}
+	}
+
+	m_spDX11DeviceContext->CopyResource(spStaging.Get(), pTexture);
+
+	ComPtr<ID3D11Texture2D>& spPrevious = m_spTapStaging[m_tapStagingIndex ^ 1];
+	if (m_fTapPending && spPrevious != nullptr)
+	{
+		D3D11_TEXTURE2D_DESC previousDesc;
+		spPrevious->GetDesc(&previousDesc);
 
-		if (SUCCEEDED(m_spDXGIOutput->WaitForVBlank()))
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		HRESULT hr = m_spDX11DeviceContext->Map(spPrevious.Get(), 0, D3D11_MAP_READ, 0, &mapped);
+		if (SUCCEEDED(hr))
+		{
+			m_frameTap->Write(static_cast<const uint8_t*>(mapped.pData), mapped.RowPitch,
+				previousDesc.Width, previousDesc.Height, MEDIA::c_frameTapFormatBGRA8, m_tapPendingPts);
+			m_spDX11DeviceContext->Unmap(spPrevious.Get(), 0);
+		}
+		else
 		{
-			OnTimer();
+			LOG_RESULT(hr);
 		}
-		else break;
 	}
 
-	return 0;
+	m_tapPendingPts = pts;
+	m_fTapPending = TRUE;
+	m_tapStagingIndex ^= 1;
+}
+
+void MEPlayer::GetPlaybackStats(MEPlaybackStats* stats)
+{
+	if (stats == nullptr)
+	{
+		return;
+	}
+
+	_presentationLag.Summarize(&stats->presentationLag);
+	_transferDuration.Summarize(&stats->transferDuration);
+	_frameInterval.Summarize(&stats->frameInterval);
+}
+
+void MEPlayer::MarkCallStart(MEDIA::WarmPool* pool, BOOL fPooled)
+{
+	EnterCriticalSection(&m_critSec);
+	m_pFirstFramePool = pool;
+	m_callStart = high_resolution_clock::now();
+	m_fFirstFramePending = (pool != nullptr);
+	m_fFromPool = fPooled;
+	LeaveCriticalSection(&m_critSec);
+}
+
+void MEPlayer::GetInitStats(MEInitStats* stats)
+{
+	if (stats == nullptr)
+	{
+		return;
+	}
+
+	EnterCriticalSection(&m_critSec);
+	*stats = m_initStats;
+	LeaveCriticalSection(&m_critSec);
 }
 
 //+-----------------------------------------------------------------------------
@@ -881,29 +1936,138 @@ DWORD MEPlayer::RealVSyncTimer()
 //  Function:   OnTimer
 //
 //  Synopsis:   Called at 60Hz - we simply call the media engine and draw
-//              a new frame to the screen if told to do so.
+//              a new frame to the screen if told to do so. Returns true
+//              when a frame was transferred.
 //
 //------------------------------------------------------------------------------
-void MEPlayer::OnTimer()
+bool MEPlayer::OnTimer()
 {
+	ME_TRACE_SPAN("MEPlayer::OnTimer");
+
+	bool transferred = false;
+
 	EnterCriticalSection(&m_critSec);
 
-	if (m_spMediaEngine != nullptr)
+	if (!m_fStopTimer && m_spMediaEngine != nullptr)
 	{
 		LONGLONG pts;
-		if (m_spMediaEngine->OnVideoStreamTick(&pts) == S_OK)
+		MEFrameSlot* slot = m_frameSlots[m_frameRing.WriteSlot()];
+		ID3D11Texture2D* pTexture = (slot != nullptr) ? slot->mediaTexture.Get() : nullptr;
+		if (pTexture != nullptr && m_spMediaEngine->OnVideoStreamTick(&pts) == S_OK)
 		{
-			MEDIA::ThrowIfFailed(
-				m_spMediaEngine->TransferVideoFrame(m_primaryMediaTexture.Get(), &m_nRect, &m_rcTarget, &m_bkgColor)
-			);
+			high_resolution_clock::time_point transferStart = high_resolution_clock::now();
+
+			// Never throws: this runs on the pump thread shared by every
+			// player, so a failed transfer (e.g. device removal) only skips
+			// this player's frame.
+			HRESULT hr;
+			if (m_fUseDX)
+			{
+				hr = m_spMediaEngine->TransferVideoFrame(pTexture, &m_nRect, &m_rcTarget, &m_bkgColor);
+			}
+			else
+			{
+				hr = TransferSoftwareFrame(pTexture);
+			}
+
+			if (FAILED(hr))
+			{
+				LOG_RESULT(hr);
+				LeaveCriticalSection(&m_critSec);
+				return false;
+			}
+
+			// make sure the frame is complete on the GPU before Unity can see it
+			m_spDX11DeviceContext->Flush();
+			m_frameRing.Publish();
+
+			if (m_frameTap != nullptr)
+			{
+				TapFrame(pTexture, pts);
+			}
 
-			FrameTransferred(this, m_rcTarget.right, m_rcTarget.bottom);
+			UpdateFrameRate(pts, transferStart, high_resolution_clock::now());
+
+			PostFrameTransferred(m_rcTarget.right, m_rcTarget.bottom);
+			transferred = true;
+
+			if (m_fFirstFramePending)
+			{
+				m_fFirstFramePending = FALSE;
+				m_pFirstFramePool->RecordFirstFrame(m_fFromPool != FALSE,
+					duration_cast<microseconds>(high_resolution_clock::now() - m_callStart).count());
+			}
 		}
 	}
 
 	LeaveCriticalSection(&m_critSec);
 
-	return;
+	return transferred;
+}
+
+// FrameTransferred notifications carry the output size.
+static const uint8_t c_frameTransferredKind = 1;
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:   PostFrameTransferred
+//
+//  Synopsis:   Queues a FrameTransferred notification from the pacing thread.
+//              The first post after the dispatcher went idle starts a new
+//              work item; m_pendingFrameNotifications is non-zero exactly
+//              while one is running, so there is never more than one.
+//
+//------------------------------------------------------------------------------
+void MEPlayer::PostFrameTransferred(int width, int height)
+{
+	uint64_t size = ((uint64_t)(width & 0xffffff) << 24) | (uint64_t)(height & 0xffffff);
+	if (!m_frameNotifications.Post(m_frameNotifications.MakePayload(c_frameTransferredKind, size)))
+	{
+		return;
+	}
+
+	if (InterlockedIncrement(&m_pendingFrameNotifications) == 1)
+	{
+		Platform::WeakReference wr(this);
+		ThreadPool::RunAsync(ref new WorkItemHandler([wr](IAsyncAction^ /*sender*/) {
+			MEPlayer^ player = wr.Resolve<MEPlayer>();
+			if (player != nullptr)
+			{
+				player->DispatchFrameNotifications();
+			}
+		}));
+	}
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:   DispatchFrameNotifications
+//
+//  Synopsis:   Raises FrameTransferred for everything queued, then retires
+//              the posts it has seen. Posts that arrived meanwhile keep it
+//              going, so none is left behind without a dispatcher.
+//
+//------------------------------------------------------------------------------
+void MEPlayer::DispatchFrameNotifications()
+{
+	LONG observed = InterlockedCompareExchange(&m_pendingFrameNotifications, 0, 0);
+
+	for (;;)
+	{
+		uint64_t payload;
+		while (m_frameNotifications.TryTake(&payload))
+		{
+			uint64_t size = m_frameNotifications.Value(payload);
+			FrameTransferred(this, (int)((size >> 24) & 0xffffff), (int)(size & 0xffffff));
+		}
+
+		LONG remaining = InterlockedAdd(&m_pendingFrameNotifications, -observed);
+		if (remaining == 0)
+		{
+			break;
+		}
+		observed = remaining;
+	}
 }
 
 //+-----------------------------------------------------------------------------
@@ -916,6 +2080,10 @@ void MEPlayer::OnTimer()
 HRESULT MEPlayer::DXGIDeviceTrim()
 {
 	HRESULT hr = S_OK;
+
+	// drop the pooled slots that are not in use before trimming
+	m_texturePool.Trim();
+
 	if (m_fUseDX && m_spDX11Device != nullptr)
 	{
 		IDXGIDevice3 *pDXGIDevice;
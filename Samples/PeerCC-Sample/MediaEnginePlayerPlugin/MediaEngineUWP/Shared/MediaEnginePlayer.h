@@ -20,6 +20,24 @@
 #include <ratio>
 #include <chrono>
 
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CoalescingQueue.h"
+#include "ColorConvert.h"
+#include "DeviceBroker.h"
+#include "FrameTap.h"
+#include "FrameSlotRing.h"
+#include "LatencyHistogram.h"
+#include "MediaSourceRegistry.h"
+#include "RunStateMachine.h"
+#include "SharedMemory.h"
+#include "TexturePool.h"
+#include "TraceSpans.h"
+#include "VSyncScheduler.h"
+#include "WarmPool.h"
+
 using namespace std::chrono;
 
 #ifndef MEPLAYER_H
@@ -50,6 +68,122 @@ internal:
     virtual void OnMediaEngineEvent(DWORD meEvent) = 0;
 };
 
+// Number of shared textures cycled between the media engine and Unity.
+static const UINT32 c_frameSlotCount = 3;
+
+// Notifications waiting for the FrameTransferred dispatcher.
+static const UINT32 c_frameNotificationCount = 8;
+
+// MEFrameSlot: One shared texture the media engine renders into and Unity samples from.
+struct MEFrameSlot
+{
+    HANDLE sharedHandle;
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> mediaTexture;
+    Microsoft::WRL::ComPtr<ABI::Windows::Graphics::DirectX::Direct3D11::IDirect3DSurface> mediaSurface;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureSRV;
+};
+
+// MEFrameSlotAllocator: Creates frame slots for the texture pool. Each slot is a
+// texture on the Unity device shared with the media engine device.
+class MEFrameSlotAllocator : public MEDIA::ITextureAllocator
+{
+    Microsoft::WRL::ComPtr<ID3D11Device>    m_spUnityDevice;
+    Microsoft::WRL::ComPtr<ID3D11Device1>   m_spMediaDevice;
+    HRESULT                                 m_hrLastError;
+
+public:
+    MEFrameSlotAllocator() : m_hrLastError(S_OK)
+    {
+    }
+
+    void SetDevices(
+        Microsoft::WRL::ComPtr<ID3D11Device> spUnityDevice,
+        Microsoft::WRL::ComPtr<ID3D11Device1> spMediaDevice)
+    {
+        m_spUnityDevice = spUnityDevice;
+        m_spMediaDevice = spMediaDevice;
+    }
+
+    // Error of the last failed Allocate call.
+    HRESULT LastError() const
+    {
+        return m_hrLastError;
+    }
+
+    virtual void* Allocate(const MEDIA::TextureKey& key) override;
+    virtual void Free(void* texture) override;
+    virtual uint64_t SizeInBytes(const MEDIA::TextureKey& key) override;
+};
+
+// MESharedDevice: D3D device, context and DXGI manager shared by every player
+// on an adapter. Handed out by the process-wide device broker.
+struct MESharedDevice
+{
+    Microsoft::WRL::ComPtr<ID3D11Device> device;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+    Microsoft::WRL::ComPtr<IMFDXGIDeviceManager> manager;
+    BOOL fHardware;
+};
+
+// MEDeviceFactory: Creates MESharedDevice instances for the device broker.
+class MEDeviceFactory : public MEDIA::IDeviceFactory
+{
+    HRESULT m_hrLastError;
+
+public:
+    MEDeviceFactory() : m_hrLastError(S_OK)
+    {
+    }
+
+    // Error of the last failed Create call.
+    HRESULT LastError() const
+    {
+        return m_hrLastError;
+    }
+
+    virtual void* Create(const MEDIA::DeviceKey& key) override;
+    virtual void Destroy(void* device) override;
+};
+
+// MERunStats: Pacing wakeups seen by a player, a MEDIA::RunStateStats for
+// scripts. idleWakeups counts vblanks delivered while not playing and
+// should stay near zero.
+struct MERunStats
+{
+    UINT32 state;
+    LONGLONG wakeups;
+    LONGLONG idleWakeups;
+    LONGLONG parks;
+    LONGLONG resumes;
+};
+
+// MEPlaybackStats: Per-player latency percentiles in microseconds, returned by GetPlaybackStats.
+struct MEPlaybackStats
+{
+    MEDIA::LatencySummary presentationLag;
+    MEDIA::LatencySummary transferDuration;
+    MEDIA::LatencySummary frameInterval;
+};
+
+// MEFrameUpdate: One player's result from the batched render event. newFrame
+// stays set until the update is read, even across several render events.
+struct MEFrameUpdate
+{
+    INT32 handle;
+    void* textureSRV;
+    BOOL newFrame;
+};
+
+// MEInitStats: Cost of the one-time engine setup versus later Initialize calls.
+struct MEInitStats
+{
+    UINT32 coldInits;
+    UINT32 warmInits;
+    LONGLONG lastColdInitMicroseconds;
+    LONGLONG lastWarmInitMicroseconds;
+    LONGLONG maxWarmInitMicroseconds;
+};
+
 // MEPlayer: Manages the Media Engine.
 
 ref class MEPlayer: public MediaEngineNotifyCallback
@@ -58,7 +192,6 @@ ref class MEPlayer: public MediaEngineNotifyCallback
     Microsoft::WRL::ComPtr<ID3D11Device>                m_spDX11Device;
 	Microsoft::WRL::ComPtr<ID3D11Device>                m_spDX11UnityDevice;
     Microsoft::WRL::ComPtr<ID3D11DeviceContext>         m_spDX11DeviceContext;
-    Microsoft::WRL::ComPtr<IDXGIOutput>                 m_spDXGIOutput;
     Microsoft::WRL::ComPtr<IDXGISwapChain1>             m_spDX11SwapChain;
     Microsoft::WRL::ComPtr<IMFDXGIDeviceManager>        m_spDXGIManager;
 
@@ -76,14 +209,20 @@ ref class MEPlayer: public MediaEngineNotifyCallback
     DXGI_FORMAT                             m_d3dFormat;
     MFARGB                                  m_bkgColor;
 	LPWSTR                                  m_pszTextureName;
-	HANDLE                                  m_sharedTextureHandle;
 
-    HANDLE                                  m_TimerThreadHandle;
     CRITICAL_SECTION                        m_critSec;
 
+    // Registration with the process-wide vsync scheduler, see StartTimer.
+    std::shared_ptr<MEDIA::IVSyncTarget>    m_spVSyncTarget;
+
     concurrency::task<Windows::Storage::StorageFile^>   m_pickFileTask;
     concurrency::cancellation_token_source              m_tcs;
     BOOL                                                m_fInitSuccess;    
+    BOOL                                                m_fMFStarted;
+
+    // Reference on the shared device; the ComPtrs above alias into it.
+    MESharedDevice*                                     m_pSharedDevice;
+    std::string                                         m_deviceClient;
     BOOL                                                m_fExitApp;
     BOOL                                                m_fUseDX;
 
@@ -92,17 +231,26 @@ internal:
 	delegate void VideoFrameTransferred(MEPlayer^ sender, int width, int height);
 
     MEPlayer(Microsoft::WRL::ComPtr<ID3D11Device> unityD3DDevice, Platform::String^ textureName,
-		Microsoft::WRL::ComPtr<ABI::Windows::Foundation::Collections::IMap<HSTRING, IInspectable*>> extensionManagerProperties);
+		Microsoft::WRL::ComPtr<MEDIA::MediaSourceRegistry> sourceRegistry);
 
     // DX11 related
     void CreateDX11Device();
+    void ReleaseDX11Device();
     void CreateBackBuffers();
 
     // Initialize/Shutdown
+    // Initialize creates the engine once and afterwards only resizes.
     void Initialize(float width, float height);
+    void EnsureOutputSize(float width, float height);
+    // Builds the device and engine ahead of time, so Initialize only has
+    // to size the output. Used by the player pool.
+    HRESULT Prewarm();
     void Shutdown();
     BOOL ExitApp();	
 
+	// A texture that always shows the latest frame, for callers that wrap
+	// it once. It only moves when the render event runs, which copies each
+	// new frame into it; AcquireLatestTexture costs no copy.
 	HRESULT GetPrimaryTexture(
 		UINT32 width,
 		UINT32 height,
@@ -113,6 +261,47 @@ internal:
 		UINT32 height,
 		_COM_Outptr_ ID3D11Texture2D** primaryTexture);
 
+	// Swaps in the newest transferred frame for the consumer (Unity render
+	// thread). The returned SRV is not AddRef'd and stays valid until the
+	// back buffers are recreated. Returns S_FALSE when no new frame arrived.
+	HRESULT AcquireLatestTexture(
+		_Outptr_ void** primarySRV);
+
+	// Render thread only, after AcquireLatestTexture reported a new frame.
+	// Returns S_FALSE when nobody asked for the primary texture.
+	HRESULT UpdatePrimaryTexture();
+
+	void GetFrameSlotStats(MEDIA::FrameSlotRingStats* stats)
+	{
+		m_frameRing.GetStats(stats);
+	}
+
+	void GetTexturePoolStats(MEDIA::TexturePoolStats* stats)
+	{
+		m_texturePool.GetStats(stats);
+	}
+
+	void GetFrameNotificationStats(MEDIA::CoalescingQueueStats* stats)
+	{
+		m_frameNotifications.GetStats(stats);
+	}
+
+	// Does not allocate; safe to call from any thread.
+	void GetPlaybackStats(MEPlaybackStats* stats);
+
+	void GetInitStats(MEInitStats* stats);
+
+	// Starts timing the first frame; the first transfer reports it to pool.
+	void MarkCallStart(MEDIA::WarmPool* pool, BOOL fPooled);
+
+	// Opt-in CPU copy of every presented frame in a named shared memory
+	// ring, for consumers in other processes. maxWidth and maxHeight size
+	// the slots; larger frames are dropped. Returns FALSE from
+	// GetFrameTapStats while no tap is enabled.
+	HRESULT EnableFrameTap(Platform::String^ name, UINT32 slotCount, UINT32 maxWidth, UINT32 maxHeight);
+	void DisableFrameTap();
+	BOOL GetFrameTapStats(MEDIA::FrameTapStats* stats);
+
 	HRESULT SetMediaStreamSource(Windows::Media::Core::IMediaStreamSource^ streamSource);
 
     // Media Engine related
@@ -143,6 +332,16 @@ internal:
         return m_fPlaying;
     }
 
+    BOOL IsTimerRunning()
+    {
+        return !m_fStopTimer && m_fPlaying;
+    }
+
+    // Called by the scheduler on every vblank this player is registered for.
+    BOOL OnVSyncWakeup();
+
+    void GetRunStats(MERunStats* stats);
+
     void CloseFilePicker()
     {
         m_tcs.cancel();
@@ -176,29 +375,115 @@ internal:
     void UpdateForWindowSizeChange(float width, float height);
 
     // Timer thread related
-	void UpdateFrameRate();
+	void UpdateFrameRate(LONGLONG pts,
+		high_resolution_clock::time_point transferStart,
+		high_resolution_clock::time_point transferEnd);
     void StartTimer();
     void StopTimer();	
-    void OnTimer();
-    DWORD RealVSyncTimer();
+    bool OnTimer();
+
+    // Pacing statistics shared by every player.
+    static void GetVSyncStats(MEDIA::VSyncSchedulerStats* stats);
+
+    // Usage of the devices shared by every player.
+    static void GetDeviceBrokerStats(MEDIA::DeviceBrokerStats* stats);
 
 	// State related to calculating FPS.
 	int _frameCounter;
 	high_resolution_clock::time_point _lastTimeFPSCalculated;
 
+	// Latency histograms, all in microseconds. The presentation lag is the
+	// wall-clock offset from pts relative to the smallest offset seen since
+	// the source was set, so it grows as frames are presented late.
+	MEDIA::LatencyHistogram _presentationLag;
+	MEDIA::LatencyHistogram _transferDuration;
+	MEDIA::LatencyHistogram _frameInterval;
+	LONGLONG _minPresentationOffset;
+	BOOL _fHasPresentationOffset;
+	high_resolution_clock::time_point _lastFramePresented;
+
     // For calling IDXGIDevice3::Trim() when app is suspended
     HRESULT DXGIDeviceTrim();
 
 private:
     ~MEPlayer();
 
-	HANDLE m_primarySharedHandle;
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> m_primaryMediaTexture;
-	Microsoft::WRL::ComPtr<ABI::Windows::Graphics::DirectX::Direct3D11::IDirect3DSurface> m_primaryMediaSurface;
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_primaryTextureSRV;
-
-	Microsoft::WRL::ComPtr<ABI::Windows::Foundation::Collections::IMap<HSTRING, IInspectable*>> m_extensionManagerProperties;
+	void ReleaseFrameSlots();
+	HRESULT EnsureStableSlot();
+
+	// Run state machine, see SetRunState. Its lock is never held while
+	// calling into the media engine.
+	void SetRunState(MEDIA::RunState state);
+
+	MEDIA::RunStateMachine m_runState;
+	void InitializeEngine(float width, float height);
+	void CreateEngine();
+
+	MEInitStats m_initStats;
+
+	// Time to first frame, from MarkCallStart to the first transfer.
+	MEDIA::WarmPool* m_pFirstFramePool;
+	high_resolution_clock::time_point m_callStart;
+	BOOL m_fFirstFramePending;
+	BOOL m_fFromPool;
+
+	// FrameTransferred is raised from a thread pool work item so a slow
+	// subscriber never holds up the pacing thread or m_critSec. Frames that
+	// were not dispatched yet collapse into the latest one.
+	void PostFrameTransferred(int width, int height);
+	void DispatchFrameNotifications();
+
+	MEDIA::CoalescingQueue<c_frameNotificationCount> m_frameNotifications;
+	volatile LONG m_pendingFrameNotifications;
+
+	// Software (WARP) path. The engine renders NV12 into a render target,
+	// the frame is read back through a staging copy and converted to BGRA
+	// on the CPU before it is uploaded into the frame slot.
+	HRESULT CreateSoftwareTargets(ID3D11Device* pDevice, UINT32 width, UINT32 height);
+	HRESULT TransferSoftwareFrame(ID3D11Texture2D* pTexture);
+	void UpdateColorMatrix();
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> m_spSoftwareTarget;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> m_spSoftwareStaging;
+	UINT32 m_softwareHeight;
+	std::vector<uint8_t> m_softwareFrame;
+	MEDIA::ColorConvertParams m_colorParams;
+
+	// Frame tap, all guarded by m_critSec. The GPU path reads back through
+	// two staging textures in turn.
+	void TapFrame(ID3D11Texture2D* pTexture, LONGLONG pts);
+
+	std::unique_ptr<MEDIA::SharedMemory> m_frameTapMemory;
+	std::unique_ptr<MEDIA::FrameTapWriter> m_frameTap;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> m_spTapStaging[2];
+	UINT32 m_tapStagingIndex;
+	BOOL m_fTapPending;
+	LONGLONG m_tapPendingPts;
+
+	// Slots are recycled through the pool so resizing back to a recent
+	// size does not recreate the textures and shared handles.
+	MEFrameSlotAllocator m_frameSlotAllocator;
+	MEDIA::TexturePool m_texturePool;
+	MEDIA::TextureKey m_frameSlotKey;
+
+	// Triple buffering between TransferVideoFrame (producer, holds m_critSec)
+	// and the Unity consumer. The handoff itself is lock-free; m_frameSlotLock
+	// guards the slot resources against CreateBackBuffers and, held exclusive
+	// in AcquireLatestTexture, keeps consumers to one at a time.
+	MEFrameSlot* m_frameSlots[c_frameSlotCount];
+	MEDIA::FrameSlotRing<c_frameSlotCount> m_frameRing;
+	SRWLOCK m_frameSlotLock;
+
+	// What GetPrimaryTexture hands out. Scripts wrap that texture once and
+	// keep sampling it, so it never rotates; the render event copies each
+	// new frame into it on the Unity device, never the pump thread. Only
+	// exists once GetPrimaryTexture was called, so the other paths pay
+	// nothing for it. Guarded like the slots.
+	MEFrameSlot* m_stableSlot;
+	MEDIA::TextureKey m_stableSlotKey;
+
+	// Shared with the scheme handler, which takes the sources we register.
+	Microsoft::WRL::ComPtr<MEDIA::MediaSourceRegistry> m_sourceRegistry;
 };
 
 #endif /* MEPLAYER_H */
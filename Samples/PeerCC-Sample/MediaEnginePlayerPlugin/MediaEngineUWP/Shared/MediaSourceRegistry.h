@@ -0,0 +1,155 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Shared with the WebRtcScheme project, keep it free of player headers.
+#include <windows.h>
+#include <inspectable.h>
+#include <wrl\client.h>
+#include <wrl\implements.h>
+#include <wrl\ftm.h>
+
+#include <new>
+
+#include "ResolveMetrics.h"
+#include "SourceRegistry.h"
+
+// Key the registry is stored under in the property set the scheme handler
+// is registered with.
+#define MEDIA_SOURCE_REGISTRY_KEY L"WebRtcScheme.SourceRegistry"
+
+//-----------------------------------------------------------------------------
+// IMediaSourceRegistry
+//
+// How the scheme handler, which lives in its own DLL, takes the media
+// source a player registered for a webrtc:// URL, and reports how its
+// request for it went.
+//-----------------------------------------------------------------------------
+MIDL_INTERFACE("0b8e4f27-5c1d-4e93-a6f2-71d9c3b58e40")
+IMediaSourceRegistry : public IUnknown
+{
+public:
+    // Returns the source registered for url and forgets it. Fails with
+    // HRESULT_FROM_WIN32(ERROR_NOT_FOUND) if there is none, including when
+    // it was already taken or has expired.
+    virtual HRESULT STDMETHODCALLTYPE TakeSource(_In_z_ LPCWSTR url, _COM_Outptr_ IInspectable** source) = 0;
+
+    // outcome is a MEDIA::ResolveOutcome; retries counts lookups that
+    // found nothing yet.
+    virtual HRESULT STDMETHODCALLTYPE ReportResolution(UINT32 outcome, UINT64 latencyMicroseconds, UINT32 retries) = 0;
+};
+
+namespace MEDIA
+{
+    //-----------------------------------------------------------------------------
+    // MediaSourceRegistry
+    //
+    // The player side: one per process, handed to the scheme handler through
+    // its property set. Every player registers its sources under its own
+    // URL, so one player's stream starting never removes another's.
+    //-----------------------------------------------------------------------------
+    class MediaSourceRegistry : public Microsoft::WRL::RuntimeClass<
+        Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::WinRtClassicComMix>,
+        IMediaSourceRegistry,
+        Microsoft::WRL::FtmBase>
+    {
+        InspectableClass(L"MediaEngineUWP.MediaSourceRegistry", BaseTrust)
+
+    public:
+        // Sources the media engine never asked for are released after this.
+        static const uint64_t c_timeToLiveMs = 30000;
+
+        MediaSourceRegistry() :
+            m_sources(c_timeToLiveMs)
+        {
+        }
+
+        HRESULT RegisterSource(_In_z_ LPCWSTR url, _In_ IInspectable* source)
+        {
+            if (url == nullptr || source == nullptr)
+            {
+                return E_INVALIDARG;
+            }
+
+            try
+            {
+                Microsoft::WRL::ComPtr<IInspectable> value(source);
+                return m_sources.Register(url, value, GetTickCount64()) ? S_OK : HRESULT_FROM_WIN32(ERROR_ALREADY_EXISTS);
+            }
+            catch (const std::bad_alloc&)
+            {
+                return E_OUTOFMEMORY;
+            }
+        }
+
+        IFACEMETHODIMP TakeSource(_In_z_ LPCWSTR url, _COM_Outptr_ IInspectable** source) override
+        {
+            if (source == nullptr)
+            {
+                return E_POINTER;
+            }
+            *source = nullptr;
+
+            if (url == nullptr)
+            {
+                return E_INVALIDARG;
+            }
+
+            try
+            {
+                Microsoft::WRL::ComPtr<IInspectable> value;
+                if (!m_sources.Take(url, GetTickCount64(), &value))
+                {
+                    return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+                }
+
+                *source = value.Detach();
+                return S_OK;
+            }
+            catch (const std::bad_alloc&)
+            {
+                return E_OUTOFMEMORY;
+            }
+        }
+
+        IFACEMETHODIMP ReportResolution(UINT32 outcome, UINT64 latencyMicroseconds, UINT32 retries) override
+        {
+            if (outcome > ResolveOutcome_TimedOut)
+            {
+                return E_INVALIDARG;
+            }
+
+            m_resolveMetrics.Record((ResolveOutcome)outcome, latencyMicroseconds, retries);
+            return S_OK;
+        }
+
+        // Releases expired sources now instead of at the next registration.
+        void Sweep()
+        {
+            m_sources.Sweep(GetTickCount64());
+        }
+
+        void GetStats(SourceRegistryStats* stats) const
+        {
+            m_sources.GetStats(stats);
+        }
+
+        void GetResolveStats(ResolveStats* stats) const
+        {
+            m_resolveMetrics.GetStats(stats);
+        }
+
+    private:
+        SourceRegistry<Microsoft::WRL::ComPtr<IInspectable>> m_sources;
+        ResolveMetrics m_resolveMetrics;
+    };
+}
@@ -0,0 +1,148 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace MEDIA
+{
+    // Where a player is in its lifetime. Only a playing player is paced,
+    // every other state is parked.
+    enum RunState : uint32_t
+    {
+        RunState_NoSource,
+        RunState_Loading,
+        RunState_Playing,
+        RunState_Paused,
+        RunState_Ended,
+        RunState_Shutdown
+    };
+
+    // idleWakeups counts vblanks delivered while not playing and should
+    // stay near zero.
+    struct RunStateStats
+    {
+        uint32_t state;
+        int64_t wakeups;
+        int64_t idleWakeups;
+        int64_t parks;
+        int64_t resumes;
+    };
+
+    //-----------------------------------------------------------------------------
+    // RunStateMachine
+    //
+    // Moves a player between run states and counts what pacing costs it.
+    // Entering PLAYING calls start and leaving it calls stop, both under the
+    // machine's lock, so transitions from the engine's event thread and from
+    // callers never interleave. Shutdown is final. If start or stop throws,
+    // the state is rolled back and the exception reaches the caller.
+    //-----------------------------------------------------------------------------
+    class RunStateMachine
+    {
+    public:
+        RunStateMachine() :
+            m_state(RunState_NoSource),
+            m_parks(0),
+            m_resumes(0),
+            m_wakeups(0),
+            m_idleWakeups(0)
+        {
+        }
+
+        // Returns false when the state did not change.
+        template <typename Start, typename Stop>
+        bool Set(RunState state, Start start, Stop stop)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            RunState previous = m_state;
+            if (previous == RunState_Shutdown || previous == state)
+            {
+                return false;
+            }
+
+            m_state = state;
+
+            try
+            {
+                if (state == RunState_Playing)
+                {
+                    start();
+                    m_resumes++;
+                }
+                else if (previous == RunState_Playing)
+                {
+                    stop();
+                    m_parks++;
+                }
+            }
+            catch (...)
+            {
+                m_state = previous;
+                throw;
+            }
+
+            return true;
+        }
+
+        RunState State() const
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_state;
+        }
+
+        // Called by the pacing thread on every vblank the player sees.
+        // Returns running, counting the wakeup as idle when it is false.
+        bool RecordWakeup(bool running)
+        {
+            m_wakeups.fetch_add(1, std::memory_order_relaxed);
+            if (!running)
+            {
+                m_idleWakeups.fetch_add(1, std::memory_order_relaxed);
+            }
+            return running;
+        }
+
+        void GetStats(RunStateStats* stats) const
+        {
+            if (stats == nullptr)
+            {
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                stats->state = m_state;
+                stats->parks = m_parks;
+                stats->resumes = m_resumes;
+            }
+
+            stats->wakeups = m_wakeups.load(std::memory_order_relaxed);
+            stats->idleWakeups = m_idleWakeups.load(std::memory_order_relaxed);
+        }
+
+    private:
+        RunStateMachine(const RunStateMachine&);
+        RunStateMachine& operator=(const RunStateMachine&);
+
+        mutable std::mutex m_lock;
+        RunState m_state;
+        int64_t m_parks;
+        int64_t m_resumes;
+
+        std::atomic<int64_t> m_wakeups;
+        std::atomic<int64_t> m_idleWakeups;
+    };
+}
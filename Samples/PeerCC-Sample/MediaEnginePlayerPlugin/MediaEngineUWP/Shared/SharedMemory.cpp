@@ -0,0 +1,305 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SharedMemory.h"
+
+#include <cstdint>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace MEDIA;
+
+#if defined(_WIN32)
+
+namespace
+{
+    std::wstring Widen(const std::string& name)
+    {
+        int length = MultiByteToWideChar(CP_UTF8, 0, name.c_str(), -1, nullptr, 0);
+        if (length <= 0)
+        {
+            return std::wstring();
+        }
+
+        std::wstring wide(length, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, name.c_str(), -1, &wide[0], length);
+        wide.resize(length - 1);
+        return wide;
+    }
+}
+
+SharedMemory::SharedMemory() :
+    m_data(nullptr),
+    m_size(0),
+    m_lastError(0),
+    m_owner(false),
+    m_mapping(nullptr)
+{
+}
+
+SharedMemory::~SharedMemory()
+{
+    Close();
+}
+
+bool SharedMemory::Create(const std::string& name, size_t size)
+{
+    Close();
+
+    std::wstring wideName = Widen(name);
+    if (wideName.empty() || size == 0)
+    {
+        m_lastError = ERROR_INVALID_PARAMETER;
+        return false;
+    }
+
+#if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+    m_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        (DWORD)((uint64_t)size >> 32), (DWORD)size, wideName.c_str());
+#else
+    m_mapping = CreateFileMappingFromApp(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, size, wideName.c_str());
+#endif
+    if (m_mapping == nullptr)
+    {
+        m_lastError = (int)GetLastError();
+        return false;
+    }
+
+    // somebody else's block, don't format over it
+    if (GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        m_lastError = ERROR_ALREADY_EXISTS;
+        Close();
+        return false;
+    }
+
+    m_owner = true;
+    m_name = name;
+    return Map(size, false);
+}
+
+bool SharedMemory::Open(const std::string& name, bool readOnly)
+{
+    Close();
+
+    std::wstring wideName = Widen(name);
+    if (wideName.empty())
+    {
+        m_lastError = ERROR_INVALID_PARAMETER;
+        return false;
+    }
+
+    DWORD access = readOnly ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS;
+#if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+    m_mapping = OpenFileMappingW(access, FALSE, wideName.c_str());
+#else
+    m_mapping = OpenFileMappingFromApp(access, FALSE, wideName.c_str());
+#endif
+    if (m_mapping == nullptr)
+    {
+        m_lastError = (int)GetLastError();
+        return false;
+    }
+
+    m_name = name;
+    return Map(0, readOnly);
+}
+
+bool SharedMemory::Remove(const std::string& name)
+{
+    return !Widen(name).empty();
+}
+
+bool SharedMemory::Map(size_t size, bool readOnly)
+{
+    DWORD access = readOnly ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS;
+#if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+    m_data = MapViewOfFile(m_mapping, access, 0, 0, size);
+#else
+    m_data = MapViewOfFileFromApp(m_mapping, access, 0, size);
+#endif
+    if (m_data == nullptr)
+    {
+        m_lastError = (int)GetLastError();
+        Close();
+        return false;
+    }
+
+    if (size == 0)
+    {
+        // the view covers the whole mapping, rounded up to a page
+        MEMORY_BASIC_INFORMATION info;
+        size = (VirtualQuery(m_data, &info, sizeof(info)) != 0) ? info.RegionSize : 0;
+    }
+
+    m_size = size;
+    return true;
+}
+
+void SharedMemory::Close()
+{
+    if (m_data != nullptr)
+    {
+        UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+
+    if (m_mapping != nullptr)
+    {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+
+    // the mapping goes away with its last handle
+    m_size = 0;
+    m_owner = false;
+    m_name.clear();
+}
+
+#else
+
+SharedMemory::SharedMemory() :
+    m_data(nullptr),
+    m_size(0),
+    m_lastError(0),
+    m_owner(false),
+    m_fd(-1)
+{
+}
+
+SharedMemory::~SharedMemory()
+{
+    Close();
+}
+
+bool SharedMemory::Create(const std::string& name, size_t size)
+{
+    Close();
+
+    if (name.empty() || name.find('/') != std::string::npos || size == 0)
+    {
+        m_lastError = EINVAL;
+        return false;
+    }
+
+    std::string path = "/" + name;
+    // like Windows, somebody else's block is left alone
+    m_fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (m_fd < 0)
+    {
+        m_lastError = errno;
+        return false;
+    }
+
+    m_owner = true;
+    m_name = path;
+
+    if (ftruncate(m_fd, (off_t)size) != 0)
+    {
+        m_lastError = errno;
+        Close();
+        return false;
+    }
+
+    return Map(size, false);
+}
+
+bool SharedMemory::Open(const std::string& name, bool readOnly)
+{
+    Close();
+
+    if (name.empty() || name.find('/') != std::string::npos)
+    {
+        m_lastError = EINVAL;
+        return false;
+    }
+
+    std::string path = "/" + name;
+    m_fd = shm_open(path.c_str(), readOnly ? O_RDONLY : O_RDWR, 0);
+    if (m_fd < 0)
+    {
+        m_lastError = errno;
+        return false;
+    }
+
+    m_name = path;
+
+    struct stat info;
+    if (fstat(m_fd, &info) != 0 || info.st_size <= 0)
+    {
+        m_lastError = (errno != 0) ? errno : EINVAL;
+        Close();
+        return false;
+    }
+
+    return Map((size_t)info.st_size, readOnly);
+}
+
+bool SharedMemory::Remove(const std::string& name)
+{
+    if (name.empty() || name.find('/') != std::string::npos)
+    {
+        return false;
+    }
+
+    std::string path = "/" + name;
+    return shm_unlink(path.c_str()) == 0 || errno == ENOENT;
+}
+
+bool SharedMemory::Map(size_t size, bool readOnly)
+{
+    void* data = mmap(nullptr, size, readOnly ? PROT_READ : (PROT_READ | PROT_WRITE), MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED)
+    {
+        m_lastError = errno;
+        Close();
+        return false;
+    }
+
+    m_data = data;
+    m_size = size;
+    return true;
+}
+
+void SharedMemory::Close()
+{
+    if (m_data != nullptr)
+    {
+        munmap(m_data, m_size);
+        m_data = nullptr;
+    }
+
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+
+    // readers that still have it mapped keep their view
+    if (m_owner)
+    {
+        shm_unlink(m_name.c_str());
+    }
+
+    m_size = 0;
+    m_owner = false;
+    m_name.clear();
+}
+
+#endif
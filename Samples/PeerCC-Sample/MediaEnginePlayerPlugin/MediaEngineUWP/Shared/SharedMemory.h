@@ -0,0 +1,85 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace MEDIA
+{
+    //-----------------------------------------------------------------------------
+    // SharedMemory
+    //
+    // A named block of memory other processes can map. Backed by a file
+    // mapping on Windows and by shm_open on POSIX systems, where the name is
+    // unlinked again when the creator closes it. Names are UTF-8 without
+    // path separators.
+    //
+    // Create never takes over a name that is already in use, on either
+    // platform: it fails with ERROR_ALREADY_EXISTS or EEXIST. On POSIX a
+    // name outlives a creator that crashed, so the caller decides whether
+    // to Remove it and try again.
+    //-----------------------------------------------------------------------------
+    class SharedMemory
+    {
+    public:
+        SharedMemory();
+        ~SharedMemory();
+
+        // Creates the block, zero filled, and maps it read-write.
+        bool Create(const std::string& name, size_t size);
+
+        // Maps an existing block.
+        bool Open(const std::string& name, bool readOnly);
+
+        // Drops a name left behind by a creator that never closed it.
+        // Nothing to do on Windows, where a mapping dies with its last
+        // handle; existing mappings stay valid on both platforms.
+        static bool Remove(const std::string& name);
+
+        void Close();
+
+        void* Data() const
+        {
+            return m_data;
+        }
+
+        size_t Size() const
+        {
+            return m_size;
+        }
+
+        // Platform error code of the last failure (GetLastError or errno).
+        int LastError() const
+        {
+            return m_lastError;
+        }
+
+    private:
+        SharedMemory(const SharedMemory&);
+        SharedMemory& operator=(const SharedMemory&);
+
+        bool Map(size_t size, bool readOnly);
+
+        void* m_data;
+        size_t m_size;
+        int m_lastError;
+        bool m_owner;
+        std::string m_name;
+
+#if defined(_WIN32)
+        void* m_mapping;
+#else
+        int m_fd;
+#endif
+    };
+}
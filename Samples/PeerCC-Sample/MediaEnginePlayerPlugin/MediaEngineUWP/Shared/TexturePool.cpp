@@ -0,0 +1,184 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "TexturePool.h"
+
+#include <iterator>
+
+using namespace MEDIA;
+
+TexturePool::TexturePool(ITextureAllocator* allocator, uint64_t budgetBytes) :
+    m_allocator(allocator),
+    m_budgetBytes(budgetBytes),
+    m_bytesIdle(0),
+    m_bytesInUse(0),
+    m_allocations(0),
+    m_reuses(0),
+    m_evictions(0),
+    m_failures(0)
+{
+}
+
+TexturePool::~TexturePool()
+{
+    // Textures still in use belong to the caller, which has to release
+    // them before the pool goes away; only the idle ones are ours.
+    Trim();
+}
+
+void* TexturePool::Acquire(const TextureKey& key)
+{
+    std::vector<void*> victims;
+    uint64_t bytes = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        // Prefer the most recently released match, it is the most likely
+        // to still be resident.
+        for (auto it = m_idle.rbegin(); it != m_idle.rend(); ++it)
+        {
+            if (it->key == key)
+            {
+                Entry entry = *it;
+                m_idle.erase(std::next(it).base());
+                m_bytesIdle -= entry.bytes;
+                m_bytesInUse += entry.bytes;
+                m_inUse[entry.texture] = entry;
+                m_reuses++;
+                return entry.texture;
+            }
+        }
+
+        bytes = m_allocator->SizeInBytes(key);
+        EvictLocked(bytes, &victims);
+    }
+
+    FreeAll(victims);
+
+    void* texture = m_allocator->Allocate(key);
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (texture == nullptr)
+    {
+        m_failures++;
+        return nullptr;
+    }
+
+    Entry entry = { key, texture, bytes };
+    m_inUse[texture] = entry;
+    m_bytesInUse += bytes;
+    m_allocations++;
+
+    return texture;
+}
+
+void TexturePool::Release(void* texture)
+{
+    if (texture == nullptr)
+    {
+        return;
+    }
+
+    std::vector<void*> victims;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        auto it = m_inUse.find(texture);
+        if (it == m_inUse.end())
+        {
+            return;
+        }
+
+        Entry entry = it->second;
+        m_inUse.erase(it);
+        m_bytesInUse -= entry.bytes;
+        m_idle.push_back(entry);
+        m_bytesIdle += entry.bytes;
+
+        EvictLocked(0, &victims);
+    }
+
+    FreeAll(victims);
+}
+
+void TexturePool::Trim()
+{
+    std::vector<void*> victims;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        for (auto& entry : m_idle)
+        {
+            victims.push_back(entry.texture);
+        }
+        m_evictions += m_idle.size();
+        m_idle.clear();
+        m_bytesIdle = 0;
+    }
+
+    FreeAll(victims);
+}
+
+void TexturePool::SetBudget(uint64_t budgetBytes)
+{
+    std::vector<void*> victims;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_budgetBytes = budgetBytes;
+        EvictLocked(0, &victims);
+    }
+
+    FreeAll(victims);
+}
+
+void TexturePool::GetStats(TexturePoolStats* stats) const
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    stats->allocations = m_allocations;
+    stats->reuses = m_reuses;
+    stats->evictions = m_evictions;
+    stats->failures = m_failures;
+    stats->bytesInUse = m_bytesInUse;
+    stats->bytesIdle = m_bytesIdle;
+    stats->texturesInUse = (uint32_t)m_inUse.size();
+    stats->texturesIdle = (uint32_t)m_idle.size();
+}
+
+void TexturePool::EvictLocked(uint64_t reserveBytes, std::vector<void*>* victims)
+{
+    while (!m_idle.empty() &&
+        m_bytesInUse + m_bytesIdle + reserveBytes > m_budgetBytes)
+    {
+        Entry& entry = m_idle.front();
+        victims->push_back(entry.texture);
+        m_bytesIdle -= entry.bytes;
+        m_evictions++;
+        m_idle.pop_front();
+    }
+}
+
+void TexturePool::FreeAll(const std::vector<void*>& victims)
+{
+    for (void* texture : victims)
+    {
+        m_allocator->Free(texture);
+    }
+}
@@ -0,0 +1,124 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The pool only does bookkeeping; the graphics API lives behind
+// ITextureAllocator so the policy can be exercised with a fake allocator.
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace MEDIA
+{
+    struct TextureKey
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t format;
+
+        bool operator==(const TextureKey& other) const
+        {
+            return width == other.width && height == other.height && format == other.format;
+        }
+    };
+
+    //-----------------------------------------------------------------------------
+    // ITextureAllocator
+    //
+    // Creates and destroys the pooled objects. Textures are opaque to the
+    // pool; Allocate returns nullptr on failure.
+    //-----------------------------------------------------------------------------
+    struct ITextureAllocator
+    {
+        virtual ~ITextureAllocator() {}
+        virtual void* Allocate(const TextureKey& key) = 0;
+        virtual void Free(void* texture) = 0;
+        virtual uint64_t SizeInBytes(const TextureKey& key) = 0;
+    };
+
+    struct TexturePoolStats
+    {
+        uint64_t allocations;
+        uint64_t reuses;
+        uint64_t evictions;
+        uint64_t failures;
+        uint64_t bytesInUse;
+        uint64_t bytesIdle;
+        uint32_t texturesInUse;
+        uint32_t texturesIdle;
+    };
+
+    //-----------------------------------------------------------------------------
+    // TexturePool
+    //
+    // Keeps released textures around, keyed by size and format, so a
+    // resize back to a recent size reuses them instead of reallocating.
+    // The byte budget covers both in-use and idle textures; when it is
+    // exceeded the least recently released idle textures are freed first.
+    // Textures in use are never evicted, so the budget can be overshot by
+    // what the caller holds.
+    //
+    // Allocator calls are made outside of the pool lock.
+    //-----------------------------------------------------------------------------
+    class TexturePool
+    {
+    public:
+        TexturePool(ITextureAllocator* allocator, uint64_t budgetBytes);
+        ~TexturePool();
+
+        // Returns an idle texture with a matching key or allocates a new one.
+        void* Acquire(const TextureKey& key);
+
+        // Hands a texture from Acquire back to the pool. nullptr is ignored.
+        void Release(void* texture);
+
+        // Frees every idle texture, e.g. when the app is suspended.
+        void Trim();
+
+        void SetBudget(uint64_t budgetBytes);
+        void GetStats(TexturePoolStats* stats) const;
+
+    private:
+        TexturePool(const TexturePool&);
+        TexturePool& operator=(const TexturePool&);
+
+        struct Entry
+        {
+            TextureKey key;
+            void* texture;
+            uint64_t bytes;
+        };
+
+        // Moves idle entries into victims until reserveBytes more fit
+        // into the budget. Called with m_lock held.
+        void EvictLocked(uint64_t reserveBytes, std::vector<void*>* victims);
+        void FreeAll(const std::vector<void*>& victims);
+
+        ITextureAllocator* m_allocator;
+
+        mutable std::mutex m_lock;
+        uint64_t m_budgetBytes;
+
+        // Front is the least recently released.
+        std::list<Entry> m_idle;
+        std::unordered_map<void*, Entry> m_inUse;
+        uint64_t m_bytesIdle;
+        uint64_t m_bytesInUse;
+
+        uint64_t m_allocations;
+        uint64_t m_reuses;
+        uint64_t m_evictions;
+        uint64_t m_failures;
+    };
+}
@@ -0,0 +1,219 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "VSyncScheduler.h"
+
+#include <algorithm>
+
+using namespace MEDIA;
+
+VSyncScheduler::VSyncScheduler(IVSyncClock* clock, int64_t nominalIntervalMicroseconds) :
+    m_clock(clock),
+    m_nominalInterval(nominalIntervalMicroseconds),
+    m_running(false),
+    m_lastTick(0),
+    m_starts(0),
+    m_ticks(0),
+    m_intervals(0),
+    m_dispatched(0),
+    m_presented(0),
+    m_skipped(0),
+    m_failed(0),
+    m_lastInterval(0),
+    m_lastJitter(0),
+    m_maxJitter(0),
+    m_jitterSum(0)
+{
+}
+
+VSyncScheduler::~VSyncScheduler()
+{
+}
+
+bool VSyncScheduler::AddTarget(const std::shared_ptr<IVSyncTarget>& target)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (std::find(m_targets.begin(), m_targets.end(), target) == m_targets.end())
+    {
+        m_targets.push_back(target);
+    }
+
+    if (m_running)
+    {
+        return false;
+    }
+
+    m_running = true;
+    m_lastTick = 0;
+    m_starts.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void VSyncScheduler::RemoveTarget(const std::shared_ptr<IVSyncTarget>& target)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    auto it = std::find(m_targets.begin(), m_targets.end(), target);
+    if (it != m_targets.end())
+    {
+        m_targets.erase(it);
+    }
+}
+
+bool VSyncScheduler::RunOnce()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_targets.empty())
+        {
+            m_running = false;
+            return false;
+        }
+    }
+
+    // Wait outside of the lock so registration is never blocked by vblank.
+    if (!m_clock->WaitForVBlank())
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_running = false;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_snapshot.assign(m_targets.begin(), m_targets.end());
+    }
+
+    int64_t now = m_clock->NowMicroseconds();
+    RecordTick(now);
+
+    for (auto& target : m_snapshot)
+    {
+        Dispatch(target.get(), now);
+    }
+
+    // Drop our references so removed targets are released promptly.
+    m_snapshot.clear();
+
+    return true;
+}
+
+void VSyncScheduler::Run()
+{
+    try
+    {
+        while (RunOnce())
+        {
+        }
+    }
+    catch (...)
+    {
+        // Only the clock gets here. Without this the scheduler would look
+        // running forever and AddTarget would never start a new pump.
+        m_snapshot.clear();
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_running = false;
+    }
+}
+
+// One target's share of a tick. Its failure must not cost the others
+// their frame, so nothing it throws gets past here.
+void VSyncScheduler::Dispatch(IVSyncTarget* target, int64_t now)
+{
+    try
+    {
+        if (!target->HasPendingFrame())
+        {
+            m_skipped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        m_dispatched.fetch_add(1, std::memory_order_relaxed);
+        if (target->OnVSync(now))
+        {
+            m_presented.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    catch (...)
+    {
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void VSyncScheduler::RecordTick(int64_t now)
+{
+    m_ticks.fetch_add(1, std::memory_order_relaxed);
+
+    // The first tick after (re)starting has nothing to measure against.
+    if (m_lastTick != 0)
+    {
+        int64_t interval = now - m_lastTick;
+        int64_t jitter = interval - m_nominalInterval;
+        if (jitter < 0)
+        {
+            jitter = -jitter;
+        }
+
+        m_intervals.fetch_add(1, std::memory_order_relaxed);
+        m_lastInterval.store(interval, std::memory_order_relaxed);
+        m_lastJitter.store(jitter, std::memory_order_relaxed);
+        m_jitterSum.fetch_add(jitter, std::memory_order_relaxed);
+        if (jitter > m_maxJitter.load(std::memory_order_relaxed))
+        {
+            m_maxJitter.store(jitter, std::memory_order_relaxed);
+        }
+    }
+
+    m_lastTick = now;
+}
+
+void VSyncScheduler::GetStats(VSyncSchedulerStats* stats) const
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+
+    stats->starts = m_starts.load(std::memory_order_relaxed);
+    stats->ticks = m_ticks.load(std::memory_order_relaxed);
+    stats->dispatched = m_dispatched.load(std::memory_order_relaxed);
+    stats->presented = m_presented.load(std::memory_order_relaxed);
+    stats->skipped = m_skipped.load(std::memory_order_relaxed);
+    stats->failed = m_failed.load(std::memory_order_relaxed);
+    stats->lastIntervalMicroseconds = m_lastInterval.load(std::memory_order_relaxed);
+    stats->lastJitterMicroseconds = m_lastJitter.load(std::memory_order_relaxed);
+    stats->maxJitterMicroseconds = m_maxJitter.load(std::memory_order_relaxed);
+    uint64_t intervals = m_intervals.load(std::memory_order_relaxed);
+    stats->meanJitterMicroseconds = (intervals > 0) ?
+        m_jitterSum.load(std::memory_order_relaxed) / (int64_t)intervals : 0;
+}
+
+void VSyncScheduler::ResetStats()
+{
+    m_starts = 0;
+    m_ticks = 0;
+    m_intervals = 0;
+    m_dispatched = 0;
+    m_presented = 0;
+    m_skipped = 0;
+    m_failed = 0;
+    m_lastInterval = 0;
+    m_lastJitter = 0;
+    m_maxJitter = 0;
+    m_jitterSum = 0;
+}
+
+size_t VSyncScheduler::TargetCount() const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_targets.size();
+}
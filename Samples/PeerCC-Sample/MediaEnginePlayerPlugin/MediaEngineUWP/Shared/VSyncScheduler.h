@@ -0,0 +1,134 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The scheduler core only depends on the standard library so that it
+// can be driven by a simulated clock outside of the UWP build.
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace MEDIA
+{
+    //-----------------------------------------------------------------------------
+    // IVSyncClock
+    //
+    // Time source for the scheduler. WaitForVBlank blocks until the next
+    // display refresh; returning false ends the pump loop.
+    //-----------------------------------------------------------------------------
+    struct IVSyncClock
+    {
+        virtual ~IVSyncClock() {}
+        virtual int64_t NowMicroseconds() = 0;
+        virtual bool WaitForVBlank() = 0;
+    };
+
+    //-----------------------------------------------------------------------------
+    // IVSyncTarget
+    //
+    // A consumer of vblank ticks. HasPendingFrame must be cheap and lock-free,
+    // it is used to skip targets that have nothing to present. OnVSync returns
+    // true when a frame was actually presented. Neither should throw; a
+    // target that does is counted as failed and the tick goes on to the
+    // next one.
+    //-----------------------------------------------------------------------------
+    struct IVSyncTarget
+    {
+        virtual ~IVSyncTarget() {}
+        virtual bool HasPendingFrame() = 0;
+        virtual bool OnVSync(int64_t nowMicroseconds) = 0;
+    };
+
+    struct VSyncSchedulerStats
+    {
+        uint64_t starts;
+        uint64_t ticks;
+        uint64_t dispatched;
+        uint64_t presented;
+        uint64_t skipped;
+        uint64_t failed;
+        int64_t lastIntervalMicroseconds;
+        int64_t lastJitterMicroseconds;
+        int64_t maxJitterMicroseconds;
+        int64_t meanJitterMicroseconds;
+    };
+
+    //-----------------------------------------------------------------------------
+    // VSyncScheduler
+    //
+    // Drives any number of targets from a single pump thread. The first
+    // AddTarget call returns true to tell the caller it must start a thread
+    // that calls Run(); Run() returns once the last target is removed, so
+    // the thread never outlives its work. Idle targets should unregister
+    // rather than report no pending frame, so an idle process sees no
+    // vblank wakeups at all; starts counts how often the pump was restarted.
+    //
+    // Targets are dispatched from a snapshot taken outside of the registration
+    // lock, so a target removed mid-tick may still see that one last call.
+    //-----------------------------------------------------------------------------
+    class VSyncScheduler
+    {
+    public:
+        VSyncScheduler(IVSyncClock* clock, int64_t nominalIntervalMicroseconds);
+        ~VSyncScheduler();
+
+        // Returns true when the caller has to start a pump thread.
+        bool AddTarget(const std::shared_ptr<IVSyncTarget>& target);
+
+        // Never blocks on an in-flight tick.
+        void RemoveTarget(const std::shared_ptr<IVSyncTarget>& target);
+
+        // Waits for one vblank and fans it out. Returns false when the
+        // clock failed or no targets are left.
+        bool RunOnce();
+
+        // Pump loop, runs until RunOnce returns false. Never throws; if the
+        // clock does, the pump stops and the next AddTarget restarts it.
+        void Run();
+
+        void GetStats(VSyncSchedulerStats* stats) const;
+        void ResetStats();
+        size_t TargetCount() const;
+
+    private:
+        VSyncScheduler(const VSyncScheduler&);
+        VSyncScheduler& operator=(const VSyncScheduler&);
+
+        void RecordTick(int64_t now);
+        void Dispatch(IVSyncTarget* target, int64_t now);
+
+        IVSyncClock* m_clock;
+        const int64_t m_nominalInterval;
+
+        mutable std::mutex m_lock;
+        std::vector<std::shared_ptr<IVSyncTarget>> m_targets;
+        bool m_running;
+
+        // Only touched by the pump thread; reused to avoid per-tick allocations.
+        std::vector<std::shared_ptr<IVSyncTarget>> m_snapshot;
+
+        int64_t m_lastTick;
+        std::atomic<uint64_t> m_starts;
+        std::atomic<uint64_t> m_ticks;
+        std::atomic<uint64_t> m_intervals;
+        std::atomic<uint64_t> m_dispatched;
+        std::atomic<uint64_t> m_presented;
+        std::atomic<uint64_t> m_skipped;
+        std::atomic<uint64_t> m_failed;
+        std::atomic<int64_t> m_lastInterval;
+        std::atomic<int64_t> m_lastJitter;
+        std::atomic<int64_t> m_maxJitter;
+        std::atomic<int64_t> m_jitterSum;
+    };
+}
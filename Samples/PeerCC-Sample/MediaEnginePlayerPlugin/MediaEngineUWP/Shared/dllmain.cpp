@@ -12,6 +12,8 @@
 #include "MediaEngine.h"
 #include "Unity/PlatformBase.h"
 #include "MediaEnginePlayer.h"
+#include "HandleTable.h"
+#include "FrameUpdateTable.h"
 
 using namespace Microsoft::WRL;
 using namespace Platform;
@@ -25,11 +27,11 @@ static UnityGfxRenderer s_DeviceType = kUnityGfxRenderernullptr;
 static IUnityInterfaces* s_UnityInterfaces = nullptr;
 static IUnityGraphics* s_Graphics = nullptr;
 
-static MEPlayer^ s_localPlayer;
-static MEPlayer^ s_remotePlayer;
+// Enough for a local preview plus 16 remote streams with room to spare.
+static const uint32_t c_maxPlayers = 32;
 
 static Microsoft::WRL::ComPtr<ABI::Windows::Media::IMediaExtensionManager> s_mediaExtensionManager;
-static Microsoft::WRL::ComPtr<ABI::Windows::Foundation::Collections::IMap<HSTRING, IInspectable*>> s_extensionManagerProperties;
+static Microsoft::WRL::ComPtr<MEDIA::MediaSourceRegistry> s_sourceRegistry;
 
 void SetupSchemeHandler()
 {
@@ -40,16 +42,30 @@ void SetupSchemeHandler()
 	{
 		throw ref new COMException(hr, ref new String(L"Failed to create media extension manager"));
 	}
-	// Create an IMap container.  It maps a source URL with an IMediaSource so it can be retrieved by the scheme handler.
+	// Create an IMap container.  It carries the source registry, which maps a source URL with an
+	// IMediaSource so it can be retrieved by the scheme handler.
 	ComPtr<IMap<HSTRING, IInspectable*>> props;
 	hr = ActivateInstance(HStringReference(RuntimeClass_Windows_Foundation_Collections_PropertySet).Get(), &props);
 	if (FAILED(hr))
 	{
 		throw ref new COMException(hr, ref new String(L"Failed to create collection property set"));
 	}
+	ComPtr<MEDIA::MediaSourceRegistry> registry = Make<MEDIA::MediaSourceRegistry>();
+	if (!registry)
+	{
+		throw ref new COMException(E_OUTOFMEMORY, ref new String(L"Failed to create media source registry"));
+	}
+	ComPtr<IInspectable> registryInspectable;
+	registry.As(&registryInspectable);
+	boolean replaced;
+	hr = props->Insert(HStringReference(MEDIA_SOURCE_REGISTRY_KEY).Get(), registryInspectable.Get(), &replaced);
+	if (FAILED(hr))
+	{
+		throw ref new COMException(hr, ref new String(L"Failed to insert the media source registry into media properties"));
+	}
 	// Register the scheme handler.  It takes the IMap container so it can be passed to the scheme
 	// handler when its invoked with a given source URL.
-	// The SchemeHandler will extract the IMediaSource from the map.
+	// The SchemeHandler will take the IMediaSource from the registry in the map.
 	ComPtr<IPropertySet> propSet;
 	props.As(&propSet);
 	HStringReference clsid(L"WebRtcScheme.SchemeHandler");
@@ -59,7 +75,7 @@ void SetupSchemeHandler()
 	{
 		throw ref new COMException(hr, ref new String(L"Failed to to register scheme handler"));
 	}
-	s_extensionManagerProperties = props;
+	s_sourceRegistry = registry;
 }
 
 STDAPI_(BOOL) DllMain(
@@ -80,7 +96,7 @@ STDAPI_(BOOL) DllMain(
     {
         Microsoft::WRL::Module<Microsoft::WRL::InProc>::GetModule().Terminate();
 		s_mediaExtensionManager.Reset();
-		s_extensionManagerProperties.Reset();
+		s_sourceRegistry.Reset();
     }
 
     return TRUE;
@@ -98,120 +114,575 @@ STDAPI DllCanUnloadNow()
     return module.GetObjectCount() == 0 ? S_OK : S_FALSE;
 }
 
-extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CreateLocalMediaPlayback()
+// Players are addressed by handle so a session can hold any number of
+// remote streams; the Local/Remote exports below wrap two of them.
+typedef MEDIA::HandleTable<MEPlayer^, c_maxPlayers> MEPlayerTable;
+
+static MEPlayerTable s_players;
+static volatile LONG s_nextPlayerId;
+static volatile LONG s_localHandle = MEPlayerTable::InvalidHandle;
+static volatile LONG s_remoteHandle = MEPlayerTable::InvalidHandle;
+
+// --------------------------------------------------------------------------
+// Player pool
+//
+// Keeps players with their device and media engine already built, so
+// answering a call skips that setup. Pooled players are named when they
+// are built, not after the texture name the caller asked for.
+
+struct MEPooledPlayer
 {
-	Log(Log_Level_Info, L"CMediaEnginePlayer::CreateLocalMediaPlayback()");
+	MEPlayer^ player;
+};
 
-	if (nullptr == s_UnityInterfaces)
-		return;
+class MEPlayerPoolFactory : public MEDIA::IWarmPoolFactory
+{
+public:
+	virtual void* Create() override;
+	virtual void Destroy(void* item) override;
 
-	if (s_DeviceType == kUnityGfxRendererD3D11)
+	virtual void OnThreadStart() override
+	{
+		RoInitialize(RO_INIT_MULTITHREADED);
+	}
+
+	virtual void OnThreadStop() override
+	{
+		RoUninitialize();
+	}
+};
+
+// One player ready by default, enough for the remote stream of a call.
+static const uint32_t c_defaultPlayerPoolSize = 1;
+
+static MEPlayerPoolFactory s_playerPoolFactory;
+static MEDIA::WarmPool s_playerPool(&s_playerPoolFactory, c_defaultPlayerPoolSize);
+
+void* MEPlayerPoolFactory::Create()
+{
+	if (nullptr == s_UnityInterfaces || s_DeviceType != kUnityGfxRendererD3D11)
+		return nullptr;
+
+	WCHAR textureName[64];
+	StringCchPrintfW(textureName, ARRAYSIZE(textureName), L"PooledTextureHandle%d", InterlockedIncrement(&s_nextPlayerId));
+
+	MEPlayer^ player;
+	try
 	{
 		IUnityGraphicsD3D11* d3d = s_UnityInterfaces->Get<IUnityGraphicsD3D11>();
-		s_localPlayer = ref new MEPlayer(d3d->GetDevice(), L"SharedLocalTextureHandle", s_extensionManagerProperties);
+		player = ref new MEPlayer(d3d->GetDevice(), ref new String(textureName), s_sourceRegistry);
+	}
+	catch (Platform::Exception^ e)
+	{
+		LOG_RESULT(e->HResult);
+		return nullptr;
+	}
+
+	HRESULT hr = player->Prewarm();
+	if (FAILED(hr))
+	{
+		LOG_RESULT(hr);
+		player->Shutdown();
+		return nullptr;
 	}
+
+	MEPooledPlayer* pooled = new (std::nothrow) MEPooledPlayer();
+	if (pooled == nullptr)
+	{
+		player->Shutdown();
+		return nullptr;
+	}
+
+	pooled->player = player;
+	return pooled;
 }
 
-extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CreateRemoteMediaPlayback()
+void MEPlayerPoolFactory::Destroy(void* item)
 {
-	Log(Log_Level_Info, L"CMediaEnginePlayer::CreateRemoteMediaPlayback()");
+	MEPooledPlayer* pooled = static_cast<MEPooledPlayer*>(item);
+	pooled->player->Shutdown();
+	delete pooled;
+}
 
+static INT32 CreatePlayer(LPCWSTR textureName)
+{
 	if (nullptr == s_UnityInterfaces)
-		return;
+		return MEPlayerTable::InvalidHandle;
 
-	if (s_DeviceType == kUnityGfxRendererD3D11)
+	if (s_DeviceType != kUnityGfxRendererD3D11)
+		return MEPlayerTable::InvalidHandle;
+
+	MEPlayer^ player;
+	MEPooledPlayer* pooled = static_cast<MEPooledPlayer*>(s_playerPool.Acquire());
+	BOOL fPooled = (pooled != nullptr);
+	if (fPooled)
+	{
+		player = pooled->player;
+		delete pooled;
+	}
+	else
 	{
 		IUnityGraphicsD3D11* d3d = s_UnityInterfaces->Get<IUnityGraphicsD3D11>();
-		s_remotePlayer = ref new MEPlayer(d3d->GetDevice(), L"SharedRemoteTextureHandle", s_extensionManagerProperties);
+		player = ref new MEPlayer(d3d->GetDevice(), ref new String(textureName), s_sourceRegistry);
 	}
+
+	// time to first frame counts from here, with or without the pool
+	player->MarkCallStart(&s_playerPool, fPooled);
+
+	INT32 handle = s_players.Insert(player);
+	if (handle == MEPlayerTable::InvalidHandle)
+	{
+		ME_LOG_ERROR(L"CMediaEnginePlayer: too many players");
+		player->Shutdown();
+	}
+	else
+	{
+		ME_LOG_INFO(L"CMediaEnginePlayer: player %d is %s", MEDIA::LogPlayerId(handle), textureName);
+	}
+
+	return handle;
 }
 
-extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReleaseLocalMediaPlayback()
+static void ReleasePlayer(INT32 handle)
 {
-    if (s_localPlayer != nullptr)
-    {
-		s_localPlayer->Pause();
-		s_localPlayer->Shutdown();
-		s_localPlayer = nullptr;
-    }
+	MEPlayer^ player;
+	if (s_players.Remove(handle, &player) && player != nullptr)
+	{
+		player->Pause();
+		player->Shutdown();
+	}
 }
 
-extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReleaseRemoteMediaPlayback()
+extern "C" INT32 UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CreateMediaPlayback()
+{
+	ME_LOG_INFO(L"CMediaEnginePlayer::CreateMediaPlayback()");
+
+	WCHAR textureName[64];
+	StringCchPrintfW(textureName, ARRAYSIZE(textureName), L"SharedTextureHandle%d", InterlockedIncrement(&s_nextPlayerId));
+
+	return CreatePlayer(textureName);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReleaseMediaPlayback(INT32 handle)
+{
+	ReleasePlayer(handle);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetPrimaryTexture(INT32 handle, _In_ UINT32 width, _In_ UINT32 height, _COM_Outptr_ void** playbackSRV)
+{
+	auto player = s_players.Lookup(handle);
+	if (player && *player != nullptr)
+		(*player)->GetPrimaryTexture(width, height, playbackSRV);
+}
+
+extern "C" BOOL UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API AcquirePrimaryTexture(INT32 handle, _Outptr_ void** playbackSRV)
+{
+	auto player = s_players.Lookup(handle);
+	if (!player || *player == nullptr)
+		return FALSE;
+
+	return (*player)->AcquireLatestTexture(playbackSRV) == S_OK;
+}
+
+extern "C" BOOL UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetPlaybackStats(INT32 handle, _Out_ MEPlaybackStats* stats)
+{
+	auto player = s_players.Lookup(handle);
+	if (!player || *player == nullptr || stats == nullptr)
+		return FALSE;
+
+	(*player)->GetPlaybackStats(stats);
+	return TRUE;
+}
+
+// Frames published to the frame slot ring, overwritten before anyone took
+// them, and taken by AcquirePrimaryTexture or the render event.
+extern "C" BOOL UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetFrameSlotStats(INT32 handle, _Out_ MEDIA::FrameSlotRingStats* stats)
+{
+	auto player = s_players.Lookup(handle);
+	if (!player || *player == nullptr || stats == nullptr)
+		return FALSE;
+
+	(*player)->GetFrameSlotStats(stats);
+	return TRUE;
+}
+
+// Frame slot textures reused from the pool against newly allocated, and
+// the bytes in use and kept idle.
+extern "C" BOOL UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetTexturePoolStats(INT32 handle, _Out_ MEDIA::TexturePoolStats* stats)
+{
+	auto player = s_players.Lookup(handle);
+	if (!player || *player == nullptr || stats == nullptr)
+		return FALSE;
+
+	(*player)->GetTexturePoolStats(stats);
+	return TRUE;
+}
+
+// What the one-time engine setup cost against the later Initialize calls
+// that only check the size, in microseconds.
+extern "C" BOOL UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetInitStats(INT32 handle, _Out_ MEInitStats* stats)
+{
+	auto player = s_players.Lookup(handle);
+	if (!player || *player == nullptr || stats == nullptr)
+		return FALSE;
+
+	(*player)->GetInitStats(stats);
+	return TRUE;
+}
+
+// The player's run state, how often it parked and resumed pacing, and the
+// vblank wakeups it saw while not playing.
+extern "C" BOOL UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetRunStats(INT32 handle, _Out_ MERunStats* stats)
+{
+	auto player = s_players.Lookup(handle);
+	if (!player || *player == nullptr || stats == nullptr)
+		return FALSE;
+
+	(*player)->GetRunStats(stats);
+	return TRUE;
+}
+
+// FrameTransferred notifications posted by the pacing thread, folded into
+// one still waiting, and raised.
+extern "C" BOOL UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetFrameNotificationStats(INT32 handle, _Out_ MEDIA::CoalescingQueueStats* stats)
+{
+	auto player = s_players.Lookup(handle);
+	if (!player || *player == nullptr || stats == nullptr)
+		return FALSE;
+
+	(*player)->GetFrameNotificationStats(stats);
+	return TRUE;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API LoadMediaStreamSource(INT32 handle, Windows::Media::Core::IMediaStreamSource^ mediaSourceHandle)
+{
+	if (mediaSourceHandle == nullptr)
+		return;
+
+	auto player = s_players.Lookup(handle);
+	if (player && *player != nullptr)
+		(*player)->SetMediaStreamSource(mediaSourceHandle);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnloadMediaStreamSource(INT32 handle)
+{
+	auto player = s_players.Lookup(handle);
+	if (player && *player != nullptr)
+		(*player)->SetMediaStreamSource(nullptr);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API Play(INT32 handle)
+{
+	auto player = s_players.Lookup(handle);
+	if (player && *player != nullptr)
+		(*player)->Play();
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API Pause(INT32 handle)
 {
-	if (s_remotePlayer != nullptr)
+	auto player = s_players.Lookup(handle);
+	if (player && *player != nullptr)
+		(*player)->Pause();
+}
+
+// Opt-in frame tap, see MEPlayer::EnableFrameTap. The name is the shared
+// memory name consumers open.
+extern "C" BOOL UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API EnableFrameTap(INT32 handle, _In_z_ LPCWSTR name, UINT32 slotCount, UINT32 maxWidth, UINT32 maxHeight)
+{
+	if (name == nullptr)
+		return FALSE;
+
+	auto player = s_players.Lookup(handle);
+	if (!player || *player == nullptr)
+		return FALSE;
+
+	return SUCCEEDED((*player)->EnableFrameTap(ref new String(name), slotCount, maxWidth, maxHeight));
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API DisableFrameTap(INT32 handle)
+{
+	auto player = s_players.Lookup(handle);
+	if (player && *player != nullptr)
+		(*player)->DisableFrameTap();
+}
+
+extern "C" BOOL UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetFrameTapStats(INT32 handle, _Out_ MEDIA::FrameTapStats* stats)
+{
+	auto player = s_players.Lookup(handle);
+	if (!player || *player == nullptr)
+		return FALSE;
+
+	return (*player)->GetFrameTapStats(stats);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetPlayerTableStats(_Out_ MEDIA::HandleTableStats* stats)
+{
+	s_players.GetStats(stats);
+}
+
+// Devices created and destroyed by the broker every player shares, and
+// the references held on them.
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetDeviceBrokerStats(_Out_ MEDIA::DeviceBrokerStats* stats)
+{
+	MEPlayer::GetDeviceBrokerStats(stats);
+}
+
+// Shared pacing thread: ticks, frames presented and vblank jitter in
+// microseconds, across every player.
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetVSyncStats(_Out_ MEDIA::VSyncSchedulerStats* stats)
+{
+	MEPlayer::GetVSyncStats(stats);
+}
+
+// Failure counts per call site, for scripts that report error rates rather
+// than reading the log. Returns how many sites were copied.
+extern "C" UINT32 UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetErrorSites(_Out_writes_(capacity) MEDIA::ErrorSiteSample* sites, UINT32 capacity)
+{
+	return MEDIA::ErrorSiteTable::Instance().Snapshot(sites, capacity);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetErrorCounterStats(_Out_ MEDIA::ErrorCounterStats* stats)
+{
+	MEDIA::ErrorSiteTable::Instance().GetStats(stats);
+	MEDIA::ErrorMessageCache::Instance().GetStats(stats);
+}
+
+// Span tracing, see TraceSpans.h. StartTrace discards the previous capture.
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API StartTrace()
+{
+	MEDIA::TraceRecorder::Instance().Start();
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API StopTrace()
+{
+	MEDIA::TraceRecorder::Instance().Stop();
+}
+
+// Copies the capture as Chrome trace-event JSON (UTF-8, null terminated)
+// when it fits and returns the size it needs, terminator included, so a
+// script can call it once with no buffer to size one.
+extern "C" UINT32 UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetTraceJson(_Out_writes_opt_(capacity) char* buffer, UINT32 capacity)
+{
+	std::string json = MEDIA::TraceRecorder::Instance().ExportJson();
+	UINT32 required = (UINT32)json.size() + 1;
+
+	if (buffer != nullptr && capacity >= required)
 	{
-		s_remotePlayer->Pause();
-		s_remotePlayer->Shutdown();
-		s_remotePlayer = nullptr;
+		memcpy(buffer, json.c_str(), required);
 	}
+
+	return required;
 }
 
-extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetLocalPrimaryTexture(_In_ UINT32 width, _In_ UINT32 height, _COM_Outptr_ void** playbackSRV)
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetTraceStats(_Out_ MEDIA::TraceStats* stats)
 {
-	if (s_localPlayer != nullptr)
-		s_localPlayer->GetPrimaryTexture(width, height, playbackSRV);
+	MEDIA::TraceRecorder::Instance().GetStats(stats);
 }
 
-extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetRemotePrimaryTexture(_In_ UINT32 width, _In_ UINT32 height, _COM_Outptr_ void** playbackSRV)
+// Sources registered, taken by the scheme handler, and dropped unclaimed.
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetSourceRegistryStats(_Out_ MEDIA::SourceRegistryStats* stats)
+{
+	if (s_sourceRegistry)
+	{
+		s_sourceRegistry->Sweep();
+		s_sourceRegistry->GetStats(stats);
+	}
+	else if (stats != nullptr)
+	{
+		memset(stats, 0, sizeof(*stats));
+	}
+}
+
+// Number of players kept ready; 0 turns the pool off.
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetPlayerPoolSize(UINT32 size)
 {
-	if (s_remotePlayer != nullptr)
-		s_remotePlayer->GetPrimaryTexture(width, height, playbackSRV);
+	s_playerPool.SetTarget(size);
 }
 
-extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API LoadLocalMediaStreamSource(Windows::Media::Core::IMediaStreamSource^ mediaSourceHandle)
+// Pool hits and misses, and time to first frame for pooled players
+// against players built on demand, in microseconds.
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetPlayerPoolStats(_Out_ MEDIA::WarmPoolStats* stats)
+{
+	s_playerPool.GetStats(stats);
+}
+
+// How the scheme handler's requests for those sources ended, and how long
+// resolved ones took in microseconds.
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetSourceResolveStats(_Out_ MEDIA::ResolveStats* stats)
 {
-	if (mediaSourceHandle != nullptr && s_localPlayer != nullptr)
+	if (s_sourceRegistry)
+	{
+		s_sourceRegistry->GetResolveStats(stats);
+	}
+	else if (stats != nullptr)
 	{
-		s_localPlayer->SetMediaStreamSource(mediaSourceHandle);
+		memset(stats, 0, sizeof(*stats));
 	}
 }
 
-extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnloadLocalMediaStreamSource()
+// --------------------------------------------------------------------------
+// Render event
+//
+// Unity schedules OnRenderEvent with IssuePluginEvent(GetRenderEventFunc(),
+// c_renderEventUpdateFrames), so every player picks up its latest frame in
+// one call on the render thread, in step with Unity's own frame. Scripts
+// read the results with GetFrameUpdates. This and AcquirePrimaryTexture
+// are both consumers of a player's frame ring; the player serializes them,
+// but a new frame is reported only to whichever runs first, so a script
+// should pick one mode per player and stick to it. The render event is
+// also what moves the texture GetPrimaryTexture hands out, so scripts that
+// wrap that texture issue it every frame too.
+
+static const int c_renderEventUpdateFrames = 1;
+
+// Indexed by player slot.
+static MEDIA::FrameUpdateTable<MEFrameUpdate, c_maxPlayers> s_frameUpdates;
+
+static void UNITY_INTERFACE_API OnRenderEvent(int eventId)
 {
-	if (s_localPlayer != nullptr)
+	if (eventId != c_renderEventUpdateFrames)
+		return;
+
+	MEFrameUpdate batch[c_maxPlayers] = {};
+
+	s_players.ForEach([&batch](INT32 handle, MEPlayer^ player) {
+		int32_t index = MEPlayerTable::SlotIndex(handle);
+		if (index < 0 || player == nullptr)
+			return;
+
+		void* textureSRV = nullptr;
+		HRESULT hr = player->AcquireLatestTexture(&textureSRV);
+		if (SUCCEEDED(hr))
+		{
+			batch[index].handle = handle;
+			batch[index].textureSRV = textureSRV;
+			batch[index].newFrame = (hr == S_OK);
+		}
+
+		if (hr == S_OK)
+		{
+			player->UpdatePrimaryTexture();
+		}
+	});
+
+	s_frameUpdates.Publish(batch);
+}
+
+extern "C" UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetRenderEventFunc()
+{
+	return OnRenderEvent;
+}
+
+// Copies the players updated by the last render event into updates and
+// clears their new frame flags. Returns the number of entries written.
+extern "C" UINT32 UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetFrameUpdates(_Out_writes_to_(capacity, return) MEFrameUpdate* updates, UINT32 capacity)
+{
+	return s_frameUpdates.Take(updates, capacity);
+}
+
+// --------------------------------------------------------------------------
+// Local/Remote exports, kept for existing scripts
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CreateLocalMediaPlayback()
+{
+	ME_LOG_INFO(L"CMediaEnginePlayer::CreateLocalMediaPlayback()");
+
+	INT32 handle = CreatePlayer(L"SharedLocalTextureHandle");
+	if (handle != MEPlayerTable::InvalidHandle)
 	{
-		s_localPlayer->SetMediaStreamSource(nullptr);
+		ReleasePlayer(InterlockedExchange(&s_localHandle, handle));
 	}
 }
 
-extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API LoadRemoteMediaStreamSource(Windows::Media::Core::IMediaStreamSource^ mediaSourceHandle)
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CreateRemoteMediaPlayback()
 {
-	if (mediaSourceHandle != nullptr && s_remotePlayer != nullptr)
+	ME_LOG_INFO(L"CMediaEnginePlayer::CreateRemoteMediaPlayback()");
+
+	INT32 handle = CreatePlayer(L"SharedRemoteTextureHandle");
+	if (handle != MEPlayerTable::InvalidHandle)
 	{
-		s_remotePlayer->SetMediaStreamSource(mediaSourceHandle);
+		ReleasePlayer(InterlockedExchange(&s_remoteHandle, handle));
 	}
 }
 
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReleaseLocalMediaPlayback()
+{
+	ReleasePlayer(InterlockedExchange(&s_localHandle, MEPlayerTable::InvalidHandle));
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReleaseRemoteMediaPlayback()
+{
+	ReleasePlayer(InterlockedExchange(&s_remoteHandle, MEPlayerTable::InvalidHandle));
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetLocalPrimaryTexture(_In_ UINT32 width, _In_ UINT32 height, _COM_Outptr_ void** playbackSRV)
+{
+	GetPrimaryTexture(s_localHandle, width, height, playbackSRV);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetRemotePrimaryTexture(_In_ UINT32 width, _In_ UINT32 height, _COM_Outptr_ void** playbackSRV)
+{
+	GetPrimaryTexture(s_remoteHandle, width, height, playbackSRV);
+}
+
+extern "C" BOOL UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API AcquireLocalPrimaryTexture(_Outptr_ void** playbackSRV)
+{
+	return AcquirePrimaryTexture(s_localHandle, playbackSRV);
+}
+
+extern "C" BOOL UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API AcquireRemotePrimaryTexture(_Outptr_ void** playbackSRV)
+{
+	return AcquirePrimaryTexture(s_remoteHandle, playbackSRV);
+}
+
+extern "C" BOOL UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetLocalPlaybackStats(_Out_ MEPlaybackStats* stats)
+{
+	return GetPlaybackStats(s_localHandle, stats);
+}
+
+extern "C" BOOL UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetRemotePlaybackStats(_Out_ MEPlaybackStats* stats)
+{
+	return GetPlaybackStats(s_remoteHandle, stats);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API LoadLocalMediaStreamSource(Windows::Media::Core::IMediaStreamSource^ mediaSourceHandle)
+{
+	LoadMediaStreamSource(s_localHandle, mediaSourceHandle);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnloadLocalMediaStreamSource()
+{
+	UnloadMediaStreamSource(s_localHandle);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API LoadRemoteMediaStreamSource(Windows::Media::Core::IMediaStreamSource^ mediaSourceHandle)
+{
+	LoadMediaStreamSource(s_remoteHandle, mediaSourceHandle);
+}
+
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnloadRemoteMediaStreamSource()
 {
-	if (s_remotePlayer != nullptr)
-	{
-		s_remotePlayer->SetMediaStreamSource(nullptr);
-	}
+	UnloadMediaStreamSource(s_remoteHandle);
 }
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API LocalPlay()
 {
-	if (s_localPlayer != nullptr)
-		s_localPlayer->Play();
+	Play(s_localHandle);
 }
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RemotePlay()
 {
-	if (s_remotePlayer != nullptr)
-		s_remotePlayer->Play();
+	Play(s_remoteHandle);
 }
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API LocalPause()
 {
-    if (s_localPlayer != nullptr)
-		s_localPlayer->Pause();
+	Pause(s_localHandle);
 }
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RemotePause()
 {
-	if (s_remotePlayer != nullptr)
-		s_remotePlayer->Pause();
+	Pause(s_remoteHandle);
 }
 
 // --------------------------------------------------------------------------
@@ -224,11 +695,18 @@ static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType ev
     if (eventType == kUnityGfxDeviceEventInitialize)
     {
         s_DeviceType = s_Graphics->GetRenderer();
+
+        // pooled players need the Unity device
+        if (s_DeviceType == kUnityGfxRendererD3D11)
+        {
+            s_playerPool.Start();
+        }
     }
 
     // Cleanup graphics API implementation upon shutdown
     if (eventType == kUnityGfxDeviceEventShutdown)
     {
+        s_playerPool.Stop();
         s_DeviceType = kUnityGfxRenderernullptr;
     }
 }
@@ -246,4 +724,8 @@ extern "C" void	UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginLoad(IUnit
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginUnload()
 {
     s_Graphics->UnregisterDeviceEventCallback(OnGraphicsDeviceEvent);
+    s_playerPool.Stop();
+
+    // write out what is still queued while the plugin is loaded
+    MELogger().Stop();
 }
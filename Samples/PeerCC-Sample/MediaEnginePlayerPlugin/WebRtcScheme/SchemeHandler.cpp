@@ -51,12 +51,12 @@ STDAPI DllCanUnloadNow()
 
 SchemeHandler::SchemeHandler()
 {
-  OutputDebugString(L"SchemeHandler::SchemeHandler()");
+  SCHEME_TRACE(L"SchemeHandler::SchemeHandler()");
 }
 
 SchemeHandler::~SchemeHandler()
 {
-  OutputDebugString(L"SchemeHandler::~SchemeHandler()");
+  SCHEME_TRACE(L"SchemeHandler::~SchemeHandler()");
 }
 
 // IMediaExtension methods
@@ -66,6 +66,167 @@ IFACEMETHODIMP SchemeHandler::SetProperties(ABI::Windows::Foundation::Collection
     return S_OK;
 }
 
+// A source normally shows up well within this; after it the request fails.
+static const ULONGLONG c_resolveTimeoutMs = 2000;
+
+// Backoff between lookups while the source is not registered yet.
+static const DWORD c_firstRetryDelayMs = 2;
+static const DWORD c_maxRetryDelayMs = 64;
+
+SourceRequest::SourceRequest() :
+    _deadline(0),
+    _retryDelayMs(c_firstRetryDelayMs),
+    _retries(0),
+    _retryKey(0)
+{
+}
+
+HRESULT SourceRequest::RuntimeClassInitialize(
+    _In_ IMediaSourceRegistry *registry,
+    _In_ LPCWSTR url,
+    _In_ IMFAsyncCallback *callback,
+    _In_opt_ IUnknown *state,
+    ULONGLONG timeoutMs)
+{
+    if ((registry == nullptr) || (url == nullptr) || (callback == nullptr))
+    {
+        return E_INVALIDARG;
+    }
+
+    try
+    {
+        _url = url;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    _registry = registry;
+    _callback = callback;
+    _state = state;
+    _started = std::chrono::steady_clock::now();
+    _deadline = GetTickCount64() + timeoutMs;
+    return S_OK;
+}
+
+HRESULT SourceRequest::Start()
+{
+    return MFPutWorkItem2(MFASYNC_CALLBACK_QUEUE_MULTITHREADED, 0, this, nullptr);
+}
+
+IFACEMETHODIMP SourceRequest::GetParameters(_Out_ DWORD *pdwFlags, _Out_ DWORD *pdwQueue)
+{
+    // retries scheduled with MFScheduleWorkItem land on the same queue
+    *pdwFlags = 0;
+    *pdwQueue = MFASYNC_CALLBACK_QUEUE_MULTITHREADED;
+    return S_OK;
+}
+
+IFACEMETHODIMP SourceRequest::Invoke(_In_opt_ IMFAsyncResult *pAsyncResult)
+{
+    UNREFERENCED_PARAMETER(pAsyncResult);
+
+    if (_gate.IsFinished())
+    {
+      return S_OK;
+    }
+
+    ComPtr<IInspectable> source;
+    HRESULT hr = _registry->TakeSource(_url.c_str(), &source);
+    if (SUCCEEDED(hr))
+    {
+      Complete(MEDIA::ResolveOutcome_Resolved, S_OK, source.Get());
+      return S_OK;
+    }
+    if (hr != HRESULT_FROM_WIN32(ERROR_NOT_FOUND))
+    {
+      Complete(MEDIA::ResolveOutcome_Failed, hr, nullptr);
+      return S_OK;
+    }
+    if (GetTickCount64() >= _deadline)
+    {
+      SCHEME_TRACE(L"WebRtcScheme: timed out waiting for a media source\n");
+      Complete(MEDIA::ResolveOutcome_TimedOut, HRESULT_FROM_WIN32(ERROR_TIMEOUT), nullptr);
+      return S_OK;
+    }
+
+    // Not registered yet, look again shortly. The retry may run before
+    // this returns, so nothing but the key is touched after scheduling.
+    DWORD delayMs = _retryDelayMs;
+    _retryDelayMs = (delayMs * 2 < c_maxRetryDelayMs) ? delayMs * 2 : c_maxRetryDelayMs;
+    _retries.fetch_add(1, std::memory_order_relaxed);
+
+    MFWORKITEM_KEY key = 0;
+    hr = MFScheduleWorkItem(this, nullptr, -(INT64)delayMs, &key);
+    if (FAILED(hr))
+    {
+      Complete(MEDIA::ResolveOutcome_Failed, hr, nullptr);
+      return S_OK;
+    }
+
+    _retryKey.store(key, std::memory_order_release);
+    if (_gate.IsFinished())
+    {
+      // cancelled while scheduling, Cancel may have missed the key
+      key = _retryKey.exchange(0, std::memory_order_acq_rel);
+      if (key != 0)
+      {
+        MFCancelWorkItem(key);
+      }
+    }
+    return S_OK;
+}
+
+IFACEMETHODIMP SourceRequest::Cancel()
+{
+    if (!_gate.TryFinish())
+    {
+      // already resolved, failed or timed out
+      return S_OK;
+    }
+
+    MFWORKITEM_KEY key = _retryKey.exchange(0, std::memory_order_acq_rel);
+    if (key != 0)
+    {
+      MFCancelWorkItem(key);
+    }
+
+    Report(MEDIA::ResolveOutcome_Cancelled);
+    return S_OK;
+}
+
+void SourceRequest::Complete(MEDIA::ResolveOutcome outcome, HRESULT status, _In_opt_ IUnknown *source)
+{
+    if (!_gate.TryFinish())
+    {
+      // cancelled; a source taken meanwhile is released with this request
+      return;
+    }
+
+    ComPtr<IMFAsyncResult> result;
+    HRESULT hr = MFCreateAsyncResult(source, _callback.Get(), _state.Get(), &result);
+    if (SUCCEEDED(hr))
+    {
+      result->SetStatus(status);
+      hr = MFInvokeCallback(result.Get());
+    }
+    if (FAILED(hr))
+    {
+      SCHEME_TRACE(L"WebRtcScheme: failed to complete a source request\n");
+      outcome = MEDIA::ResolveOutcome_Failed;
+    }
+
+    Report(outcome);
+}
+
+void SourceRequest::Report(MEDIA::ResolveOutcome outcome)
+{
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - _started);
+    _registry->ReportResolution((UINT32)outcome, (UINT64)latency.count(), _retries.load(std::memory_order_relaxed));
+}
+
 // IMFSchemeHandler methods
 IFACEMETHODIMP SchemeHandler::BeginCreateObject(
     _In_ LPCWSTR pwszURL,
@@ -89,41 +250,47 @@ IFACEMETHODIMP SchemeHandler::BeginCreateObject(
     {
       return E_INVALIDARG;
     }
-    // Cast the IPropertySet to an IMap and extract the media source that
+    // Cast the IPropertySet to an IMap and get the player's source registry from it.
     ComPtr<ABI::Windows::Foundation::Collections::IMap<HSTRING, IInspectable*>> propMap;
     HRESULT hr = _extensionManagerProperties.As(&propMap);
     if (FAILED(hr))
     {
       return hr;
     }
-    ComPtr<IInspectable> frameSourceInspectable;
-    hr = propMap->Lookup(HStringReference(pwszURL).Get(), &frameSourceInspectable);
+    ComPtr<IInspectable> registryInspectable;
+    hr = propMap->Lookup(HStringReference(MEDIA_SOURCE_REGISTRY_KEY).Get(), &registryInspectable);
     if (FAILED(hr))
     {
-      unsigned int size;
-      hr = propMap->get_Size(&size);
-      if (size == 0)
-      {
-        return E_FAIL;
-      }
       return hr;
     }
-    propMap->Clear();
-
-
-    // Asynchronously return the media source.
-    ComPtr<IMFAsyncResult> result;
-    hr = MFCreateAsyncResult(frameSourceInspectable.Get(), pCallback, punkState, &result);
+    ComPtr<IMediaSourceRegistry> registry;
+    hr = registryInspectable.As(&registry);
+    if (FAILED(hr))
+    {
+      return hr;
+    }
+    // Take the media source registered for this URL on the work queue and
+    // return it through the callback. Sources registered for other URLs
+    // stay where they are.
+    ComPtr<SourceRequest> request;
+    hr = MakeAndInitialize<SourceRequest>(&request, registry.Get(), pwszURL, pCallback, punkState, c_resolveTimeoutMs);
     if (FAILED(hr))
     {
       return hr;
     }
-    hr = pCallback->Invoke(result.Get());
+    hr = request->Start();
     if (FAILED(hr))
     {
       return hr;
     }
-    return result->GetStatus();
+
+    if (ppIUnknownCancelCookie != nullptr)
+    {
+      ComPtr<IUnknown> cookie;
+      request.As(&cookie);
+      *ppIUnknownCancelCookie = cookie.Detach();
+    }
+    return S_OK;
 }
 
 IFACEMETHODIMP SchemeHandler::EndCreateObject(
@@ -158,5 +325,16 @@ IFACEMETHODIMP SchemeHandler::EndCreateObject(
 IFACEMETHODIMP SchemeHandler::CancelObjectCreation(
     _In_ IUnknown *pIUnknownCancelCookie)
 {
-    return E_NOTIMPL;
+    if (pIUnknownCancelCookie == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+
+    ComPtr<ISourceRequest> request;
+    HRESULT hr = pIUnknownCancelCookie->QueryInterface(IID_PPV_ARGS(&request));
+    if (FAILED(hr))
+    {
+        return E_INVALIDARG;
+    }
+    return request->Cancel();
 }
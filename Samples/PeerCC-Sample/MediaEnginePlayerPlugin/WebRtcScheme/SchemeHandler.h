@@ -21,9 +21,78 @@
 #include <windows.media.h>
 #include <mfidl.h>
 #include <mfapi.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "..\MediaEngineUWP\Shared\MediaSourceRegistry.h"
+
+// Debug builds only; in release builds the call compiles to nothing.
+#if defined(_DEBUG)
+#define SCHEME_TRACE(message) OutputDebugString(message)
+#else
+#define SCHEME_TRACE(message) ((void)0)
+#endif
 //DECLSPEC_UUID("40FB267E-050F-4C3A-BFDA-976C14A59BBE")
 namespace WebRtcScheme {
 
+// The cancel cookie BeginCreateObject hands out.
+MIDL_INTERFACE("a43f0c9e-7d26-4b51-9e8a-3c5f1b72d6e8")
+ISourceRequest : public IUnknown
+{
+public:
+    virtual HRESULT STDMETHODCALLTYPE Cancel() = 0;
+};
+
+// One BeginCreateObject call. The lookup runs on the multithreaded MF work
+// queue, retrying with backoff while the source is not registered yet,
+// until it resolves, fails, times out or is cancelled. Whichever comes
+// first finishes the request; the caller's callback runs at most once and
+// never after a cancel.
+class SourceRequest :
+    public Microsoft::WRL::RuntimeClass<
+    Microsoft::WRL::RuntimeClassFlags< Microsoft::WRL::RuntimeClassType::ClassicCom >,
+    IMFAsyncCallback,
+    ISourceRequest,
+    Microsoft::WRL::FtmBase >
+{
+public:
+    SourceRequest();
+
+    HRESULT RuntimeClassInitialize(
+        _In_ IMediaSourceRegistry *registry,
+        _In_ LPCWSTR url,
+        _In_ IMFAsyncCallback *callback,
+        _In_opt_ IUnknown *state,
+        ULONGLONG timeoutMs);
+
+    // Queues the first lookup.
+    HRESULT Start();
+
+    // IMFAsyncCallback
+    IFACEMETHOD(GetParameters) (_Out_ DWORD *pdwFlags, _Out_ DWORD *pdwQueue);
+    IFACEMETHOD(Invoke) (_In_opt_ IMFAsyncResult *pAsyncResult);
+
+    // ISourceRequest
+    IFACEMETHOD(Cancel) ();
+
+private:
+    void Complete(MEDIA::ResolveOutcome outcome, HRESULT status, _In_opt_ IUnknown *source);
+    void Report(MEDIA::ResolveOutcome outcome);
+
+    Microsoft::WRL::ComPtr<IMediaSourceRegistry> _registry;
+    std::wstring _url;
+    Microsoft::WRL::ComPtr<IMFAsyncCallback> _callback;
+    Microsoft::WRL::ComPtr<IUnknown> _state;
+    std::chrono::steady_clock::time_point _started;
+    ULONGLONG _deadline;
+    DWORD _retryDelayMs;    // only touched by Invoke, one lookup at a time
+    std::atomic<UINT32> _retries;
+    MEDIA::ResolveGate _gate;
+    std::atomic<MFWORKITEM_KEY> _retryKey;
+};
+
 class SchemeHandler :
     public Microsoft::WRL::RuntimeClass<
     Microsoft::WRL::RuntimeClassFlags< Microsoft::WRL::RuntimeClassType::WinRtClassicComMix >,
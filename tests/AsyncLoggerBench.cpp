@@ -0,0 +1,88 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// What a log call costs the thread that makes it, against formatting the
+// same message in place as the old synchronous logging did. Calls are
+// timed in batches that fit the ring, with a flush in between that is
+// not counted, so no call is measured taking the cheap dropped path.
+
+#include "AsyncLogger.h"
+#include "Benchmark.h"
+
+#include <cwchar>
+
+using namespace MEDIA;
+
+namespace
+{
+    // Half the ring, less one: a batch never reaches the level at which a
+    // log call wakes the drain thread early.
+    const uint32_t c_batch = AsyncLogger::c_ringCapacity / 2 - 1;
+
+    class NullSink : public ILogSink
+    {
+    public:
+        virtual void Write(const LogEntry& entry)
+        {
+            Bench::KeepAlive(entry.length);
+        }
+    };
+
+    template <typename Call>
+    void RunBatched(const char* name, uint64_t batches, Call call)
+    {
+        double seconds = 0;
+        for (uint64_t b = 0; b < batches; b++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < c_batch; i++)
+            {
+                call(i);
+            }
+            seconds += Bench::Seconds(start);
+            AsyncLogger::Instance().Flush();
+        }
+
+        double calls = (double)batches * c_batch;
+        printf("%-48s %12.1f ns/op  %14.0f ops/s\n", name, seconds * 1e9 / calls, calls / seconds);
+    }
+}
+
+int main()
+{
+    AsyncLogger& logger = AsyncLogger::Instance();
+    logger.AddSink(std::make_shared<NullSink>());
+    const uint64_t batches = 20000;
+
+    RunBatched("log, no arguments", batches, [&](uint32_t) {
+        logger.Log(3, L"frame presented");
+    });
+
+    RunBatched("log, three integers", batches, [&](uint32_t i) {
+        logger.Log(3, L"frame %u size %ux%u", i, LogWidth(1920), LogHeight(1080));
+    });
+
+    RunBatched("log, string and HRESULT", batches, [&](uint32_t) {
+        logger.Log(c_logLevelError, L"%hs failed, hr=0x%08x", "CreateTexture2D", LogHResult(0x887a0005));
+    });
+
+    wchar_t text[256];
+    Bench::Run("swprintf in place, three integers", batches * c_batch, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            swprintf(text, 256, L"frame %u size %ux%u", (unsigned)i, 1920u, 1080u);
+            Bench::KeepAlive(text[0]);
+        }
+    });
+
+    logger.Stop();
+    return 0;
+}
@@ -0,0 +1,518 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "AsyncLogger.h"
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+using namespace MEDIA;
+
+namespace
+{
+    // Formats a record captured from args, the way the drain thread does.
+    template <typename... Args>
+    std::wstring Format(const wchar_t* format, const Args&... args)
+    {
+        LogRecord record;
+        record.format = format;
+        LogRecordWriter writer(&record);
+        int expand[] = { 0, (writer.Put(args), 0)... };
+        (void)expand;
+        writer.Finish();
+
+        wchar_t text[1024];
+        size_t length = AsyncLogger::Format(record, text, 1024);
+        return std::wstring(text, length);
+    }
+
+    // Keeps the text of every entry; Write runs on the drain thread.
+    class CaptureSink : public ILogSink
+    {
+    public:
+        virtual void Write(const LogEntry& entry)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_lines.push_back(std::wstring(entry.text, entry.length));
+            m_threads.push_back(entry.threadId);
+        }
+
+        std::vector<std::wstring> Lines()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_lines;
+        }
+
+        std::vector<uint32_t> Threads()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_threads;
+        }
+
+    private:
+        std::mutex m_lock;
+        std::vector<std::wstring> m_lines;
+        std::vector<uint32_t> m_threads;
+    };
+
+    // Blocks the drain thread inside Write until Release is called.
+    class GateSink : public ILogSink, public Test::Gate
+    {
+    public:
+        virtual void Write(const LogEntry&)
+        {
+            Enter();
+        }
+    };
+
+    LogStats Stats()
+    {
+        return Test::Stats(AsyncLogger::Instance());
+    }
+
+    std::string TempPath(const char* what)
+    {
+#if defined(_WIN32)
+        return std::string("AsyncLoggerTest_") + what + ".log";
+#else
+        return std::string("/tmp/AsyncLoggerTest_") + what + "_" + std::to_string(getpid()) + ".log";
+#endif
+    }
+
+    std::string ReadFile(const std::string& path)
+    {
+        std::string contents;
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file != nullptr)
+        {
+            char buffer[4096];
+            size_t read;
+            while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            {
+                contents.append(buffer, read);
+            }
+            fclose(file);
+        }
+        return contents;
+    }
+
+    struct BinaryLogRecord
+    {
+        std::string format;
+        uint64_t timestamp;
+        uint32_t threadId;
+        uint8_t level;
+        uint8_t truncated;
+        std::string data;
+    };
+
+    // Splits a BinaryFileLogSink file into its records, each with the text
+    // of its format. False on anything the layout in AsyncLogger.h does not
+    // allow.
+    bool ReadBinaryLog(const std::string& contents, std::vector<BinaryLogRecord>* records)
+    {
+        if (contents.size() < 8 || contents.compare(0, 4, "MELB") != 0)
+        {
+            return false;
+        }
+
+        std::vector<std::string> formats;
+        size_t offset = 8;
+        while (offset < contents.size())
+        {
+            char tag = contents[offset++];
+            uint32_t id;
+            if (tag == 'F' && offset + 6 <= contents.size())
+            {
+                uint16_t length;
+                memcpy(&id, contents.data() + offset, sizeof(id));
+                memcpy(&length, contents.data() + offset + 4, sizeof(length));
+                if (id != formats.size() || offset + 6 + length > contents.size())
+                {
+                    return false;
+                }
+                formats.push_back(contents.substr(offset + 6, length));
+                offset += 6 + length;
+            }
+            else if (tag == 'R' && offset + 20 <= contents.size())
+            {
+                BinaryLogRecord record;
+                uint16_t size;
+                memcpy(&id, contents.data() + offset, sizeof(id));
+                memcpy(&record.timestamp, contents.data() + offset + 4, sizeof(record.timestamp));
+                memcpy(&record.threadId, contents.data() + offset + 12, sizeof(record.threadId));
+                record.level = (uint8_t)contents[offset + 16];
+                record.truncated = (uint8_t)contents[offset + 17];
+                memcpy(&size, contents.data() + offset + 18, sizeof(size));
+                if (id >= formats.size() || offset + 20 + size > contents.size())
+                {
+                    return false;
+                }
+                record.format = formats[id];
+                record.data = contents.substr(offset + 20, size);
+                records->push_back(record);
+                offset += 20 + size;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    struct LoggedArg
+    {
+        uint8_t type;
+        uint64_t scalar;
+        double real;
+        std::string string;     // raw units, wide or narrow
+    };
+
+    // Walks LogRecord::data the way the drain thread does.
+    std::vector<LoggedArg> ReadArgs(const std::string& data)
+    {
+        std::vector<LoggedArg> args;
+        size_t offset = 0;
+        while (offset < data.size())
+        {
+            LoggedArg arg = {};
+            arg.type = (uint8_t)data[offset++];
+            if (arg.type == LogArg_Double)
+            {
+                memcpy(&arg.real, data.data() + offset, sizeof(arg.real));
+                offset += sizeof(arg.real);
+            }
+            else if (arg.type == LogArg_WString || arg.type == LogArg_String)
+            {
+                uint16_t units;
+                memcpy(&units, data.data() + offset, sizeof(units));
+                size_t bytes = units * ((arg.type == LogArg_WString) ? sizeof(wchar_t) : sizeof(char));
+                arg.string = data.substr(offset + sizeof(units), bytes);
+                offset += sizeof(units) + bytes;
+            }
+            else
+            {
+                memcpy(&arg.scalar, data.data() + offset, sizeof(arg.scalar));
+                offset += sizeof(arg.scalar);
+            }
+            args.push_back(arg);
+        }
+        return args;
+    }
+}
+
+// The format checks run at compile time, so these are the test.
+static_assert(LogFormatMatches(L"%d %u %x", decltype(LogArgKindsOf(1, 2u, 3))()), "integers");
+static_assert(LogFormatMatches(L"%s %hs %S", decltype(LogArgKindsOf(L"w", "n", "n"))()), "strings");
+static_assert(LogFormatMatches(L"%*d %.*f %p", decltype(LogArgKindsOf(4, 1, 2, 3.0, (void*)nullptr))()), "star");
+static_assert(LogFormatMatches(L"100%% %I64d", decltype(LogArgKindsOf(LogPts(1)))()), "fields");
+static_assert(!LogFormatMatches(L"%d %d", decltype(LogArgKindsOf(1))()), "missing argument");
+static_assert(!LogFormatMatches(L"%d", decltype(LogArgKindsOf(1, 2))()), "extra argument");
+static_assert(!LogFormatMatches(L"%s", decltype(LogArgKindsOf(1))()), "integer for a string");
+static_assert(!LogFormatMatches(L"%hs", decltype(LogArgKindsOf(L"w"))()), "wide for narrow");
+static_assert(!LogFormatMatches(L"%f", decltype(LogArgKindsOf(1))()), "integer for a real");
+
+TEST_CASE(FormatsScalars)
+{
+    CHECK(Format(L"plain") == L"plain");
+    CHECK(Format(L"%d|%u|%x|%X", -5, 7u, 255, 255) == L"-5|7|ff|FF");
+    CHECK(Format(L"%5d|%-3d|%03d", 42, 1, 7) == L"   42|1  |007");
+    CHECK(Format(L"%.2f|%g", 3.14159, 0.5) == L"3.14|0.5");
+    CHECK(Format(L"%*d", 4, 9) == L"   9");
+    CHECK(Format(L"%c%c", 'o', 'k') == L"ok");
+    CHECK(Format(L"100%%") == L"100%");
+    CHECK(Format(L"%lld|%I64u", (long long)-1, (unsigned long long)2) == L"-1|2");
+}
+
+TEST_CASE(FormatsStringsOfBothWidths)
+{
+    CHECK(Format(L"[%s]", L"wide") == L"[wide]");
+    CHECK(Format(L"[%ls]", L"wide") == L"[wide]");
+    CHECK(Format(L"[%hs]", "narrow") == L"[narrow]");
+    CHECK(Format(L"[%S]", "narrow") == L"[narrow]");
+    CHECK(Format(L"[%-6hs]", "ab") == L"[ab    ]");
+    CHECK(Format(L"[%s]", (const wchar_t*)nullptr) == L"[]");
+}
+
+TEST_CASE(TypedFieldsPrintLikeIntegers)
+{
+    CHECK(Format(L"hr=0x%08x", LogHResult(0x80004005)) == L"hr=0x80004005");
+    CHECK(Format(L"pts=%lld", LogPts(-400000)) == L"pts=-400000");
+    CHECK(Format(L"%ux%u", LogWidth(1920), LogHeight(1080)) == L"1920x1080");
+    CHECK(Format(L"player %d", LogPlayerId(-3)) == L"player -3");
+}
+
+TEST_CASE(MismatchesAndMissingArgumentsDoNotReadGarbage)
+{
+    // The captured type wins over the conversion.
+    CHECK(Format(L"%s", 12) == L"12");
+    CHECK(Format(L"%d", 2.5) == L"2.5");
+    CHECK(Format(L"%d and %d", 1) == L"1 and %d");
+}
+
+TEST_CASE(LongStringsAreTruncatedNotOverrun)
+{
+    std::string longText(2000, 'a');
+    LogRecord record;
+    record.format = L"%hs %d";
+    LogRecordWriter writer(&record);
+    writer.Put(longText.c_str());
+    writer.Put(5);
+    writer.Finish();
+    CHECK(record.truncated == 1);
+    CHECK(record.size <= sizeof(record.data));
+
+    wchar_t text[4096];
+    size_t length = AsyncLogger::Format(record, text, 4096);
+    CHECK(length > 100 && length < longText.size());
+
+    // A small output buffer cuts the message short but stays terminated.
+    wchar_t small[8];
+    CHECK(AsyncLogger::Format(record, small, 8) < 8);
+}
+
+TEST_CASE(RecordsFromManyThreadsAllArriveInOrder)
+{
+    const int c_threads = 4;
+    const int c_perThread = 50;
+    AsyncLogger& logger = AsyncLogger::Instance();
+    auto sink = std::make_shared<CaptureSink>();
+    logger.AddSink(sink);
+    LogStats before = Stats();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < c_threads; t++)
+    {
+        threads.emplace_back([&logger, t]() {
+            for (int i = 0; i < c_perThread; i++)
+            {
+                logger.Log(3, L"thread %d message %d", t, i);
+                if ((i % 16) == 15)
+                {
+                    // stay below the ring capacity, dropping is tested below
+                    logger.Flush();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    logger.Flush();
+    logger.RemoveSink(sink);
+
+    std::vector<std::wstring> lines = sink->Lines();
+    CHECK(lines.size() == (size_t)(c_threads * c_perThread));
+    int next[c_threads] = {};
+    for (const std::wstring& line : lines)
+    {
+        int t = -1;
+        int i = -1;
+        REQUIRE(swscanf(line.c_str(), L"thread %d message %d", &t, &i) == 2);
+        REQUIRE(t >= 0 && t < c_threads);
+        CHECK(i == next[t]);
+        next[t] = i + 1;
+    }
+
+    LogStats after = Stats();
+    CHECK(after.logged - before.logged == (uint64_t)(c_threads * c_perThread));
+    CHECK(after.dropped == before.dropped);
+}
+
+TEST_CASE(AFullRingDropsAndCounts)
+{
+    AsyncLogger& logger = AsyncLogger::Instance();
+    auto gate = std::make_shared<GateSink>();
+    logger.AddSink(gate);
+    LogStats before = Stats();
+
+    // The logging thread is a fresh one, so its ring starts empty. Its
+    // first record parks the drain thread in the sink; the ring then holds
+    // c_ringCapacity records and everything after that is dropped.
+    const uint32_t c_extra = 10;
+    std::thread producer([&]() {
+        logger.Log(c_logLevelError, L"first");
+        gate->WaitUntilEntered();
+        for (uint32_t i = 0; i < AsyncLogger::c_ringCapacity + c_extra; i++)
+        {
+            logger.Log(3, L"filler %u", i);
+        }
+    });
+    producer.join();
+
+    LogStats full = Stats();
+    gate->Release();
+    logger.Flush();
+    logger.RemoveSink(gate);
+
+    // The parked record is still in the ring until the sink returns.
+    CHECK(full.dropped - before.dropped == c_extra + 1);
+    CHECK(full.logged - before.logged == AsyncLogger::c_ringCapacity);
+
+    LogStats after = Stats();
+    CHECK(after.written - before.written == AsyncLogger::c_ringCapacity);
+}
+
+TEST_CASE(FileSinkWritesOneUtf8LinePerEntry)
+{
+    std::string path = TempPath("file");
+    remove(path.c_str());
+
+    AsyncLogger& logger = AsyncLogger::Instance();
+    auto sink = std::make_shared<FileLogSink>();
+    REQUIRE(sink->Open(path.c_str()));
+    logger.AddSink(sink);
+    logger.Log(c_logLevelError, L"caf\u00e9 %d\r\n", 1);
+    logger.Log(3, L"second");
+    logger.Flush();
+    logger.RemoveSink(sink);
+    sink.reset();
+
+    std::string contents = ReadFile(path);
+    remove(path.c_str());
+
+    CHECK(contents.find(" ERROR caf\xc3\xa9 1\n") != std::string::npos);
+    CHECK(contents.find(" INFO second\n") != std::string::npos);
+    CHECK(contents.find('\r') == std::string::npos);
+}
+
+TEST_CASE(BinarySinkStartsWithItsHeader)
+{
+    std::string path = TempPath("binary");
+    remove(path.c_str());
+
+    AsyncLogger& logger = AsyncLogger::Instance();
+    auto sink = std::make_shared<BinaryFileLogSink>();
+    REQUIRE(sink->Open(path.c_str()));
+    logger.AddSink(sink);
+    const wchar_t* format = L"frame %I64d";
+    logger.Log(3, format, LogPts(333));
+    logger.Log(3, format, LogPts(666));
+    logger.Flush();
+    logger.RemoveSink(sink);
+    sink.reset();
+
+    std::string contents = ReadFile(path);
+    remove(path.c_str());
+
+    REQUIRE(contents.size() > 8);
+    CHECK(contents.compare(0, 4, "MELB") == 0);
+    uint16_t version;
+    memcpy(&version, contents.data() + 4, sizeof(version));
+    CHECK(version == BinaryFileLogSink::c_version);
+    CHECK((uint8_t)contents[6] == sizeof(wchar_t));
+
+    // The format goes out once, followed by both records.
+    size_t formats = 0;
+    size_t records = 0;
+    size_t offset = 8;
+    while (offset < contents.size())
+    {
+        char tag = contents[offset++];
+        if (tag == 'F')
+        {
+            uint16_t length;
+            memcpy(&length, contents.data() + offset + 4, sizeof(length));
+            CHECK(contents.compare(offset + 6, length, "frame %I64d") == 0);
+            offset += 6 + length;
+            formats++;
+        }
+        else if (tag == 'R')
+        {
+            uint16_t size;
+            memcpy(&size, contents.data() + offset + 4 + 8 + 4 + 1 + 1, sizeof(size));
+            offset += 4 + 8 + 4 + 1 + 1 + 2 + size;
+            records++;
+        }
+        else
+        {
+            CHECK(!"unknown chunk");
+            break;
+        }
+    }
+    CHECK(formats == 1);
+    CHECK(records == 2);
+}
+
+TEST_CASE(BinaryRecordsRoundTripWithTheirFields)
+{
+    std::string path = TempPath("roundtrip");
+    remove(path.c_str());
+
+    AsyncLogger& logger = AsyncLogger::Instance();
+    auto binary = std::make_shared<BinaryFileLogSink>();
+    auto text = std::make_shared<CaptureSink>();
+    REQUIRE(binary->Open(path.c_str()));
+    logger.AddSink(binary);
+    logger.AddSink(text);
+    logger.Log(c_logLevelError, L"hr=0x%08x pts=%lld %ux%u player %d %s %hs %d %.1f",
+        LogHResult(0x80004005), LogPts(-400000), LogWidth(1920), LogHeight(1080), LogPlayerId(-3),
+        L"wide", "narrow", 7, 2.5);
+    logger.Log(3, L"second");
+    logger.Flush();
+    logger.RemoveSink(text);
+    logger.RemoveSink(binary);
+    binary.reset();
+
+    std::string contents = ReadFile(path);
+    remove(path.c_str());
+
+    std::vector<BinaryLogRecord> records;
+    REQUIRE(ReadBinaryLog(contents, &records));
+    REQUIRE(records.size() == 2);
+    CHECK(records[0].format == "hr=0x%08x pts=%lld %ux%u player %d %s %hs %d %.1f");
+    CHECK(records[0].level == c_logLevelError);
+    CHECK(records[0].truncated == 0);
+    CHECK(records[1].format == "second");
+    CHECK(records[1].level == 3);
+    CHECK(records[1].data.empty());
+    CHECK(records[1].timestamp >= records[0].timestamp);
+    CHECK(records[1].threadId == records[0].threadId);
+
+    // Every field comes back with its tag and its value.
+    std::vector<LoggedArg> args = ReadArgs(records[0].data);
+    REQUIRE(args.size() == 9);
+    CHECK(args[0].type == LogArg_HResult && args[0].scalar == 0x80004005);
+    CHECK(args[1].type == LogArg_Pts && (int64_t)args[1].scalar == -400000);
+    CHECK(args[2].type == LogArg_Width && args[2].scalar == 1920);
+    CHECK(args[3].type == LogArg_Height && args[3].scalar == 1080);
+    CHECK(args[4].type == LogArg_PlayerId && (int64_t)args[4].scalar == -3);
+    CHECK(args[5].type == LogArg_WString && args[5].string == std::string((const char*)L"wide", 4 * sizeof(wchar_t)));
+    CHECK(args[6].type == LogArg_String && args[6].string == "narrow");
+    CHECK(args[7].type == LogArg_Int && args[7].scalar == 7);
+    CHECK(args[8].type == LogArg_Double && args[8].real == 2.5);
+
+    // Formatting the decoded record gives what a text sink got.
+    std::wstring format(records[0].format.begin(), records[0].format.end());
+    LogRecord record;
+    record.format = format.c_str();
+    REQUIRE(records[0].data.size() <= sizeof(record.data));
+    memcpy(record.data, records[0].data.data(), records[0].data.size());
+    record.size = (uint16_t)records[0].data.size();
+
+    wchar_t formatted[1024];
+    std::wstring line(formatted, AsyncLogger::Format(record, formatted, 1024));
+    CHECK(line == L"hr=0x80004005 pts=-400000 1920x1080 player -3 wide narrow 7 2.5");
+
+    std::vector<std::wstring> lines = text->Lines();
+    REQUIRE(lines.size() == 2);
+    CHECK(lines[0] == line);
+}
@@ -0,0 +1,49 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace Bench
+{
+    // Keeps the optimizer from dropping a result nobody reads.
+    template <typename T>
+    inline void KeepAlive(const T& value)
+    {
+#if defined(__GNUC__)
+        __asm__ __volatile__("" : : "r"(&value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+        (void)sink;
+#endif
+    }
+
+    inline double Seconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Times body(iterations) and prints the cost per iteration.
+    template <typename Body>
+    inline double Run(const char* name, uint64_t iterations, Body body)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        double seconds = Seconds(start);
+        double nanoseconds = seconds * 1e9 / (double)iterations;
+        printf("%-48s %12.1f ns/op  %14.0f ops/s\n", name, nanoseconds, (double)iterations / seconds);
+        return nanoseconds;
+    }
+}
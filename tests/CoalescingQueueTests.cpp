@@ -0,0 +1,162 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "CoalescingQueue.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace MEDIA;
+
+namespace
+{
+    typedef CoalescingQueue<4> Queue;
+
+    const uint8_t c_frame = 1;
+    const uint8_t c_event = 2;
+}
+
+TEST_CASE(PayloadsCarryTheirKind)
+{
+    uint64_t payload = Queue::MakePayload(c_event, 0x123456789abcull);
+    CHECK(Queue::Kind(payload) == c_event);
+    CHECK(Queue::Value(payload) == 0x123456789abcull);
+
+    // The value may not spill into the kind byte.
+    payload = Queue::MakePayload(c_frame, ~0ull);
+    CHECK(Queue::Kind(payload) == c_frame);
+}
+
+TEST_CASE(AnEmptyQueueHasNothingToTake)
+{
+    Queue queue;
+    uint64_t payload = 7;
+    CHECK(!queue.HasPending());
+    CHECK(!queue.TryTake(&payload));
+    CHECK(payload == 7);
+}
+
+TEST_CASE(UnconsumedFramesCollapseIntoTheLatest)
+{
+    Queue queue;
+    for (uint64_t frame = 1; frame <= 10; frame++)
+    {
+        CHECK(queue.Post(Queue::MakePayload(c_frame, frame)));
+    }
+
+    uint64_t payload = 0;
+    CHECK(queue.TryTake(&payload));
+    CHECK(Queue::Value(payload) == 10);
+    CHECK(!queue.TryTake(&payload));
+
+    CoalescingQueueStats stats = Test::Stats(queue);
+    CHECK(stats.posted == 10);
+    CHECK(stats.coalesced == 9);
+    CHECK(stats.taken == 1);
+}
+
+TEST_CASE(OtherKindsQueueInOrder)
+{
+    Queue queue;
+    queue.Post(Queue::MakePayload(c_frame, 1));
+    queue.Post(Queue::MakePayload(c_event, 2));
+    // Only the most recent cell coalesces, so this frame queues again.
+    queue.Post(Queue::MakePayload(c_frame, 3));
+    queue.Post(Queue::MakePayload(c_frame, 4));
+
+    uint64_t payload = 0;
+    CHECK(queue.TryTake(&payload) && Queue::Value(payload) == 1);
+    CHECK(queue.TryTake(&payload) && Queue::Value(payload) == 2);
+    CHECK(queue.TryTake(&payload) && Queue::Value(payload) == 4);
+    CHECK(!queue.HasPending());
+}
+
+TEST_CASE(ATakenFrameIsNotReplaced)
+{
+    Queue queue;
+    queue.Post(Queue::MakePayload(c_frame, 1));
+    uint64_t payload = 0;
+    CHECK(queue.TryTake(&payload));
+
+    // The previous cell is empty now, so the next frame is a new entry.
+    queue.Post(Queue::MakePayload(c_frame, 2));
+    CHECK(queue.TryTake(&payload) && Queue::Value(payload) == 2);
+    CHECK(Test::Stats(queue).coalesced == 0);
+}
+
+TEST_CASE(AFullQueueDropsNewKinds)
+{
+    Queue queue;
+    for (uint64_t i = 0; i < 4; i++)
+    {
+        CHECK(queue.Post(Queue::MakePayload((i % 2) ? c_event : c_frame, i + 1)));
+    }
+    CHECK(!queue.Post(Queue::MakePayload(c_frame, 5)));
+    CHECK(Test::Stats(queue).dropped == 1);
+
+    // The same kind as the newest entry still coalesces when full.
+    CHECK(queue.Post(Queue::MakePayload(c_event, 6)));
+}
+
+// Frames interleaved with the occasional other event: the consumer must
+// see frame numbers only increase, and every post must end up taken,
+// coalesced or dropped.
+TEST_CASE(StressProducerAgainstSlowConsumer)
+{
+    const uint64_t c_posts = 500000;
+    CoalescingQueue<8> queue;
+    std::atomic<bool> finished(false);
+
+    std::thread producer([&]() {
+        for (uint64_t i = 1; i <= c_posts; i++)
+        {
+            uint8_t kind = (i % 64) == 0 ? c_event : c_frame;
+            queue.Post(CoalescingQueue<8>::MakePayload(kind, i));
+        }
+        finished.store(true, std::memory_order_release);
+    });
+
+    uint64_t lastFrame = 0;
+    uint64_t backwards = 0;
+    uint64_t taken = 0;
+    for (;;)
+    {
+        bool last = finished.load(std::memory_order_acquire);
+        uint64_t payload = 0;
+        while (queue.TryTake(&payload))
+        {
+            taken++;
+            uint64_t value = CoalescingQueue<8>::Value(payload);
+            if (CoalescingQueue<8>::Kind(payload) == c_frame)
+            {
+                if (value <= lastFrame)
+                {
+                    backwards++;
+                }
+                lastFrame = value;
+            }
+        }
+        if (last)
+        {
+            break;
+        }
+        std::this_thread::yield();
+    }
+    producer.join();
+
+    CoalescingQueueStats stats;
+    queue.GetStats(&stats);
+    CHECK(backwards == 0);
+    CHECK(stats.taken == taken);
+    CHECK(stats.posted == c_posts);
+    CHECK(stats.taken + stats.coalesced + stats.dropped == c_posts);
+}
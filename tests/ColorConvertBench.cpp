@@ -0,0 +1,100 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Conversion throughput per kernel and format at 720p and 1080p.
+
+#include "Benchmark.h"
+#include "ColorConvert.h"
+
+#include <vector>
+
+using namespace MEDIA;
+
+namespace
+{
+    const char* KernelName(ConvertKernel kernel)
+    {
+        switch (kernel)
+        {
+        case ConvertKernel_Scalar:
+            return "scalar";
+        case ConvertKernel_SSE41:
+            return "sse4.1";
+        case ConvertKernel_AVX2:
+            return "avx2";
+        default:
+            return "auto";
+        }
+    }
+}
+
+int main()
+{
+    const int sizes[][2] = { { 1280, 720 }, { 1920, 1080 } };
+    const ConvertKernel kernels[] = { ConvertKernel_Scalar, ConvertKernel_SSE41, ConvertKernel_AVX2 };
+    const uint64_t frames = 100;
+
+    for (const auto& size : sizes)
+    {
+        const int width = size[0];
+        const int height = size[1];
+        std::vector<uint8_t> y((size_t)width * height, 120);
+        std::vector<uint8_t> chroma((size_t)width * height / 2, 100);
+        std::vector<uint16_t> y16((size_t)width * height, 500 << 6);
+        std::vector<uint16_t> chroma16((size_t)width * height / 2, 400 << 6);
+        std::vector<uint8_t> bgra((size_t)width * height * 4);
+
+        for (ConvertKernel kernel : kernels)
+        {
+            if (!IsConvertKernelSupported(kernel))
+            {
+                printf("%-48s not supported here\n", KernelName(kernel));
+                continue;
+            }
+
+            ColorConvertParams params = { ColorMatrix_BT709, ColorRange_Limited, kernel };
+            char name[64];
+            double perFrame;
+
+            snprintf(name, sizeof(name), "NV12 %dx%d %s", width, height, KernelName(kernel));
+            perFrame = Bench::Run(name, frames, [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; i++)
+                {
+                    ConvertNV12ToBGRA(y.data(), width, chroma.data(), width, bgra.data(), width * 4, width, height, params);
+                }
+            });
+            printf("%-48s %12.2f Mpixel/s\n", "", (double)width * height * 1e3 / perFrame);
+
+            snprintf(name, sizeof(name), "I420 %dx%d %s", width, height, KernelName(kernel));
+            perFrame = Bench::Run(name, frames, [&](uint64_t n) {
+                const uint8_t* u = chroma.data();
+                const uint8_t* v = u + (size_t)width * height / 4;
+                for (uint64_t i = 0; i < n; i++)
+                {
+                    ConvertI420ToBGRA(y.data(), width, u, width / 2, v, width / 2, bgra.data(), width * 4, width, height, params);
+                }
+            });
+            printf("%-48s %12.2f Mpixel/s\n", "", (double)width * height * 1e3 / perFrame);
+
+            snprintf(name, sizeof(name), "P010 %dx%d %s", width, height, KernelName(kernel));
+            perFrame = Bench::Run(name, frames, [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; i++)
+                {
+                    ConvertP010ToBGRA(y16.data(), width * 2, chroma16.data(), width * 2, bgra.data(), width * 4, width, height, params);
+                }
+            });
+            printf("%-48s %12.2f Mpixel/s\n", "", (double)width * height * 1e3 / perFrame);
+            Bench::KeepAlive(bgra[0]);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "ColorConvert.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace MEDIA;
+
+namespace
+{
+    // Stride padding is filled with this and must survive every kernel.
+    const uint8_t c_guard = 0xa5;
+
+    class Random
+    {
+    public:
+        explicit Random(uint32_t seed) : m_state(seed ? seed : 1) {}
+
+        uint32_t Next()
+        {
+            m_state ^= m_state << 13;
+            m_state ^= m_state >> 17;
+            m_state ^= m_state << 5;
+            return m_state;
+        }
+
+    private:
+        uint32_t m_state;
+    };
+
+    // An image in any of the three layouts, with stride padding on every
+    // plane so a kernel that reads or writes past the width shows up.
+    struct Frame
+    {
+        int width;
+        int height;
+        int chromaWidth;
+        int chromaHeight;
+        int yStride;
+        int uvStride;
+        int bgraStride;
+        std::vector<uint8_t> y;
+        std::vector<uint8_t> u;
+        std::vector<uint8_t> v;
+        std::vector<uint8_t> uv;
+        std::vector<uint16_t> y16;
+        std::vector<uint16_t> uv16;
+
+        Frame(int w, int h, uint32_t seed) :
+            width(w),
+            height(h),
+            chromaWidth((w + 1) / 2),
+            chromaHeight((h + 1) / 2),
+            yStride(w + 24),
+            uvStride(chromaWidth * 2 + 24),
+            bgraStride(w * 4 + 64)
+        {
+            Random random(seed);
+            y.resize((size_t)yStride * height);
+            u.resize((size_t)uvStride * chromaHeight);
+            v.resize((size_t)uvStride * chromaHeight);
+            uv.resize((size_t)uvStride * chromaHeight);
+            y16.resize(y.size());
+            uv16.resize(uv.size());
+            for (size_t i = 0; i < y.size(); i++)
+            {
+                y[i] = (uint8_t)random.Next();
+                y16[i] = (uint16_t)((random.Next() & 0x3ff) << 6);
+            }
+            for (size_t i = 0; i < uv.size(); i++)
+            {
+                u[i] = (uint8_t)random.Next();
+                v[i] = (uint8_t)random.Next();
+                uv[i] = (uint8_t)random.Next();
+                uv16[i] = (uint16_t)((random.Next() & 0x3ff) << 6);
+            }
+        }
+
+        std::vector<uint8_t> MakeOutput() const
+        {
+            return std::vector<uint8_t>((size_t)bgraStride * height, c_guard);
+        }
+    };
+
+    enum Format
+    {
+        Format_NV12,
+        Format_I420,
+        Format_P010
+    };
+
+    bool Convert(const Frame& frame, Format format, const ColorConvertParams& params, std::vector<uint8_t>* out)
+    {
+        switch (format)
+        {
+        case Format_NV12:
+            return ConvertNV12ToBGRA(frame.y.data(), frame.yStride, frame.uv.data(), frame.uvStride,
+                out->data(), frame.bgraStride, frame.width, frame.height, params);
+        case Format_I420:
+            return ConvertI420ToBGRA(frame.y.data(), frame.yStride, frame.u.data(), frame.uvStride,
+                frame.v.data(), frame.uvStride, out->data(), frame.bgraStride, frame.width, frame.height, params);
+        case Format_P010:
+            return ConvertP010ToBGRA(frame.y16.data(), frame.yStride * 2, frame.uv16.data(), frame.uvStride * 2,
+                out->data(), frame.bgraStride, frame.width, frame.height, params);
+        }
+        return false;
+    }
+
+    bool PaddingIntact(const Frame& frame, const std::vector<uint8_t>& out)
+    {
+        for (int row = 0; row < frame.height; row++)
+        {
+            for (int x = frame.width * 4; x < frame.bgraStride; x++)
+            {
+                if (out[(size_t)row * frame.bgraStride + x] != c_guard)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void ConvertPixel(uint8_t y, uint8_t u, uint8_t v, ColorRange range, uint8_t bgra[4])
+    {
+        ColorConvertParams params = { ColorMatrix_BT709, range, ConvertKernel_Scalar };
+        uint8_t uv[2] = { u, v };
+        ConvertNV12ToBGRA(&y, 1, uv, 2, bgra, 4, 1, 1, params);
+    }
+}
+
+TEST_CASE(ScalarIsAlwaysSupported)
+{
+    CHECK(IsConvertKernelSupported(ConvertKernel_Scalar));
+    CHECK(IsConvertKernelSupported(ConvertKernel_Auto));
+    CHECK(BestConvertKernel() != ConvertKernel_Auto);
+    CHECK(IsConvertKernelSupported(BestConvertKernel()));
+}
+
+TEST_CASE(BadArgumentsAreRejected)
+{
+    uint8_t y[4] = {}, uv[4] = {}, bgra[16] = {};
+    ColorConvertParams params = { ColorMatrix_BT601, ColorRange_Limited, ConvertKernel_Scalar };
+    CHECK(!ConvertNV12ToBGRA(nullptr, 2, uv, 2, bgra, 8, 2, 2, params));
+    CHECK(!ConvertNV12ToBGRA(y, 2, uv, 2, nullptr, 8, 2, 2, params));
+    CHECK(!ConvertNV12ToBGRA(y, 2, uv, 2, bgra, 8, 0, 2, params));
+    CHECK(!ConvertNV12ToBGRA(y, 2, uv, 2, bgra, 8, 2, -1, params));
+    CHECK(ConvertNV12ToBGRA(y, 2, uv, 2, bgra, 8, 2, 2, params));
+}
+
+TEST_CASE(LimitedRangeBlackAndWhiteHitTheRails)
+{
+    uint8_t bgra[4];
+    ConvertPixel(16, 128, 128, ColorRange_Limited, bgra);
+    CHECK(bgra[0] == 0 && bgra[1] == 0 && bgra[2] == 0 && bgra[3] == 255);
+
+    ConvertPixel(235, 128, 128, ColorRange_Limited, bgra);
+    CHECK(bgra[0] == 255 && bgra[1] == 255 && bgra[2] == 255);
+
+    // Out-of-range input clamps instead of wrapping.
+    ConvertPixel(0, 128, 128, ColorRange_Limited, bgra);
+    CHECK(bgra[0] == 0 && bgra[1] == 0 && bgra[2] == 0);
+    ConvertPixel(255, 255, 255, ColorRange_Limited, bgra);
+    CHECK(bgra[2] == 255);
+}
+
+TEST_CASE(FullRangeGrayPassesThrough)
+{
+    uint8_t bgra[4];
+    for (int gray = 0; gray < 256; gray += 17)
+    {
+        ConvertPixel((uint8_t)gray, 128, 128, ColorRange_Full, bgra);
+        CHECK(bgra[0] == gray && bgra[1] == gray && bgra[2] == gray);
+    }
+}
+
+// Every vector kernel this CPU supports must match the scalar kernel
+// byte for byte, including the odd widths that leave a scalar tail.
+TEST_CASE(VectorKernelsMatchScalarBitForBit)
+{
+    const int sizes[][2] = { { 1, 1 }, { 7, 3 }, { 8, 2 }, { 15, 5 }, { 16, 16 }, { 33, 9 }, { 64, 4 }, { 181, 17 } };
+    const ConvertKernel kernels[] = { ConvertKernel_SSE41, ConvertKernel_AVX2, ConvertKernel_Auto };
+    const ColorMatrix matrices[] = { ColorMatrix_BT601, ColorMatrix_BT709 };
+    const ColorRange ranges[] = { ColorRange_Limited, ColorRange_Full };
+    const Format formats[] = { Format_NV12, Format_I420, Format_P010 };
+
+    int compared = 0;
+    uint32_t seed = 1;
+    for (const auto& size : sizes)
+    {
+        Frame frame(size[0], size[1], seed++);
+        for (Format format : formats)
+        {
+            for (ColorMatrix matrix : matrices)
+            {
+                for (ColorRange range : ranges)
+                {
+                    ColorConvertParams params = { matrix, range, ConvertKernel_Scalar };
+                    std::vector<uint8_t> expected = frame.MakeOutput();
+                    REQUIRE(Convert(frame, format, params, &expected));
+                    CHECK(PaddingIntact(frame, expected));
+
+                    for (ConvertKernel kernel : kernels)
+                    {
+                        params.kernel = kernel;
+                        std::vector<uint8_t> actual = frame.MakeOutput();
+                        if (!IsConvertKernelSupported(kernel))
+                        {
+                            CHECK(!Convert(frame, format, params, &actual));
+                            continue;
+                        }
+                        REQUIRE(Convert(frame, format, params, &actual));
+                        CHECK(actual == expected);
+                        compared++;
+                    }
+                }
+            }
+        }
+    }
+
+    if (BestConvertKernel() == ConvertKernel_Scalar)
+    {
+        printf("    no vector kernels on this CPU, only Auto was compared\n");
+    }
+    CHECK(compared > 0);
+}
@@ -0,0 +1,202 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "DeviceBroker.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace MEDIA;
+
+namespace
+{
+    // Stands in for the D3D device and DXGI manager pair.
+    class FakeDeviceFactory : public IDeviceFactory
+    {
+    public:
+        FakeDeviceFactory() : created(0), destroyed(0), fail(false) {}
+
+        virtual void* Create(const DeviceKey& key) override
+        {
+            if (fail)
+            {
+                return nullptr;
+            }
+            created++;
+            return new DeviceKey(key);
+        }
+
+        virtual void Destroy(void* device) override
+        {
+            destroyed++;
+            delete static_cast<DeviceKey*>(device);
+        }
+
+        std::atomic<int> created;
+        std::atomic<int> destroyed;
+        bool fail;
+    };
+
+    const DeviceKey c_hardware = { 0, 0x800 };
+    const DeviceKey c_warp = { 0, 0x800 | 0x1 };
+}
+
+TEST_CASE(PlayersShareOneDevicePerKey)
+{
+    FakeDeviceFactory factory;
+    DeviceBroker broker(&factory);
+
+    void* a = broker.Acquire(c_hardware, "player1");
+    void* b = broker.Acquire(c_hardware, "player2");
+    void* warp = broker.Acquire(c_warp, "player3");
+    CHECK(a != nullptr);
+    CHECK(a == b);
+    CHECK(warp != a);
+    CHECK(factory.created == 2);
+    CHECK(broker.ReferenceCount(a) == 2);
+
+    broker.Release(a, "player1");
+    broker.Release(b, "player2");
+    broker.Release(warp, "player3");
+}
+
+TEST_CASE(TheLastReleaseDestroysTheDevice)
+{
+    FakeDeviceFactory factory;
+    DeviceBroker broker(&factory);
+
+    void* a = broker.Acquire(c_hardware, "player1");
+    broker.Acquire(c_hardware, "player2");
+
+    broker.Release(a, "player1");
+    CHECK(factory.destroyed == 0);
+    CHECK(broker.ReferenceCount(a) == 1);
+
+    broker.Release(a, "player2");
+    CHECK(factory.destroyed == 1);
+    CHECK(broker.ReferenceCount(a) == 0);
+
+    DeviceBrokerStats stats = Test::Stats(broker);
+    CHECK(stats.created == 1);
+    CHECK(stats.destroyed == 1);
+    CHECK(stats.acquisitions == 2);
+    CHECK(stats.liveDevices == 0);
+    CHECK(stats.liveReferences == 0);
+}
+
+TEST_CASE(AClientCanOnlyReleaseItsOwnReferences)
+{
+    FakeDeviceFactory factory;
+    DeviceBroker broker(&factory);
+
+    void* device = broker.Acquire(c_hardware, "player1");
+    broker.Release(device, "player2");
+    broker.Release(device, "player2");
+    CHECK(broker.ReferenceCount(device) == 1);
+    CHECK(factory.destroyed == 0);
+
+    broker.Release(device, "player1");
+    // A double release finds nothing left and changes nothing.
+    broker.Release(device, "player1");
+    CHECK(factory.destroyed == 1);
+}
+
+TEST_CASE(ClientReferencesAreCountedAcrossDevices)
+{
+    FakeDeviceFactory factory;
+    DeviceBroker broker(&factory);
+
+    void* hardware = broker.Acquire(c_hardware, "engine1");
+    broker.Acquire(c_hardware, "engine1");
+    void* warp = broker.Acquire(c_warp, "engine1");
+    broker.Acquire(c_warp, "engine2");
+
+    CHECK(broker.ClientReferences("engine1") == 3);
+    CHECK(broker.ClientReferences("engine2") == 1);
+    CHECK(broker.ClientReferences("nobody") == 0);
+
+    broker.Release(hardware, "engine1");
+    broker.Release(hardware, "engine1");
+    broker.Release(warp, "engine1");
+    broker.Release(warp, "engine2");
+    CHECK(Test::Stats(broker).liveDevices == 0);
+}
+
+TEST_CASE(FailedCreationsAreCountedAndRetried)
+{
+    FakeDeviceFactory factory;
+    DeviceBroker broker(&factory);
+
+    factory.fail = true;
+    CHECK(broker.Acquire(c_hardware, "player1") == nullptr);
+    CHECK(Test::Stats(broker).failures == 1);
+
+    factory.fail = false;
+    void* device = broker.Acquire(c_hardware, "player1");
+    CHECK(device != nullptr);
+    broker.Release(device, "player1");
+}
+
+TEST_CASE(TheBrokerDestroysWhatIsStillLive)
+{
+    FakeDeviceFactory factory;
+    {
+        DeviceBroker broker(&factory);
+        broker.Acquire(c_hardware, "leaky");
+    }
+    CHECK(factory.destroyed == 1);
+}
+
+TEST_CASE(ConcurrentFirstUsersGetTheSameDevice)
+{
+    const int c_threads = 8;
+    const int c_rounds = 2000;
+    FakeDeviceFactory factory;
+    DeviceBroker broker(&factory);
+    std::atomic<int> mismatches(0);
+
+    // Keep one reference so the device outlives the churn.
+    void* anchor = broker.Acquire(c_hardware, "anchor");
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < c_threads; t++)
+    {
+        threads.emplace_back([&broker, &mismatches, anchor, t]() {
+            std::string client = "player" + std::to_string(t);
+            for (int i = 0; i < c_rounds; i++)
+            {
+                void* device = broker.Acquire(c_hardware, client);
+                if (device != anchor)
+                {
+                    mismatches++;
+                }
+                void* warp = broker.Acquire(c_warp, client);
+                broker.Release(warp, client);
+                broker.Release(device, client);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    CHECK(mismatches == 0);
+    CHECK(broker.ReferenceCount(anchor) == 1);
+    broker.Release(anchor, "anchor");
+
+    DeviceBrokerStats stats = Test::Stats(broker);
+    CHECK(stats.liveDevices == 0);
+    CHECK(factory.created == factory.destroyed);
+}
@@ -0,0 +1,204 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "ErrorCounters.h"
+
+#include <cwchar>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace MEDIA;
+
+namespace
+{
+    const wchar_t* const c_file = L"C:\\src\\plugin\\MediaEnginePlayer.cpp";
+    const wchar_t* const c_otherFile = L"/home/build/Shared/dllmain.cpp";
+    const uint32_t c_failed = 0x80004005;
+    const uint32_t c_outOfMemory = 0x8007000e;
+}
+
+TEST_CASE(FileNameDropsTheDirectories)
+{
+    CHECK(wcscmp(ErrorSiteFileName(c_file), L"MediaEnginePlayer.cpp") == 0);
+    CHECK(wcscmp(ErrorSiteFileName(c_otherFile), L"dllmain.cpp") == 0);
+    CHECK(wcscmp(ErrorSiteFileName(L"bare.cpp"), L"bare.cpp") == 0);
+    CHECK(wcscmp(ErrorSiteFileName(nullptr), L"") == 0);
+}
+
+TEST_CASE(RepeatedFailuresCountPerSite)
+{
+    std::unique_ptr<ErrorSiteTable> table(new ErrorSiteTable());
+    const wchar_t* fileName = nullptr;
+
+    CHECK(table->Record(c_file, L"Initialize", 10, c_failed, &fileName) == 1);
+    CHECK(wcscmp(fileName, L"MediaEnginePlayer.cpp") == 0);
+    CHECK(table->Record(c_file, L"Initialize", 10, c_failed, nullptr) == 2);
+    CHECK(table->Record(c_file, L"Initialize", 10, c_failed, nullptr) == 3);
+
+    // Another line, HRESULT or file is another site.
+    CHECK(table->Record(c_file, L"Initialize", 11, c_failed, nullptr) == 1);
+    CHECK(table->Record(c_file, L"Initialize", 10, c_outOfMemory, nullptr) == 1);
+    CHECK(table->Record(c_otherFile, L"Initialize", 10, c_failed, nullptr) == 1);
+
+    ErrorCounterStats stats = Test::Stats(*table);
+    CHECK(stats.sites == 4);
+    CHECK(stats.errors == 6);
+    CHECK(stats.overflowed == 0);
+}
+
+TEST_CASE(SnapshotCopiesTheSites)
+{
+    std::unique_ptr<ErrorSiteTable> table(new ErrorSiteTable());
+    table->Record(c_file, L"Play", 20, c_failed, nullptr);
+    table->Record(c_file, L"Play", 20, c_failed, nullptr);
+
+    std::wstring longName(200, L'f');
+    table->Record(c_otherFile, longName.c_str(), 30, c_outOfMemory, nullptr);
+
+    ErrorSiteSample samples[4];
+    REQUIRE(table->Snapshot(samples, 4) == 2);
+    CHECK(table->Snapshot(samples, 1) == 1);
+    CHECK(table->Snapshot(nullptr, 4) == 0);
+
+    uint32_t count = table->Snapshot(samples, 4);
+    bool sawLongName = false;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const ErrorSiteSample& sample = samples[i];
+        if (sample.line == 20)
+        {
+            CHECK(sample.hr == c_failed);
+            CHECK(sample.count == 2);
+            CHECK(wcscmp(sample.file, L"MediaEnginePlayer.cpp") == 0);
+            CHECK(wcscmp(sample.function, L"Play") == 0);
+        }
+        else if (sample.line == 30)
+        {
+            CHECK(wcslen(sample.function) == c_errorSiteNameLength - 1);
+            CHECK(wcscmp(sample.file, L"dllmain.cpp") == 0);
+            sawLongName = (count == 2);
+        }
+    }
+    CHECK(sawLongName);
+}
+
+TEST_CASE(SitesBeyondTheCapacityOverflow)
+{
+    std::unique_ptr<ErrorSiteTable> table(new ErrorSiteTable());
+    for (uint32_t line = 1; line <= ErrorSiteTable::c_capacity; line++)
+    {
+        REQUIRE(table->Record(c_file, L"Fill", line, c_failed, nullptr) == 1);
+    }
+
+    const wchar_t* fileName = nullptr;
+    CHECK(table->Record(c_file, L"Fill", 0, c_failed, &fileName) == 0);
+    CHECK(wcscmp(fileName, L"MediaEnginePlayer.cpp") == 0);
+
+    // Known sites keep counting once the table is full.
+    CHECK(table->Record(c_file, L"Fill", 1, c_failed, nullptr) == 2);
+
+    ErrorCounterStats stats = Test::Stats(*table);
+    CHECK(stats.sites == ErrorSiteTable::c_capacity);
+    CHECK(stats.overflowed == 1);
+    CHECK(stats.errors == ErrorSiteTable::c_capacity + 2);
+}
+
+// Threads failing at the same few sites at once: every failure is counted
+// exactly once and each site gets a single slot.
+TEST_CASE(StressConcurrentRecording)
+{
+    const int c_threads = 4;
+    const uint32_t c_sites = 8;
+    const uint32_t c_rounds = 20000;
+    std::unique_ptr<ErrorSiteTable> table(new ErrorSiteTable());
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < c_threads; t++)
+    {
+        threads.emplace_back([&table]() {
+            for (uint32_t i = 0; i < c_rounds; i++)
+            {
+                table->Record(c_file, L"Render", 100 + (i % c_sites), c_failed, nullptr);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ErrorCounterStats stats = Test::Stats(*table);
+    CHECK(stats.sites == c_sites);
+    CHECK(stats.errors == (uint64_t)c_threads * c_rounds);
+
+    ErrorSiteSample samples[c_sites];
+    REQUIRE(table->Snapshot(samples, c_sites) == c_sites);
+    for (const ErrorSiteSample& sample : samples)
+    {
+        CHECK(sample.count == (uint64_t)c_threads * c_rounds / c_sites);
+    }
+}
+
+TEST_CASE(MessagesAreInternedOnce)
+{
+    std::unique_ptr<ErrorMessageCache> cache(new ErrorMessageCache());
+    CHECK(cache->Find(c_failed) == nullptr);
+
+    const wchar_t* message = cache->Intern(c_failed, L"Unspecified error\r\n", 17);
+    CHECK(wcscmp(message, L"Unspecified error") == 0);
+    CHECK(cache->Find(c_failed) == message);
+    CHECK(cache->Intern(c_failed, L"other text", 10) == message);
+    CHECK(cache->Find(c_outOfMemory) == nullptr);
+
+    ErrorCounterStats stats = {};
+    cache->GetStats(&stats);
+    CHECK(stats.messages == 1);
+    CHECK(stats.messageMisses == 2);
+}
+
+TEST_CASE(AFullMessageCacheReturnsEmptyText)
+{
+    std::unique_ptr<ErrorMessageCache> cache(new ErrorMessageCache());
+    for (uint32_t i = 0; i < ErrorMessageCache::c_capacity; i++)
+    {
+        REQUIRE(wcscmp(cache->Intern(0x80070000 + i, L"x", 1), L"x") == 0);
+    }
+    CHECK(wcscmp(cache->Intern(c_failed, L"late", 4), L"") == 0);
+    CHECK(cache->Find(c_failed) == nullptr);
+
+    // Everything interned before stays findable.
+    CHECK(wcscmp(cache->Find(0x80070000), L"x") == 0);
+}
+
+TEST_CASE(RacingInternsAgreeOnOneCopy)
+{
+    std::unique_ptr<ErrorMessageCache> cache(new ErrorMessageCache());
+    const wchar_t* results[4] = {};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&cache, &results, t]() {
+            results[t] = cache->Intern(c_outOfMemory, L"Not enough memory", 17);
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (const wchar_t* result : results)
+    {
+        CHECK(result == results[0]);
+    }
+    CHECK(cache->Find(c_outOfMemory) == results[0]);
+}
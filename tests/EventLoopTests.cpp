@@ -0,0 +1,311 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "EventLoop.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+
+namespace
+{
+    const uint32_t c_gateEvent = 1000;
+
+    // Records what it handles. The gate event blocks the loop thread in
+    // OnEvent until Release is called, so a test can queue up behind it.
+    class RecordingHandler : public IEventHandler
+    {
+    public:
+        RecordingHandler() : m_starts(0), m_stops(0) {}
+
+        virtual void OnEvent(const QueuedEvent& event)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_events.push_back(event);
+                m_threads.push_back(std::this_thread::get_id());
+            }
+            if (event.id == c_gateEvent)
+            {
+                gate.Enter();
+            }
+        }
+
+        virtual void OnThreadStart()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_starts++;
+        }
+
+        virtual void OnThreadStop()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_stops++;
+        }
+
+        std::vector<QueuedEvent> Events()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_events;
+        }
+
+        std::vector<std::thread::id> Threads()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_threads;
+        }
+
+        int Starts()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_starts;
+        }
+
+        int Stops()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_stops;
+        }
+
+        Test::Gate gate;
+
+    private:
+        std::mutex m_lock;
+        std::vector<QueuedEvent> m_events;
+        std::vector<std::thread::id> m_threads;
+        int m_starts;
+        int m_stops;
+    };
+
+    bool HandledCount(const EventLoop& loop, uint64_t count)
+    {
+        return Test::WaitUntil([&loop, count]() { return Test::Stats(loop).handled == count; });
+    }
+}
+
+TEST_CASE(PostsWhileStoppedAreDropped)
+{
+    RecordingHandler handler;
+    EventLoop loop(&handler);
+    loop.Post(1, 0, 0, false);
+    loop.Post(2, 0, 0, true);
+
+    EventLoopStats stats = Test::Stats(loop);
+    CHECK(stats.posted == 2);
+    CHECK(stats.dropped == 2);
+    CHECK(stats.depth == 0);
+    CHECK(handler.Starts() == 0);
+}
+
+TEST_CASE(EventsAreHandledInOrderOnTheLoopThread)
+{
+    RecordingHandler handler;
+    EventLoop loop(&handler);
+    loop.Start();
+    loop.Start();
+
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        loop.Post(i, i * 10, i + 1, false);
+    }
+    REQUIRE(HandledCount(loop, 100));
+    loop.Stop();
+
+    std::vector<QueuedEvent> events = handler.Events();
+    REQUIRE(events.size() == 100);
+    int wrong = 0;
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        wrong += (events[i].id != i || events[i].param1 != i * 10 || events[i].param2 != i + 1) ? 1 : 0;
+    }
+    CHECK(wrong == 0);
+
+    // One thread, not this one, set up and torn down once.
+    std::vector<std::thread::id> threads = handler.Threads();
+    int elsewhere = 0;
+    for (auto id : threads)
+    {
+        elsewhere += (id != threads[0]) ? 1 : 0;
+    }
+    CHECK(elsewhere == 0);
+    CHECK(threads[0] != std::this_thread::get_id());
+    CHECK(handler.Starts() == 1);
+    CHECK(handler.Stops() == 1);
+
+    EventLoopStats stats = Test::Stats(loop);
+    CHECK(stats.posted == 100 && stats.handled == 100 && stats.dropped == 0);
+    CHECK(stats.wait.count == 100);
+    CHECK(stats.handling.count == 100);
+}
+
+TEST_CASE(AStormOfCoalescingPostsBecomesOneEvent)
+{
+    RecordingHandler handler;
+    EventLoop loop(&handler);
+    loop.Start();
+    loop.Post(c_gateEvent, 0, 0, false);
+    handler.gate.WaitUntilEntered();
+
+    // The first post queues behind the gate; the rest are absorbed and
+    // keep the first one's parameters.
+    for (uint32_t i = 0; i < 50; i++)
+    {
+        loop.Post(7, i, i, true);
+    }
+    loop.Post(8, 0, 0, true);
+
+    EventLoopStats stats = Test::Stats(loop);
+    CHECK(stats.coalesced == 49);
+    CHECK(stats.depth == 2);
+    CHECK(stats.maxDepth == 2);
+
+    handler.gate.Release();
+    REQUIRE(HandledCount(loop, 3));
+    loop.Stop();
+
+    std::vector<QueuedEvent> events = handler.Events();
+    REQUIRE(events.size() == 3);
+    CHECK(events[1].id == 7 && events[1].param1 == 0);
+    CHECK(events[2].id == 8);
+}
+
+TEST_CASE(ACoalescingPostDuringItsOwnHandlingQueuesAnother)
+{
+    RecordingHandler handler;
+    EventLoop loop(&handler);
+    loop.Start();
+
+    // The event being handled is already off the queue, so a change that
+    // comes in meanwhile is not lost.
+    loop.Post(c_gateEvent, 1, 0, true);
+    handler.gate.WaitUntilEntered();
+    loop.Post(c_gateEvent, 2, 0, true);
+    CHECK(Test::Stats(loop).coalesced == 0);
+    CHECK(Test::Stats(loop).depth == 1);
+
+    handler.gate.Release();
+    REQUIRE(HandledCount(loop, 2));
+    loop.Stop();
+    CHECK(handler.Events()[1].param1 == 2);
+}
+
+TEST_CASE(StopDropsWhatIsStillWaiting)
+{
+    RecordingHandler handler;
+    EventLoop loop(&handler);
+    loop.Start();
+    loop.Post(c_gateEvent, 0, 0, false);
+    handler.gate.WaitUntilEntered();
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        loop.Post(i, 0, 0, false);
+    }
+
+    // Stop waits for the handler, so it runs on its own thread; a post
+    // being dropped shows it has begun.
+    std::thread stopper([&loop]() { loop.Stop(); });
+    bool stopping = Test::WaitUntil([&loop]() {
+        loop.Post(99, 0, 0, false);
+        return Test::Stats(loop).dropped > 0;
+    });
+    handler.gate.Release();
+    stopper.join();
+    REQUIRE(stopping);
+
+    EventLoopStats stats = Test::Stats(loop);
+    CHECK(stats.handled == 1);
+    CHECK(stats.depth == 0);
+    CHECK(stats.posted == stats.handled + stats.dropped);
+    CHECK(handler.Events().size() == 1);
+    CHECK(handler.Stops() == 1);
+}
+
+TEST_CASE(TheLoopCanBeRestarted)
+{
+    RecordingHandler handler;
+    EventLoop loop(&handler);
+    loop.Start();
+    loop.Post(1, 0, 0, false);
+    REQUIRE(HandledCount(loop, 1));
+    loop.Stop();
+    loop.Stop();
+
+    loop.Post(2, 0, 0, false);
+    loop.Start();
+    loop.Post(3, 0, 0, false);
+    REQUIRE(HandledCount(loop, 2));
+    loop.Stop();
+
+    std::vector<QueuedEvent> events = handler.Events();
+    REQUIRE(events.size() == 2);
+    CHECK(events[1].id == 3);
+    CHECK(handler.Starts() == 2);
+    CHECK(Test::Stats(loop).dropped == 1);
+}
+
+// Several threads post at once: each one's events come out in its own
+// order, and every post is handled, absorbed or dropped exactly once.
+TEST_CASE(ConcurrentPostersKeepTheirOrder)
+{
+    RecordingHandler handler;
+    EventLoop loop(&handler);
+    loop.Start();
+
+    const int c_posters = 4;
+    const uint32_t c_posts = 5000;
+    std::atomic<int> started(0);
+    std::vector<std::thread> posters;
+    for (int p = 0; p < c_posters; p++)
+    {
+        posters.emplace_back([&loop, &started, p, c_posts]() {
+            started++;
+            while (started.load() < c_posters)
+            {
+                std::this_thread::yield();
+            }
+            for (uint32_t i = 0; i < c_posts; i++)
+            {
+                // a coalescing id per poster mixed into its ordered stream
+                bool coalesce = (i % 8 == 0);
+                loop.Post(coalesce ? 100 + p : p, i, 0, coalesce);
+            }
+        });
+    }
+    for (auto& poster : posters)
+    {
+        poster.join();
+    }
+
+    EventLoopStats stats = Test::Stats(loop);
+    REQUIRE(HandledCount(loop, stats.posted - stats.coalesced));
+    loop.Stop();
+
+    uint64_t next[c_posters] = {};
+    int outOfOrder = 0;
+    for (const QueuedEvent& event : handler.Events())
+    {
+        if (event.id < (uint32_t)c_posters)
+        {
+            outOfOrder += (event.param1 < next[event.id]) ? 1 : 0;
+            next[event.id] = event.param1 + 1;
+        }
+    }
+    CHECK(outOfOrder == 0);
+
+    stats = Test::Stats(loop);
+    CHECK(stats.posted == c_posters * c_posts);
+    CHECK(stats.dropped == 0);
+    CHECK(stats.handled + stats.coalesced == stats.posted);
+}
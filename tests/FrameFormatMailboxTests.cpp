@@ -0,0 +1,335 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "FrameFormatMailbox.h"
+#include "SharedMemory.h"
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+
+namespace
+{
+    // Zeroed like a new file mapping, and aligned like one.
+    struct Memory
+    {
+        Memory() : words((FrameFormatMailbox::c_size + 7) / 8, 0) {}
+        void* Data() { return words.data(); }
+        size_t Size() const { return words.size() * sizeof(uint64_t); }
+        std::vector<uint64_t> words;
+    };
+
+    // The panel only ever sees what the renderer posted together, so every
+    // field is derived from the generation.
+    void PostGeneration(FrameFormatMailbox& mailbox, uint64_t generation)
+    {
+        mailbox.Post(1000 + generation, (uint32_t)generation * 2, (uint32_t)generation * 3, 42, generation);
+    }
+
+    bool IsConsistent(const FrameFormatRecord& record)
+    {
+        return (record.swapChainHandle == 1000 + record.generation) &&
+            (record.width == (uint32_t)record.generation * 2) &&
+            (record.height == (uint32_t)record.generation * 3) &&
+            (record.foregroundProcessId == 42);
+    }
+
+    // Leaves the record as a writer that died half way through a post does:
+    // its version, the word after the header and the epoch counter, odd.
+    void StopHalfWay(Memory& memory)
+    {
+        memory.words[2] |= 1;
+    }
+}
+
+TEST_CASE(AReaderWaitsForAWriterToLayTheMemoryOut)
+{
+    Memory memory;
+    FrameFormatMailbox reader;
+    CHECK(!reader.AttachReader(memory.Data(), memory.Size()));
+    CHECK(!reader.IsAttached());
+
+    FrameFormatMailbox writer;
+    CHECK(!writer.AttachWriter(nullptr, memory.Size()));
+    CHECK(!writer.AttachWriter(memory.Data(), FrameFormatMailbox::c_size - 1));
+    REQUIRE(writer.AttachWriter(memory.Data(), memory.Size()));
+    CHECK(writer.IsAttached());
+
+    CHECK(!reader.AttachReader(memory.Data(), FrameFormatMailbox::c_size - 1));
+    CHECK(reader.AttachReader(memory.Data(), memory.Size()));
+
+    // Nothing posted yet.
+    FrameFormatRecord record;
+    CHECK(!reader.ReadIfChanged(&record));
+}
+
+TEST_CASE(APostIsReadOnce)
+{
+    Memory memory;
+    FrameFormatMailbox writer;
+    FrameFormatMailbox reader;
+    REQUIRE(writer.AttachWriter(memory.Data(), memory.Size()));
+    REQUIRE(reader.AttachReader(memory.Data(), memory.Size()));
+
+    PostGeneration(writer, 1);
+    FrameFormatRecord record = {};
+    REQUIRE(reader.ReadIfChanged(&record));
+    CHECK(IsConsistent(record));
+    CHECK(record.generation == 1 && record.epoch == 1);
+    CHECK(!reader.ReadIfChanged(&record));
+
+    // Only the newest of several posts is seen.
+    PostGeneration(writer, 2);
+    PostGeneration(writer, 3);
+    REQUIRE(reader.ReadIfChanged(&record));
+    CHECK(record.generation == 3 && IsConsistent(record));
+}
+
+TEST_CASE(AnAcknowledgementIsTakenOnce)
+{
+    Memory memory;
+    FrameFormatMailbox writer;
+    FrameFormatMailbox reader;
+    REQUIRE(writer.AttachWriter(memory.Data(), memory.Size()));
+    REQUIRE(reader.AttachReader(memory.Data(), memory.Size()));
+
+    uint64_t generation = 0;
+    CHECK(!writer.TakeAcknowledged(&generation));
+
+    PostGeneration(writer, 5);
+    FrameFormatRecord record;
+    REQUIRE(reader.ReadIfChanged(&record));
+    reader.Acknowledge(record);
+
+    CHECK(writer.TakeAcknowledged(&generation));
+    CHECK(generation == 5);
+    CHECK(!writer.TakeAcknowledged(&generation));
+}
+
+TEST_CASE(ANewWriterIgnoresItsPredecessorsAcknowledgements)
+{
+    Memory memory;
+    FrameFormatMailbox reader;
+    FrameFormatRecord record;
+    {
+        FrameFormatMailbox first;
+        REQUIRE(first.AttachWriter(memory.Data(), memory.Size()));
+        REQUIRE(reader.AttachReader(memory.Data(), memory.Size()));
+        PostGeneration(first, 7);
+        REQUIRE(reader.ReadIfChanged(&record));
+    }
+
+    FrameFormatMailbox second;
+    REQUIRE(second.AttachWriter(memory.Data(), memory.Size()));
+
+    // The panel catches up late on the old renderer's generation 7; the
+    // new one has a generation 7 of its own that is not done with.
+    reader.Acknowledge(record);
+    uint64_t generation = 0;
+    CHECK(!second.TakeAcknowledged(&generation));
+
+    // The same values posted again are still a change to the reader.
+    PostGeneration(second, 7);
+    FrameFormatRecord next;
+    REQUIRE(reader.ReadIfChanged(&next));
+    CHECK(next.epoch == record.epoch + 1);
+    reader.Acknowledge(next);
+    CHECK(second.TakeAcknowledged(&generation));
+    CHECK(generation == 7);
+}
+
+TEST_CASE(AnIncompatibleLayoutIsLeftAlone)
+{
+    Memory memory;
+    FrameFormatMailbox writer;
+    REQUIRE(writer.AttachWriter(memory.Data(), memory.Size()));
+    PostGeneration(writer, 1);
+
+    // The version follows the magic; both are part of the contract
+    // between builds of the two processes.
+    uint32_t version = FrameFormatMailbox::c_layoutVersion + 1;
+    std::memcpy(static_cast<uint8_t*>(memory.Data()) + sizeof(uint32_t), &version, sizeof(version));
+
+    FrameFormatMailbox other;
+    CHECK(!other.AttachWriter(memory.Data(), memory.Size()));
+    CHECK(!other.AttachReader(memory.Data(), memory.Size()));
+    CHECK(!other.IsAttached());
+}
+
+TEST_CASE(AReaderGivesUpOnAWriterThatDiedMidPost)
+{
+    Memory memory;
+    FrameFormatRecord record;
+    {
+        FrameFormatMailbox dead;
+        REQUIRE(dead.AttachWriter(memory.Data(), memory.Size()));
+        PostGeneration(dead, 1);
+    }
+    StopHalfWay(memory);
+
+    FrameFormatMailbox reader;
+    REQUIRE(reader.AttachReader(memory.Data(), memory.Size()));
+    for (uint32_t i = 1; i <= 5; i++)
+    {
+        CHECK(!reader.ReadIfChanged(&record));
+        CHECK(reader.BusyReads() == i);
+    }
+
+    // A new writer neither waits for the old post nor gets stuck behind it.
+    FrameFormatMailbox writer;
+    REQUIRE(writer.AttachWriter(memory.Data(), memory.Size()));
+    PostGeneration(writer, 4);
+    REQUIRE(reader.ReadIfChanged(&record));
+    CHECK(reader.BusyReads() == 0);
+    CHECK(record.generation == 4 && IsConsistent(record));
+    CHECK(record.epoch == 2);
+}
+
+TEST_CASE(AWriterGivesUpOnAReaderThatDiedMidAcknowledgement)
+{
+    Memory memory;
+    FrameFormatMailbox writer;
+    FrameFormatMailbox reader;
+    REQUIRE(writer.AttachWriter(memory.Data(), memory.Size()));
+    REQUIRE(reader.AttachReader(memory.Data(), memory.Size()));
+    PostGeneration(writer, 1);
+    FrameFormatRecord record;
+    REQUIRE(reader.ReadIfChanged(&record));
+
+    // The ack follows the record: five words of record after its version.
+    memory.words[2 + 1 + 5] |= 1;
+    uint64_t generation = 0;
+    CHECK(!writer.TakeAcknowledged(&generation));
+    CHECK(writer.BusyReads() == 1);
+
+    // The reader's next acknowledgement gets it going again.
+    reader.Acknowledge(record);
+    CHECK(writer.TakeAcknowledged(&generation));
+    CHECK(generation == 1);
+}
+
+#if !defined(_WIN32)
+TEST_CASE(TheMailboxWorksAcrossMappings)
+{
+    std::string name = "FrameFormatMailboxTest_" + std::to_string(getpid());
+    MEDIA::SharedMemory::Remove(name);
+
+    MEDIA::SharedMemory background;
+    REQUIRE(background.Create(name, FrameFormatMailbox::c_size));
+    MEDIA::SharedMemory foreground;
+    REQUIRE(foreground.Open(name, false));
+    CHECK(background.Data() != foreground.Data());
+
+    FrameFormatMailbox writer;
+    FrameFormatMailbox reader;
+    REQUIRE(writer.AttachWriter(background.Data(), background.Size()));
+    REQUIRE(reader.AttachReader(foreground.Data(), foreground.Size()));
+
+    PostGeneration(writer, 3);
+    FrameFormatRecord record;
+    REQUIRE(reader.ReadIfChanged(&record));
+    CHECK(record.generation == 3 && IsConsistent(record));
+    reader.Acknowledge(record);
+
+    uint64_t generation = 0;
+    CHECK(writer.TakeAcknowledged(&generation));
+    CHECK(generation == 3);
+}
+#endif
+
+// The renderer posting as fast as it can while the panel reads and
+// acknowledges: records are never torn, and both sides only ever see
+// generations move forward.
+TEST_CASE(PostsAndAcknowledgementsRaceCleanly)
+{
+    Memory memory;
+    FrameFormatMailbox writer;
+    FrameFormatMailbox reader;
+    REQUIRE(writer.AttachWriter(memory.Data(), memory.Size()));
+    REQUIRE(reader.AttachReader(memory.Data(), memory.Size()));
+
+    const uint64_t c_posts = 100000;
+    std::atomic<bool> started(false);
+    std::atomic<bool> done(false);
+    int torn = 0;
+    int backwards = 0;
+    uint64_t reads = 0;
+    std::thread panel([&]() {
+        started = true;
+        uint64_t last = 0;
+        FrameFormatRecord record;
+        for (;;)
+        {
+            // done first: once it is seen, so is the last post
+            bool finished = done.load();
+            if (!reader.ReadIfChanged(&record))
+            {
+                if (finished)
+                {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            torn += IsConsistent(record) ? 0 : 1;
+            backwards += (record.generation <= last) ? 1 : 0;
+            last = record.generation;
+            reads++;
+            reader.Acknowledge(record);
+        }
+    });
+
+    while (!started.load())
+    {
+        std::this_thread::yield();
+    }
+
+    uint64_t lastAcknowledged = 0;
+    int ackBackwards = 0;
+    int ackAhead = 0;
+    for (uint64_t generation = 1; generation <= c_posts; generation++)
+    {
+        PostGeneration(writer, generation);
+        uint64_t acknowledged;
+        if (writer.TakeAcknowledged(&acknowledged))
+        {
+            ackBackwards += (acknowledged < lastAcknowledged) ? 1 : 0;
+            ackAhead += (acknowledged > generation) ? 1 : 0;
+            lastAcknowledged = acknowledged;
+        }
+        if (generation % 1024 == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    done = true;
+    panel.join();
+
+    CHECK(torn == 0);
+    CHECK(backwards == 0);
+    CHECK(ackBackwards == 0);
+    CHECK(ackAhead == 0);
+    CHECK(reads > 0);
+
+    // The last post is the last thing the panel acknowledged.
+    uint64_t acknowledged = lastAcknowledged;
+    writer.TakeAcknowledged(&acknowledged);
+    CHECK(acknowledged == c_posts);
+}
@@ -0,0 +1,75 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Handoff throughput of FrameSlotRing: publish and acquire on one thread,
+// then with the producer and consumer on their own threads.
+
+#include "Benchmark.h"
+#include "FrameSlotRing.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace MEDIA;
+
+int main()
+{
+    const uint64_t iterations = 20000000;
+
+    {
+        FrameSlotRing<3> ring;
+        Bench::Run("publish", iterations, [&ring](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                ring.Publish();
+            }
+        });
+    }
+
+    {
+        FrameSlotRing<3> ring;
+        uint32_t slot = 0;
+        Bench::Run("publish + acquire, one thread", iterations, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                ring.Publish();
+                ring.AcquireLatest(&slot);
+            }
+        });
+        Bench::KeepAlive(slot);
+    }
+
+    {
+        FrameSlotRing<3> ring;
+        std::atomic<bool> finished(false);
+        uint64_t acquired = 0;
+        Bench::Run("publish, consumer spinning on another thread", iterations, [&](uint64_t n) {
+            std::thread consumer([&]() {
+                while (!finished.load(std::memory_order_acquire))
+                {
+                    if (ring.AcquireLatest(nullptr))
+                    {
+                        acquired++;
+                    }
+                }
+            });
+            for (uint64_t i = 0; i < n; i++)
+            {
+                ring.Publish();
+            }
+            finished.store(true, std::memory_order_release);
+            consumer.join();
+        });
+        printf("%-48s %12llu frames acquired\n", "", (unsigned long long)acquired);
+    }
+
+    return 0;
+}
@@ -0,0 +1,233 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "FrameSlotRing.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+using namespace MEDIA;
+
+TEST_CASE(NothingIsReadyAfterReset)
+{
+    FrameSlotRing<3> ring;
+    uint32_t slot = 99;
+    CHECK(!ring.AcquireLatest(&slot));
+    CHECK(slot == ring.ReadSlot());
+
+    FrameSlotRingStats stats;
+    ring.GetStats(&stats);
+    CHECK(stats.stale == 1);
+    CHECK(stats.acquired == 0);
+}
+
+TEST_CASE(AcquireReturnsThePublishedSlot)
+{
+    FrameSlotRing<3> ring;
+    uint32_t written = ring.WriteSlot();
+    CHECK(written != ring.ReadSlot());
+    ring.Publish();
+
+    uint32_t slot = 99;
+    CHECK(ring.AcquireLatest(&slot));
+    CHECK(slot == written);
+    CHECK(ring.ReadSlot() == written);
+
+    // Nothing new since, so the same slot again.
+    CHECK(!ring.AcquireLatest(&slot));
+    CHECK(slot == written);
+}
+
+TEST_CASE(OnlyTheNewestOfSeveralFramesIsAcquired)
+{
+    FrameSlotRing<4> ring;
+    uint32_t last = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        last = ring.WriteSlot();
+        ring.Publish();
+    }
+
+    uint32_t slot;
+    CHECK(ring.AcquireLatest(&slot));
+    CHECK(slot == last);
+
+    FrameSlotRingStats stats;
+    ring.GetStats(&stats);
+    CHECK(stats.published == 5);
+    CHECK(stats.overwritten == 4);
+    CHECK(stats.acquired == 1);
+}
+
+TEST_CASE(ProducerNeverWritesTheSlotBeingRead)
+{
+    FrameSlotRing<3> ring;
+    for (int i = 0; i < 1000; i++)
+    {
+        if ((i % 3) == 0)
+        {
+            ring.AcquireLatest(nullptr);
+        }
+        CHECK(ring.WriteSlot() != ring.ReadSlot());
+        CHECK(ring.WriteSlot() < ring.Count());
+        ring.Publish();
+    }
+}
+
+TEST_CASE(ResetReturnsEverySlot)
+{
+    FrameSlotRing<5> ring;
+    for (int i = 0; i < 7; i++)
+    {
+        ring.Publish();
+        ring.AcquireLatest(nullptr);
+    }
+
+    ring.Reset();
+    CHECK(ring.ReadSlot() == 0);
+    CHECK(!ring.AcquireLatest(nullptr));
+}
+
+// The producer stamps each slot with an increasing frame number while it
+// owns it; the consumer must only ever see complete, non-decreasing
+// frames in slots nobody else is writing.
+TEST_CASE(StressOneProducerOneConsumer)
+{
+    const uint32_t c_slots = 3;
+    const uint64_t c_frames = 500000;
+
+    FrameSlotRing<c_slots> ring;
+    std::atomic<uint64_t> begun[c_slots];
+    std::atomic<uint64_t> done[c_slots];
+    for (uint32_t i = 0; i < c_slots; i++)
+    {
+        begun[i] = 0;
+        done[i] = 0;
+    }
+
+    std::atomic<bool> finished(false);
+    std::thread producer([&]() {
+        for (uint64_t frame = 1; frame <= c_frames; frame++)
+        {
+            uint32_t slot = ring.WriteSlot();
+            begun[slot].store(frame, std::memory_order_relaxed);
+            done[slot].store(frame, std::memory_order_relaxed);
+            ring.Publish();
+        }
+        finished.store(true, std::memory_order_release);
+    });
+
+    uint64_t lastFrame = 0;
+    uint64_t torn = 0;
+    uint64_t backwards = 0;
+    uint64_t acquired = 0;
+    for (;;)
+    {
+        bool last = finished.load(std::memory_order_acquire);
+        uint32_t slot;
+        if (ring.AcquireLatest(&slot))
+        {
+            uint64_t frame = done[slot].load(std::memory_order_relaxed);
+            if (begun[slot].load(std::memory_order_relaxed) != frame)
+            {
+                torn++;
+            }
+            if (frame <= lastFrame)
+            {
+                backwards++;
+            }
+            lastFrame = frame;
+            acquired++;
+        }
+        if (last)
+        {
+            break;
+        }
+    }
+    producer.join();
+
+    CHECK(torn == 0);
+    CHECK(backwards == 0);
+    CHECK(lastFrame == c_frames);
+
+    FrameSlotRingStats stats;
+    ring.GetStats(&stats);
+    CHECK(stats.published == c_frames);
+    CHECK(stats.acquired == acquired);
+    CHECK(stats.acquired + stats.overwritten == c_frames);
+}
+
+// Two consumer paths are fine as long as they take turns, which is what
+// MEPlayer's exclusive lock does: neither ever reads a slot the producer
+// is writing.
+TEST_CASE(StressSerializedConsumers)
+{
+    const uint32_t c_slots = 3;
+    const uint64_t c_frames = 200000;
+
+    FrameSlotRing<c_slots> ring;
+    std::atomic<uint64_t> begun[c_slots];
+    std::atomic<uint64_t> done[c_slots];
+    for (uint32_t i = 0; i < c_slots; i++)
+    {
+        begun[i] = 0;
+        done[i] = 0;
+    }
+
+    std::atomic<bool> finished(false);
+    std::atomic<uint64_t> torn(0);
+    std::atomic_flag consumerLock = ATOMIC_FLAG_INIT;
+
+    std::thread producer([&]() {
+        for (uint64_t frame = 1; frame <= c_frames; frame++)
+        {
+            uint32_t slot = ring.WriteSlot();
+            begun[slot].store(frame, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            done[slot].store(frame, std::memory_order_relaxed);
+            ring.Publish();
+        }
+        finished.store(true, std::memory_order_release);
+    });
+
+    auto consume = [&]() {
+        while (!finished.load(std::memory_order_acquire))
+        {
+            while (consumerLock.test_and_set(std::memory_order_acquire))
+            {
+            }
+            uint32_t slot;
+            ring.AcquireLatest(&slot);
+            // Look twice, so a producer that moved into the slot while we
+            // held it shows up as a mismatch.
+            for (int look = 0; look < 2; look++)
+            {
+                uint64_t frame = done[slot].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (begun[slot].load(std::memory_order_relaxed) != frame)
+                {
+                    torn.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            consumerLock.clear(std::memory_order_release);
+        }
+    };
+
+    std::thread renderEvent(consume);
+    std::thread acquireExport(consume);
+    producer.join();
+    renderEvent.join();
+    acquireExport.join();
+
+    CHECK(torn.load() == 0);
+}
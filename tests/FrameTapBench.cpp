@@ -0,0 +1,85 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Cost of publishing a frame into the tap and of a reader picking it up,
+// at the sizes the plugin taps most often.
+
+#include "Benchmark.h"
+#include "FrameTap.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace MEDIA;
+
+int main()
+{
+    const uint32_t sizes[][2] = { { 640, 360 }, { 1280, 720 }, { 1920, 1080 } };
+    const uint32_t slots = 3;
+    const uint64_t frames = 500;
+
+    for (const auto& size : sizes)
+    {
+        const uint32_t width = size[0];
+        const uint32_t height = size[1];
+        const uint32_t frameBytes = width * height * 4;
+        size_t blockBytes = FrameTapRequiredBytes(slots, frameBytes);
+        std::vector<uint64_t> block((blockBytes + 7) / 8);
+        std::vector<uint8_t> frame(frameBytes, 0x80);
+        std::vector<uint8_t> copy(frameBytes);
+
+        FrameTapWriter writer(block.data(), blockBytes, slots, frameBytes);
+        FrameTapReader reader(block.data(), blockBytes);
+
+        char name[64];
+        snprintf(name, sizeof(name), "write %ux%u", width, height);
+        double perWrite = Bench::Run(name, frames, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                writer.Write(frame.data(), width * 4, width, height, c_frameTapFormatBGRA8, (int64_t)i);
+            }
+        });
+        printf("%-48s %12.2f GB/s\n", "", frameBytes / perWrite);
+
+        // The reader copies out, as a consumer that keeps the frame would.
+        snprintf(name, sizeof(name), "read and copy %ux%u", width, height);
+        Bench::Run(name, frames, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                const uint8_t* pixels;
+                FrameTapInfo info;
+                FrameTapReadToken token;
+                if (reader.BeginRead(&pixels, &info, &token))
+                {
+                    memcpy(copy.data(), pixels, (size_t)info.stride * info.height);
+                    Bench::KeepAlive(reader.EndRead(token));
+                }
+            }
+        });
+
+        snprintf(name, sizeof(name), "read in place %ux%u", width, height);
+        Bench::Run(name, frames * 1000, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                const uint8_t* pixels;
+                FrameTapInfo info;
+                FrameTapReadToken token;
+                if (reader.BeginRead(&pixels, &info, &token))
+                {
+                    Bench::KeepAlive(pixels[0]);
+                    Bench::KeepAlive(reader.EndRead(token));
+                }
+            }
+        });
+    }
+
+    return 0;
+}
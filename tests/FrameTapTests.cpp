@@ -0,0 +1,370 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "FrameTap.h"
+#include "SharedMemory.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+using namespace MEDIA;
+
+namespace
+{
+    // 64 bit elements keep the block aligned like a real mapping.
+    class Block
+    {
+    public:
+        explicit Block(size_t size) : m_words((size + 7) / 8), m_size(size) {}
+
+        void* Data()
+        {
+            return m_words.data();
+        }
+
+        size_t Size() const
+        {
+            return m_size;
+        }
+
+    private:
+        std::vector<uint64_t> m_words;
+        size_t m_size;
+    };
+
+    std::vector<uint8_t> MakeFrame(uint32_t width, uint32_t height, uint8_t fill)
+    {
+        return std::vector<uint8_t>((size_t)width * height * 4, fill);
+    }
+
+    bool WriteFrame(FrameTapWriter& writer, uint32_t width, uint32_t height, uint8_t fill, int64_t timestamp = 0)
+    {
+        std::vector<uint8_t> frame = MakeFrame(width, height, fill);
+        return writer.Write(frame.data(), width * 4, width, height, c_frameTapFormatBGRA8, timestamp);
+    }
+
+#if !defined(_WIN32)
+    std::string UniqueName(const char* what)
+    {
+        return std::string("FrameTapTest_") + what + "_" + std::to_string(getpid());
+    }
+#endif
+}
+
+TEST_CASE(RequiredBytesRespectsTheLimits)
+{
+    CHECK(FrameTapRequiredBytes(0, 16) == 0);
+    CHECK(FrameTapRequiredBytes(2, 0) == 0);
+    CHECK(FrameTapRequiredBytes(c_frameTapMaxSlots + 1, 16) == 0);
+    CHECK(FrameTapRequiredBytes(2, c_frameTapMaxSlotBytes + 1) == 0);
+
+    // Slots are cache line aligned, each with its own header.
+    CHECK(FrameTapRequiredBytes(1, 1) == sizeof(FrameTapHeader) + sizeof(FrameTapSlot) + 64);
+    CHECK(FrameTapRequiredBytes(3, 128) == sizeof(FrameTapHeader) + 3 * (sizeof(FrameTapSlot) + 128));
+
+    // The largest layout is computed without wrapping.
+    uint64_t largest = sizeof(FrameTapHeader) +
+        (uint64_t)c_frameTapMaxSlots * (sizeof(FrameTapSlot) + c_frameTapMaxSlotBytes);
+    if (largest <= (uint64_t)SIZE_MAX)
+    {
+        CHECK(FrameTapRequiredBytes(c_frameTapMaxSlots, c_frameTapMaxSlotBytes) == (size_t)largest);
+    }
+}
+
+TEST_CASE(WriterNeedsEnoughRoom)
+{
+    size_t required = FrameTapRequiredBytes(2, 256);
+    Block block(required);
+    CHECK(!FrameTapWriter(block.Data(), required - 1, 2, 256).IsValid());
+    CHECK(!FrameTapWriter(nullptr, required, 2, 256).IsValid());
+    CHECK(FrameTapWriter(block.Data(), required, 2, 256).IsValid());
+}
+
+TEST_CASE(ReaderSeesTheLatestFrame)
+{
+    size_t size = FrameTapRequiredBytes(3, 8 * 8 * 4);
+    Block block(size);
+    FrameTapWriter writer(block.Data(), size, 3, 8 * 8 * 4);
+    FrameTapReader reader(block.Data(), size);
+    REQUIRE(reader.IsValid());
+
+    const uint8_t* pixels = nullptr;
+    FrameTapInfo info;
+    FrameTapReadToken token;
+    CHECK(reader.Latest() == 0);
+    CHECK(!reader.BeginRead(&pixels, &info, &token));
+
+    for (uint8_t i = 1; i <= 5; i++)
+    {
+        REQUIRE(WriteFrame(writer, 8, 4, i, 1000 * i));
+    }
+
+    CHECK(reader.Latest() == 5);
+    REQUIRE(reader.BeginRead(&pixels, &info, &token));
+    CHECK(info.width == 8 && info.height == 4 && info.stride == 32);
+    CHECK(info.format == c_frameTapFormatBGRA8);
+    CHECK(info.frameNumber == 5);
+    CHECK(info.timestamp == 5000);
+    CHECK(pixels[0] == 5 && pixels[8 * 4 * 4 - 1] == 5);
+    CHECK(reader.EndRead(token));
+}
+
+TEST_CASE(StridedSourcesArePacked)
+{
+    size_t size = FrameTapRequiredBytes(1, 4 * 2 * 4);
+    Block block(size);
+    FrameTapWriter writer(block.Data(), size, 1, 4 * 2 * 4);
+
+    // Two rows of four pixels with eight bytes of padding each.
+    std::vector<uint8_t> source(2 * 24, 0xee);
+    memset(source.data(), 1, 16);
+    memset(source.data() + 24, 2, 16);
+    REQUIRE(writer.Write(source.data(), 24, 4, 2, c_frameTapFormatBGRA8, 0));
+
+    FrameTapReader reader(block.Data(), size);
+    const uint8_t* pixels;
+    FrameTapInfo info;
+    FrameTapReadToken token;
+    REQUIRE(reader.BeginRead(&pixels, &info, &token));
+    CHECK(info.stride == 16);
+    CHECK(pixels[15] == 1 && pixels[16] == 2 && pixels[31] == 2);
+}
+
+TEST_CASE(FramesThatDoNotFitAreDropped)
+{
+    size_t size = FrameTapRequiredBytes(2, 4 * 4 * 4);
+    Block block(size);
+    FrameTapWriter writer(block.Data(), size, 2, 4 * 4 * 4);
+
+    CHECK(!WriteFrame(writer, 8, 4, 1));
+    std::vector<uint8_t> frame = MakeFrame(4, 4, 1);
+    CHECK(!writer.Write(frame.data(), 16, 0, 4, c_frameTapFormatBGRA8, 0));
+    CHECK(!writer.Write(frame.data(), 8, 4, 4, c_frameTapFormatBGRA8, 0));
+    CHECK(WriteFrame(writer, 4, 4, 1));
+
+    FrameTapStats stats;
+    writer.GetStats(&stats);
+    CHECK(stats.written == 1);
+    CHECK(stats.dropped == 3);
+}
+
+TEST_CASE(ReaderRejectsBadHeaders)
+{
+    size_t size = FrameTapRequiredBytes(2, 256);
+    Block block(size);
+    FrameTapWriter writer(block.Data(), size, 2, 256);
+    FrameTapHeader* header = static_cast<FrameTapHeader*>(block.Data());
+
+    CHECK(!FrameTapReader(block.Data(), size - 1).IsValid());
+    CHECK(!FrameTapReader(block.Data(), sizeof(FrameTapHeader) - 1).IsValid());
+
+    header->slotCount = c_frameTapMaxSlots + 1;
+    CHECK(!FrameTapReader(block.Data(), size).IsValid());
+    header->slotCount = 2;
+
+    // A stride too small for its slot would let slots overlap.
+    header->slotStride = 256;
+    CHECK(!FrameTapReader(block.Data(), size).IsValid());
+    header->slotStride = sizeof(FrameTapSlot) + 256;
+
+    header->version = c_frameTapVersion + 1;
+    CHECK(!FrameTapReader(block.Data(), size).IsValid());
+    header->version = c_frameTapVersion;
+
+    header->magic = 0;
+    CHECK(!FrameTapReader(block.Data(), size).IsValid());
+    header->magic = c_frameTapMagic;
+    CHECK(FrameTapReader(block.Data(), size).IsValid());
+}
+
+TEST_CASE(EndReadFailsOnceTheSlotIsReused)
+{
+    size_t size = FrameTapRequiredBytes(2, 64);
+    Block block(size);
+    FrameTapWriter writer(block.Data(), size, 2, 64);
+    FrameTapReader reader(block.Data(), size);
+    REQUIRE(WriteFrame(writer, 4, 4, 1));
+
+    const uint8_t* pixels;
+    FrameTapInfo info;
+    FrameTapReadToken token;
+    REQUIRE(reader.BeginRead(&pixels, &info, &token));
+
+    // The next frame goes to the other slot, the one after to ours.
+    REQUIRE(WriteFrame(writer, 4, 4, 2));
+    CHECK(reader.EndRead(token));
+    REQUIRE(WriteFrame(writer, 4, 4, 3));
+    CHECK(!reader.EndRead(token));
+}
+
+// A writer thread fills every frame with its own number; a read that
+// EndRead accepts must never mix two frames.
+TEST_CASE(StressReaderAgainstWriter)
+{
+    const uint32_t c_width = 64;
+    const uint32_t c_height = 64;
+    size_t size = FrameTapRequiredBytes(2, c_width * c_height * 4);
+    Block block(size);
+    FrameTapWriter writer(block.Data(), size, 2, c_width * c_height * 4);
+    FrameTapReader reader(block.Data(), size);
+    std::atomic<bool> finished(false);
+
+    std::thread producer([&]() {
+        std::vector<uint8_t> frame = MakeFrame(c_width, c_height, 0);
+        for (uint32_t i = 1; i <= 20000; i++)
+        {
+            memset(frame.data(), (uint8_t)i, frame.size());
+            writer.Write(frame.data(), c_width * 4, c_width, c_height, c_frameTapFormatBGRA8, i);
+        }
+        finished.store(true);
+    });
+
+    uint64_t accepted = 0;
+    uint64_t torn = 0;
+    std::vector<uint8_t> copy(c_width * c_height * 4);
+    for (;;)
+    {
+        // one more read after the writer stops, which always succeeds
+        bool last = finished.load();
+        const uint8_t* pixels;
+        FrameTapInfo info;
+        FrameTapReadToken token;
+        if (reader.BeginRead(&pixels, &info, &token))
+        {
+            memcpy(copy.data(), pixels, copy.size());
+            if (reader.EndRead(token))
+            {
+                accepted++;
+                uint8_t expected = (uint8_t)info.frameNumber;
+                for (uint8_t value : copy)
+                {
+                    if (value != expected)
+                    {
+                        torn++;
+                        break;
+                    }
+                }
+            }
+        }
+        if (last)
+        {
+            break;
+        }
+    }
+    producer.join();
+
+    CHECK(torn == 0);
+    CHECK(accepted > 0);
+}
+
+#if !defined(_WIN32)
+TEST_CASE(SharedMemoryIsVisibleThroughOpen)
+{
+    std::string name = UniqueName("open");
+    SharedMemory::Remove(name);
+
+    SharedMemory creator;
+    REQUIRE(creator.Create(name, 4096));
+    CHECK(creator.Size() == 4096);
+    CHECK(static_cast<uint8_t*>(creator.Data())[4095] == 0);
+
+    SharedMemory viewer;
+    REQUIRE(viewer.Open(name, true));
+    CHECK(viewer.Size() == 4096);
+
+    static_cast<uint8_t*>(creator.Data())[100] = 42;
+    CHECK(static_cast<const uint8_t*>(viewer.Data())[100] == 42);
+}
+
+TEST_CASE(SharedMemoryCreateLeavesExistingNamesAlone)
+{
+    std::string name = UniqueName("exists");
+    SharedMemory::Remove(name);
+
+    SharedMemory first;
+    REQUIRE(first.Create(name, 4096));
+    static_cast<uint8_t*>(first.Data())[0] = 7;
+
+    SharedMemory second;
+    CHECK(!second.Create(name, 4096));
+    CHECK(second.LastError() == EEXIST);
+    CHECK(static_cast<uint8_t*>(first.Data())[0] == 7);
+
+    // Once the stale name is removed by hand the create goes through,
+    // and the first mapping stays usable.
+    CHECK(SharedMemory::Remove(name));
+    CHECK(second.Create(name, 4096));
+    CHECK(static_cast<uint8_t*>(first.Data())[0] == 7);
+}
+
+TEST_CASE(SharedMemoryNameGoesAwayWithItsCreator)
+{
+    std::string name = UniqueName("close");
+    SharedMemory::Remove(name);
+
+    SharedMemory viewer;
+    {
+        SharedMemory creator;
+        REQUIRE(creator.Create(name, 4096));
+        static_cast<uint8_t*>(creator.Data())[1] = 9;
+        REQUIRE(viewer.Open(name, true));
+    }
+
+    // The open view survives, the name does not.
+    CHECK(static_cast<const uint8_t*>(viewer.Data())[1] == 9);
+    SharedMemory late;
+    CHECK(!late.Open(name, true));
+    CHECK(late.LastError() == ENOENT);
+}
+
+TEST_CASE(SharedMemoryRejectsBadNames)
+{
+    SharedMemory memory;
+    CHECK(!memory.Create("", 16));
+    CHECK(!memory.Create("a/b", 16));
+    CHECK(!memory.Create(UniqueName("zero"), 0));
+    CHECK(memory.LastError() == EINVAL);
+    CHECK(!SharedMemory::Remove("a/b"));
+}
+
+TEST_CASE(FrameTapAcrossSharedMemory)
+{
+    std::string name = UniqueName("tap");
+    SharedMemory::Remove(name);
+
+    size_t size = FrameTapRequiredBytes(3, 16 * 16 * 4);
+    SharedMemory producer;
+    REQUIRE(producer.Create(name, size));
+    FrameTapWriter writer(producer.Data(), producer.Size(), 3, 16 * 16 * 4);
+    REQUIRE(writer.IsValid());
+    REQUIRE(WriteFrame(writer, 16, 16, 0x3c));
+
+    SharedMemory consumer;
+    REQUIRE(consumer.Open(name, true));
+    FrameTapReader reader(consumer.Data(), consumer.Size());
+    REQUIRE(reader.IsValid());
+
+    const uint8_t* pixels;
+    FrameTapInfo info;
+    FrameTapReadToken token;
+    REQUIRE(reader.BeginRead(&pixels, &info, &token));
+    CHECK(info.width == 16 && pixels[16 * 16 * 4 - 1] == 0x3c);
+    CHECK(reader.EndRead(token));
+}
+#endif
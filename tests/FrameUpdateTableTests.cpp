@@ -0,0 +1,271 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "FrameSlotRing.h"
+#include "FrameUpdateTable.h"
+#include "HandleTable.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace MEDIA;
+
+namespace
+{
+    const uint32_t c_players = 4;
+
+    struct FrameUpdate
+    {
+        int32_t handle;
+        void* textureSRV;
+        bool newFrame;
+    };
+
+    typedef FrameUpdateTable<FrameUpdate, c_players> UpdateTable;
+
+    // A player as the render event sees it: a frame ring whose consumers
+    // are serialized by a lock, like MEPlayer::AcquireLatestTexture.
+    class SimulatedPlayer
+    {
+    public:
+        void PresentFrame()
+        {
+            m_ring.Publish();
+        }
+
+        bool AcquireLatest(void** texture)
+        {
+            std::lock_guard<std::mutex> lock(m_consumerLock);
+            uint32_t slot;
+            bool newFrame = m_ring.AcquireLatest(&slot);
+            *texture = &m_textures[slot];
+            return newFrame;
+        }
+
+    private:
+        FrameSlotRing<3> m_ring;
+        std::mutex m_consumerLock;
+        int m_textures[3];
+    };
+
+    typedef HandleTable<std::shared_ptr<SimulatedPlayer>, c_players> PlayerTable;
+
+    // What OnRenderEvent does: one walk over every player, one batch.
+    void RenderEvent(PlayerTable& players, UpdateTable& updates)
+    {
+        FrameUpdate batch[c_players] = {};
+        players.ForEach([&batch](PlayerTable::Handle handle, std::shared_ptr<SimulatedPlayer>& player) {
+            int32_t index = PlayerTable::SlotIndex(handle);
+            if (index < 0 || player == nullptr)
+            {
+                return;
+            }
+            batch[index].handle = handle;
+            batch[index].newFrame = player->AcquireLatest(&batch[index].textureSRV);
+        });
+        updates.Publish(batch);
+    }
+
+    uint32_t NewFrames(const FrameUpdate* updates, uint32_t count)
+    {
+        uint32_t frames = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            frames += updates[i].newFrame ? 1 : 0;
+        }
+        return frames;
+    }
+}
+
+TEST_CASE(AnEmptyTableReportsNothing)
+{
+    UpdateTable updates;
+    FrameUpdate taken[c_players];
+    CHECK(updates.Take(taken, c_players) == 0);
+    CHECK(updates.Take(nullptr, c_players) == 0);
+}
+
+TEST_CASE(OneEventUpdatesEveryPlayer)
+{
+    PlayerTable players;
+    UpdateTable updates;
+    auto first = std::make_shared<SimulatedPlayer>();
+    auto second = std::make_shared<SimulatedPlayer>();
+    auto idle = std::make_shared<SimulatedPlayer>();
+    PlayerTable::Handle firstHandle = players.Insert(first);
+    PlayerTable::Handle secondHandle = players.Insert(second);
+    PlayerTable::Handle idleHandle = players.Insert(idle);
+
+    first->PresentFrame();
+    second->PresentFrame();
+    RenderEvent(players, updates);
+
+    FrameUpdate taken[c_players];
+    REQUIRE(updates.Take(taken, c_players) == 3);
+    CHECK(taken[0].handle == firstHandle && taken[0].newFrame);
+    CHECK(taken[1].handle == secondHandle && taken[1].newFrame);
+    CHECK(taken[2].handle == idleHandle && !taken[2].newFrame);
+    CHECK(taken[0].textureSRV != nullptr && taken[0].textureSRV != taken[1].textureSRV);
+
+    // Taking clears the flags, not the entries.
+    REQUIRE(updates.Take(taken, c_players) == 3);
+    CHECK(NewFrames(taken, 3) == 0);
+}
+
+TEST_CASE(ANewFrameWaitsUntilItIsTaken)
+{
+    PlayerTable players;
+    UpdateTable updates;
+    auto player = std::make_shared<SimulatedPlayer>();
+    players.Insert(player);
+
+    player->PresentFrame();
+    RenderEvent(players, updates);
+    // Unity renders twice more before the script polls.
+    RenderEvent(players, updates);
+    RenderEvent(players, updates);
+
+    FrameUpdate taken[c_players];
+    REQUIRE(updates.Take(taken, c_players) == 1);
+    CHECK(taken[0].newFrame);
+    REQUIRE(updates.Take(taken, c_players) == 1);
+    CHECK(!taken[0].newFrame);
+}
+
+TEST_CASE(AReplacedPlayerDoesNotInheritTheFlag)
+{
+    PlayerTable players;
+    UpdateTable updates;
+    auto old = std::make_shared<SimulatedPlayer>();
+    PlayerTable::Handle oldHandle = players.Insert(old);
+    old->PresentFrame();
+    RenderEvent(players, updates);
+
+    // Released before the script read its frame; a new player takes the slot.
+    players.Remove(oldHandle, nullptr);
+    PlayerTable::Handle newHandle = players.Insert(std::make_shared<SimulatedPlayer>());
+    REQUIRE(PlayerTable::SlotIndex(newHandle) == PlayerTable::SlotIndex(oldHandle));
+    RenderEvent(players, updates);
+
+    FrameUpdate taken[c_players];
+    REQUIRE(updates.Take(taken, c_players) == 1);
+    CHECK(taken[0].handle == newHandle);
+    CHECK(!taken[0].newFrame);
+
+    // Once gone, a player is no longer reported at all.
+    players.Remove(newHandle, nullptr);
+    RenderEvent(players, updates);
+    CHECK(updates.Take(taken, c_players) == 0);
+}
+
+TEST_CASE(TakeStopsAtTheCallersCapacity)
+{
+    PlayerTable players;
+    UpdateTable updates;
+    for (uint32_t i = 0; i < c_players; i++)
+    {
+        players.Insert(std::make_shared<SimulatedPlayer>());
+    }
+    RenderEvent(players, updates);
+
+    FrameUpdate taken[c_players];
+    CHECK(updates.Take(taken, 2) == 2);
+    CHECK(updates.Take(taken, c_players) == c_players);
+}
+
+TEST_CASE(AFrameTakenByTheOtherConsumerIsNotReportedTwice)
+{
+    PlayerTable players;
+    UpdateTable updates;
+    auto player = std::make_shared<SimulatedPlayer>();
+    players.Insert(player);
+
+    // AcquirePrimaryTexture runs first and gets the frame.
+    player->PresentFrame();
+    void* texture;
+    CHECK(player->AcquireLatest(&texture));
+    RenderEvent(players, updates);
+
+    FrameUpdate taken[c_players];
+    REQUIRE(updates.Take(taken, c_players) == 1);
+    CHECK(!taken[0].newFrame);
+    CHECK(taken[0].textureSRV == texture);
+}
+
+TEST_CASE(StressEveryFrameIsReportedAtMostOnce)
+{
+    const uint64_t c_frames = 20000;
+
+    PlayerTable players;
+    UpdateTable updates;
+    auto player = std::make_shared<SimulatedPlayer>();
+    players.Insert(player);
+
+    std::atomic<bool> finished(false);
+    std::atomic<uint64_t> acquiredDirectly(0);
+
+    std::thread producer([&]() {
+        for (uint64_t frame = 0; frame < c_frames; frame++)
+        {
+            player->PresentFrame();
+            if ((frame & 1023) == 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+        finished.store(true, std::memory_order_release);
+    });
+
+    std::thread renderThread([&]() {
+        while (!finished.load(std::memory_order_acquire))
+        {
+            RenderEvent(players, updates);
+        }
+        RenderEvent(players, updates);
+    });
+
+    // The other consumer path, polled alongside the render event.
+    std::thread acquireExport([&]() {
+        void* texture;
+        while (!finished.load(std::memory_order_acquire))
+        {
+            if (player->AcquireLatest(&texture))
+            {
+                acquiredDirectly++;
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    uint64_t reported = 0;
+    FrameUpdate taken[c_players];
+    while (!finished.load(std::memory_order_acquire))
+    {
+        reported += NewFrames(taken, updates.Take(taken, c_players));
+        std::this_thread::yield();
+    }
+
+    producer.join();
+    renderThread.join();
+    acquireExport.join();
+    reported += NewFrames(taken, updates.Take(taken, c_players));
+    CHECK(reported + acquiredDirectly.load() <= c_frames);
+
+    // Quiet again: one more frame is reported exactly once.
+    player->PresentFrame();
+    RenderEvent(players, updates);
+    RenderEvent(players, updates);
+    CHECK(NewFrames(taken, updates.Take(taken, c_players)) == 1);
+    CHECK(NewFrames(taken, updates.Take(taken, c_players)) == 0);
+}
@@ -0,0 +1,140 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// What sharing a swap chain handle costs: the broker's bookkeeping over a
+// transport that does nothing, and a real descriptor round trip over
+// SCM_RIGHTS, one handle per call against a batch per call.
+
+#include "Benchmark.h"
+#include "HandleBroker.h"
+#include "ScmRightsHandleTransport.h"
+
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+
+namespace
+{
+    class NullTransport : public IHandleTransport
+    {
+    public:
+        NullTransport() : m_next(0), m_process(0) {}
+
+        virtual void* OpenProcess(uint32_t) { return &m_process; }
+        virtual void CloseProcess(void*) {}
+
+        virtual void Send(void*, const uint64_t*, size_t count, uint64_t* remote)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                remote[i] = ++m_next;
+            }
+        }
+
+        virtual void CloseRemote(void*, const uint64_t*, size_t) {}
+
+    private:
+        uint64_t m_next;
+        int m_process;
+    };
+
+    const uint64_t c_handles = 1000000;
+
+    // Shares and releases handles batch at a time, one generation each.
+    void ShareAndRelease(HandleBroker& broker, uint64_t handles, size_t batch, uint64_t local)
+    {
+        std::vector<HandleShare> shares(batch);
+        std::vector<uint64_t> remote(batch);
+        std::vector<uint64_t> generations(batch);
+        uint64_t generation = 0;
+        for (uint64_t done = 0; done < handles; done += batch)
+        {
+            for (size_t i = 0; i < batch; i++)
+            {
+                generations[i] = ++generation;
+                HandleShare share = { 1, generation, local, 100 };
+                shares[i] = share;
+            }
+            broker.Share(shares.data(), batch, remote.data());
+            Bench::KeepAlive(remote[0]);
+            broker.Release(1, generations.data(), batch);
+        }
+    }
+}
+
+int main()
+{
+    {
+        NullTransport transport;
+        HandleBroker broker(&transport, 2);
+        Bench::Run("broker share+release, 1 per call", c_handles, [&](uint64_t n) {
+            ShareAndRelease(broker, n, 1, 10);
+        });
+        Bench::Run("broker share+release, 16 per call", c_handles, [&](uint64_t n) {
+            ShareAndRelease(broker, n, 16, 10);
+        });
+    }
+
+#if !defined(_WIN32)
+    // The receiver drains on this thread after each call, so the socket
+    // never fills; the time includes both ends.
+    const uint64_t c_descriptors = 100000;
+    for (size_t batch : { (size_t)1, (size_t)16 })
+    {
+        int sockets[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets) != 0)
+        {
+            return 1;
+        }
+        int pipes[2];
+        if (pipe(pipes) != 0)
+        {
+            return 1;
+        }
+
+        ScmRightsHandleTransport transport;
+        transport.Connect(100, sockets[0]);
+        ScmRightsHandleReceiver receiver(sockets[1]);
+        HandleBroker broker(&transport, 2);
+
+        std::vector<HandleShare> shares(batch);
+        std::vector<uint64_t> remote(batch);
+        std::vector<uint64_t> generations(batch);
+        const char* name = (batch == 1) ? "scm_rights share+release, 1 per call" : "scm_rights share+release, 16 per call";
+        Bench::Run(name, c_descriptors, [&](uint64_t n) {
+            uint64_t generation = 0;
+            for (uint64_t done = 0; done < n; done += batch)
+            {
+                for (size_t i = 0; i < batch; i++)
+                {
+                    generations[i] = ++generation;
+                    HandleShare share = { 1, generation, (uint64_t)pipes[1], 100 };
+                    shares[i] = share;
+                }
+                broker.Share(shares.data(), batch, remote.data());
+                receiver.Receive();
+                broker.Release(1, generations.data(), batch);
+                receiver.Receive();
+            }
+        });
+
+        close(pipes[0]);
+        close(pipes[1]);
+    }
+#endif
+
+    return 0;
+}
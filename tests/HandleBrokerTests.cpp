@@ -0,0 +1,588 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "HandleBroker.h"
+#include "ScmRightsHandleTransport.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+
+namespace
+{
+    // Keeps the copies it hands out per process and counts anything the
+    // broker does out of turn: closing a copy that is not there, closing a
+    // process with copies left in it, sending to a closed process.
+    class FakeTransport : public IHandleTransport
+    {
+    public:
+        FakeTransport() : m_nextRemote(1), m_violations(0), m_opens(0), m_sends(0), m_closeCalls(0) {}
+
+        ~FakeTransport()
+        {
+            for (auto* process : m_all)
+            {
+                delete process;
+            }
+        }
+
+        virtual void* OpenProcess(uint32_t processId)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_unreachable.count(processId) != 0)
+            {
+                return nullptr;
+            }
+            Process* process = new Process();
+            process->processId = processId;
+            process->open = true;
+            m_all.push_back(process);
+            m_opens++;
+            return process;
+        }
+
+        virtual void CloseProcess(void* handle)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            Process* process = static_cast<Process*>(handle);
+            if (!process->open || !process->copies.empty())
+            {
+                m_violations++;
+            }
+            process->open = false;
+        }
+
+        virtual void Send(void* handle, const uint64_t* local, size_t count, uint64_t* remote)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            Process* process = static_cast<Process*>(handle);
+            if (!process->open)
+            {
+                m_violations++;
+            }
+            m_sends++;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (m_failing.count(local[i]) != 0)
+                {
+                    remote[i] = c_invalidRemoteHandle;
+                    continue;
+                }
+                remote[i] = m_nextRemote++;
+                process->copies.insert(remote[i]);
+            }
+        }
+
+        virtual void CloseRemote(void* handle, const uint64_t* remote, size_t count)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            Process* process = static_cast<Process*>(handle);
+            m_closeCalls++;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (process->copies.erase(remote[i]) == 0)
+                {
+                    m_violations++;
+                }
+            }
+        }
+
+        void SetUnreachable(uint32_t processId)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_unreachable.insert(processId);
+        }
+
+        void SetFailing(uint64_t local)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_failing.insert(local);
+        }
+
+        // Copies still alive in processId, over every time it was opened.
+        size_t Live(uint32_t processId)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            size_t live = 0;
+            for (auto* process : m_all)
+            {
+                live += (process->processId == processId) ? process->copies.size() : 0;
+            }
+            return live;
+        }
+
+        size_t OpenCount()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            size_t open = 0;
+            for (auto* process : m_all)
+            {
+                open += process->open ? 1 : 0;
+            }
+            return open;
+        }
+
+        bool IsOpen(uint32_t processId)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            for (auto* process : m_all)
+            {
+                if (process->open && (process->processId == processId))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        int Violations() { return m_violations; }
+        int Opens() { return m_opens; }
+        int Sends() { return m_sends; }
+        int CloseCalls() { return m_closeCalls; }
+
+    private:
+        struct Process
+        {
+            uint32_t processId;
+            bool open;
+            std::set<uint64_t> copies;
+        };
+
+        std::mutex m_lock;
+        std::vector<Process*> m_all;
+        std::set<uint32_t> m_unreachable;
+        std::set<uint64_t> m_failing;
+        uint64_t m_nextRemote;
+        int m_violations;
+        int m_opens;
+        int m_sends;
+        int m_closeCalls;
+    };
+}
+
+TEST_CASE(ShareMakesOneCallPerProcess)
+{
+    FakeTransport transport;
+    HandleBroker broker(&transport, 2);
+
+    HandleShare shares[] = {
+        { 1, 1, 10, 100 },
+        { 1, 2, 11, 200 },
+        { 2, 1, 12, 100 },
+        { 2, 2, 13, 200 },
+    };
+    uint64_t remote[4];
+    broker.Share(shares, 4, remote);
+
+    int invalid = 0;
+    for (auto copy : remote)
+    {
+        invalid += (copy == c_invalidRemoteHandle) ? 1 : 0;
+    }
+    CHECK(invalid == 0);
+    CHECK(transport.Opens() == 2);
+    CHECK(transport.Sends() == 2);
+    CHECK(transport.Live(100) == 2 && transport.Live(200) == 2);
+
+    HandleBrokerStats stats = Test::Stats(broker);
+    CHECK(stats.processOpens == 2 && stats.sendBatches == 2);
+    CHECK(stats.sent == 4 && stats.outstanding == 4);
+    CHECK(stats.openProcesses == 2);
+    CHECK(broker.Outstanding(1) == 2 && broker.Outstanding(2) == 2);
+
+    // The process is open already the second time.
+    broker.Share(3, 1, 14, 100);
+    CHECK(transport.Opens() == 2);
+    CHECK(Test::Stats(broker).processHits == 1);
+    CHECK(transport.Violations() == 0);
+}
+
+TEST_CASE(SharingAGenerationAgainReplacesItsCopy)
+{
+    FakeTransport transport;
+    HandleBroker broker(&transport, 2);
+
+    uint64_t first = broker.Share(1, 1, 10, 100);
+    uint64_t second = broker.Share(1, 1, 11, 100);
+    CHECK(first != c_invalidRemoteHandle && second != c_invalidRemoteHandle);
+    CHECK(first != second);
+    CHECK(transport.Live(100) == 1);
+    CHECK(broker.Outstanding(1) == 1);
+    CHECK(Test::Stats(broker).released == 1);
+    CHECK(transport.Violations() == 0);
+}
+
+TEST_CASE(ReleaseClosesOnlyTheGivenGenerations)
+{
+    FakeTransport transport;
+    HandleBroker broker(&transport, 2);
+    for (uint64_t generation = 1; generation <= 4; generation++)
+    {
+        broker.Share(1, generation, 10 + generation, 100);
+    }
+    broker.Share(2, 1, 20, 100);
+
+    uint64_t release[] = { 1, 3, 99 };
+    broker.Release(1, release, 3);
+    CHECK(broker.Outstanding(1) == 2);
+    CHECK(broker.Outstanding(2) == 1);
+    CHECK(transport.Live(100) == 3);
+    CHECK(transport.CloseCalls() == 1);
+
+    HandleBrokerStats stats = Test::Stats(broker);
+    CHECK(stats.released == 2 && stats.releaseBatches == 1);
+
+    broker.ReleaseOwner(1);
+    CHECK(broker.Outstanding(1) == 0);
+    CHECK(broker.Outstanding(2) == 1);
+    CHECK(transport.Live(100) == 1);
+
+    // Releasing what is gone does nothing.
+    broker.Release(1, release, 3);
+    broker.ReleaseOwner(1);
+    CHECK(Test::Stats(broker).released == 4);
+    CHECK(transport.Violations() == 0);
+}
+
+TEST_CASE(IdleProcessesAreCachedUpToTheLimit)
+{
+    FakeTransport transport;
+    HandleBroker broker(&transport, 1);
+
+    broker.Share(1, 1, 10, 100);
+    broker.ReleaseOwner(1);
+    CHECK(transport.IsOpen(100));
+    CHECK(Test::Stats(broker).openProcesses == 1);
+
+    // A second idle process pushes out the least recently used one.
+    broker.Share(1, 2, 10, 200);
+    broker.ReleaseOwner(1);
+    CHECK(!transport.IsOpen(100));
+    CHECK(transport.IsOpen(200));
+
+    // A process with copies in it is never trimmed.
+    broker.Share(1, 3, 10, 100);
+    broker.Share(2, 1, 10, 300);
+    broker.ReleaseOwner(2);
+    CHECK(transport.IsOpen(100));
+    CHECK(transport.OpenCount() == 2);
+    CHECK(transport.Violations() == 0);
+}
+
+TEST_CASE(AnUnreachableProcessFailsItsShares)
+{
+    FakeTransport transport;
+    HandleBroker broker(&transport, 2);
+    transport.SetUnreachable(100);
+
+    HandleShare shares[] = {
+        { 1, 1, 10, 100 },
+        { 1, 2, 11, 200 },
+    };
+    uint64_t remote[2];
+    broker.Share(shares, 2, remote);
+    CHECK(remote[0] == c_invalidRemoteHandle);
+    CHECK(remote[1] != c_invalidRemoteHandle);
+    CHECK(Test::Stats(broker).failed == 1);
+    CHECK(broker.Outstanding(1) == 1);
+}
+
+TEST_CASE(AFailedSendDropsTheProcessOnlyWhenNothingGotThrough)
+{
+    FakeTransport transport;
+    HandleBroker broker(&transport, 2);
+    transport.SetFailing(66);
+
+    CHECK(broker.Share(1, 1, 66, 100) == c_invalidRemoteHandle);
+    CHECK(!transport.IsOpen(100));
+    CHECK(Test::Stats(broker).openProcesses == 0);
+
+    HandleShare shares[] = {
+        { 1, 2, 10, 100 },
+        { 1, 3, 66, 100 },
+    };
+    uint64_t remote[2];
+    broker.Share(shares, 2, remote);
+    CHECK(remote[0] != c_invalidRemoteHandle);
+    CHECK(remote[1] == c_invalidRemoteHandle);
+    CHECK(transport.IsOpen(100));
+    CHECK(broker.Outstanding(1) == 1);
+    CHECK(Test::Stats(broker).failed == 2);
+    CHECK(transport.Violations() == 0);
+}
+
+TEST_CASE(TheBrokerClosesEverythingOnTheWayOut)
+{
+    FakeTransport transport;
+    {
+        HandleBroker broker(&transport, 4);
+        for (uint32_t i = 0; i < 20; i++)
+        {
+            broker.Share(i % 3, i, 10 + i, 100 + i % 5);
+        }
+    }
+    size_t live = 0;
+    for (uint32_t processId = 100; processId < 105; processId++)
+    {
+        live += transport.Live(processId);
+    }
+    CHECK(live == 0);
+    CHECK(transport.OpenCount() == 0);
+    CHECK(transport.Violations() == 0);
+}
+
+// Renderers sharing and releasing generations at once: the broker's count
+// and the copies really alive in the processes always agree.
+TEST_CASE(ConcurrentOwnersLeaveNothingBehind)
+{
+    FakeTransport transport;
+    HandleBroker broker(&transport, 2);
+
+    const int c_owners = 4;
+    std::atomic<int> started(0);
+    std::atomic<int> mismatched(0);
+    std::vector<std::thread> owners;
+    for (int owner = 0; owner < c_owners; owner++)
+    {
+        owners.emplace_back([&, owner]() {
+            started++;
+            while (started.load() < c_owners)
+            {
+                std::this_thread::yield();
+            }
+            std::set<uint64_t> mine;
+            uint32_t random = 77 + owner;
+            for (uint64_t generation = 1; generation <= 2000; generation++)
+            {
+                random = random * 1103515245 + 12345;
+                uint32_t processId = 100 + (random >> 16) % 4;
+                if (broker.Share(owner, generation, generation, processId) != c_invalidRemoteHandle)
+                {
+                    mine.insert(generation);
+                }
+
+                // keep a few generations around, like a renderer waiting
+                // for its foreground process to catch up
+                while (mine.size() > 3)
+                {
+                    uint64_t oldest = *mine.begin();
+                    broker.Release(owner, &oldest, 1);
+                    mine.erase(mine.begin());
+                }
+                if (broker.Outstanding(owner) != mine.size())
+                {
+                    mismatched++;
+                }
+                if (generation % 64 == 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+            broker.ReleaseOwner(owner);
+        });
+    }
+    for (auto& owner : owners)
+    {
+        owner.join();
+    }
+
+    CHECK(mismatched.load() == 0);
+    size_t live = 0;
+    for (uint32_t processId = 100; processId < 104; processId++)
+    {
+        live += transport.Live(processId);
+    }
+    CHECK(live == 0);
+
+    HandleBrokerStats stats = Test::Stats(broker);
+    CHECK(stats.outstanding == 0);
+    CHECK(stats.sent == stats.released);
+    CHECK(stats.openProcesses <= 2);
+    CHECK(transport.Violations() == 0);
+}
+
+#if !defined(_WIN32)
+namespace
+{
+    // A pipe whose write end is sent; whatever the receiver writes through
+    // its copy comes out of the read end here.
+    struct Pipe
+    {
+        Pipe() { CHECK(pipe(ends) == 0); }
+        ~Pipe()
+        {
+            close(ends[0]);
+            close(ends[1]);
+        }
+        int ends[2];
+    };
+
+    bool WritesThrough(int descriptor, const Pipe& target)
+    {
+        char out = 'x';
+        char in = 0;
+        if (write(descriptor, &out, 1) != 1)
+        {
+            return false;
+        }
+        return (read(target.ends[0], &in, 1) == 1) && (in == out);
+    }
+
+    // Links a transport to a receiver standing in for process processId.
+    std::unique_ptr<ScmRightsHandleReceiver> Connect(ScmRightsHandleTransport& transport, uint32_t processId)
+    {
+        int sockets[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) != 0)
+        {
+            return nullptr;
+        }
+        transport.Connect(processId, sockets[0]);
+        return std::unique_ptr<ScmRightsHandleReceiver>(new ScmRightsHandleReceiver(sockets[1]));
+    }
+
+    bool IsOpenDescriptor(int descriptor)
+    {
+        return fcntl(descriptor, F_GETFD) != -1;
+    }
+}
+
+TEST_CASE(ScmRightsSendsAWorkingDescriptor)
+{
+    ScmRightsHandleTransport transport;
+    auto receiver = Connect(transport, 100);
+    REQUIRE(receiver != nullptr);
+    Pipe pipe;
+
+    void* process = transport.OpenProcess(100);
+    REQUIRE(process != nullptr);
+    uint64_t local = (uint64_t)pipe.ends[1];
+    uint64_t token = c_invalidRemoteHandle;
+    transport.Send(process, &local, 1, &token);
+    REQUIRE(token != c_invalidRemoteHandle);
+
+    REQUIRE(receiver->Receive());
+    int copy = receiver->Find(token);
+    REQUIRE(copy >= 0);
+    CHECK(copy != pipe.ends[1]);
+    CHECK(WritesThrough(copy, pipe));
+
+    transport.CloseRemote(process, &token, 1);
+    REQUIRE(receiver->Receive());
+    CHECK(receiver->Find(token) == -1);
+    CHECK(receiver->Count() == 0);
+    CHECK(!IsOpenDescriptor(copy));
+
+    transport.CloseProcess(process);
+}
+
+TEST_CASE(ScmRightsSplitsLargeBatches)
+{
+    ScmRightsHandleTransport transport;
+    auto receiver = Connect(transport, 100);
+    REQUIRE(receiver != nullptr);
+    Pipe pipe;
+
+    // More than fit in one message; the same descriptor many times is
+    // still a separate copy each time.
+    const size_t c_count = 150;
+    std::vector<uint64_t> local(c_count, (uint64_t)pipe.ends[1]);
+    std::vector<uint64_t> tokens(c_count, c_invalidRemoteHandle);
+    void* process = transport.OpenProcess(100);
+    REQUIRE(process != nullptr);
+    transport.Send(process, local.data(), c_count, tokens.data());
+
+    int received = 0;
+    while (receiver->Count() < c_count && receiver->Receive())
+    {
+        received++;
+    }
+    CHECK(received == 3);
+    CHECK(receiver->Count() == c_count);
+    CHECK(std::set<uint64_t>(tokens.begin(), tokens.end()).size() == c_count);
+    CHECK(WritesThrough(receiver->Find(tokens[c_count - 1]), pipe));
+
+    transport.CloseRemote(process, tokens.data(), c_count);
+    while (receiver->Count() > 0 && receiver->Receive())
+    {
+    }
+    CHECK(receiver->Count() == 0);
+    transport.CloseProcess(process);
+}
+
+TEST_CASE(ScmRightsFailsWithoutAReceiver)
+{
+    ScmRightsHandleTransport transport;
+    CHECK(transport.OpenProcess(100) == nullptr);
+
+    auto receiver = Connect(transport, 100);
+    REQUIRE(receiver != nullptr);
+    void* process = transport.OpenProcess(100);
+    REQUIRE(process != nullptr);
+
+    // An open process keeps its own socket through a Disconnect...
+    transport.Disconnect(100);
+    CHECK(transport.OpenProcess(100) == nullptr);
+    Pipe pipe;
+    uint64_t local = (uint64_t)pipe.ends[1];
+    uint64_t token = c_invalidRemoteHandle;
+    transport.Send(process, &local, 1, &token);
+    CHECK(token != c_invalidRemoteHandle);
+    CHECK(receiver->Receive());
+
+    // ...but not through the receiver going away.
+    receiver.reset();
+    transport.Send(process, &local, 1, &token);
+    CHECK(token == c_invalidRemoteHandle);
+    transport.CloseProcess(process);
+}
+
+TEST_CASE(TheBrokerWorksOverScmRights)
+{
+    ScmRightsHandleTransport transport;
+    auto receiver = Connect(transport, 100);
+    REQUIRE(receiver != nullptr);
+    Pipe pipe;
+
+    {
+        HandleBroker broker(&transport, 1);
+        uint64_t token = broker.Share(1, 1, (uint64_t)pipe.ends[1], 100);
+        REQUIRE(token != c_invalidRemoteHandle);
+        REQUIRE(receiver->Receive());
+        CHECK(WritesThrough(receiver->Find(token), pipe));
+
+        uint64_t generation = 1;
+        broker.Release(1, &generation, 1);
+        REQUIRE(receiver->Receive());
+        CHECK(receiver->Count() == 0);
+
+        broker.Share(1, 2, (uint64_t)pipe.ends[1], 100);
+        REQUIRE(receiver->Receive());
+        CHECK(receiver->Count() == 1);
+    }
+
+    // The broker closed its last copy on the way out.
+    REQUIRE(receiver->Receive());
+    CHECK(receiver->Count() == 0);
+}
+#endif
@@ -0,0 +1,306 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Both classes take the time as an argument, so these tests drive them
+// with a plain counter instead of a clock.
+
+#include "Test.h"
+#include "HandleGenerations.h"
+
+#include <map>
+#include <vector>
+
+using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+
+namespace
+{
+    const uint64_t c_graceMs = 500;
+
+    bool Contains(const std::vector<uint64_t>& values, uint64_t value)
+    {
+        for (uint64_t v : values)
+        {
+            if (v == value)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+TEST_CASE(TimersNeverFireEarlyNorMoreThanATickLate)
+{
+    const uint64_t c_tickMs = 10;
+    TimerWheel wheel(c_tickMs, 8, 1000);
+
+    // Due times spread over several turns of the wheel.
+    std::map<uint64_t, uint64_t> due;
+    for (uint64_t id = 1; id <= 200; id++)
+    {
+        uint64_t dueMs = 1000 + (id * 37) % 400;
+        wheel.Schedule(id, dueMs);
+        due[id] = dueMs;
+    }
+
+    int early = 0;
+    int late = 0;
+    size_t fired = 0;
+    for (uint64_t now = 1000; now <= 1500; now++)
+    {
+        std::vector<uint64_t> expired;
+        wheel.Advance(now, &expired);
+        for (uint64_t id : expired)
+        {
+            early += (now < due[id]) ? 1 : 0;
+            late += (now >= due[id] + c_tickMs) ? 1 : 0;
+            fired++;
+        }
+    }
+
+    CHECK(early == 0);
+    CHECK(late == 0);
+    CHECK(fired == due.size());
+    CHECK(wheel.IsEmpty());
+}
+
+TEST_CASE(ADueTimeInThePastFiresOnTheNextAdvance)
+{
+    TimerWheel wheel(10, 4, 1000);
+    wheel.Schedule(1, 500);
+    CHECK(!wheel.IsEmpty());
+
+    std::vector<uint64_t> expired;
+    wheel.Advance(1005, &expired);
+    CHECK(expired.empty());
+    wheel.Advance(1010, &expired);
+    CHECK(expired.size() == 1 && expired[0] == 1);
+}
+
+TEST_CASE(ALongJumpFiresEverythingDueAndNothingElse)
+{
+    TimerWheel wheel(10, 4, 0);
+    for (uint64_t id = 1; id <= 20; id++)
+    {
+        wheel.Schedule(id, id * 100);
+    }
+
+    // Many turns at once: each slot is visited once and the later
+    // entries sharing those slots stay put.
+    std::vector<uint64_t> expired;
+    wheel.Advance(1000, &expired);
+    CHECK(expired.size() == 10);
+    CHECK(!Contains(expired, 11));
+
+    expired.clear();
+    wheel.Advance(100000, &expired);
+    CHECK(expired.size() == 10);
+    CHECK(wheel.IsEmpty());
+}
+
+TEST_CASE(TimeStandingStillFiresNothing)
+{
+    TimerWheel wheel(10, 4, 100);
+    wheel.Schedule(1, 120);
+    std::vector<uint64_t> expired;
+    wheel.Advance(100, &expired);
+    wheel.Advance(50, &expired);
+    CHECK(expired.empty());
+}
+
+TEST_CASE(TheFirstPublishRetiresNothing)
+{
+    HandleGenerations generations(c_graceMs, 4, 0);
+    CHECK(generations.Current() == 0);
+
+    std::vector<uint64_t> release;
+    CHECK(generations.Publish(0, &release) == 1);
+    CHECK(generations.Current() == 1);
+    CHECK(release.empty());
+    CHECK(!generations.IsRetiring());
+}
+
+TEST_CASE(AcknowledgingReleasesOlderGenerations)
+{
+    HandleGenerations generations(c_graceMs, 4, 0);
+    std::vector<uint64_t> release;
+    generations.Publish(0, &release);
+    generations.Publish(10, &release);
+    generations.Publish(20, &release);
+    CHECK(release.empty());
+    CHECK(Test::Stats(generations).retiring == 2);
+
+    // The consumer moved to 2: only 1 is done with.
+    generations.Acknowledge(2, &release);
+    CHECK(release.size() == 1 && release[0] == 1);
+
+    // Unknown generations change nothing.
+    generations.Acknowledge(0, &release);
+    generations.Acknowledge(99, &release);
+    CHECK(release.size() == 1);
+
+    generations.Acknowledge(3, &release);
+    CHECK(release.size() == 2 && release[1] == 2);
+    CHECK(Test::Stats(generations).acknowledged == 2);
+    CHECK(!generations.IsRetiring());
+}
+
+TEST_CASE(AnUnacknowledgedGenerationExpiresAfterTheGracePeriod)
+{
+    HandleGenerations generations(c_graceMs, 4, 0);
+    std::vector<uint64_t> release;
+    generations.Publish(0, &release);
+    generations.Publish(100, &release);
+
+    uint64_t releasedAt = 0;
+    for (uint64_t now = 100; now <= 100 + 2 * c_graceMs && releasedAt == 0; now++)
+    {
+        generations.Advance(now, &release);
+        if (!release.empty())
+        {
+            releasedAt = now;
+        }
+    }
+
+    // Never before the grace period, and within a wheel tick of it.
+    REQUIRE(releasedAt != 0);
+    CHECK(releasedAt >= 100 + c_graceMs);
+    CHECK(releasedAt <= 100 + c_graceMs + c_graceMs / 64 + 1);
+    CHECK(release.size() == 1 && release[0] == 1);
+    CHECK(Test::Stats(generations).expired == 1);
+}
+
+TEST_CASE(AnAcknowledgedGenerationDoesNotExpireAgain)
+{
+    HandleGenerations generations(c_graceMs, 4, 0);
+    std::vector<uint64_t> release;
+    generations.Publish(0, &release);
+    generations.Publish(0, &release);
+    generations.Acknowledge(2, &release);
+    REQUIRE(release.size() == 1);
+
+    generations.Advance(10 * c_graceMs, &release);
+    CHECK(release.size() == 1);
+    CHECK(Test::Stats(generations).expired == 0);
+}
+
+TEST_CASE(TooManyRetiringEvictsTheOldest)
+{
+    HandleGenerations generations(c_graceMs, 2, 0);
+    std::vector<uint64_t> release;
+    for (int i = 0; i < 5; i++)
+    {
+        generations.Publish(0, &release);
+    }
+
+    // Generations 1..4 retired, only two may wait.
+    CHECK(release.size() == 2);
+    CHECK(release[0] == 1 && release[1] == 2);
+    CHECK(Test::Stats(generations).evicted == 2);
+    CHECK(Test::Stats(generations).retiring == 2);
+}
+
+TEST_CASE(ClearReleasesEverything)
+{
+    HandleGenerations generations(c_graceMs, 4, 0);
+    std::vector<uint64_t> release;
+    generations.Publish(0, &release);
+    generations.Publish(0, &release);
+    generations.Publish(0, &release);
+
+    generations.Clear(&release);
+    CHECK(release.size() == 3);
+    CHECK(generations.Current() == 0);
+    CHECK(!generations.IsRetiring());
+
+    // Numbering carries on, a stale acknowledgement cannot match.
+    CHECK(generations.Publish(0, &release) == 4);
+}
+
+// A long simulated session mixing publishes, late acknowledgements and
+// clock jumps: every generation is released exactly once, never while it
+// is current and never before the consumer is past it or its grace ran out.
+TEST_CASE(EveryGenerationIsReleasedExactlyOnce)
+{
+    HandleGenerations generations(c_graceMs, 3, 0);
+    std::map<uint64_t, int> releases;
+    std::map<uint64_t, uint64_t> retiredAt;
+    uint64_t acknowledged = 0;
+    int premature = 0;
+
+    uint32_t random = 12345;
+    uint64_t now = 0;
+    for (int step = 0; step < 20000; step++)
+    {
+        random = random * 1103515245 + 12345;
+        uint32_t action = (random >> 16) % 10;
+
+        std::vector<uint64_t> release;
+        if (action < 3)
+        {
+            uint64_t previous = generations.Current();
+            generations.Publish(now, &release);
+            if (previous != 0)
+            {
+                retiredAt[previous] = now;
+            }
+        }
+        else if (action < 5 && generations.Current() > 1)
+        {
+            // the consumer catches up to some recent generation
+            uint64_t target = generations.Current() - ((random >> 8) % 2);
+            if (target > acknowledged)
+            {
+                acknowledged = target;
+            }
+            generations.Acknowledge(target, &release);
+        }
+        else
+        {
+            now += ((random >> 4) % 8 == 0) ? 2000 : (random >> 4) % 50;
+            generations.Advance(now, &release);
+        }
+
+        for (uint64_t generation : release)
+        {
+            releases[generation]++;
+            bool current = (generation == generations.Current());
+            bool expired = retiredAt.count(generation) && now >= retiredAt[generation] + c_graceMs;
+            bool passed = generation < acknowledged;
+            // eviction may release early, it is counted separately
+            if (current || !(expired || passed || action < 3))
+            {
+                premature++;
+            }
+        }
+    }
+
+    std::vector<uint64_t> release;
+    uint64_t last = generations.Current();
+    generations.Clear(&release);
+    for (uint64_t generation : release)
+    {
+        releases[generation]++;
+    }
+
+    int wrong = 0;
+    for (uint64_t generation = 1; generation <= last; generation++)
+    {
+        wrong += (releases[generation] != 1) ? 1 : 0;
+    }
+    CHECK(wrong == 0);
+    CHECK(premature == 0);
+    CHECK(releases.size() == last);
+
+    HandleGenerationStats stats = Test::Stats(generations);
+    CHECK(stats.published == last);
+    CHECK(stats.acknowledged + stats.expired + stats.evicted + release.size() == last);
+}
@@ -0,0 +1,143 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Overhead of resolving a player handle the way every plugin export does,
+// against the map-under-a-lock lookup the table replaced.
+
+#include "Benchmark.h"
+#include "HandleTable.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace MEDIA;
+
+namespace
+{
+    struct Player
+    {
+        Player() : calls(0) {}
+
+        // Stands in for a cheap export such as GetPlaybackStats.
+        void Touch()
+        {
+            calls++;
+        }
+
+        uint64_t calls;
+    };
+
+    typedef HandleTable<std::shared_ptr<Player>, 64> PlayerTable;
+
+    class LockedMap
+    {
+    public:
+        int32_t Insert(const std::shared_ptr<Player>& player)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_players[++m_next] = player;
+            return m_next;
+        }
+
+        std::shared_ptr<Player> Lookup(int32_t handle)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto it = m_players.find(handle);
+            return it == m_players.end() ? nullptr : it->second;
+        }
+
+    private:
+        std::mutex m_lock;
+        std::map<int32_t, std::shared_ptr<Player>> m_players;
+        int32_t m_next = 0;
+    };
+
+    const int c_players = 8;
+    const uint64_t c_calls = 5000000;
+
+    template <typename Call>
+    void RunThreads(int threads, Call call)
+    {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++)
+        {
+            workers.emplace_back([&call, t]() {
+                for (uint64_t i = 0; i < c_calls / 4; i++)
+                {
+                    call((int)((i + t) % c_players));
+                }
+            });
+        }
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+}
+
+int main()
+{
+    PlayerTable table;
+    LockedMap map;
+    PlayerTable::Handle tableHandles[c_players];
+    int32_t mapHandles[c_players];
+    for (int i = 0; i < c_players; i++)
+    {
+        auto player = std::make_shared<Player>();
+        tableHandles[i] = table.Insert(player);
+        mapHandles[i] = map.Insert(player);
+    }
+
+    Bench::Run("handle table export call", c_calls, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            auto guard = table.Lookup(tableHandles[i % c_players]);
+            if (guard)
+            {
+                (*guard)->Touch();
+            }
+        }
+    });
+
+    Bench::Run("locked map export call", c_calls, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            auto player = map.Lookup(mapHandles[i % c_players]);
+            if (player)
+            {
+                player->Touch();
+            }
+        }
+    });
+
+    // Four threads, as when the render thread and script threads call in
+    // at once. Reported per call across all threads.
+    printf("%u hardware threads\n", std::thread::hardware_concurrency());
+    Bench::Run("handle table export call, 4 threads", c_calls, [&](uint64_t) {
+        RunThreads(4, [&](int i) {
+            auto guard = table.Lookup(tableHandles[i]);
+            Bench::KeepAlive(guard ? (*guard).get() : nullptr);
+        });
+    });
+
+    Bench::Run("locked map export call, 4 threads", c_calls, [&](uint64_t) {
+        RunThreads(4, [&](int i) {
+            auto player = map.Lookup(mapHandles[i]);
+            Bench::KeepAlive(player.get());
+        });
+    });
+
+    return 0;
+}
@@ -0,0 +1,234 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "HandleTable.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace MEDIA;
+
+namespace
+{
+    typedef HandleTable<int, 4> SmallTable;
+    typedef HandleTable<int, 1> OneSlotTable;
+}
+
+TEST_CASE(InsertedValuesCanBeLookedUp)
+{
+    SmallTable table;
+    SmallTable::Handle a = table.Insert(10);
+    SmallTable::Handle b = table.Insert(20);
+    CHECK(a > 0 && b > 0 && a != b);
+
+    auto guard = table.Lookup(a);
+    REQUIRE(guard);
+    CHECK(*guard == 10);
+    CHECK(*table.Lookup(b) == 20);
+    CHECK(Test::Stats(table).live == 2);
+}
+
+TEST_CASE(MalformedHandlesMiss)
+{
+    SmallTable table;
+    table.Insert(1);
+    CHECK(!table.Lookup(SmallTable::InvalidHandle));
+    CHECK(!table.Lookup(-5));
+    CHECK(!table.Lookup(5));
+    CHECK(SmallTable::SlotIndex(0) == -1);
+    CHECK(SmallTable::SlotIndex(5) == -1);
+    CHECK(Test::Stats(table).lookupMisses == 3);
+}
+
+TEST_CASE(RemoveHandsTheValueBack)
+{
+    SmallTable table;
+    SmallTable::Handle handle = table.Insert(42);
+
+    int value = 0;
+    CHECK(table.Remove(handle, &value));
+    CHECK(value == 42);
+    CHECK(!table.Lookup(handle));
+    CHECK(!table.Remove(handle, &value));
+
+    HandleTableStats stats = Test::Stats(table);
+    CHECK(stats.live == 0);
+    CHECK(stats.inserted == 1);
+    CHECK(stats.removed == 1);
+}
+
+TEST_CASE(AReusedSlotGetsANewHandle)
+{
+    OneSlotTable table;
+    OneSlotTable::Handle first = table.Insert(1);
+    REQUIRE(table.Remove(first, nullptr));
+
+    OneSlotTable::Handle second = table.Insert(2);
+    CHECK(second != first);
+    CHECK(OneSlotTable::SlotIndex(first) == OneSlotTable::SlotIndex(second));
+    CHECK(!table.Lookup(first));
+    CHECK(*table.Lookup(second) == 2);
+
+    // The stale handle must not remove the new occupant either.
+    CHECK(!table.Remove(first, nullptr));
+    CHECK(table.Lookup(second));
+}
+
+TEST_CASE(GenerationsWrapWithoutGoingNegative)
+{
+    OneSlotTable table;
+    OneSlotTable::Handle previous = OneSlotTable::InvalidHandle;
+    for (int i = 0; i < 70000; i++)
+    {
+        OneSlotTable::Handle handle = table.Insert(i);
+        REQUIRE(handle > 0);
+        CHECK(handle != previous);
+        REQUIRE(table.Remove(handle, nullptr));
+        previous = handle;
+    }
+}
+
+TEST_CASE(AFullTableRefusesInserts)
+{
+    SmallTable table;
+    for (int i = 0; i < 4; i++)
+    {
+        CHECK(table.Insert(i) != SmallTable::InvalidHandle);
+    }
+    CHECK(table.Insert(4) == SmallTable::InvalidHandle);
+}
+
+TEST_CASE(ForEachVisitsLiveSlots)
+{
+    SmallTable table;
+    SmallTable::Handle a = table.Insert(1);
+    table.Insert(2);
+    table.Insert(4);
+    table.Remove(a, nullptr);
+
+    int sum = 0;
+    int visited = 0;
+    table.ForEach([&](SmallTable::Handle handle, int& value) {
+        CHECK(table.Lookup(handle));
+        sum += value;
+        visited++;
+    });
+    CHECK(visited == 2);
+    CHECK(sum == 6);
+}
+
+TEST_CASE(RemoveWaitsForReaders)
+{
+    SmallTable table;
+    SmallTable::Handle handle = table.Insert(7);
+    std::atomic<bool> removed(false);
+
+    std::thread remover;
+    {
+        auto guard = table.Lookup(handle);
+        REQUIRE(guard);
+        remover = std::thread([&]() {
+            table.Remove(handle, nullptr);
+            removed.store(true);
+        });
+
+        // Remove cannot finish while the guard is held.
+        for (int i = 0; i < 1000; i++)
+        {
+            std::this_thread::yield();
+        }
+        CHECK(!removed.load());
+        CHECK(*guard == 7);
+    }
+    remover.join();
+    CHECK(removed.load());
+    CHECK(Test::Stats(table).removeWaits == 1);
+}
+
+// Readers look up handles while a writer keeps removing and reinserting
+// objects. An object is only retired after Remove returns, so a reader
+// must never see a retired object through a guard.
+TEST_CASE(StressLookupsAgainstRemoval)
+{
+    struct Object
+    {
+        std::atomic<bool> alive;
+    };
+
+    const int c_slots = 16;
+    const int c_cycles = 20000;
+    HandleTable<Object*, c_slots> table;
+    Object objects[c_slots];
+    std::atomic<int32_t> handles[c_slots];
+    for (int i = 0; i < c_slots; i++)
+    {
+        objects[i].alive.store(true);
+        handles[i].store(table.Insert(&objects[i]));
+    }
+
+    std::atomic<bool> finished(false);
+    std::atomic<int> started(0);
+    std::atomic<uint64_t> retiredSeen(0);
+    std::atomic<uint64_t> hits(0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++)
+    {
+        readers.emplace_back([&, r]() {
+            uint32_t i = (uint32_t)r;
+            started++;
+            while (!finished.load(std::memory_order_relaxed))
+            {
+                auto guard = table.Lookup(handles[i++ % c_slots].load(std::memory_order_relaxed));
+                if (guard)
+                {
+                    if (!(*guard)->alive.load())
+                    {
+                        retiredSeen++;
+                    }
+                    std::this_thread::yield();
+                    if (!(*guard)->alive.load())
+                    {
+                        retiredSeen++;
+                    }
+                    hits++;
+                }
+            }
+        });
+    }
+
+    while (started.load() < 3)
+    {
+        std::this_thread::yield();
+    }
+
+    for (int cycle = 0; cycle < c_cycles; cycle++)
+    {
+        // Yielding lets the readers in even on a single core.
+        std::this_thread::yield();
+        int i = cycle % c_slots;
+        Object* object = nullptr;
+        REQUIRE(table.Remove(handles[i].load(), &object));
+        REQUIRE(object == &objects[i]);
+        object->alive.store(false);
+        object->alive.store(true);
+        handles[i].store(table.Insert(object));
+    }
+    finished.store(true);
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    CHECK(retiredSeen.load() == 0);
+    CHECK(hits.load() > 0);
+}
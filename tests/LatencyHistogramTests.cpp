@@ -0,0 +1,138 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "LatencyHistogram.h"
+
+#include <thread>
+#include <vector>
+
+using namespace MEDIA;
+
+TEST_CASE(EveryValueFallsInABucketThatCoversIt)
+{
+    uint32_t previous = 0;
+    for (uint64_t value = 0; value <= 0xffffffffull; value = value * 17 / 16 + 1)
+    {
+        uint32_t index = LatencyHistogram::BucketIndex((uint32_t)value);
+        REQUIRE(index < LatencyHistogram::c_bucketCount);
+        CHECK(index >= previous);
+        CHECK(LatencyHistogram::BucketUpperBound(index) >= value);
+        if (index > 0)
+        {
+            CHECK(LatencyHistogram::BucketUpperBound(index - 1) < value);
+        }
+        previous = index;
+    }
+
+    CHECK(LatencyHistogram::BucketIndex(0xffffffffu) == LatencyHistogram::c_bucketCount - 1);
+}
+
+TEST_CASE(RelativeErrorStaysUnderOneSubBucket)
+{
+    for (uint32_t value = 1; value < 1000000; value += 7)
+    {
+        uint64_t upper = LatencyHistogram::BucketUpperBound(LatencyHistogram::BucketIndex(value));
+        CHECK((upper - value) * LatencyHistogram::c_subBucketCount <= value);
+    }
+}
+
+TEST_CASE(EmptyHistogramSummarizesToZero)
+{
+    LatencyHistogram histogram;
+    LatencySummary summary;
+    histogram.Summarize(&summary);
+    CHECK(summary.count == 0);
+    CHECK(summary.p50 == 0);
+    CHECK(summary.p99 == 0);
+    CHECK(summary.max == 0);
+}
+
+TEST_CASE(PercentilesOfAUniformSpread)
+{
+    LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 1000; value++)
+    {
+        histogram.Record(value);
+    }
+
+    LatencySummary summary;
+    histogram.Summarize(&summary);
+    CHECK(summary.count == 1000);
+    CHECK(summary.max == 1000);
+
+    // Upper bucket bounds, so within an eighth above the exact rank.
+    CHECK(summary.p50 >= 500 && summary.p50 <= 500 + 500 / 8);
+    CHECK(summary.p95 >= 950 && summary.p95 <= 1000);
+    CHECK(summary.p99 >= 990 && summary.p99 <= 1000);
+}
+
+TEST_CASE(PercentilesNeverExceedTheMax)
+{
+    LatencyHistogram histogram;
+    histogram.Record(9);
+    histogram.Record(9);
+
+    LatencySummary summary;
+    histogram.Summarize(&summary);
+    CHECK(summary.p50 == 9);
+    CHECK(summary.p99 == 9);
+}
+
+TEST_CASE(HugeValuesAreClamped)
+{
+    LatencyHistogram histogram;
+    histogram.Record(0x1ffffffffull);
+
+    LatencySummary summary;
+    histogram.Summarize(&summary);
+    CHECK(summary.count == 1);
+    CHECK(summary.max == 0xffffffffull);
+}
+
+TEST_CASE(ResetForgetsEverything)
+{
+    LatencyHistogram histogram;
+    histogram.Record(42);
+    histogram.Reset();
+
+    LatencySummary summary;
+    histogram.Summarize(&summary);
+    CHECK(summary.count == 0);
+    CHECK(summary.max == 0);
+}
+
+TEST_CASE(ConcurrentRecordsAreAllCounted)
+{
+    const int c_threads = 4;
+    const uint64_t c_perThread = 100000;
+    LatencyHistogram histogram;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < c_threads; t++)
+    {
+        threads.emplace_back([&histogram, t]() {
+            for (uint64_t i = 0; i < c_perThread; i++)
+            {
+                histogram.Record(i % 5000 + (uint64_t)t);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    LatencySummary summary;
+    histogram.Summarize(&summary);
+    CHECK(summary.count == c_threads * c_perThread);
+    CHECK(summary.max == 4999 + c_threads - 1);
+}
@@ -0,0 +1,27 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Must NOT compile. log_format_mismatch_test builds this file and passes
+// only when the compiler stops at the format check below, which is the
+// static_assert ME_LOG expands to (MediaEngine.h itself needs the Windows
+// headers). A player id passed for %s is the kind of mistake it exists
+// to catch.
+
+#include "AsyncLogger.h"
+
+#define TEST_LOG(format, ...) \
+    static_assert(MEDIA::LogFormatMatches(format, decltype(MEDIA::LogArgKindsOf(__VA_ARGS__))()), \
+        "log arguments do not match the format " #format)
+
+void LogAPlayerIdAsAString()
+{
+    TEST_LOG(L"player %s started", MEDIA::LogPlayerId(3));
+}
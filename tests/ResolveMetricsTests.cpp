@@ -0,0 +1,141 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "ResolveMetrics.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace MEDIA;
+
+TEST_CASE(OutcomesAreCountedSeparately)
+{
+    ResolveMetrics metrics;
+    metrics.Record(ResolveOutcome_Resolved, 100, 0);
+    metrics.Record(ResolveOutcome_Resolved, 300, 2);
+    metrics.Record(ResolveOutcome_Failed, 5, 1);
+    metrics.Record(ResolveOutcome_Cancelled, 7, 0);
+    metrics.Record(ResolveOutcome_TimedOut, 5000000, 4);
+    metrics.Record((ResolveOutcome)42, 1, 0);
+
+    ResolveStats stats = Test::Stats(metrics);
+    CHECK(stats.resolved == 2);
+    CHECK(stats.failed == 2);
+    CHECK(stats.cancelled == 1);
+    CHECK(stats.timedOut == 1);
+    CHECK(stats.retries == 7);
+}
+
+TEST_CASE(OnlyResolvedRequestsFeedTheLatency)
+{
+    ResolveMetrics metrics;
+    metrics.Record(ResolveOutcome_TimedOut, 5000000, 0);
+    metrics.Record(ResolveOutcome_Cancelled, 4000000, 0);
+    CHECK(Test::Stats(metrics).latency.count == 0);
+
+    for (uint64_t i = 1; i <= 100; i++)
+    {
+        metrics.Record(ResolveOutcome_Resolved, i * 10, 0);
+    }
+
+    ResolveStats stats = Test::Stats(metrics);
+    CHECK(stats.latency.count == 100);
+    CHECK(stats.latency.max == 1000);
+    CHECK(stats.latency.p50 >= 490 && stats.latency.p50 <= 520);
+    CHECK(stats.latency.p99 <= stats.latency.max);
+}
+
+TEST_CASE(GetStatsIgnoresNull)
+{
+    ResolveMetrics metrics;
+    metrics.GetStats(nullptr);
+    CHECK(Test::Stats(metrics).resolved == 0);
+}
+
+TEST_CASE(TheGateLetsOneFinisherThrough)
+{
+    ResolveGate gate;
+    CHECK(!gate.IsFinished());
+    CHECK(gate.TryFinish());
+    CHECK(gate.IsFinished());
+    CHECK(!gate.TryFinish());
+}
+
+// Completion, cancellation and timeout racing for the same request: one
+// of them wins every time.
+TEST_CASE(StressRacingFinishers)
+{
+    const int c_requests = 2000;
+    int winners[c_requests] = {};
+    for (int request = 0; request < c_requests; request++)
+    {
+        ResolveGate gate;
+        std::atomic<int> won(0);
+        std::atomic<int> ready(0);
+        std::vector<std::thread> finishers;
+        for (int f = 0; f < 3; f++)
+        {
+            finishers.emplace_back([&]() {
+                ready++;
+                while (ready.load() < 3)
+                {
+                    std::this_thread::yield();
+                }
+                if (gate.TryFinish())
+                {
+                    won++;
+                }
+            });
+        }
+        for (auto& finisher : finishers)
+        {
+            finisher.join();
+        }
+        winners[request] = won.load();
+    }
+
+    int wrong = 0;
+    for (int count : winners)
+    {
+        wrong += (count != 1) ? 1 : 0;
+    }
+    CHECK(wrong == 0);
+}
+
+TEST_CASE(ConcurrentRecordsAreAllCounted)
+{
+    const int c_threads = 4;
+    const uint32_t c_records = 10000;
+    ResolveMetrics metrics;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < c_threads; t++)
+    {
+        threads.emplace_back([&metrics]() {
+            for (uint32_t i = 0; i < c_records; i++)
+            {
+                metrics.Record((i % 4) == 0 ? ResolveOutcome_TimedOut : ResolveOutcome_Resolved, i, 1);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ResolveStats stats = Test::Stats(metrics);
+    CHECK(stats.resolved == (uint64_t)c_threads * c_records * 3 / 4);
+    CHECK(stats.timedOut == (uint64_t)c_threads * c_records / 4);
+    CHECK(stats.retries == (uint64_t)c_threads * c_records);
+    CHECK(stats.latency.count == stats.resolved);
+}
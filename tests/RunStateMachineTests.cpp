@@ -0,0 +1,279 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "RunStateMachine.h"
+#include "VSyncScheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace MEDIA;
+
+namespace
+{
+    const int64_t c_interval = 16667;
+
+    // Every vblank arrives at once, or after a short sleep for the cases
+    // that run a real pump thread.
+    class FakeClock : public IVSyncClock
+    {
+    public:
+        FakeClock() : now(0), sleepMicroseconds(0) {}
+
+        virtual int64_t NowMicroseconds() override
+        {
+            return now;
+        }
+
+        virtual bool WaitForVBlank() override
+        {
+            if (sleepMicroseconds > 0)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(sleepMicroseconds));
+            }
+            now += c_interval;
+            return true;
+        }
+
+        int64_t now;
+        int64_t sleepMicroseconds;
+    };
+
+    // What MEPlayer does with the machine: PLAYING registers it with the
+    // scheduler, leaving PLAYING unregisters it, and every vblank the
+    // player sees is recorded as a wakeup.
+    class PacedPlayer : public IVSyncTarget, public std::enable_shared_from_this<PacedPlayer>
+    {
+    public:
+        explicit PacedPlayer(VSyncScheduler* scheduler) :
+            startThrows(false),
+            pumpStarts(0),
+            m_scheduler(scheduler),
+            m_playing(false)
+        {
+        }
+
+        ~PacedPlayer()
+        {
+            JoinPump();
+        }
+
+        bool Set(RunState state)
+        {
+            return machine.Set(state,
+                [this]() {
+                    if (startThrows)
+                    {
+                        throw std::runtime_error("start failed");
+                    }
+                    m_playing = true;
+                    if (m_scheduler->AddTarget(shared_from_this()))
+                    {
+                        pumpStarts++;
+                        JoinPump();
+                        m_pump = std::thread([this]() { m_scheduler->Run(); });
+                    }
+                },
+                [this]() {
+                    m_playing = false;
+                    m_scheduler->RemoveTarget(shared_from_this());
+                });
+        }
+
+        void JoinPump()
+        {
+            if (m_pump.joinable())
+            {
+                m_pump.join();
+            }
+        }
+
+        virtual bool HasPendingFrame() override
+        {
+            return machine.RecordWakeup(m_playing);
+        }
+
+        virtual bool OnVSync(int64_t) override
+        {
+            return true;
+        }
+
+        RunStateMachine machine;
+        bool startThrows;
+        int pumpStarts;
+
+    private:
+        VSyncScheduler* m_scheduler;
+        std::atomic<bool> m_playing;
+        std::thread m_pump;
+    };
+
+    bool WaitForWakeups(const PacedPlayer& player, int64_t wakeups)
+    {
+        return Test::WaitUntil([&player, wakeups]() { return Test::Stats(player.machine).wakeups >= wakeups; });
+    }
+}
+
+TEST_CASE(ParkedStatesNeverStartPacing)
+{
+    FakeClock clock;
+    VSyncScheduler scheduler(&clock, c_interval);
+    auto player = std::make_shared<PacedPlayer>(&scheduler);
+
+    CHECK(player->Set(RunState_Loading));
+    CHECK(player->Set(RunState_Paused));
+    CHECK(player->Set(RunState_Ended));
+    CHECK(player->Set(RunState_NoSource));
+
+    CHECK(scheduler.TargetCount() == 0);
+    CHECK(player->pumpStarts == 0);
+
+    RunStateStats stats = Test::Stats(player->machine);
+    CHECK(stats.state == RunState_NoSource);
+    CHECK(stats.parks == 0);
+    CHECK(stats.resumes == 0);
+    CHECK(stats.wakeups == 0);
+}
+
+TEST_CASE(ThePumpThreadExitsWhileParked)
+{
+    FakeClock clock;
+    clock.sleepMicroseconds = 200;
+    VSyncScheduler scheduler(&clock, c_interval);
+    auto player = std::make_shared<PacedPlayer>(&scheduler);
+
+    CHECK(player->Set(RunState_Loading));
+    CHECK(player->Set(RunState_Playing));
+    CHECK(player->pumpStarts == 1);
+    REQUIRE(WaitForWakeups(*player, 3));
+
+    // Pausing unregisters the only target, so Run returns and the thread
+    // ends by itself; the join would hang otherwise.
+    CHECK(player->Set(RunState_Paused));
+    player->JoinPump();
+    CHECK(scheduler.TargetCount() == 0);
+
+    // Nothing wakes the player while it is parked.
+    int64_t wakeups = Test::Stats(player->machine).wakeups;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    CHECK(Test::Stats(player->machine).wakeups == wakeups);
+
+    // The target can see one last tick from a snapshot taken before it
+    // was removed, never more.
+    CHECK(Test::Stats(player->machine).idleWakeups <= 1);
+}
+
+TEST_CASE(ResumingRestartsThePump)
+{
+    FakeClock clock;
+    VSyncScheduler scheduler(&clock, c_interval);
+    auto player = std::make_shared<PacedPlayer>(&scheduler);
+
+    CHECK(player->Set(RunState_Playing));
+    CHECK(player->Set(RunState_Paused));
+    player->JoinPump();
+    CHECK(player->Set(RunState_Playing));
+    CHECK(player->Set(RunState_Ended));
+    player->JoinPump();
+
+    CHECK(player->pumpStarts == 2);
+    VSyncSchedulerStats schedulerStats;
+    scheduler.GetStats(&schedulerStats);
+    CHECK(schedulerStats.starts == 2);
+
+    RunStateStats stats = Test::Stats(player->machine);
+    CHECK(stats.state == RunState_Ended);
+    CHECK(stats.resumes == 2);
+    CHECK(stats.parks == 2);
+}
+
+TEST_CASE(OnlyLeavingPlayingCountsAsAPark)
+{
+    FakeClock clock;
+    VSyncScheduler scheduler(&clock, c_interval);
+    auto player = std::make_shared<PacedPlayer>(&scheduler);
+
+    CHECK(player->Set(RunState_Playing));
+    CHECK(!player->Set(RunState_Playing));
+    CHECK(player->Set(RunState_Paused));
+    player->JoinPump();
+    CHECK(player->Set(RunState_Ended));
+    CHECK(player->Set(RunState_NoSource));
+
+    RunStateStats stats = Test::Stats(player->machine);
+    CHECK(stats.resumes == 1);
+    CHECK(stats.parks == 1);
+}
+
+TEST_CASE(ShutdownIsFinal)
+{
+    FakeClock clock;
+    VSyncScheduler scheduler(&clock, c_interval);
+    auto player = std::make_shared<PacedPlayer>(&scheduler);
+
+    CHECK(player->Set(RunState_Playing));
+    CHECK(player->Set(RunState_Shutdown));
+    player->JoinPump();
+    CHECK(!player->Set(RunState_Playing));
+    CHECK(!player->Set(RunState_Loading));
+
+    CHECK(scheduler.TargetCount() == 0);
+    CHECK(player->machine.State() == RunState_Shutdown);
+    CHECK(Test::Stats(player->machine).parks == 1);
+}
+
+TEST_CASE(AFailedStartLeavesTheStateAlone)
+{
+    FakeClock clock;
+    VSyncScheduler scheduler(&clock, c_interval);
+    auto player = std::make_shared<PacedPlayer>(&scheduler);
+    CHECK(player->Set(RunState_Loading));
+
+    player->startThrows = true;
+    bool threw = false;
+    try
+    {
+        player->Set(RunState_Playing);
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(player->machine.State() == RunState_Loading);
+    CHECK(Test::Stats(player->machine).resumes == 0);
+    CHECK(scheduler.TargetCount() == 0);
+
+    // The next attempt goes through.
+    player->startThrows = false;
+    CHECK(player->Set(RunState_Playing));
+    CHECK(Test::Stats(player->machine).resumes == 1);
+    CHECK(player->Set(RunState_Shutdown));
+}
+
+TEST_CASE(WakeupsWhileNotRunningAreIdle)
+{
+    RunStateMachine machine;
+    CHECK(machine.RecordWakeup(true));
+    CHECK(!machine.RecordWakeup(false));
+    CHECK(!machine.RecordWakeup(false));
+
+    RunStateStats stats = Test::Stats(machine);
+    CHECK(stats.wakeups == 3);
+    CHECK(stats.idleWakeups == 2);
+
+    // null is ignored
+    machine.GetStats(nullptr);
+}
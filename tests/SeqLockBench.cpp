@@ -0,0 +1,140 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Cost of the render thread reading its config each frame, through the
+// seqlock against the lock it replaced, with and without a UI thread
+// writing layout changes at the same time.
+
+#include "Benchmark.h"
+#include "SeqLock.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+
+namespace
+{
+    struct Config
+    {
+        uint32_t processId;
+        float width;
+        float height;
+        float videoWidth;
+        float videoHeight;
+        int32_t mode;
+        bool mirror;
+    };
+
+    class LockedConfig
+    {
+    public:
+        void Write(const Config& config)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_config = config;
+            m_version += 2;
+        }
+
+        uint64_t Read(Config* config)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            *config = m_config;
+            return m_version;
+        }
+
+    private:
+        std::mutex m_lock;
+        Config m_config = {};
+        uint64_t m_version = 0;
+    };
+
+    const uint64_t c_reads = 20000000;
+
+    // Writes continuously on another thread while body runs.
+    template <typename Writer, typename Body>
+    void WithWriter(Writer write, Body body)
+    {
+        std::atomic<bool> done(false);
+        std::thread writer([&]() {
+            Config config = { 1, 640.0f, 360.0f, 1920.0f, 1080.0f, 0, false };
+            while (!done.load(std::memory_order_relaxed))
+            {
+                config.width += 1.0f;
+                write(config);
+            }
+        });
+        body();
+        done = true;
+        writer.join();
+    }
+}
+
+int main()
+{
+    SeqLock<Config> seqLock;
+    LockedConfig locked;
+
+    Bench::Run("seqlock read", c_reads, [&](uint64_t n) {
+        Config config;
+        for (uint64_t i = 0; i < n; i++)
+        {
+            Bench::KeepAlive(seqLock.Read(&config));
+            Bench::KeepAlive(config);
+        }
+    });
+
+    Bench::Run("seqlock read if changed", c_reads, [&](uint64_t n) {
+        Config config;
+        uint64_t version = 0;
+        for (uint64_t i = 0; i < n; i++)
+        {
+            Bench::KeepAlive(seqLock.ReadIfChanged(&version, &config));
+        }
+    });
+
+    Bench::Run("mutex read", c_reads, [&](uint64_t n) {
+        Config config;
+        for (uint64_t i = 0; i < n; i++)
+        {
+            Bench::KeepAlive(locked.Read(&config));
+            Bench::KeepAlive(config);
+        }
+    });
+
+    // With one CPU the writer only runs when the reader is descheduled, so
+    // these numbers mean something only on a multi-core machine.
+    printf("%u hardware threads\n", std::thread::hardware_concurrency());
+    WithWriter([&](const Config& config) { seqLock.Write(config); }, [&]() {
+        Bench::Run("seqlock read, writer running", c_reads / 4, [&](uint64_t n) {
+            Config config;
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::KeepAlive(seqLock.Read(&config));
+                Bench::KeepAlive(config);
+            }
+        });
+    });
+
+    WithWriter([&](const Config& config) { locked.Write(config); }, [&]() {
+        Bench::Run("mutex read, writer running", c_reads / 4, [&](uint64_t n) {
+            Config config;
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::KeepAlive(locked.Read(&config));
+                Bench::KeepAlive(config);
+            }
+        });
+    });
+
+    return 0;
+}
@@ -0,0 +1,218 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "SeqLock.h"
+
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+
+namespace
+{
+    // Shaped like the renderer's config: not a whole number of words.
+    struct Config
+    {
+        uint32_t processId;
+        float width;
+        float height;
+        float videoWidth;
+        float videoHeight;
+        int32_t mode;
+        bool mirror;
+    };
+
+    // Every field carries the same stamp, so a torn copy shows up as a
+    // mismatch between fields.
+    struct Stamped
+    {
+        uint64_t stamp[5];
+        uint32_t tail;
+    };
+
+    Stamped MakeStamped(uint64_t stamp)
+    {
+        Stamped value;
+        for (auto& word : value.stamp)
+        {
+            word = stamp;
+        }
+        value.tail = (uint32_t)stamp;
+        return value;
+    }
+
+    bool IsConsistent(const Stamped& value)
+    {
+        for (auto word : value.stamp)
+        {
+            if (word != value.stamp[0])
+            {
+                return false;
+            }
+        }
+        return value.tail == (uint32_t)value.stamp[0];
+    }
+}
+
+TEST_CASE(ADefaultValueReadsAsZero)
+{
+    SeqLock<Config> lock;
+    Config config;
+    config.width = 1.0f;
+    CHECK(lock.Read(&config) == 0);
+    CHECK(config.processId == 0 && config.width == 0.0f && !config.mirror);
+    CHECK(lock.Version() == 0);
+}
+
+TEST_CASE(WritesRoundTrip)
+{
+    Config written = { 42, 640.0f, 360.0f, 1920.0f, 1080.0f, 2, true };
+    SeqLock<Config> lock(written);
+
+    Config read = {};
+    CHECK(lock.Read(&read) == 2);
+    CHECK(read.processId == 42);
+    CHECK(read.width == 640.0f && read.height == 360.0f);
+    CHECK(read.videoWidth == 1920.0f && read.videoHeight == 1080.0f);
+    CHECK(read.mode == 2 && read.mirror);
+}
+
+TEST_CASE(EachWriteBumpsTheVersionByTwo)
+{
+    SeqLock<uint32_t> lock;
+    for (uint32_t i = 1; i <= 10; i++)
+    {
+        lock.Write(i);
+        CHECK(lock.Version() == 2 * i);
+    }
+}
+
+TEST_CASE(ReadIfChangedOnlyReadsNewWrites)
+{
+    SeqLock<uint32_t> lock(7);
+    uint64_t version = 0;
+    uint32_t value = 0;
+
+    CHECK(lock.ReadIfChanged(&version, &value));
+    CHECK(value == 7 && version == 2);
+
+    value = 0;
+    CHECK(!lock.ReadIfChanged(&version, &value));
+    CHECK(value == 0);
+
+    // Writing the same value is still a change.
+    lock.Write(7);
+    CHECK(lock.ReadIfChanged(&version, &value));
+    CHECK(value == 7 && version == 4);
+}
+
+TEST_CASE(TryReadReadsLikeRead)
+{
+    SeqLock<uint32_t> lock(9);
+    uint32_t value = 0;
+    uint64_t version = 0;
+    CHECK(lock.TryRead(&value, &version, 1));
+    CHECK(value == 9 && version == 2);
+}
+
+// A writer in another process that dies mid-write leaves the version odd.
+// The version is the first word, so a test can leave it that way too.
+TEST_CASE(TryReadGivesUpOnAWriterThatStopped)
+{
+    static_assert(std::is_standard_layout<SeqLock<uint32_t>>::value, "the version is the first word");
+    alignas(SeqLock<uint32_t>) unsigned char memory[sizeof(SeqLock<uint32_t>)];
+    SeqLock<uint32_t>* lock = new (memory) SeqLock<uint32_t>(9);
+    uint64_t stopped = 3;
+    std::memcpy(memory, &stopped, sizeof(stopped));
+
+    uint32_t value = 0;
+    uint64_t version = 0;
+    CHECK(!lock->TryRead(&value, &version, 1000));
+    CHECK(value == 0 && version == 0);
+
+    // The next writer starts past the half finished write.
+    lock->Write(10);
+    CHECK(lock->Version() == 6);
+    CHECK(lock->TryRead(&value, &version, 1));
+    CHECK(value == 10 && version == 6);
+    lock->~SeqLock<uint32_t>();
+}
+
+TEST_CASE(ReadersNeverSeeATornValue)
+{
+    SeqLock<Stamped> lock(MakeStamped(0));
+    std::atomic<bool> done(false);
+    std::atomic<int> started(0);
+    std::atomic<int> torn(0);
+    std::atomic<int> backwards(0);
+    std::atomic<uint64_t> reads(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++)
+    {
+        readers.emplace_back([&]() {
+            started++;
+            uint64_t lastVersion = 0;
+            uint64_t lastStamp = 0;
+            uint64_t count = 0;
+            while (!done.load())
+            {
+                Stamped value;
+                uint64_t version = lock.Read(&value);
+                if (!IsConsistent(value))
+                {
+                    torn++;
+                }
+                // versions and values only move forward, and agree
+                if (version < lastVersion || value.stamp[0] < lastStamp || version != 2 * value.stamp[0] + 2)
+                {
+                    backwards++;
+                }
+                lastVersion = version;
+                lastStamp = value.stamp[0];
+                count++;
+            }
+            reads += count;
+        });
+    }
+
+    while (started.load() < 3)
+    {
+        std::this_thread::yield();
+    }
+
+    const uint64_t c_writes = 200000;
+    for (uint64_t stamp = 1; stamp <= c_writes; stamp++)
+    {
+        lock.Write(MakeStamped(stamp));
+        if (stamp % 1024 == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    done = true;
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    CHECK(torn.load() == 0);
+    CHECK(backwards.load() == 0);
+    CHECK(reads.load() > 0);
+
+    Stamped last;
+    CHECK(lock.Read(&last) == 2 * c_writes + 2);
+    CHECK(last.stamp[0] == c_writes && IsConsistent(last));
+}
@@ -0,0 +1,80 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Register and take pairs from several threads at once, sharded against a
+// single shard, which behaves like the one global lock it replaced.
+
+#include "Benchmark.h"
+#include "SourceRegistry.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace MEDIA;
+
+namespace
+{
+    const uint64_t c_pairsPerThread = 200000;
+
+    template <uint32_t Shards>
+    void RunContention(const char* label, int threads)
+    {
+        SourceRegistry<std::shared_ptr<int>, Shards> registry(1000);
+        auto source = std::make_shared<int>(0);
+
+        // keys are built up front so the timing is the registry alone
+        std::vector<std::vector<std::wstring>> keys(threads);
+        for (int t = 0; t < threads; t++)
+        {
+            for (uint64_t i = 0; i < 64; i++)
+            {
+                keys[t].push_back(L"ms-media-stream-id:" + std::to_wstring(t) + L"/" + std::to_wstring(i));
+            }
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "%s, %d threads", label, threads);
+        Bench::Run(name, c_pairsPerThread * threads, [&](uint64_t) {
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; t++)
+            {
+                workers.emplace_back([&registry, &keys, &source, t]() {
+                    std::shared_ptr<int> value;
+                    for (uint64_t i = 0; i < c_pairsPerThread; i++)
+                    {
+                        const std::wstring& key = keys[t][i % 64];
+                        registry.Register(key, source, i);
+                        registry.Take(key, i, &value);
+                    }
+                    Bench::KeepAlive(value);
+                });
+            }
+            for (auto& worker : workers)
+            {
+                worker.join();
+            }
+        });
+    }
+}
+
+int main()
+{
+    printf("%u hardware threads\n", std::thread::hardware_concurrency());
+    const int threadCounts[] = { 1, 2, 4, 8 };
+    for (int threads : threadCounts)
+    {
+        RunContention<1>("register+take, 1 shard", threads);
+        RunContention<16>("register+take, 16 shards", threads);
+    }
+    return 0;
+}
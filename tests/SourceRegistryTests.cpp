@@ -0,0 +1,204 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "SourceRegistry.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace MEDIA;
+
+namespace
+{
+    const uint64_t c_timeToLive = 1000;
+
+    std::wstring Key(int thread, int index)
+    {
+        return L"ms-media-stream-id:" + std::to_wstring(thread) + L"/" + std::to_wstring(index);
+    }
+}
+
+TEST_CASE(AKeyIsTakenExactlyOnce)
+{
+    SourceRegistry<int> registry(c_timeToLive);
+    CHECK(registry.Register(L"a", 1, 0));
+    CHECK(registry.Register(L"b", 2, 0));
+
+    int value = 0;
+    CHECK(registry.Take(L"a", 10, &value));
+    CHECK(value == 1);
+    CHECK(!registry.Take(L"a", 10, &value));
+    CHECK(!registry.Take(L"never", 10, &value));
+
+    SourceRegistryStats stats = Test::Stats(registry);
+    CHECK(stats.live == 1);
+    CHECK(stats.registered == 2);
+    CHECK(stats.taken == 1);
+    CHECK(stats.misses == 2);
+}
+
+TEST_CASE(ALiveKeyCannotBeRegisteredTwice)
+{
+    SourceRegistry<int> registry(c_timeToLive);
+    CHECK(registry.Register(L"a", 1, 0));
+    CHECK(!registry.Register(L"a", 2, 500));
+    CHECK(Test::Stats(registry).duplicates == 1);
+
+    int value = 0;
+    CHECK(registry.Take(L"a", 600, &value));
+    CHECK(value == 1);
+
+    // Once taken the key is free again.
+    CHECK(registry.Register(L"a", 3, 700));
+}
+
+TEST_CASE(EntriesExpireAfterTheirTimeToLive)
+{
+    SourceRegistry<int> registry(c_timeToLive);
+    registry.Register(L"a", 1, 0);
+
+    int value = 0;
+    CHECK(!registry.Take(L"a", c_timeToLive, &value));
+    CHECK(value == 0);
+
+    SourceRegistryStats stats = Test::Stats(registry);
+    CHECK(stats.live == 0);
+    CHECK(stats.expired == 1);
+    CHECK(stats.misses == 1);
+}
+
+TEST_CASE(SweepDropsOnlyExpiredEntries)
+{
+    SourceRegistry<int> registry(c_timeToLive);
+    for (int i = 0; i < 40; i++)
+    {
+        registry.Register(Key(0, i), i, (i < 6) ? 0 : 600);
+    }
+
+    // The first six expired at 1000, the rest live until 1600.
+    CHECK(registry.Sweep(1500) == 6);
+    CHECK(registry.Sweep(1500) == 0);
+    CHECK(Test::Stats(registry).live == 34);
+
+    int value;
+    CHECK(!registry.Take(Key(0, 5), 1500, &value));
+    CHECK(registry.Take(Key(0, 6), 1500, &value) && value == 6);
+}
+
+TEST_CASE(AnExpiredKeyCanBeRegisteredAgain)
+{
+    // One shard, so the registration sweeps the stale entry first.
+    SourceRegistry<int, 1> registry(c_timeToLive);
+    registry.Register(L"a", 1, 0);
+    CHECK(registry.Register(L"a", 2, c_timeToLive + 1));
+
+    int value = 0;
+    CHECK(registry.Take(L"a", c_timeToLive + 2, &value));
+    CHECK(value == 2);
+    CHECK(Test::Stats(registry).expired == 1);
+    CHECK(Test::Stats(registry).duplicates == 0);
+}
+
+// Releasing a source can run arbitrary code, including code that touches
+// the registry again; with a single shard that would deadlock if expired
+// values were released under the lock.
+TEST_CASE(ExpiredValuesAreReleasedOutsideTheLock)
+{
+    typedef SourceRegistry<std::shared_ptr<int>, 1> Registry;
+    Registry registry(c_timeToLive);
+    int released = 0;
+
+    // the deleter takes the shard lock, as a source's teardown might
+    auto reentrant = [&registry, &released]() {
+        return std::shared_ptr<int>(new int(0), [&registry, &released](int* value) {
+            std::shared_ptr<int> other;
+            registry.Take(L"unrelated", 0, &other);
+            released++;
+            delete value;
+        });
+    };
+
+    registry.Register(L"swept", reentrant(), 0);
+    registry.Register(L"taken", reentrant(), 0);
+
+    std::shared_ptr<int> value;
+    CHECK(!registry.Take(L"taken", c_timeToLive, &value));
+    CHECK(released == 1);
+    CHECK(registry.Sweep(c_timeToLive) == 1);
+    CHECK(released == 2);
+
+    // and through the sweep a registration does
+    registry.Register(L"registered", reentrant(), 0);
+    CHECK(registry.Register(L"next", std::make_shared<int>(1), c_timeToLive));
+    CHECK(released == 3);
+    CHECK(Test::Stats(registry).live == 1);
+}
+
+// Threads register and take their own keys while others try to steal
+// them and a sweeper runs; every key ends up taken exactly once.
+TEST_CASE(StressRegisterTakeAndSweep)
+{
+    const int c_threads = 4;
+    const int c_keys = 5000;
+    SourceRegistry<int> registry(1u << 30);
+    std::atomic<int> taken(0);
+    std::atomic<int> stolen(0);
+    std::atomic<bool> finished(false);
+
+    std::thread sweeper([&]() {
+        while (!finished.load())
+        {
+            registry.Sweep(1);
+            std::this_thread::yield();
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < c_threads; t++)
+    {
+        threads.emplace_back([&, t]() {
+            int value;
+            for (int i = 0; i < c_keys; i++)
+            {
+                registry.Register(Key(t, i), i, 0);
+
+                // take a neighbour's key now and then
+                if ((i % 7) == 0 && registry.Take(Key((t + 1) % c_threads, i), 1, &value))
+                {
+                    stolen++;
+                }
+                if (registry.Take(Key(t, i), 1, &value))
+                {
+                    taken++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    finished.store(true);
+    sweeper.join();
+
+    // Owners take their key right after registering it, so whatever was
+    // not stolen went to its owner and nothing is left over.
+    SourceRegistryStats stats = Test::Stats(registry);
+    CHECK(taken.load() + stolen.load() == c_threads * c_keys);
+    CHECK(stats.live == 0);
+    CHECK(stats.taken == (uint64_t)(c_threads * c_keys));
+    CHECK(stats.registered == (uint64_t)(c_threads * c_keys));
+    CHECK(stats.expired == 0);
+}
@@ -0,0 +1,154 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Minimal test registry, so the tests need nothing beyond the compiler.
+//
+//   TEST_CASE(NameOfTheCase)
+//   {
+//       CHECK(1 + 1 == 2);
+//   }
+//
+// A failed CHECK reports itself and the case carries on; REQUIRE returns
+// from the case instead. TestMain.cpp runs every registered case and exits
+// non-zero if any check failed.
+//
+// The helpers below are shared by the fixtures: Stats, WaitUntil for
+// conditions another thread makes true, and Gate to hold a worker thread
+// inside a callback.
+//-----------------------------------------------------------------------------
+namespace Test
+{
+    typedef void (*CaseFunction)();
+
+    struct Case
+    {
+        const char* name;
+        CaseFunction function;
+    };
+
+    inline std::vector<Case>& Cases()
+    {
+        static std::vector<Case> cases;
+        return cases;
+    }
+
+    inline int& Failures()
+    {
+        static int failures = 0;
+        return failures;
+    }
+
+    struct Registrar
+    {
+        Registrar(const char* name, CaseFunction function)
+        {
+            Cases().push_back(Case{ name, function });
+        }
+    };
+
+    inline bool Check(bool passed, const char* expression, const char* file, int line)
+    {
+        if (!passed)
+        {
+            fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+            Failures()++;
+        }
+        return passed;
+    }
+
+    template <typename Source, typename StatsType>
+    StatsType StatsTypeOf(void (Source::*)(StatsType*) const);
+    template <typename Source, typename StatsType>
+    StatsType StatsTypeOf(void (Source::*)(StatsType*));
+
+    // What source.GetStats(&stats) fills in, by value.
+    template <typename Source>
+    auto Stats(Source& source) -> decltype(StatsTypeOf(&std::remove_const<Source>::type::GetStats))
+    {
+        decltype(StatsTypeOf(&std::remove_const<Source>::type::GetStats)) stats = {};
+        source.GetStats(&stats);
+        return stats;
+    }
+
+    // Polls condition until it holds. Background threads run on their own
+    // time, so they get up to two seconds.
+    template <typename Condition>
+    bool WaitUntil(Condition condition)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (!condition())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    // Enter blocks the calling thread until Release; the test waits for it
+    // with WaitUntilEntered, so work can queue up behind a busy worker.
+    class Gate
+    {
+    public:
+        Gate() : m_entered(false), m_open(false) {}
+
+        void Enter()
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_entered = true;
+            m_changed.notify_all();
+            m_changed.wait(lock, [this] { return m_open; });
+        }
+
+        void WaitUntilEntered()
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_changed.wait(lock, [this] { return m_entered; });
+        }
+
+        void Release()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_open = true;
+            m_changed.notify_all();
+        }
+
+    private:
+        std::mutex m_lock;
+        std::condition_variable m_changed;
+        bool m_entered;
+        bool m_open;
+    };
+}
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static Test::Registrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(expression) \
+    Test::Check((expression) ? true : false, #expression, __FILE__, __LINE__)
+
+#define REQUIRE(expression) \
+    do { if (!CHECK(expression)) return; } while (0)
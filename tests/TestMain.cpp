@@ -0,0 +1,37 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+
+#include <cstring>
+
+// Runs every case, or only those whose name contains argv[1].
+int main(int argc, char** argv)
+{
+    const char* filter = (argc > 1) ? argv[1] : nullptr;
+
+    int run = 0;
+    for (const Test::Case& testCase : Test::Cases())
+    {
+        if (filter != nullptr && strstr(testCase.name, filter) == nullptr)
+        {
+            continue;
+        }
+
+        int failuresBefore = Test::Failures();
+        testCase.function();
+        printf("%s %s\n", (Test::Failures() == failuresBefore) ? "[ pass ]" : "[ FAIL ]", testCase.name);
+        run++;
+    }
+
+    printf("%d cases, %d failed checks\n", run, Test::Failures());
+    return (Test::Failures() == 0 && run > 0) ? 0 : 1;
+}
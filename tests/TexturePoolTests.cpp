@@ -0,0 +1,209 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "TexturePool.h"
+
+#include <set>
+
+using namespace MEDIA;
+
+namespace
+{
+    // Hands out numbered fake textures, 4 bytes per pixel.
+    class FakeAllocator : public ITextureAllocator
+    {
+    public:
+        FakeAllocator() : next(1), fail(false) {}
+
+        ~FakeAllocator()
+        {
+            CHECK(live.empty());
+        }
+
+        virtual void* Allocate(const TextureKey&) override
+        {
+            if (fail)
+            {
+                return nullptr;
+            }
+            void* texture = reinterpret_cast<void*>(next++);
+            live.insert(texture);
+            return texture;
+        }
+
+        virtual void Free(void* texture) override
+        {
+            CHECK(live.erase(texture) == 1);
+        }
+
+        virtual uint64_t SizeInBytes(const TextureKey& key) override
+        {
+            return (uint64_t)key.width * key.height * 4;
+        }
+
+        uintptr_t next;
+        bool fail;
+        std::set<void*> live;
+    };
+
+    const TextureKey c_small = { 64, 64, 87 };     // 16 KiB
+    const TextureKey c_large = { 128, 128, 87 };   // 64 KiB
+}
+
+TEST_CASE(ReleasedTexturesAreReusedForTheSameKey)
+{
+    FakeAllocator allocator;
+    TexturePool pool(&allocator, 1 << 20);
+
+    void* first = pool.Acquire(c_small);
+    pool.Release(first);
+    void* second = pool.Acquire(c_small);
+    CHECK(second == first);
+
+    TexturePoolStats stats = Test::Stats(pool);
+    CHECK(stats.allocations == 1);
+    CHECK(stats.reuses == 1);
+    CHECK(stats.texturesInUse == 1);
+    CHECK(stats.bytesInUse == 64 * 64 * 4);
+
+    pool.Release(second);
+}
+
+TEST_CASE(ADifferentKeyAllocates)
+{
+    FakeAllocator allocator;
+    TexturePool pool(&allocator, 1 << 20);
+
+    void* small = pool.Acquire(c_small);
+    pool.Release(small);
+    void* large = pool.Acquire(c_large);
+    CHECK(large != small);
+    CHECK(Test::Stats(pool).allocations == 2);
+    CHECK(Test::Stats(pool).texturesIdle == 1);
+
+    pool.Release(large);
+}
+
+TEST_CASE(AResizeBackReusesTheOlderTextures)
+{
+    FakeAllocator allocator;
+    TexturePool pool(&allocator, 1 << 20);
+
+    // Three frame slots at one size, then a resize, then back again.
+    void* slots[3];
+    for (auto& slot : slots) slot = pool.Acquire(c_small);
+    for (auto& slot : slots) pool.Release(slot);
+    for (auto& slot : slots) slot = pool.Acquire(c_large);
+    for (auto& slot : slots) pool.Release(slot);
+    for (auto& slot : slots) slot = pool.Acquire(c_small);
+
+    TexturePoolStats stats = Test::Stats(pool);
+    CHECK(stats.allocations == 6);
+    CHECK(stats.reuses == 3);
+    CHECK(stats.evictions == 0);
+
+    for (auto& slot : slots) pool.Release(slot);
+}
+
+TEST_CASE(TheLeastRecentlyReleasedIsEvictedFirst)
+{
+    FakeAllocator allocator;
+    // Room for two small textures and nothing more.
+    TexturePool pool(&allocator, 2 * 64 * 64 * 4);
+
+    void* a = pool.Acquire(c_small);
+    void* b = pool.Acquire(c_small);
+    pool.Release(a);
+    pool.Release(b);
+
+    // A third texture needs room, so a goes.
+    void* c = pool.Acquire({ 32, 32, 87 });
+    CHECK(allocator.live.count(a) == 0);
+    CHECK(allocator.live.count(b) == 1);
+    CHECK(Test::Stats(pool).evictions == 1);
+
+    pool.Release(c);
+}
+
+TEST_CASE(TexturesInUseAreNeverEvicted)
+{
+    FakeAllocator allocator;
+    TexturePool pool(&allocator, 64 * 64 * 4);
+
+    void* a = pool.Acquire(c_small);
+    void* b = pool.Acquire(c_large);
+    CHECK(a != nullptr && b != nullptr);
+    CHECK(allocator.live.size() == 2);
+
+    TexturePoolStats stats = Test::Stats(pool);
+    CHECK(stats.bytesInUse > 64 * 64 * 4);
+    CHECK(stats.evictions == 0);
+
+    // Over budget, so whatever comes back is freed right away.
+    pool.Release(a);
+    CHECK(allocator.live.count(a) == 0);
+    pool.Release(b);
+    CHECK(Test::Stats(pool).texturesIdle == 0);
+}
+
+TEST_CASE(ShrinkingTheBudgetEvicts)
+{
+    FakeAllocator allocator;
+    TexturePool pool(&allocator, 1 << 20);
+    pool.Release(pool.Acquire(c_small));
+    pool.Release(pool.Acquire(c_large));
+
+    // Only the large one, released last, still fits.
+    pool.SetBudget(128 * 128 * 4);
+    TexturePoolStats stats = Test::Stats(pool);
+    CHECK(stats.texturesIdle == 1);
+    CHECK(stats.bytesIdle == 128 * 128 * 4);
+    CHECK(stats.evictions == 1);
+}
+
+TEST_CASE(TrimFreesEveryIdleTexture)
+{
+    FakeAllocator allocator;
+    TexturePool pool(&allocator, 1 << 20);
+    void* held = pool.Acquire(c_large);
+    pool.Release(pool.Acquire(c_small));
+    pool.Release(pool.Acquire(c_small));
+
+    pool.Trim();
+    CHECK(allocator.live.size() == 1);
+    CHECK(Test::Stats(pool).texturesIdle == 0);
+    CHECK(Test::Stats(pool).bytesIdle == 0);
+
+    pool.Release(held);
+}
+
+TEST_CASE(FailedAllocationsAreCounted)
+{
+    FakeAllocator allocator;
+    TexturePool pool(&allocator, 1 << 20);
+    allocator.fail = true;
+
+    CHECK(pool.Acquire(c_small) == nullptr);
+    TexturePoolStats stats = Test::Stats(pool);
+    CHECK(stats.failures == 1);
+    CHECK(stats.allocations == 0);
+    CHECK(stats.bytesInUse == 0);
+}
+
+TEST_CASE(UnknownAndNullReleasesAreIgnored)
+{
+    FakeAllocator allocator;
+    TexturePool pool(&allocator, 1 << 20);
+    pool.Release(nullptr);
+    pool.Release(reinterpret_cast<void*>(0x1234));
+    CHECK(Test::Stats(pool).texturesIdle == 0);
+}
@@ -0,0 +1,528 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "TraceSpans.h"
+
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace MEDIA;
+
+namespace
+{
+    //-------------------------------------------------------------------------
+    // Just enough of a strict JSON parser to prove an export is well formed
+    // and to read the events back out of it.
+    //-------------------------------------------------------------------------
+    struct JsonValue
+    {
+        enum Type { Null, Bool, Number, String, Array, Object };
+
+        JsonValue() : type(Null), number(0) {}
+
+        const JsonValue* Member(const std::string& key) const
+        {
+            for (const auto& member : members)
+            {
+                if (member.first == key)
+                {
+                    return &member.second;
+                }
+            }
+            return nullptr;
+        }
+
+        Type type;
+        double number;
+        std::string text;
+        std::vector<JsonValue> items;
+        std::vector<std::pair<std::string, JsonValue>> members;
+    };
+
+    class JsonParser
+    {
+    public:
+        explicit JsonParser(const std::string& text) : m_text(text), m_pos(0) {}
+
+        // False unless the whole text is exactly one JSON value.
+        bool Parse(JsonValue* value)
+        {
+            if (!ParseValue(value))
+            {
+                return false;
+            }
+            SkipSpace();
+            return m_pos == m_text.size();
+        }
+
+    private:
+        void SkipSpace()
+        {
+            while (m_pos < m_text.size() && strchr(" \t\r\n", m_text[m_pos]) != nullptr)
+            {
+                m_pos++;
+            }
+        }
+
+        bool Consume(char c)
+        {
+            SkipSpace();
+            if (m_pos < m_text.size() && m_text[m_pos] == c)
+            {
+                m_pos++;
+                return true;
+            }
+            return false;
+        }
+
+        bool ConsumeWord(const char* word)
+        {
+            size_t length = strlen(word);
+            if (m_text.compare(m_pos, length, word) != 0)
+            {
+                return false;
+            }
+            m_pos += length;
+            return true;
+        }
+
+        bool ParseValue(JsonValue* value)
+        {
+            SkipSpace();
+            if (m_pos >= m_text.size())
+            {
+                return false;
+            }
+
+            char c = m_text[m_pos];
+            if (c == '{')
+            {
+                return ParseObject(value);
+            }
+            if (c == '[')
+            {
+                return ParseArray(value);
+            }
+            if (c == '"')
+            {
+                value->type = JsonValue::String;
+                return ParseString(&value->text);
+            }
+            if (c == 't' || c == 'f')
+            {
+                value->type = JsonValue::Bool;
+                value->number = (c == 't') ? 1 : 0;
+                return ConsumeWord(c == 't' ? "true" : "false");
+            }
+            if (c == 'n')
+            {
+                return ConsumeWord("null");
+            }
+            return ParseNumber(value);
+        }
+
+        bool ParseObject(JsonValue* value)
+        {
+            value->type = JsonValue::Object;
+            m_pos++;
+            if (Consume('}'))
+            {
+                return true;
+            }
+            do
+            {
+                std::pair<std::string, JsonValue> member;
+                SkipSpace();
+                if (!ParseString(&member.first) || !Consume(':') || !ParseValue(&member.second))
+                {
+                    return false;
+                }
+                value->members.push_back(std::move(member));
+            } while (Consume(','));
+            return Consume('}');
+        }
+
+        bool ParseArray(JsonValue* value)
+        {
+            value->type = JsonValue::Array;
+            m_pos++;
+            if (Consume(']'))
+            {
+                return true;
+            }
+            do
+            {
+                JsonValue item;
+                if (!ParseValue(&item))
+                {
+                    return false;
+                }
+                value->items.push_back(std::move(item));
+            } while (Consume(','));
+            return Consume(']');
+        }
+
+        bool ParseString(std::string* out)
+        {
+            if (m_pos >= m_text.size() || m_text[m_pos] != '"')
+            {
+                return false;
+            }
+            m_pos++;
+
+            while (m_pos < m_text.size())
+            {
+                unsigned char c = (unsigned char)m_text[m_pos++];
+                if (c == '"')
+                {
+                    return true;
+                }
+                if (c < 0x20)
+                {
+                    return false;
+                }
+                if (c != '\\')
+                {
+                    out->push_back((char)c);
+                    continue;
+                }
+
+                if (m_pos >= m_text.size())
+                {
+                    return false;
+                }
+                char escape = m_text[m_pos++];
+                switch (escape)
+                {
+                case '"': out->push_back('"'); break;
+                case '\\': out->push_back('\\'); break;
+                case '/': out->push_back('/'); break;
+                case 'b': out->push_back('\b'); break;
+                case 'f': out->push_back('\f'); break;
+                case 'n': out->push_back('\n'); break;
+                case 'r': out->push_back('\r'); break;
+                case 't': out->push_back('\t'); break;
+                case 'u':
+                {
+                    // only the control characters the recorder escapes
+                    if (m_pos + 4 > m_text.size())
+                    {
+                        return false;
+                    }
+                    char* end = nullptr;
+                    std::string hex = m_text.substr(m_pos, 4);
+                    long code = strtol(hex.c_str(), &end, 16);
+                    if (end != hex.c_str() + 4 || code >= 0x80)
+                    {
+                        return false;
+                    }
+                    out->push_back((char)code);
+                    m_pos += 4;
+                    break;
+                }
+                default:
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        bool ParseNumber(JsonValue* value)
+        {
+            size_t start = m_pos;
+            if (m_pos < m_text.size() && m_text[m_pos] == '-')
+            {
+                m_pos++;
+            }
+            size_t digits = m_pos;
+            while (m_pos < m_text.size() && isdigit((unsigned char)m_text[m_pos]))
+            {
+                m_pos++;
+            }
+            if (m_pos == digits || (m_text[digits] == '0' && m_pos - digits > 1))
+            {
+                return false;
+            }
+            if (m_pos < m_text.size() && m_text[m_pos] == '.')
+            {
+                size_t fraction = ++m_pos;
+                while (m_pos < m_text.size() && isdigit((unsigned char)m_text[m_pos]))
+                {
+                    m_pos++;
+                }
+                if (m_pos == fraction)
+                {
+                    return false;
+                }
+            }
+            value->type = JsonValue::Number;
+            value->number = strtod(m_text.substr(start, m_pos - start).c_str(), nullptr);
+            return true;
+        }
+
+        const std::string& m_text;
+        size_t m_pos;
+    };
+
+    struct Event
+    {
+        std::string name;
+        std::string category;
+        double ts;
+        double dur;
+        double pid;
+        double tid;
+    };
+
+    // Parses an export and checks every event has the fields a trace
+    // viewer needs, with the right types.
+    bool ParseExport(const std::string& json, std::vector<Event>* events)
+    {
+        JsonValue root;
+        if (!JsonParser(json).Parse(&root) || root.type != JsonValue::Object)
+        {
+            return false;
+        }
+
+        const JsonValue* list = root.Member("traceEvents");
+        const JsonValue* unit = root.Member("displayTimeUnit");
+        if (list == nullptr || list->type != JsonValue::Array || unit == nullptr || unit->text != "ms")
+        {
+            return false;
+        }
+
+        for (const JsonValue& item : list->items)
+        {
+            const JsonValue* name = item.Member("name");
+            const JsonValue* cat = item.Member("cat");
+            const JsonValue* ph = item.Member("ph");
+            const JsonValue* ts = item.Member("ts");
+            const JsonValue* dur = item.Member("dur");
+            const JsonValue* pid = item.Member("pid");
+            const JsonValue* tid = item.Member("tid");
+            if (name == nullptr || name->type != JsonValue::String ||
+                cat == nullptr || cat->type != JsonValue::String ||
+                ph == nullptr || ph->text != "X" ||
+                ts == nullptr || ts->type != JsonValue::Number ||
+                dur == nullptr || dur->type != JsonValue::Number ||
+                pid == nullptr || pid->type != JsonValue::Number ||
+                tid == nullptr || tid->type != JsonValue::Number)
+            {
+                return false;
+            }
+
+            Event event = { name->text, cat->text, ts->number, dur->number, pid->number, tid->number };
+            events->push_back(event);
+        }
+        return true;
+    }
+}
+
+TEST_CASE(TheParserRejectsBrokenJson)
+{
+    JsonValue value;
+    CHECK(JsonParser("{\"a\":[1,2.5,\"x\"]}").Parse(&value));
+    CHECK(!JsonParser("{\"a\":[1,2,]}").Parse(&value));
+    CHECK(!JsonParser("{\"a\":1} x").Parse(&value));
+    CHECK(!JsonParser("\"tab\there\"").Parse(&value));
+    CHECK(!JsonParser("{\"a\":01}").Parse(&value));
+}
+
+TEST_CASE(AnEmptyCaptureIsValidJson)
+{
+    TraceRecorder& recorder = TraceRecorder::Instance();
+    recorder.Start();
+    std::vector<Event> events;
+    CHECK(ParseExport(recorder.ExportJson(), &events));
+    CHECK(events.empty());
+    CHECK(Test::Stats(recorder).enabled);
+
+    recorder.Stop();
+    CHECK(ParseExport(recorder.ExportJson(), &events));
+    CHECK(events.empty());
+    CHECK(!Test::Stats(recorder).enabled);
+}
+
+TEST_CASE(RecordedSpansComeOutAsCompleteEvents)
+{
+    TraceRecorder& recorder = TraceRecorder::Instance();
+    recorder.Start();
+    recorder.Record("Present", "media", 1500, 4250);
+    recorder.Record("Resolve", "source", 2000000, 1999000);
+
+    std::vector<Event> events;
+    REQUIRE(ParseExport(recorder.ExportJson(), &events));
+    REQUIRE(events.size() == 2);
+    CHECK(events[0].name == "Present");
+    CHECK(events[0].category == "media");
+    CHECK(events[0].ts == 1.5);
+    CHECK(events[0].dur == 2.75);
+    CHECK(events[0].pid > 0 && events[0].tid > 0);
+
+    // An end before the begin becomes an empty span.
+    CHECK(events[1].ts == 2000.0);
+    CHECK(events[1].dur == 0.0);
+}
+
+TEST_CASE(NamesAreEscaped)
+{
+    static const char c_name[] = "quote \" slash \\ newline \n tab \t bell \x07";
+    TraceRecorder& recorder = TraceRecorder::Instance();
+    recorder.Start();
+    recorder.Record(c_name, "cat\"egory", 0, 1);
+    recorder.Record(nullptr, nullptr, 0, 1);
+
+    std::vector<Event> events;
+    REQUIRE(ParseExport(recorder.ExportJson(), &events));
+    REQUIRE(events.size() == 2);
+    CHECK(events[0].name == c_name);
+    CHECK(events[0].category == "cat\"egory");
+    CHECK(events[1].name.empty());
+}
+
+TEST_CASE(StartDiscardsThePreviousCapture)
+{
+    TraceRecorder& recorder = TraceRecorder::Instance();
+    recorder.Start();
+    recorder.Record("old", "media", 0, 1);
+    recorder.Stop();
+    CHECK(!Test::Stats(recorder).enabled);
+
+    // Export still works after Stop.
+    std::vector<Event> events;
+    REQUIRE(ParseExport(recorder.ExportJson(), &events));
+    CHECK(events.size() == 1);
+
+    recorder.Start();
+    recorder.Record("new", "media", 0, 1);
+    events.clear();
+    REQUIRE(ParseExport(recorder.ExportJson(), &events));
+    REQUIRE(events.size() == 1);
+    CHECK(events[0].name == "new");
+    CHECK(Test::Stats(recorder).recorded == 1);
+}
+
+TEST_CASE(EachThreadDropsBeyondItsLimit)
+{
+    TraceRecorder& recorder = TraceRecorder::Instance();
+    recorder.Start();
+    for (uint32_t i = 0; i < TraceRecorder::c_eventsPerThread + 5; i++)
+    {
+        recorder.Record("span", "media", i, i + 1);
+    }
+
+    TraceStats stats = Test::Stats(recorder);
+    CHECK(stats.recorded == TraceRecorder::c_eventsPerThread);
+    CHECK(stats.dropped == 5);
+
+    std::vector<Event> events;
+    REQUIRE(ParseExport(recorder.ExportJson(), &events));
+    CHECK(events.size() == TraceRecorder::c_eventsPerThread);
+}
+
+TEST_CASE(SpansOnlyRecordWhileTracing)
+{
+    TraceRecorder& recorder = TraceRecorder::Instance();
+    recorder.Stop();
+    {
+        ME_TRACE_SPAN("while stopped");
+    }
+
+    recorder.Start();
+    {
+        ME_TRACE_SPAN("outer");
+        {
+            ME_TRACE_SPAN("inner");
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+    recorder.Stop();
+
+    std::vector<Event> events;
+    REQUIRE(ParseExport(recorder.ExportJson(), &events));
+    REQUIRE(events.size() == 2);
+
+    // Spans close innermost first, and the outer one contains the inner.
+    CHECK(events[0].name == "inner");
+    CHECK(events[1].name == "outer");
+    CHECK(events[0].category == "media");
+    CHECK(events[0].dur >= 2000.0);
+    CHECK(events[1].ts <= events[0].ts);
+    CHECK(events[1].ts + events[1].dur >= events[0].ts + events[0].dur);
+}
+
+// Several threads record while another keeps exporting; every export must
+// parse, and the final one holds every span, grouped by thread id.
+TEST_CASE(StressExportWhileRecording)
+{
+    const int c_threads = 4;
+    const int c_spans = 2000;
+    TraceRecorder& recorder = TraceRecorder::Instance();
+    recorder.Start();
+
+    std::atomic<int> running(c_threads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < c_threads; t++)
+    {
+        threads.emplace_back([&recorder, &running]() {
+            for (int i = 0; i < c_spans; i++)
+            {
+                uint64_t begin = recorder.Now();
+                recorder.Record("work", "media", begin, recorder.Now());
+            }
+            running--;
+        });
+    }
+
+    int exports = 0;
+    int invalid = 0;
+    while (running.load() > 0)
+    {
+        std::vector<Event> events;
+        if (!ParseExport(recorder.ExportJson(), &events))
+        {
+            invalid++;
+        }
+        exports++;
+        std::this_thread::yield();
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    CHECK(invalid == 0);
+    CHECK(exports > 0);
+
+    std::vector<Event> events;
+    REQUIRE(ParseExport(recorder.ExportJson(), &events));
+    CHECK(events.size() == (size_t)(c_threads * c_spans));
+
+    std::map<double, int> perThread;
+    for (const Event& event : events)
+    {
+        perThread[event.tid]++;
+    }
+    CHECK(perThread.size() == (size_t)c_threads);
+    for (const auto& entry : perThread)
+    {
+        CHECK(entry.second == c_spans);
+    }
+    CHECK(Test::Stats(recorder).threads == (uint32_t)c_threads);
+}
@@ -0,0 +1,96 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Cost of one scheduler tick with many simulated players, headless: the
+// clock returns immediately, so this is the fan-out overhead alone.
+
+#include "Benchmark.h"
+#include "VSyncScheduler.h"
+
+#include <memory>
+#include <vector>
+
+using namespace MEDIA;
+
+namespace
+{
+    class FreeRunningClock : public IVSyncClock
+    {
+    public:
+        FreeRunningClock() : m_now(0) {}
+
+        virtual int64_t NowMicroseconds() override
+        {
+            return m_now;
+        }
+
+        virtual bool WaitForVBlank() override
+        {
+            m_now += 16667;
+            return true;
+        }
+
+    private:
+        int64_t m_now;
+    };
+
+    class SimulatedPlayer : public IVSyncTarget
+    {
+    public:
+        explicit SimulatedPlayer(bool pending) : m_pending(pending), m_frames(0) {}
+
+        virtual bool HasPendingFrame() override
+        {
+            return m_pending;
+        }
+
+        virtual bool OnVSync(int64_t) override
+        {
+            m_frames++;
+            return true;
+        }
+
+    private:
+        bool m_pending;
+        uint64_t m_frames;
+    };
+}
+
+int main()
+{
+    const int playerCounts[] = { 1, 8, 32, 64, 128 };
+    const uint64_t ticks = 200000;
+
+    for (int players : playerCounts)
+    {
+        FreeRunningClock clock;
+        VSyncScheduler scheduler(&clock, 16667);
+        std::vector<std::shared_ptr<IVSyncTarget>> targets;
+        for (int i = 0; i < players; i++)
+        {
+            // A quarter of the players are idle, as in a typical call.
+            targets.push_back(std::make_shared<SimulatedPlayer>((i % 4) != 0));
+            scheduler.AddTarget(targets.back());
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "tick, %d players", players);
+        double perTick = Bench::Run(name, ticks, [&scheduler](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                scheduler.RunOnce();
+            }
+        });
+        printf("%-48s %12.1f ns/player\n", "", perTick / players);
+    }
+
+    return 0;
+}
@@ -0,0 +1,264 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "VSyncScheduler.h"
+
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace MEDIA;
+
+namespace
+{
+    const int64_t c_interval = 16667;
+
+    // Advances by a scripted interval per vblank and stops after a budget.
+    class FakeClock : public IVSyncClock
+    {
+    public:
+        explicit FakeClock(int vblanks) :
+            now(1000000),
+            remaining(vblanks),
+            throwAfter(-1),
+            interval(c_interval)
+        {
+        }
+
+        virtual int64_t NowMicroseconds() override
+        {
+            return now;
+        }
+
+        virtual bool WaitForVBlank() override
+        {
+            if (throwAfter == 0)
+            {
+                throw std::runtime_error("vblank wait failed");
+            }
+            throwAfter--;
+
+            if (remaining == 0)
+            {
+                return false;
+            }
+            remaining--;
+            now += interval;
+            return true;
+        }
+
+        int64_t now;
+        int remaining;
+        int throwAfter;
+        int64_t interval;
+    };
+
+    class FakePlayer : public IVSyncTarget
+    {
+    public:
+        FakePlayer() :
+            pending(true),
+            throws(false),
+            calls(0),
+            lastNow(0)
+        {
+        }
+
+        virtual bool HasPendingFrame() override
+        {
+            return pending;
+        }
+
+        virtual bool OnVSync(int64_t nowMicroseconds) override
+        {
+            calls++;
+            lastNow = nowMicroseconds;
+            if (throws)
+            {
+                throw std::runtime_error("present failed");
+            }
+            return true;
+        }
+
+        bool pending;
+        bool throws;
+        int calls;
+        int64_t lastNow;
+    };
+}
+
+TEST_CASE(OnlyTheFirstTargetStartsThePump)
+{
+    FakeClock clock(0);
+    VSyncScheduler scheduler(&clock, c_interval);
+    auto a = std::make_shared<FakePlayer>();
+    auto b = std::make_shared<FakePlayer>();
+
+    CHECK(scheduler.AddTarget(a));
+    CHECK(!scheduler.AddTarget(b));
+    CHECK(!scheduler.AddTarget(a));
+    CHECK(scheduler.TargetCount() == 2);
+    CHECK(Test::Stats(scheduler).starts == 1);
+}
+
+TEST_CASE(RunStopsWhenTheLastTargetIsRemoved)
+{
+    FakeClock clock(1000);
+    VSyncScheduler scheduler(&clock, c_interval);
+    auto player = std::make_shared<FakePlayer>();
+    CHECK(scheduler.AddTarget(player));
+
+    CHECK(scheduler.RunOnce());
+    scheduler.RemoveTarget(player);
+    CHECK(!scheduler.RunOnce());
+
+    // Stopped, so the next registration has to start a new pump.
+    CHECK(scheduler.AddTarget(player));
+    CHECK(Test::Stats(scheduler).starts == 2);
+}
+
+TEST_CASE(TicksFanOutToPendingTargetsOnly)
+{
+    FakeClock clock(10);
+    VSyncScheduler scheduler(&clock, c_interval);
+    auto busy = std::make_shared<FakePlayer>();
+    auto idle = std::make_shared<FakePlayer>();
+    idle->pending = false;
+    scheduler.AddTarget(busy);
+    scheduler.AddTarget(idle);
+
+    scheduler.Run();
+
+    CHECK(busy->calls == 10);
+    CHECK(busy->lastNow == clock.now);
+    CHECK(idle->calls == 0);
+
+    VSyncSchedulerStats stats = Test::Stats(scheduler);
+    CHECK(stats.ticks == 10);
+    CHECK(stats.dispatched == 10);
+    CHECK(stats.presented == 10);
+    CHECK(stats.skipped == 10);
+    CHECK(stats.failed == 0);
+}
+
+TEST_CASE(JitterIsMeasuredAgainstTheNominalInterval)
+{
+    FakeClock clock(3);
+    VSyncScheduler scheduler(&clock, c_interval);
+    scheduler.AddTarget(std::make_shared<FakePlayer>());
+
+    CHECK(scheduler.RunOnce());
+    clock.interval = c_interval + 500;
+    CHECK(scheduler.RunOnce());
+    clock.interval = c_interval - 100;
+    CHECK(scheduler.RunOnce());
+
+    // The first tick has nothing to compare with.
+    VSyncSchedulerStats stats = Test::Stats(scheduler);
+    CHECK(stats.lastIntervalMicroseconds == c_interval - 100);
+    CHECK(stats.lastJitterMicroseconds == 100);
+    CHECK(stats.maxJitterMicroseconds == 500);
+    CHECK(stats.meanJitterMicroseconds == 300);
+
+    scheduler.ResetStats();
+    stats = Test::Stats(scheduler);
+    CHECK(stats.ticks == 0);
+    CHECK(stats.maxJitterMicroseconds == 0);
+}
+
+TEST_CASE(AThrowingTargetDoesNotCostTheOthersTheirFrame)
+{
+    FakeClock clock(5);
+    VSyncScheduler scheduler(&clock, c_interval);
+    auto broken = std::make_shared<FakePlayer>();
+    auto healthy = std::make_shared<FakePlayer>();
+    broken->throws = true;
+    scheduler.AddTarget(broken);
+    scheduler.AddTarget(healthy);
+
+    scheduler.Run();
+
+    CHECK(healthy->calls == 5);
+    VSyncSchedulerStats stats = Test::Stats(scheduler);
+    CHECK(stats.failed == 5);
+    CHECK(stats.presented == 5);
+}
+
+TEST_CASE(AThrowingClockStopsThePumpSoItCanRestart)
+{
+    FakeClock clock(100);
+    clock.throwAfter = 3;
+    VSyncScheduler scheduler(&clock, c_interval);
+    auto player = std::make_shared<FakePlayer>();
+    CHECK(scheduler.AddTarget(player));
+
+    scheduler.Run();
+
+    CHECK(player->calls == 3);
+    CHECK(scheduler.AddTarget(player));
+}
+
+TEST_CASE(DozensOfSimulatedPlayersShareOneTick)
+{
+    const int players = 48;
+    const int vblanks = 120;
+    FakeClock clock(vblanks);
+    VSyncScheduler scheduler(&clock, c_interval);
+
+    std::vector<std::shared_ptr<FakePlayer>> targets;
+    for (int i = 0; i < players; i++)
+    {
+        targets.push_back(std::make_shared<FakePlayer>());
+        // Every third player is paused and has nothing to present.
+        targets.back()->pending = (i % 3) != 0;
+        scheduler.AddTarget(targets.back());
+    }
+
+    scheduler.Run();
+
+    int presenting = 0;
+    for (auto& target : targets)
+    {
+        CHECK(target->calls == (target->pending ? vblanks : 0));
+        presenting += target->pending ? 1 : 0;
+    }
+
+    VSyncSchedulerStats stats = Test::Stats(scheduler);
+    CHECK(stats.ticks == (uint64_t)vblanks);
+    CHECK(stats.presented == (uint64_t)(presenting * vblanks));
+    CHECK(stats.skipped == (uint64_t)((players - presenting) * vblanks));
+}
+
+TEST_CASE(TargetsCanComeAndGoWhileThePumpRuns)
+{
+    // A clock that never runs out; the pump ends when the last target goes.
+    FakeClock clock(-1);
+    VSyncScheduler scheduler(&clock, c_interval);
+    auto anchor = std::make_shared<FakePlayer>();
+    REQUIRE(scheduler.AddTarget(anchor));
+
+    std::thread pump([&scheduler]() { scheduler.Run(); });
+
+    for (int i = 0; i < 1000; i++)
+    {
+        auto player = std::make_shared<FakePlayer>();
+        CHECK(!scheduler.AddTarget(player));
+        scheduler.RemoveTarget(player);
+    }
+
+    scheduler.RemoveTarget(anchor);
+    pump.join();
+
+    CHECK(scheduler.TargetCount() == 0);
+    CHECK(Test::Stats(scheduler).starts == 1);
+}
@@ -0,0 +1,53 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Cost of one layout, which the renderer now computes at most once per
+// coalesced resize instead of on every size change event.
+
+#include "Benchmark.h"
+#include "VideoLayout.h"
+
+#include <vector>
+
+using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+
+int main()
+{
+    // a window being dragged: the control size changes every step
+    std::vector<float> widths;
+    std::vector<float> heights;
+    for (int i = 0; i < 1024; i++)
+    {
+        widths.push_back(320.0f + (float)((i * 37) % 1600));
+        heights.push_back(180.0f + (float)((i * 53) % 900));
+    }
+
+    const VideoScaleMode modes[] = { VideoScaleMode_Fill, VideoScaleMode_Fit, VideoScaleMode_Stretch };
+    const char* names[] = { "layout, fill", "layout, fit", "layout, stretch" };
+    for (int m = 0; m < 3; m++)
+    {
+        VideoScaleMode mode = modes[m];
+        Bench::Run(names[m], 20000000, [&](uint64_t n) {
+            int32_t sum = 0;
+            for (uint64_t i = 0; i < n; i++)
+            {
+                size_t k = i & 1023;
+                if (CanLayOutVideo(widths[k], heights[k], 1280.0f, 720.0f))
+                {
+                    VideoLayout layout = ComputeVideoLayout(mode, widths[k], heights[k], 1280.0f, 720.0f);
+                    sum += layout.destinationRight;
+                }
+            }
+            Bench::KeepAlive(sum);
+        });
+    }
+    return 0;
+}
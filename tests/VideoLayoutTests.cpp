@@ -0,0 +1,161 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "VideoLayout.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace ChatterBoxClient::Universal::BackgroundRenderer;
+
+namespace
+{
+    bool Near(double a, double b, double tolerance = 1e-6)
+    {
+        return std::fabs(a - b) <= tolerance;
+    }
+
+    // The layout is constexpr; prove it by evaluating one at compile time.
+    constexpr VideoLayout c_compiled = ComputeVideoLayout(VideoScaleMode_Fit, 1920.0f, 1080.0f, 640.0f, 480.0f);
+    static_assert(c_compiled.destinationLeft == 240 && c_compiled.destinationRight == 1680,
+        "4:3 video fits a 1080p control with 240 pixel bars");
+    static_assert(c_compiled.destinationTop == 0 && c_compiled.destinationBottom == 1080,
+        "the fitted video spans the full height");
+    static_assert(!CanLayOutVideo(0.0f, 1.0f, 1.0f, 1.0f), "empty control");
+}
+
+TEST_CASE(OnlyPositiveSizesCanBeLaidOut)
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    CHECK(CanLayOutVideo(1.0f, 1.0f, 1.0f, 1.0f));
+    CHECK(!CanLayOutVideo(1.0f, 0.0f, 1.0f, 1.0f));
+    CHECK(!CanLayOutVideo(1.0f, 1.0f, -640.0f, 480.0f));
+    CHECK(!CanLayOutVideo(nan, 1.0f, 1.0f, 1.0f));
+    CHECK(!CanLayOutVideo(1.0f, 1.0f, 1.0f, nan));
+}
+
+TEST_CASE(MatchingAspectRatiosNeedNoCropOrBars)
+{
+    const VideoScaleMode modes[] = { VideoScaleMode_Fill, VideoScaleMode_Fit, VideoScaleMode_Stretch };
+    for (VideoScaleMode mode : modes)
+    {
+        VideoLayout layout = ComputeVideoLayout(mode, 1280.0f, 720.0f, 1920.0f, 1080.0f);
+        CHECK(layout.sourceLeft == 0.0f && layout.sourceTop == 0.0f);
+        CHECK(layout.sourceRight == 1.0f && layout.sourceBottom == 1.0f);
+        CHECK(layout.destinationLeft == 0 && layout.destinationTop == 0);
+        CHECK(layout.destinationRight == 1280 && layout.destinationBottom == 720);
+    }
+}
+
+TEST_CASE(FillCropsTheWiderSideEvenly)
+{
+    // 16:9 video in a square control loses the sides.
+    VideoLayout wide = ComputeVideoLayout(VideoScaleMode_Fill, 500.0f, 500.0f, 1600.0f, 900.0f);
+    CHECK(Near(wide.sourceLeft, (1.0 - 900.0 / 1600.0) / 2.0));
+    CHECK(Near(wide.sourceLeft, 1.0 - wide.sourceRight));
+    CHECK(wide.sourceTop == 0.0f && wide.sourceBottom == 1.0f);
+    CHECK(wide.destinationRight == 500 && wide.destinationBottom == 500);
+
+    // Portrait video in a landscape control loses top and bottom.
+    VideoLayout tall = ComputeVideoLayout(VideoScaleMode_Fill, 1600.0f, 900.0f, 720.0f, 1280.0f);
+    CHECK(tall.sourceLeft == 0.0f && tall.sourceRight == 1.0f);
+    CHECK(Near(tall.sourceTop, 1.0 - tall.sourceBottom));
+    CHECK(tall.sourceTop > 0.3f);
+}
+
+TEST_CASE(FitCentersTheVideoWithBars)
+{
+    // Letterbox: wide video, bars above and below.
+    VideoLayout letterbox = ComputeVideoLayout(VideoScaleMode_Fit, 800.0f, 800.0f, 1600.0f, 900.0f);
+    CHECK(letterbox.destinationLeft == 0 && letterbox.destinationRight == 800);
+    CHECK(letterbox.destinationTop == 175 && letterbox.destinationBottom == 625);
+
+    // Pillarbox: tall video, bars on the sides.
+    VideoLayout pillarbox = ComputeVideoLayout(VideoScaleMode_Fit, 1280.0f, 720.0f, 720.0f, 1280.0f);
+    CHECK(pillarbox.destinationTop == 0 && pillarbox.destinationBottom == 720);
+    CHECK(pillarbox.destinationRight - pillarbox.destinationLeft == 405);
+
+    // Edges at half pixels both round up, so the bars may differ by one.
+    CHECK(std::abs(pillarbox.destinationLeft - (1280 - pillarbox.destinationRight)) <= 1);
+
+    // The whole frame is shown either way.
+    CHECK(letterbox.sourceLeft == 0.0f && letterbox.sourceBottom == 1.0f);
+    CHECK(pillarbox.sourceTop == 0.0f && pillarbox.sourceRight == 1.0f);
+}
+
+TEST_CASE(StretchIgnoresTheAspectRatio)
+{
+    VideoLayout layout = ComputeVideoLayout(VideoScaleMode_Stretch, 300.0f, 900.0f, 1920.0f, 1080.0f);
+    CHECK(layout.sourceLeft == 0.0f && layout.sourceRight == 1.0f);
+    CHECK(layout.destinationRight == 300 && layout.destinationBottom == 900);
+}
+
+TEST_CASE(FractionalControlSizesRoundToPixels)
+{
+    VideoLayout layout = ComputeVideoLayout(VideoScaleMode_Stretch, 640.6f, 359.4f, 16.0f, 9.0f);
+    CHECK(layout.destinationRight == 641);
+    CHECK(layout.destinationBottom == 359);
+}
+
+// Across a spread of control and video sizes: Fit stays inside the control
+// and keeps the aspect ratio to within the pixel rounding, Fill shows a
+// source region with the control's aspect ratio, and both stay centered.
+// Aspect ratios more than 16 times apart are skipped: the part Fill shows
+// is then so thin that the float source edges cannot hold it to 1e-4.
+TEST_CASE(PropertiesHoldAcrossSizes)
+{
+    int failures = 0;
+    int checked = 0;
+    for (int cw = 16; cw <= 4096; cw = cw * 3 / 2 + 7)
+    {
+        for (int ch = 16; ch <= 4096; ch = ch * 3 / 2 + 5)
+        {
+            for (int vw = 32; vw <= 3840; vw = vw * 2 + 16)
+            {
+                for (int vh = 32; vh <= 2160; vh = vh * 2 + 8)
+                {
+                    double mismatch = ((double)vw / vh) / ((double)cw / ch);
+                    if (mismatch > 16.0 || mismatch < 1.0 / 16.0)
+                    {
+                        continue;
+                    }
+
+                    VideoLayout fit = ComputeVideoLayout(VideoScaleMode_Fit, (float)cw, (float)ch, (float)vw, (float)vh);
+                    int width = fit.destinationRight - fit.destinationLeft;
+                    int height = fit.destinationBottom - fit.destinationTop;
+                    bool fitOk =
+                        fit.destinationLeft >= 0 && fit.destinationTop >= 0 &&
+                        fit.destinationRight <= cw && fit.destinationBottom <= ch &&
+                        (width == cw || height == ch) &&
+                        std::abs(fit.destinationLeft - (cw - fit.destinationRight)) <= 1 &&
+                        std::abs(fit.destinationTop - (ch - fit.destinationBottom)) <= 1 &&
+                        std::fabs((double)width * vh - (double)height * vw) <= 1.5 * (vw + vh);
+
+                    VideoLayout fill = ComputeVideoLayout(VideoScaleMode_Fill, (float)cw, (float)ch, (float)vw, (float)vh);
+                    double shownAspect = ((fill.sourceRight - fill.sourceLeft) * vw) /
+                        ((fill.sourceBottom - fill.sourceTop) * vh);
+                    bool fillOk =
+                        fill.sourceLeft >= 0.0f && fill.sourceTop >= 0.0f &&
+                        Near(fill.sourceLeft, 1.0 - fill.sourceRight) &&
+                        Near(fill.sourceTop, 1.0 - fill.sourceBottom) &&
+                        std::fabs(shownAspect / ((double)cw / ch) - 1.0) < 1e-4 &&
+                        fill.destinationRight == cw && fill.destinationBottom == ch;
+
+                    failures += (fitOk && fillOk) ? 0 : 1;
+                    checked++;
+                }
+            }
+        }
+    }
+    CHECK(failures == 0);
+    CHECK(checked > 1000);
+}
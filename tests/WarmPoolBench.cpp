@@ -0,0 +1,167 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Time from creating a player to its first frame, as CreatePlayer sees it:
+// with an empty pool the player is set up on the spot, with a primed pool
+// it comes ready. The simulated setup allocates and clears the frame slots,
+// standing in for MEPlayer::Prewarm; on Windows the device and engine cost
+// comes on top of it, see GetInitStats.
+
+#include "Benchmark.h"
+#include "WarmPool.h"
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace MEDIA;
+
+namespace
+{
+    const uint32_t c_width = 1280;
+    const uint32_t c_height = 720;
+    const uint32_t c_slotCount = 3;
+
+    class SimulatedPlayer
+    {
+    public:
+        SimulatedPlayer() : m_frames(0) {}
+
+        void Prewarm()
+        {
+            if (!m_slots.empty())
+            {
+                return;
+            }
+            for (uint32_t i = 0; i < c_slotCount; i++)
+            {
+                m_slots.emplace_back(c_width * c_height * 4, 0);
+            }
+        }
+
+        // Like MEPlayer::Initialize, the first frame sets up whatever
+        // the pool did not.
+        void PresentFrame()
+        {
+            Prewarm();
+            std::vector<uint8_t>& slot = m_slots[m_frames % c_slotCount];
+            memset(slot.data(), (int)(m_frames & 0xff), slot.size());
+            m_frames++;
+        }
+
+        const uint8_t* Pixels() const
+        {
+            return m_slots[0].data();
+        }
+
+    private:
+        std::vector<std::vector<uint8_t>> m_slots;
+        uint64_t m_frames;
+    };
+
+    class SimulatedPlayerFactory : public IWarmPoolFactory
+    {
+    public:
+        virtual void* Create() override
+        {
+            SimulatedPlayer* player = new SimulatedPlayer();
+            player->Prewarm();
+            return player;
+        }
+
+        virtual void Destroy(void* item) override
+        {
+            delete static_cast<SimulatedPlayer*>(item);
+        }
+    };
+
+    uint64_t Microseconds(std::chrono::steady_clock::time_point start)
+    {
+        return (uint64_t)(Bench::Seconds(start) * 1e6);
+    }
+
+    void WaitForReady(const WarmPool& pool)
+    {
+        WarmPoolStats stats;
+        for (;;)
+        {
+            pool.GetStats(&stats);
+            if (stats.ready == stats.target)
+            {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void PrintSummary(const char* name, const LatencySummary& summary)
+    {
+        printf("%-48s %12llu us p50  %8llu us p95  %8llu us max\n", name,
+            (unsigned long long)summary.p50,
+            (unsigned long long)summary.p95,
+            (unsigned long long)summary.max);
+    }
+}
+
+int main()
+{
+    const uint32_t calls = 200;
+
+    SimulatedPlayerFactory factory;
+    WarmPool pool(&factory, 1);
+
+    // Empty pool: every call builds its own player.
+    pool.SetTarget(0);
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        SimulatedPlayer* player = static_cast<SimulatedPlayer*>(pool.Acquire());
+        if (player == nullptr)
+        {
+            player = new SimulatedPlayer();
+        }
+        player->PresentFrame();
+        pool.RecordFirstFrame(false, Microseconds(start));
+        Bench::KeepAlive(player->Pixels()[0]);
+        delete player;
+    }
+
+    // Primed pool: the refill thread has a player ready before each call.
+    // Only the call is timed, not the wait for the refill.
+    pool.SetTarget(1);
+    pool.Start();
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        WaitForReady(pool);
+        auto start = std::chrono::steady_clock::now();
+        SimulatedPlayer* player = static_cast<SimulatedPlayer*>(pool.Acquire());
+        bool pooled = (player != nullptr);
+        if (!pooled)
+        {
+            player = new SimulatedPlayer();
+        }
+        player->PresentFrame();
+        pool.RecordFirstFrame(pooled, Microseconds(start));
+        Bench::KeepAlive(player->Pixels()[0]);
+        delete player;
+    }
+    pool.Stop();
+
+    WarmPoolStats stats;
+    pool.GetStats(&stats);
+    PrintSummary("create to first frame, empty pool", stats.firstFrameCold);
+    PrintSummary("create to first frame, primed pool", stats.firstFrameWarm);
+    printf("%-48s %12llu hits  %8llu misses\n", "",
+        (unsigned long long)stats.hits, (unsigned long long)stats.misses);
+
+    return 0;
+}
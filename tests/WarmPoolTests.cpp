@@ -0,0 +1,277 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Test.h"
+#include "WarmPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace MEDIA;
+
+namespace
+{
+    // Stands in for a player with its media engine already set up.
+    class FakePlayerFactory : public IWarmPoolFactory
+    {
+    public:
+        FakePlayerFactory() :
+            created(0),
+            destroyed(0),
+            failuresLeft(0),
+            createDelayMs(0),
+            threadStarted(false),
+            threadStopped(false),
+            wrongThread(false)
+        {
+        }
+
+        virtual void* Create() override
+        {
+            if (!threadStarted || std::this_thread::get_id() != poolThread)
+            {
+                wrongThread = true;
+            }
+            if (createDelayMs > 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(createDelayMs.load()));
+            }
+            if (failuresLeft > 0)
+            {
+                failuresLeft--;
+                return nullptr;
+            }
+            created++;
+            return new int(created);
+        }
+
+        virtual void Destroy(void* item) override
+        {
+            destroyed++;
+            delete static_cast<int*>(item);
+        }
+
+        virtual void OnThreadStart() override
+        {
+            poolThread = std::this_thread::get_id();
+            threadStarted = true;
+        }
+
+        virtual void OnThreadStop() override
+        {
+            threadStopped = true;
+        }
+
+        int Live() const
+        {
+            return created - destroyed;
+        }
+
+        std::atomic<int> created;
+        std::atomic<int> destroyed;
+        std::atomic<int> failuresLeft;
+        std::atomic<int> createDelayMs;
+        std::atomic<bool> threadStarted;
+        std::atomic<bool> threadStopped;
+        std::atomic<bool> wrongThread;
+        std::thread::id poolThread;
+    };
+
+    bool ReadyCount(const WarmPool& pool, uint32_t count)
+    {
+        return Test::WaitUntil([&pool, count]() { return Test::Stats(pool).ready == count; });
+    }
+}
+
+TEST_CASE(NothingIsBuiltBeforeStart)
+{
+    FakePlayerFactory factory;
+    WarmPool pool(&factory, 2);
+    CHECK(pool.Acquire() == nullptr);
+
+    WarmPoolStats stats = Test::Stats(pool);
+    CHECK(stats.ready == 0);
+    CHECK(stats.target == 2);
+    CHECK(stats.misses == 1);
+    CHECK(factory.created == 0);
+
+    // Stop without Start is harmless.
+    pool.Stop();
+}
+
+TEST_CASE(StartFillsThePoolOnItsOwnThread)
+{
+    FakePlayerFactory factory;
+    WarmPool pool(&factory, 3);
+    pool.Start();
+    pool.Start();
+    REQUIRE(ReadyCount(pool, 3));
+    CHECK(factory.threadStarted);
+    CHECK(!factory.wrongThread);
+
+    // A full pool builds nothing more.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(factory.created == 3);
+
+    pool.Stop();
+    CHECK(factory.threadStopped);
+    CHECK(factory.destroyed == 3);
+}
+
+TEST_CASE(AcquiringRefillsThePool)
+{
+    FakePlayerFactory factory;
+    WarmPool pool(&factory, 2);
+    pool.Start();
+    REQUIRE(ReadyCount(pool, 2));
+
+    int* first = static_cast<int*>(pool.Acquire());
+    REQUIRE(first != nullptr);
+    REQUIRE(ReadyCount(pool, 2));
+    CHECK(factory.created == 3);
+
+    WarmPoolStats stats = Test::Stats(pool);
+    CHECK(stats.hits == 1);
+    CHECK(stats.misses == 0);
+
+    // The caller owns what it acquired; Stop only destroys the rest.
+    pool.Stop();
+    CHECK(factory.destroyed == 2);
+    factory.Destroy(first);
+    CHECK(factory.Live() == 0);
+}
+
+TEST_CASE(LoweringTheTargetDestroysTheSurplus)
+{
+    FakePlayerFactory factory;
+    WarmPool pool(&factory, 4);
+    pool.Start();
+    REQUIRE(ReadyCount(pool, 4));
+
+    pool.SetTarget(1);
+    CHECK(Test::Stats(pool).ready == 1);
+    CHECK(factory.destroyed == 3);
+
+    pool.SetTarget(0);
+    CHECK(Test::Stats(pool).ready == 0);
+    CHECK(pool.Acquire() == nullptr);
+
+    pool.SetTarget(2);
+    CHECK(ReadyCount(pool, 2));
+    pool.Stop();
+    CHECK(factory.Live() == 0);
+}
+
+TEST_CASE(FailedCreatesBackOffAndRecover)
+{
+    FakePlayerFactory factory;
+    factory.failuresLeft = 1;
+    WarmPool pool(&factory, 1);
+
+    auto start = std::chrono::steady_clock::now();
+    pool.Start();
+    REQUIRE(ReadyCount(pool, 1));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    CHECK(Test::Stats(pool).failures == 1);
+    CHECK(elapsed >= std::chrono::milliseconds(WarmPool::c_retryDelayMs));
+    pool.Stop();
+}
+
+TEST_CASE(SetTargetCutsTheBackoffShort)
+{
+    FakePlayerFactory factory;
+    factory.failuresLeft = 1;
+    WarmPool pool(&factory, 1);
+    pool.Start();
+    REQUIRE(Test::WaitUntil([&pool]() { return Test::Stats(pool).failures == 1; }));
+
+    // Setting the target wakes the thread ahead of the delay.
+    auto start = std::chrono::steady_clock::now();
+    pool.SetTarget(1);
+    REQUIRE(ReadyCount(pool, 1));
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(WarmPool::c_retryDelayMs));
+    pool.Stop();
+}
+
+TEST_CASE(AnItemFinishedAfterStopIsDestroyed)
+{
+    FakePlayerFactory factory;
+    factory.createDelayMs = 50;
+    WarmPool pool(&factory, 1);
+    pool.Start();
+    REQUIRE(Test::WaitUntil([&factory]() { return factory.threadStarted.load(); }));
+
+    // Stop lands while Create is sleeping.
+    pool.Stop();
+    CHECK(factory.Live() == 0);
+    CHECK(Test::Stats(pool).ready == 0);
+}
+
+TEST_CASE(FirstFrameTimesAreKeptApart)
+{
+    FakePlayerFactory factory;
+    WarmPool pool(&factory, 0);
+    pool.RecordFirstFrame(true, 40000);
+    pool.RecordFirstFrame(true, 60000);
+    pool.RecordFirstFrame(false, 900000);
+
+    WarmPoolStats stats = Test::Stats(pool);
+    CHECK(stats.firstFrameWarm.count == 2);
+    CHECK(stats.firstFrameCold.count == 1);
+    CHECK(stats.firstFrameWarm.max <= 61000);
+    CHECK(stats.firstFrameCold.max >= 890000);
+}
+
+// Callers grab items as fast as they can while the thread refills; every
+// item built is either handed out or destroyed by the pool.
+TEST_CASE(StressAcquireAgainstRefill)
+{
+    const int c_threads = 4;
+    FakePlayerFactory factory;
+    WarmPool pool(&factory, 2);
+    pool.Start();
+
+    std::atomic<int> acquired(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < c_threads; t++)
+    {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 2000; i++)
+            {
+                void* item = pool.Acquire();
+                if (item != nullptr)
+                {
+                    acquired++;
+                    factory.Destroy(item);
+                }
+                if ((i % 500) == 0)
+                {
+                    pool.SetTarget(1 + (i / 500) % 3);
+                }
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    pool.Stop();
+
+    WarmPoolStats stats = Test::Stats(pool);
+    CHECK(acquired.load() > 0);
+    CHECK(stats.hits == (uint64_t)acquired.load());
+    CHECK(stats.hits + stats.misses == (uint64_t)c_threads * 2000);
+    CHECK(factory.Live() == 0);
+}